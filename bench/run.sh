@@ -0,0 +1,151 @@
+#!/bin/sh
+# runtime benchmark of the code generated by the compiler
+# every kernel in bench/kernels is compiled through each backend:
+#   c-O0, c-O2   gen_C_code and then $CC -O0 / -O2
+#   nasm         gen_NASM_code and then nasm + ld
+#   elf          the executable written by the compiler itself, its loops vectorized with SSE2
+#   elf-avx2     the same with -march=x86-64-v3, when the processor has AVX2
+#   elf-novec    the same with -fno-vectorize
+#   elf-noroll   the same with -funroll=1, the loops are not unrolled
+#   jit          compiler --run, assembled in memory and run inside the compiler
+#   interp       compiler --interpret, the bytecode interpreter
+# and the resulting programs are run and measured,
+# the times of jit and interp include the compilation because it happens on every run
+#
+# environment variables:
+#   COMP     path of the compiler binary        (default: ./comp)
+#   CC       C compiler for the C backend        (default: cc)
+#   REPEAT   runs per program, the best is kept  (default: 3)
+#   OUT      directory for the build artifacts   (default: bench/out)
+#
+# the results are printed as a table and saved in $OUT/results.csv
+
+BENCH_DIR=$(dirname "$0")
+COMP=${COMP:-./comp}
+CC=${CC:-cc}
+REPEAT=${REPEAT:-3}
+OUT=${OUT:-$BENCH_DIR/out}
+
+if [ ! -x "$COMP" ]; then
+  echo "Error: can not find the compiler at $COMP, build it first or set COMP"
+  exit 1
+fi
+mkdir -p "$OUT"
+
+HAS_NASM=false
+if command -v nasm >/dev/null 2>&1 && command -v ld >/dev/null 2>&1; then
+  HAS_NASM=true
+fi
+HAS_AVX2=false
+if grep -q avx2 /proc/cpuinfo 2>/dev/null; then
+  HAS_AVX2=true
+fi
+HAS_PERF=false
+if command -v perf >/dev/null 2>&1 && perf stat -x, -e instructions true >/dev/null 2>&1; then
+  HAS_PERF=true
+fi
+
+now_ns() {
+  date +%s%N
+}
+
+# runs the program $1 $REPEAT times and sets:
+#   RUN_MS     the fastest wall time in milliseconds
+#   RUN_EXIT   the exit code of the program
+run_program() {
+  RUN_MS=
+  i=0
+  while [ $i -lt "$REPEAT" ]; do
+    start=$(now_ns)
+    "$1" > /dev/null
+    RUN_EXIT=$?
+    elapsed=$(( ($(now_ns) - start) / 1000 ))
+    if [ -z "$RUN_MS" ] || [ $elapsed -lt "$RUN_MS" ]; then
+      RUN_MS=$elapsed
+    fi
+    i=$((i + 1))
+  done
+  # keep 3 decimals of the microseconds
+  RUN_MS=$(printf "%d.%03d" $((RUN_MS / 1000)) $((RUN_MS % 1000)))
+}
+
+# sets RUN_INSTRUCTIONS to the retired instructions of the program $1
+count_instructions() {
+  RUN_INSTRUCTIONS=-
+  if $HAS_PERF; then
+    RUN_INSTRUCTIONS=$(perf stat -x, -e instructions -- "$1" 2>&1 >/dev/null | grep instructions | cut -d, -f1)
+  fi
+}
+
+# records one result in the table and the csv
+# kernel backend status exit runtime instructions size
+report() {
+  printf "%-16s %-12s %-8s %5s %12s %14s %10s\n" "$@"
+  echo "$1,$2,$3,$4,$5,$6,$7" >> "$OUT/results.csv"
+}
+
+# measure the program $3 of the kernel $1 built with the backend $2,
+# its size is $4 when it is given
+measure() {
+  run_program "$3"
+  count_instructions "$3"
+  size=${4:-$(wc -c < "$3" | tr -d ' ')}
+  if [ -n "$EXPECTED_EXIT" ] && [ "$RUN_EXIT" != "$EXPECTED_EXIT" ]; then
+    report "$1" "$2" mismatch "$RUN_EXIT" "$RUN_MS" "$RUN_INSTRUCTIONS" "$size"
+  else
+    report "$1" "$2" ok "$RUN_EXIT" "$RUN_MS" "$RUN_INSTRUCTIONS" "$size"
+  fi
+}
+
+echo "kernel,backend,status,exit,runtime_ms,instructions,size_bytes" > "$OUT/results.csv"
+printf "%-16s %-12s %-8s %5s %12s %14s %10s\n" kernel backend status exit runtime_ms instructions size_bytes
+
+for kernel_path in "$BENCH_DIR"/kernels/*.src; do
+  kernel=$(basename "$kernel_path" .src)
+  # the exit code of the first backend is the reference for the others
+  EXPECTED_EXIT=
+
+  if "$COMP" "$kernel_path" "$OUT/$kernel.c" > /dev/null; then
+    for opt in O0 O2; do
+      if "$CC" -$opt -w "$OUT/$kernel.c" -o "$OUT/$kernel-c-$opt"; then
+        measure "$kernel" "c-$opt" "$OUT/$kernel-c-$opt"
+        EXPECTED_EXIT=${EXPECTED_EXIT:-$RUN_EXIT}
+      else
+        report "$kernel" "c-$opt" cc-error - - - -
+      fi
+    done
+  else
+    report "$kernel" c comp-error - - - -
+  fi
+
+  if "$COMP" "$kernel_path" "$OUT/$kernel.asm" > /dev/null; then
+    if ! $HAS_NASM; then
+      report "$kernel" nasm no-nasm - - - -
+    elif nasm -f elf64 "$OUT/$kernel.asm" -o "$OUT/$kernel.o" && ld "$OUT/$kernel.o" -o "$OUT/$kernel-nasm"; then
+      measure "$kernel" nasm "$OUT/$kernel-nasm"
+    else
+      report "$kernel" nasm asm-error - - - -
+    fi
+  else
+    report "$kernel" nasm comp-error - - - -
+  fi
+
+  for variant in elf:-march=x86-64 elf-avx2:-march=x86-64-v3 elf-novec:-fno-vectorize elf-noroll:-funroll=1; do
+    backend=${variant%%:*}
+    if [ $backend = elf-avx2 ] && ! $HAS_AVX2; then
+      report "$kernel" $backend no-avx2 - - - -
+    elif "$COMP" "${variant#*:}" "$kernel_path" "$OUT/$kernel-$backend" > /dev/null; then
+      measure "$kernel" $backend "$OUT/$kernel-$backend"
+    else
+      report "$kernel" $backend comp-error - - - -
+    fi
+  done
+
+  # the programs run by the compiler are measured through a script, they have no size
+  for mode in run interpret; do
+    backend=$([ $mode = run ] && echo jit || echo interp)
+    printf '#!/bin/sh\nexec "%s" --%s "%s"\n' "$COMP" $mode "$kernel_path" > "$OUT/$kernel-$backend"
+    chmod +x "$OUT/$kernel-$backend"
+    measure "$kernel" $backend "$OUT/$kernel-$backend" -
+  done
+done
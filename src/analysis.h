@@ -0,0 +1,405 @@
+#ifndef ANALYSIS_H_
+#define ANALYSIS_H_
+
+#include "errors.h"
+#include "mlib.h"
+#include "tokenizer.h"
+#include "parser.h"
+
+
+/* * * * * * * * * * * * * * *
+ * Analyzing the syntax trees *
+ * * * * * * * * * * * * * * */
+
+// the generators use these to know what the program does before generating it
+
+// returns true if the address of the variable is taken in the expresion
+static bool is_variable_address_taken(const Node_Expresion expresion, const Token variable) {
+  switch (expresion.expresion_type) {
+    case expresion_number_type:
+    case expresion_identifier_type:
+      return false;
+
+    case expresion_binary_operation_type:
+      return is_variable_address_taken(get_binary_operation(expresion)->left_side, variable)
+          || is_variable_address_taken(get_binary_operation(expresion)->right_side, variable);
+
+    case expresion_unary_operation_type:;
+      const Node_Unary_Operation operation = *get_unary_operation(expresion);
+      if (operation.operation_type == unary_operation_addr_type && operation.expresion.expresion_type == expresion_identifier_type
+          && compare_str_of_tokens(operation.expresion.expresion_value.expresion_identifier_value, variable)) {
+        return true;
+      }
+      return is_variable_address_taken(operation.expresion, variable);
+
+    case expresion_array_type:;
+      const Node_Array array = expresion.expresion_value.expresion_array_value;
+      for (int i = 0; i < array.elements_count; i++) {
+        if (is_variable_address_taken(get_array_elements(array)[i], variable)) {
+          return true;
+        }
+      }
+      return false;
+  }
+  return true;
+}
+
+// returns true if the statements assign a variable with the name, when the assignments are counted,
+// or take its address, when the addresses are counted
+// the names are not compared by scope, so any variable with the same name counts
+static bool is_variable_used_in(const Node_Statement * statements, const int statements_count, const Token variable,
+                                const bool are_assignments_counted, const bool are_addresses_counted) {
+  for (int i = 0; i < statements_count; i++) {
+    const Node_Statement stmt = statements[i];
+    switch (stmt.statement_type) {
+      case var_declaration_type:
+        if (are_addresses_counted && is_variable_address_taken(stmt.statement_value.var_declaration.value, variable)) {
+          return true;
+        }
+        break;
+
+      case var_assignment_type:
+        if ((are_assignments_counted && compare_str_of_tokens(stmt.statement_value.var_assignment.var_name, variable))
+            || (are_addresses_counted && is_variable_address_taken(stmt.statement_value.var_assignment.value, variable))) {
+          return true;
+        }
+        break;
+
+      case exit_node_type:
+        if (are_addresses_counted && is_variable_address_taken(stmt.statement_value.exit_node.exit_code, variable)) {
+          return true;
+        }
+        break;
+
+      case print_type:
+        if (are_addresses_counted && is_variable_address_taken(stmt.statement_value.print.chr, variable)) {
+          return true;
+        }
+        break;
+
+      case scope_type:;
+        const Node_Scope scope = stmt.statement_value.scope;
+        if (is_variable_used_in(get_scope_statements(scope), scope.statements_count, variable, are_assignments_counted, are_addresses_counted)) {
+          return true;
+        }
+        break;
+
+      case if_type:;
+        const Node_If if_node = stmt.statement_value.if_node;
+        if ((are_addresses_counted && is_variable_address_taken(if_node.condition, variable))
+            || is_variable_used_in(get_scope_statements(if_node.scope), if_node.scope.statements_count, variable,
+                                   are_assignments_counted, are_addresses_counted)
+            || (if_node.has_else_block && is_variable_used_in(get_scope_statements(if_node.else_block), if_node.else_block.statements_count, variable,
+                                                              are_assignments_counted, are_addresses_counted))) {
+          return true;
+        }
+        break;
+
+      case while_type:;
+        const Node_While while_node = stmt.statement_value.while_node;
+        if ((are_addresses_counted && is_variable_address_taken(while_node.condition, variable))
+            || is_variable_used_in(get_scope_statements(while_node.scope), while_node.scope.statements_count, variable,
+                                   are_assignments_counted, are_addresses_counted)) {
+          return true;
+        }
+        break;
+    }
+  }
+  return false;
+}
+
+// returns true if the statements can change a variable with the name, by assigning it or through its address
+static bool is_variable_written(const Node_Statement * statements, const int statements_count, const Token variable) {
+  return is_variable_used_in(statements, statements_count, variable, true, true);
+}
+
+/* the ranges of the indexes */
+
+// with --bounds-check the programs check that the indexes of the arrays are less than their length,
+// and they stop with an error when they are not
+bool is_bounds_checking = false;
+// print how many of the checks are removed
+bool is_reporting_bounds_checks = false;
+
+// the checks of the indexes that are always in the range are removed, the range analysis finds numbers that are
+// always bigger than an index from the numbers in the code: the conditions of the loops and the ifs, like in
+// `while i < 10 { ... }`, and the values given to the variables, like in `i = j % 8;`
+// the facts about a variable are forgotten after a statement that changes it,
+// and the loops forget the facts about the variables they change before they begin
+
+// bigger numbers are not used, so the sums and the products of the bounds do not overflow
+#define MAX_KNOWN_BOUND ((long long)1 << 31)
+
+// the value of the variable is always less than the bound
+typedef struct Range_fact {
+  Token variable;
+  long long bound;
+} Range_fact;
+
+typedef struct Range_facts {
+  int facts_count;
+  Range_fact * facts;
+} Range_facts;
+
+// a number bigger than the index of every access, by the index of the access in the pool of binary operations,
+// -1 when it is not known
+typedef struct Index_bounds {
+  int bounds_count;
+  long long * bounds;
+} Index_bounds;
+
+static Range_facts copy_range_facts(const Range_facts facts) {
+  Range_facts result = { .facts_count = facts.facts_count, .facts = smalloc(facts.facts_count * sizeof(*facts.facts)) };
+  memcpy(result.facts, facts.facts, facts.facts_count * sizeof(*facts.facts));
+  return result;
+}
+
+static void forget_range_fact(Range_facts * facts, const Token variable) {
+  for (int i = 0; i < facts->facts_count; i++) {
+    if (compare_str_of_tokens(facts->facts[i].variable, variable)) {
+      facts->facts[i] = facts->facts[facts->facts_count -1];
+      facts->facts_count--;
+      return;
+    }
+  }
+}
+
+// the new fact replaces the old one about the variable
+static void add_range_fact(Range_facts * facts, const Token variable, const long long bound) {
+  forget_range_fact(facts, variable);
+  if (bound == -1) {
+    return;
+  }
+  facts->facts_count++;
+  facts->facts = srealloc(facts->facts, facts->facts_count * sizeof(*facts->facts));
+  facts->facts[facts->facts_count -1] = (Range_fact) { .variable = variable, .bound = bound };
+}
+
+// forgets the facts about the variables that the statements change
+static void forget_written_range_facts(Range_facts * facts, const Node_Statement * statements, const int statements_count) {
+  for (int i = 0; i < facts->facts_count;) {
+    if (is_variable_written(statements, statements_count, facts->facts[i].variable)) {
+      forget_range_fact(facts, facts->facts[i].variable);
+    }
+    else {
+      i++;
+    }
+  }
+}
+
+static long long get_variable_bound(const Range_facts facts, const Token variable) {
+  for (int i = 0; i < facts.facts_count; i++) {
+    if (compare_str_of_tokens(facts.facts[i].variable, variable)) {
+      return facts.facts[i].bound;
+    }
+  }
+  return -1;
+}
+
+// the bound is unknown when it is too big
+static long long limit_bound(const long long bound) {
+  return bound > MAX_KNOWN_BOUND ? -1 : bound;
+}
+
+// returns a number bigger than the value of the expresion, or -1 if it is not known,
+// and saves the bounds of the indexes of the accesses in the expresion
+static long long get_expresion_bound(const Node_Expresion expresion, const Range_facts facts, Index_bounds * index_bounds) {
+  switch (expresion.expresion_type) {
+    case expresion_number_type:;
+      const uint64_t value = expresion.expresion_value.expresion_number_value.value;
+      return value >= MAX_KNOWN_BOUND ? -1 : (long long) value + 1;
+
+    case expresion_identifier_type:
+      return get_variable_bound(facts, expresion.expresion_value.expresion_identifier_value);
+
+    case expresion_binary_operation_type:;
+      const Node_Binary_Operation operation = *get_binary_operation(expresion);
+      const long long left_bound = get_expresion_bound(operation.left_side, facts, index_bounds);
+      const long long right_bound = get_expresion_bound(operation.right_side, facts, index_bounds);
+      switch (operation.operation_type) {
+        case binary_operation_sum_type:
+          return left_bound == -1 || right_bound == -1 ? -1 : limit_bound(left_bound + right_bound - 1);
+
+        case binary_operation_mul_type:
+          return left_bound == -1 || right_bound == -1 ? -1 : limit_bound((left_bound - 1) * (right_bound - 1) + 1);
+
+        case binary_operation_div_type:
+          // the division by zero stops the program
+          return left_bound;
+
+        case binary_operation_mod_type:
+          // the remainder is less than the divisor, which is less than its bound
+          if (right_bound != -1 && (left_bound == -1 || right_bound - 1 < left_bound)) {
+            return right_bound - 1;
+          }
+          return left_bound;
+
+        case binary_operation_equ_type:
+        case binary_operation_big_type:
+        case binary_operation_les_type:
+          return 2;
+
+        case binary_operation_access_type:
+          if (index_bounds != NULL) {
+            index_bounds->bounds[expresion.expresion_value.expresion_binary_operation_value] = right_bound;
+          }
+          return -1;
+
+        // the subtraction can go below 0 and become a big number
+        case binary_operation_sub_type:
+        case binary_operation_exp_type:
+          return -1;
+      }
+      return -1;
+
+    case expresion_unary_operation_type:
+      get_expresion_bound(get_unary_operation(expresion)->expresion, facts, index_bounds);
+      return -1;
+
+    case expresion_array_type:;
+      const Node_Array array = expresion.expresion_value.expresion_array_value;
+      for (int i = 0; i < array.elements_count; i++) {
+        get_expresion_bound(get_array_elements(array)[i], facts, index_bounds);
+      }
+      return -1;
+  }
+  return -1;
+}
+
+// adds the facts that are true when the condition is true: `variable < bound` and `bound > variable`
+static void add_condition_range_facts(Range_facts * facts, const Node_Expresion condition) {
+  if (condition.expresion_type != expresion_binary_operation_type) {
+    return;
+  }
+  const Node_Binary_Operation operation = *get_binary_operation(condition);
+  Node_Expresion variable;
+  Node_Expresion limit;
+  if (operation.operation_type == binary_operation_les_type) {
+    variable = operation.left_side;
+    limit = operation.right_side;
+  }
+  else if (operation.operation_type == binary_operation_big_type) {
+    variable = operation.right_side;
+    limit = operation.left_side;
+  }
+  else {
+    return;
+  }
+  if (variable.expresion_type != expresion_identifier_type) {
+    return;
+  }
+  // the variable is less than the limit, which is less than its bound
+  const long long limit_bound = get_expresion_bound(limit, *facts, NULL);
+  const long long old_bound = get_variable_bound(*facts, variable.expresion_value.expresion_identifier_value);
+  if (limit_bound != -1 && (old_bound == -1 || limit_bound - 1 < old_bound)) {
+    add_range_fact(facts, variable.expresion_value.expresion_identifier_value, limit_bound - 1);
+  }
+}
+
+static void analyze_range_statements(const Node_Statement * statements, const int statements_count, Range_facts * facts, Index_bounds * index_bounds);
+
+// analyzes the statements of a scope inside the current one, the facts it finds are not kept after it
+static void analyze_range_scope(const Node_Scope scope, const Range_facts facts, Index_bounds * index_bounds) {
+  Range_facts scope_facts = copy_range_facts(facts);
+  analyze_range_statements(get_scope_statements(scope), scope.statements_count, &scope_facts, index_bounds);
+  sfree(scope_facts.facts);
+}
+
+static void analyze_range_statements(const Node_Statement * statements, const int statements_count, Range_facts * facts, Index_bounds * index_bounds) {
+  for (int i = 0; i < statements_count; i++) {
+    const Node_Statement stmt = statements[i];
+    switch (stmt.statement_type) {
+      case var_declaration_type:;
+        const Node_Var_declaration var_declaration = stmt.statement_value.var_declaration;
+        add_range_fact(facts, var_declaration.var_name, get_expresion_bound(var_declaration.value, *facts, index_bounds));
+        break;
+
+      case var_assignment_type:;
+        const Node_Var_assignment var_assignment = stmt.statement_value.var_assignment;
+        add_range_fact(facts, var_assignment.var_name, get_expresion_bound(var_assignment.value, *facts, index_bounds));
+        break;
+
+      case exit_node_type:
+        get_expresion_bound(stmt.statement_value.exit_node.exit_code, *facts, index_bounds);
+        break;
+
+      case print_type:
+        get_expresion_bound(stmt.statement_value.print.chr, *facts, index_bounds);
+        break;
+
+      case scope_type:
+        analyze_range_scope(stmt.statement_value.scope, *facts, index_bounds);
+        break;
+
+      case if_type:;
+        const Node_If if_node = stmt.statement_value.if_node;
+        get_expresion_bound(if_node.condition, *facts, index_bounds);
+        Range_facts if_facts = copy_range_facts(*facts);
+        add_condition_range_facts(&if_facts, if_node.condition);
+        analyze_range_scope(if_node.scope, if_facts, index_bounds);
+        sfree(if_facts.facts);
+        if (if_node.has_else_block) {
+          analyze_range_scope(if_node.else_block, *facts, index_bounds);
+        }
+        break;
+
+      case while_type:;
+        const Node_While while_node = stmt.statement_value.while_node;
+        // the condition and the body run after the iterations that change the variables
+        forget_written_range_facts(facts, get_scope_statements(while_node.scope), while_node.scope.statements_count);
+        get_expresion_bound(while_node.condition, *facts, index_bounds);
+        Range_facts body_facts = copy_range_facts(*facts);
+        add_condition_range_facts(&body_facts, while_node.condition);
+        analyze_range_scope(while_node.scope, body_facts, index_bounds);
+        sfree(body_facts.facts);
+        break;
+    }
+    // the variables changed in the scopes inside are not known after them
+    if (stmt.statement_type == scope_type || stmt.statement_type == if_type) {
+      forget_written_range_facts(facts, &stmt, 1);
+    }
+  }
+}
+
+// finds the bounds of the indexes of the accesses in the statements
+Index_bounds analyze_index_bounds(const Node_Statement * statements, const int statements_count) {
+  Index_bounds index_bounds = {
+    .bounds_count = active_node_pools->binary_operations.items_count,
+    .bounds = smalloc(active_node_pools->binary_operations.items_count * sizeof(*index_bounds.bounds))
+  };
+  for (int i = 0; i < index_bounds.bounds_count; i++) {
+    index_bounds.bounds[i] = -1;
+  }
+  Range_facts facts = { .facts_count = 0, .facts = smalloc(0) };
+  analyze_range_statements(statements, statements_count, &facts, &index_bounds);
+  sfree(facts.facts);
+  return index_bounds;
+}
+
+// returns a number bigger than the index of the access, or -1 if it is not known
+long long get_index_bound(const Index_bounds index_bounds, const Node_Expresion access) {
+  const Node_index index = access.expresion_value.expresion_binary_operation_value;
+  return index < (Node_index)index_bounds.bounds_count ? index_bounds.bounds[index] : -1;
+}
+
+// returns true if the index of the access is always less than the length of the array
+bool is_index_in_range(const Index_bounds index_bounds, const Node_Expresion access, const int length) {
+  const long long bound = get_index_bound(index_bounds, access);
+  return bound != -1 && bound <= length;
+}
+
+void free_index_bounds(const Index_bounds index_bounds) {
+  sfree(index_bounds.bounds);
+}
+
+// prints how many of the checks of a program are removed
+void report_removed_index_checks(const int checks_count, const int removed_checks_count) {
+  if (!is_reporting_bounds_checks) {
+    return;
+  }
+  flockfile(stderr);
+  fprintf(stderr, "Note: %d of the %d index checks are removed by the range analysis\n", removed_checks_count, checks_count);
+  funlockfile(stderr);
+}
+
+#endif
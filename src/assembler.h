@@ -0,0 +1,1134 @@
+#ifndef ASSEMBLER_H_
+#define ASSEMBLER_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "mlib.h"
+#include "errors.h"
+
+
+/* * * * * * * * * * * * * * * * * *
+ * Assembling x86-64 machine code *
+ * * * * * * * * * * * * * * * * * */
+
+// the assembler turns the NASM code written by the generator into x86-64 machine code,
+// so the programs can be run without nasm and ld
+// it only knows the instructions the generator uses, in 64 and 8 bits, and the moves in 32 and 16 bits:
+//   mov lea add sub cmp xor test mul div movzx setcc jcc jmp call push pop syscall
+// and the vector instructions of the vectorized loops, in SSE2 and AVX2:
+//   movdqu paddq psubq pxor vmovdqu vpaddq vpsubq vpxor vzeroupper
+// the constant data of the `.rodata` and `.data` sections goes after the code, in the same memory,
+// and the zeroed memory of the `.bss` section goes after them, in pages of its own that the program can write
+
+// the registers in the order of their encoding
+typedef enum Register {
+  reg_rax, reg_rcx, reg_rdx, reg_rbx, reg_rsp, reg_rbp, reg_rsi, reg_rdi,
+  reg_r8, reg_r9, reg_r10, reg_r11, reg_r12, reg_r13, reg_r14, reg_r15,
+  // there is no register
+  reg_none = -1
+} Register;
+
+static const char * const register_names_64[] = {
+  "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+  "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+
+static const char * const register_names_32[] = {
+  "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+  "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+};
+
+static const char * const register_names_16[] = {
+  "ax", "cx", "dx", "bx", "sp", "bp", "si", "di",
+  "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w"
+};
+
+static const char * const register_names_8[] = {
+  "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+  "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"
+};
+
+// the vector registers have the same encoding as the others
+static const char * const register_names_128[] = {
+  "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7",
+  "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15"
+};
+
+static const char * const register_names_256[] = {
+  "ymm0", "ymm1", "ymm2", "ymm3", "ymm4", "ymm5", "ymm6", "ymm7",
+  "ymm8", "ymm9", "ymm10", "ymm11", "ymm12", "ymm13", "ymm14", "ymm15"
+};
+
+// the condition codes of setcc and jcc, the names that mean the same have the same code
+typedef struct Condition_code {
+  const char * name;
+  uint8_t code;
+} Condition_code;
+
+static const Condition_code condition_codes[] = {
+  {"o", 0x0}, {"no", 0x1}, {"b", 0x2}, {"c", 0x2}, {"nae", 0x2}, {"ae", 0x3}, {"nb", 0x3}, {"nc", 0x3},
+  {"e", 0x4}, {"z", 0x4}, {"ne", 0x5}, {"nz", 0x5}, {"be", 0x6}, {"na", 0x6}, {"a", 0x7}, {"nbe", 0x7},
+  {"s", 0x8}, {"ns", 0x9}, {"p", 0xa}, {"pe", 0xa}, {"np", 0xb}, {"po", 0xb}, {"l", 0xc}, {"nge", 0xc},
+  {"ge", 0xd}, {"nl", 0xd}, {"le", 0xe}, {"ng", 0xe}, {"g", 0xf}, {"nle", 0xf}
+};
+
+typedef enum Operand_type {
+  operand_register,       // 64 bits register
+  operand_dword_register, // 32 bits register
+  operand_word_register,  // 16 bits register
+  operand_byte_register,  // 8 bits register
+  operand_vector_register,  // xmm or ymm register, its size is 16 or 32
+  operand_memory,
+  operand_immediate,
+  operand_label
+} Operand_type;
+
+typedef struct Operand {
+  Operand_type type;
+  // the size in bytes written before a memory operand, 0 if there is none, or the size of a vector register
+  int size;
+  Register reg;
+  // the memory address is base + index * scale + displacement, or label + displacement relative to rip
+  Register base;
+  Register index;
+  int scale;
+  int64_t displacement;
+  uint64_t immediate;
+  // the label of a jump or of an address, NULL if there is none
+  const char * label;
+  int label_length;
+} Operand;
+
+// the most operands an instruction of the generator has
+#define MAX_OPERANDS 3
+
+// the memory of the `.bss` section begins in a page of its own
+#define ASM_PAGE_SIZE 4096
+
+// the sections of the NASM code, the generator writes the constant data in `.rodata`
+typedef enum Asm_section {
+  asm_section_text,
+  asm_section_data,
+  asm_section_bss
+} Asm_section;
+
+// a label defined in the code, and the place of the code it points to
+typedef struct Asm_label {
+  const char * name;
+  int length;
+  size_t place;
+  // the place is in the data, which goes after the code, or in the bss
+  Asm_section section;
+} Asm_label;
+
+// the place of a 32 bits displacement relative to the end of the instruction, to a label and maybe a number after it,
+// it is filled when all the labels are known
+typedef struct Asm_fixup {
+  const char * name;
+  int length;
+  int64_t addend;
+  size_t place;
+  // the end of the instruction, an immediate can go after the displacement
+  size_t instruction_end;
+  int line_number;
+} Asm_fixup;
+
+typedef struct Machine_code {
+  uint8_t * bytes;
+  size_t size;
+  size_t capacity;
+  // the zeroed memory of the bss, it is not in the bytes and it begins at bss_place from the beginning of the code
+  size_t bss_place;
+  size_t bss_size;
+} Machine_code;
+
+typedef struct Assembler {
+  Machine_code code;
+  Machine_code data;
+  // the section being assembled
+  Asm_section section;
+  size_t bss_size;
+  // the place of the beginning of the code in its page, so the bss begins in a page of its own
+  size_t page_offset;
+  Asm_label * labels;
+  int labels_count;
+  int labels_capacity;
+  Asm_fixup * fixups;
+  int fixups_count;
+  int fixups_capacity;
+  // the line of the NASM code being assembled, for the errors
+  int line_number;
+  // when it is set, every syscall is replaced by this NASM code, so the program can be run inside the compiler
+  const char * syscall_code;
+} Assembler;
+
+void assemble_NASM_text(Assembler * assembler, const char * text, const size_t text_size);
+
+void free_machine_code(const Machine_code code) {
+  sfree(code.bytes);
+}
+
+// stops the assembling, the NASM code comes from the generator so any error in it is a bug in the compiler
+static void assembler_error(const Assembler * assembler, const char * message, const char * line, const int line_length) {
+  const Token line_token = { .beginning = (char *)line, .length = line_length };
+  report_error_at(0, 0, "Implementation Error: %s, in the line %d of the NASM code: %t\n", message, assembler->line_number, line_token);
+  stop_compilation(2);
+}
+
+static void emit_byte(Assembler * assembler, const uint8_t byte) {
+  if (assembler->section == asm_section_bss) {
+    implementation_error("the assembler can not put bytes in the bss");
+  }
+  Machine_code * code = assembler->section == asm_section_data ? &assembler->data : &assembler->code;
+  if (code->size == code->capacity) {
+    code->capacity = code->capacity == 0 ? 4096 : 2 * code->capacity;
+    code->bytes = srealloc(code->bytes, code->capacity);
+  }
+  code->bytes[code->size++] = byte;
+}
+
+// the numbers are little endian in x86
+static void emit_number(Assembler * assembler, const uint64_t number, const int size) {
+  for (int i = 0; i < size; i++) {
+    emit_byte(assembler, (uint8_t)(number >> (8 * i)));
+  }
+}
+
+
+/* parsing the NASM code */
+
+static bool is_asm_name_symbol(const char symbol) {
+  return (symbol >= 'a' && symbol <= 'z') || (symbol >= 'A' && symbol <= 'Z') || (symbol >= '0' && symbol <= '9')
+      || symbol == '_' || symbol == '.';
+}
+
+static bool is_asm_word(const char * text, const int length, const char * word) {
+  return (int)strlen(word) == length && strncmp(text, word, length) == 0;
+}
+
+static const char * skip_asm_spaces(const char * text, const char * end) {
+  while (text < end && (*text == ' ' || *text == '\t')) {
+    text++;
+  }
+  return text;
+}
+
+// returns the register with the name in the list of names, or reg_none
+static Register find_register(const char * const * names, const char * text, const int length) {
+  for (int i = 0; i < 16; i++) {
+    if (is_asm_word(text, length, names[i])) {
+      return (Register)i;
+    }
+  }
+  return reg_none;
+}
+
+// parses a number in decimal, or hexadecimal and binary with the prefixes `0x` and `0b`
+// returns false if the text is not a number
+static bool parse_asm_number(const char * text, const int length, uint64_t * number) {
+  int base = 10;
+  int i = 0;
+  if (length > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+    base = 16;
+    i = 2;
+  }
+  else if (length > 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B')) {
+    base = 2;
+    i = 2;
+  }
+  if (i == length) {
+    return false;
+  }
+  *number = 0;
+  for (; i < length; i++) {
+    const char symbol = text[i];
+    int digit;
+    if (symbol >= '0' && symbol <= '9') {
+      digit = symbol - '0';
+    }
+    else if (symbol >= 'a' && symbol <= 'f') {
+      digit = symbol - 'a' + 10;
+    }
+    else if (symbol >= 'A' && symbol <= 'F') {
+      digit = symbol - 'A' + 10;
+    }
+    else {
+      return false;
+    }
+    if (digit >= base) {
+      return false;
+    }
+    *number = *number * base + digit;
+  }
+  return true;
+}
+
+// parses the address inside the brackets of a memory operand: terms like `reg`, `reg * scale` and numbers
+// joined by `+` and `-`
+static bool parse_asm_address(const char * text, const char * end, Operand * operand) {
+  operand->base = reg_none;
+  operand->index = reg_none;
+  operand->scale = 1;
+  operand->displacement = 0;
+  int sign = 1;
+  while (true) {
+    text = skip_asm_spaces(text, end);
+    const char * word = text;
+    while (text < end && is_asm_name_symbol(*text)) {
+      text++;
+    }
+    const int word_length = text - word;
+    if (word_length == 0) {
+      return false;
+    }
+    uint64_t number;
+    const Register reg = find_register(register_names_64, word, word_length);
+    if (reg != reg_none) {
+      if (sign < 0) {
+        return false;
+      }
+      text = skip_asm_spaces(text, end);
+      if (text < end && *text == '*') {
+        text = skip_asm_spaces(text + 1, end);
+        const char * scale = text;
+        while (text < end && is_asm_name_symbol(*text)) {
+          text++;
+        }
+        if (operand->index != reg_none || !parse_asm_number(scale, text - scale, &number)
+            || (number != 1 && number != 2 && number != 4 && number != 8)) {
+          return false;
+        }
+        operand->index = reg;
+        operand->scale = (int)number;
+      }
+      else if (operand->base == reg_none) {
+        operand->base = reg;
+      }
+      else if (operand->index == reg_none) {
+        operand->index = reg;
+      }
+      else {
+        return false;
+      }
+    }
+    else if (parse_asm_number(word, word_length, &number)) {
+      operand->displacement += sign * (int64_t)number;
+    }
+    else if (operand->label == NULL && sign > 0) {
+      operand->label = word;
+      operand->label_length = word_length;
+    }
+    else {
+      return false;
+    }
+    text = skip_asm_spaces(text, end);
+    if (text == end) {
+      break;
+    }
+    if (*text == '+') {
+      sign = 1;
+    }
+    else if (*text == '-') {
+      sign = -1;
+    }
+    else {
+      return false;
+    }
+    text++;
+  }
+  // the addresses of the labels are relative to rip, which can not have registers
+  if (operand->label != NULL && (operand->base != reg_none || operand->index != reg_none)) {
+    return false;
+  }
+  // the stack pointer can not be an index, but with a scale of 1 it can be the base
+  if (operand->index == reg_rsp) {
+    if (operand->scale != 1 || operand->base == reg_rsp) {
+      return false;
+    }
+    operand->index = operand->base;
+    operand->base = reg_rsp;
+  }
+  return operand->displacement >= INT32_MIN && operand->displacement <= INT32_MAX;
+}
+
+// parses an operand of an instruction, returns false if it is not valid
+static bool parse_asm_operand(const char * text, const char * end, Operand * operand) {
+  text = skip_asm_spaces(text, end);
+  while (end > text && (end[-1] == ' ' || end[-1] == '\t')) {
+    end--;
+  }
+  *operand = (Operand) { .size = 0, .reg = reg_none, .base = reg_none, .index = reg_none, .scale = 1, .label = NULL };
+  const char * word = text;
+  while (text < end && is_asm_name_symbol(*text)) {
+    text++;
+  }
+  int word_length = text - word;
+  // the size of the memory operand
+  static const struct { const char * name; int size; } sizes[] = {
+    {"byte", 1}, {"word", 2}, {"dword", 4}, {"qword", 8}, {"oword", 16}, {"yword", 32}
+  };
+  for (int i = 0; i < (int)(sizeof(sizes) / sizeof(*sizes)); i++) {
+    if (is_asm_word(word, word_length, sizes[i].name)) {
+      operand->size = sizes[i].size;
+      text = skip_asm_spaces(text, end);
+      word = text;
+      word_length = 0;
+      break;
+    }
+  }
+  if (text < end && *text == '[') {
+    if (word_length != 0 || end[-1] != ']') {
+      return false;
+    }
+    operand->type = operand_memory;
+    return parse_asm_address(text + 1, end - 1, operand);
+  }
+  if (text != end || word_length == 0 || operand->size != 0) {
+    return false;
+  }
+  if ((operand->reg = find_register(register_names_64, word, word_length)) != reg_none) {
+    operand->type = operand_register;
+  }
+  else if ((operand->reg = find_register(register_names_32, word, word_length)) != reg_none) {
+    operand->type = operand_dword_register;
+  }
+  else if ((operand->reg = find_register(register_names_16, word, word_length)) != reg_none) {
+    operand->type = operand_word_register;
+  }
+  else if ((operand->reg = find_register(register_names_8, word, word_length)) != reg_none) {
+    operand->type = operand_byte_register;
+  }
+  else if ((operand->reg = find_register(register_names_128, word, word_length)) != reg_none) {
+    operand->type = operand_vector_register;
+    operand->size = 16;
+  }
+  else if ((operand->reg = find_register(register_names_256, word, word_length)) != reg_none) {
+    operand->type = operand_vector_register;
+    operand->size = 32;
+  }
+  else if (parse_asm_number(word, word_length, &operand->immediate)) {
+    operand->type = operand_immediate;
+  }
+  else {
+    operand->type = operand_label;
+    operand->label = word;
+    operand->label_length = word_length;
+  }
+  return true;
+}
+
+
+/* encoding the instructions */
+
+static bool is_register_operand(const Operand operand) {
+  return operand.type == operand_register || operand.type == operand_byte_register;
+}
+
+// the spl, bpl, sil and dil registers need a REX prefix, without it they are ah, ch, dh and bh
+static bool is_rex_byte_register(const Operand operand) {
+  return operand.type == operand_byte_register && operand.reg >= reg_rsp && operand.reg <= reg_rdi;
+}
+
+// emits the REX prefix if it is needed, `reg` is the register of the ModRM reg field and `rm` the other operand
+static void emit_rex(Assembler * assembler, const bool is_64_bits, const Register reg, const bool is_byte_reg, const Operand rm) {
+  uint8_t rex = 0x40;
+  if (is_64_bits) {
+    rex |= 0x08;
+  }
+  if (reg != reg_none && reg >= reg_r8) {
+    rex |= 0x04;
+  }
+  if (rm.type == operand_memory) {
+    if (rm.index != reg_none && rm.index >= reg_r8) {
+      rex |= 0x02;
+    }
+    if (rm.base != reg_none && rm.base >= reg_r8) {
+      rex |= 0x01;
+    }
+  }
+  else if (rm.reg >= reg_r8) {
+    rex |= 0x01;
+  }
+  const bool is_forced = (is_byte_reg && reg >= reg_rsp && reg <= reg_rdi) || is_rex_byte_register(rm);
+  if (rex != 0x40 || is_forced) {
+    emit_byte(assembler, rex);
+  }
+}
+
+static void add_asm_fixup(Assembler * assembler, const Operand label);
+
+// emits the ModRM byte, and the SIB byte and the displacement if they are needed
+static void emit_modrm(Assembler * assembler, const int reg_field, const Operand rm) {
+  const uint8_t reg_bits = (reg_field & 7) << 3;
+  if (rm.type != operand_memory) {
+    emit_byte(assembler, 0xc0 | reg_bits | (rm.reg & 7));
+    return;
+  }
+  static const uint8_t scale_bits[] = { [1] = 0, [2] = 1, [4] = 2, [8] = 3 };
+  // the address of a label is relative to the end of the instruction, which is known after its immediate
+  if (rm.label != NULL) {
+    emit_byte(assembler, 0x05 | reg_bits);
+    add_asm_fixup(assembler, rm);
+    return;
+  }
+  // without a base the address only has a 32 bits displacement, and maybe an index
+  if (rm.base == reg_none) {
+    emit_byte(assembler, 0x04 | reg_bits);
+    const uint8_t index_bits = rm.index == reg_none ? 4 : (rm.index & 7);
+    emit_byte(assembler, (scale_bits[rm.scale] << 6) | (index_bits << 3) | 5);
+    emit_number(assembler, (uint64_t)rm.displacement, 4);
+    return;
+  }
+  // rbp and r13 as the base always have a displacement
+  uint8_t mod;
+  int displacement_size;
+  if (rm.displacement == 0 && (rm.base & 7) != reg_rbp) {
+    mod = 0x00;
+    displacement_size = 0;
+  }
+  else if (rm.displacement >= INT8_MIN && rm.displacement <= INT8_MAX) {
+    mod = 0x40;
+    displacement_size = 1;
+  }
+  else {
+    mod = 0x80;
+    displacement_size = 4;
+  }
+  // rsp and r12 as the base always need the SIB byte
+  if (rm.index != reg_none || (rm.base & 7) == reg_rsp) {
+    emit_byte(assembler, mod | reg_bits | 4);
+    const uint8_t index_bits = rm.index == reg_none ? 4 : (rm.index & 7);
+    emit_byte(assembler, (scale_bits[rm.scale] << 6) | (index_bits << 3) | (rm.base & 7));
+  }
+  else {
+    emit_byte(assembler, mod | reg_bits | (rm.base & 7));
+  }
+  emit_number(assembler, (uint64_t)rm.displacement, displacement_size);
+}
+
+// emits an instruction with a ModRM operand: the prefix, the opcode and the operands
+static void emit_modrm_instruction(Assembler * assembler, const bool is_64_bits, const uint8_t * opcode, const int opcode_size,
+                                   const int reg_field, const bool is_byte_reg, const Operand rm) {
+  emit_rex(assembler, is_64_bits, (Register)reg_field, is_byte_reg, rm);
+  for (int i = 0; i < opcode_size; i++) {
+    emit_byte(assembler, opcode[i]);
+  }
+  emit_modrm(assembler, reg_field, rm);
+}
+
+// the prefixes of the vector instructions, the pp field of the VEX prefix stands for them
+#define SSE_PREFIX_66 0x66
+#define SSE_PREFIX_F3 0xf3
+#define VEX_PP_66 0x1
+#define VEX_PP_F3 0x2
+
+// emits an SSE instruction with a 0x0f opcode: its prefix goes before the REX prefix
+static void emit_sse_instruction(Assembler * assembler, const uint8_t prefix, const uint8_t opcode, const int reg_field, const Operand rm) {
+  emit_byte(assembler, prefix);
+  emit_modrm_instruction(assembler, false, (uint8_t[]) {0x0f, opcode}, 2, reg_field, false, rm);
+}
+
+// emits an AVX instruction with a 0x0f opcode, the VEX prefix has the SSE prefix, the REX bits,
+// the size of the vectors and the register of the first source, or 0 if there is none
+static void emit_vex_instruction(Assembler * assembler, const uint8_t pp, const bool is_256_bits, const uint8_t opcode,
+                                 const int reg_field, const int source, const Operand rm) {
+  const bool is_index_extended = rm.type == operand_memory && rm.index != reg_none && rm.index >= reg_r8;
+  const bool is_base_extended = rm.type == operand_memory ? rm.base != reg_none && rm.base >= reg_r8 : rm.reg >= reg_r8;
+  // the bits of the registers are inverted in the prefix
+  const uint8_t reg_bit = reg_field >= reg_r8 ? 0x00 : 0x80;
+  const uint8_t last_byte = ((~source & 0xf) << 3) | (is_256_bits ? 0x04 : 0x00) | pp;
+  if (!is_index_extended && !is_base_extended) {
+    emit_byte(assembler, 0xc5);
+    emit_byte(assembler, reg_bit | last_byte);
+  }
+  else {
+    emit_byte(assembler, 0xc4);
+    emit_byte(assembler, reg_bit | (is_index_extended ? 0x00 : 0x40) | (is_base_extended ? 0x00 : 0x20) | 0x01);
+    emit_byte(assembler, last_byte);
+  }
+  emit_byte(assembler, opcode);
+  emit_modrm(assembler, reg_field, rm);
+}
+
+static void add_asm_fixup(Assembler * assembler, const Operand label) {
+  if (assembler->fixups_count == assembler->fixups_capacity) {
+    assembler->fixups_capacity = assembler->fixups_capacity == 0 ? 64 : 2 * assembler->fixups_capacity;
+    assembler->fixups = srealloc(assembler->fixups, assembler->fixups_capacity * sizeof(*assembler->fixups));
+  }
+  assembler->fixups[assembler->fixups_count++] = (Asm_fixup) {
+    .name = label.label,
+    .length = label.label_length,
+    .addend = label.type == operand_memory ? label.displacement : 0,
+    .place = assembler->code.size,
+    .instruction_end = assembler->code.size + 4,
+    .line_number = assembler->line_number
+  };
+  // the displacement is filled at the end
+  emit_number(assembler, 0, 4);
+}
+
+static void add_asm_label(Assembler * assembler, const char * name, const int length) {
+  if (assembler->labels_count == assembler->labels_capacity) {
+    assembler->labels_capacity = assembler->labels_capacity == 0 ? 64 : 2 * assembler->labels_capacity;
+    assembler->labels = srealloc(assembler->labels, assembler->labels_capacity * sizeof(*assembler->labels));
+  }
+  assembler->labels[assembler->labels_count++] = (Asm_label) {
+    .name = name,
+    .length = length,
+    .place = assembler->section == asm_section_data ? assembler->data.size
+           : assembler->section == asm_section_bss ? assembler->bss_size : assembler->code.size,
+    .section = assembler->section
+  };
+}
+
+static bool fits_in_int32(const uint64_t number) {
+  return (int64_t)number >= INT32_MIN && (int64_t)number <= INT32_MAX;
+}
+
+// returns the condition code of the end of a setcc or jcc instruction, or -1 if it is not one
+static int find_condition_code(const char * text, const int length) {
+  for (int i = 0; i < (int)(sizeof(condition_codes) / sizeof(*condition_codes)); i++) {
+    if (is_asm_word(text, length, condition_codes[i].name)) {
+      return condition_codes[i].code;
+    }
+  }
+  return -1;
+}
+
+// encodes the `mov` instruction, returns false if the operands are not valid for it
+static bool assemble_mov(Assembler * assembler, const Operand destination, const Operand source) {
+  // 64 bits moves
+  if (destination.type == operand_register && (source.type == operand_register || source.type == operand_memory)) {
+    if (source.type == operand_memory && source.size != 0 && source.size != 8) {
+      return false;
+    }
+    emit_modrm_instruction(assembler, true, (uint8_t[]) {0x8b}, 1, destination.reg, false, source);
+    return true;
+  }
+  if (destination.type == operand_memory && source.type == operand_register) {
+    if (destination.size != 0 && destination.size != 8) {
+      return false;
+    }
+    emit_modrm_instruction(assembler, true, (uint8_t[]) {0x89}, 1, source.reg, false, destination);
+    return true;
+  }
+  if (destination.type == operand_register && source.type == operand_immediate) {
+    // the smallest encoding that keeps the value, writing the 32 bits register clears the upper half
+    if (source.immediate <= UINT32_MAX) {
+      emit_rex(assembler, false, reg_none, false, destination);
+      emit_byte(assembler, 0xb8 + (destination.reg & 7));
+      emit_number(assembler, source.immediate, 4);
+    }
+    else if (fits_in_int32(source.immediate)) {
+      emit_modrm_instruction(assembler, true, (uint8_t[]) {0xc7}, 1, 0, false, destination);
+      emit_number(assembler, source.immediate, 4);
+    }
+    else {
+      emit_rex(assembler, true, reg_none, false, destination);
+      emit_byte(assembler, 0xb8 + (destination.reg & 7));
+      emit_number(assembler, source.immediate, 8);
+    }
+    return true;
+  }
+  if (destination.type == operand_memory && destination.size == 8 && source.type == operand_immediate) {
+    if (fits_in_int32(source.immediate)) {
+      emit_modrm_instruction(assembler, true, (uint8_t[]) {0xc7}, 1, 0, false, destination);
+      emit_number(assembler, source.immediate, 4);
+      return true;
+    }
+    // there is no move of a 64 bits number into memory, it goes through r11,
+    // the generator never uses it and the syscalls clobber it anyway
+    const Operand scratch = { .type = operand_register, .reg = reg_r11 };
+    return assemble_mov(assembler, scratch, source) && assemble_mov(assembler, destination, scratch);
+  }
+  // 8 bits moves
+  if (destination.type == operand_byte_register && (source.type == operand_byte_register || source.type == operand_memory)) {
+    if (source.type == operand_memory && source.size != 0 && source.size != 1) {
+      return false;
+    }
+    emit_modrm_instruction(assembler, false, (uint8_t[]) {0x8a}, 1, destination.reg, true, source);
+    return true;
+  }
+  if (destination.type == operand_memory && source.type == operand_byte_register) {
+    if (destination.size != 0 && destination.size != 1) {
+      return false;
+    }
+    emit_modrm_instruction(assembler, false, (uint8_t[]) {0x88}, 1, source.reg, true, destination);
+    return true;
+  }
+  if (destination.type == operand_memory && destination.size == 1 && source.type == operand_immediate) {
+    emit_modrm_instruction(assembler, false, (uint8_t[]) {0xc6}, 1, 0, false, destination);
+    emit_number(assembler, source.immediate, 1);
+    return true;
+  }
+  // 32 bits moves, writing the register clears its upper half
+  if (destination.type == operand_dword_register && (source.type == operand_dword_register || source.type == operand_memory)) {
+    if (source.type == operand_memory && source.size != 0 && source.size != 4) {
+      return false;
+    }
+    emit_modrm_instruction(assembler, false, (uint8_t[]) {0x8b}, 1, destination.reg, false, source);
+    return true;
+  }
+  if (destination.type == operand_memory && source.type == operand_dword_register) {
+    if (destination.size != 0 && destination.size != 4) {
+      return false;
+    }
+    emit_modrm_instruction(assembler, false, (uint8_t[]) {0x89}, 1, source.reg, false, destination);
+    return true;
+  }
+  // 16 bits moves, with the prefix of the operand size
+  if (destination.type == operand_word_register && (source.type == operand_word_register || source.type == operand_memory)) {
+    if (source.type == operand_memory && source.size != 0 && source.size != 2) {
+      return false;
+    }
+    emit_byte(assembler, 0x66);
+    emit_modrm_instruction(assembler, false, (uint8_t[]) {0x8b}, 1, destination.reg, false, source);
+    return true;
+  }
+  if (destination.type == operand_memory && source.type == operand_word_register) {
+    if (destination.size != 0 && destination.size != 2) {
+      return false;
+    }
+    emit_byte(assembler, 0x66);
+    emit_modrm_instruction(assembler, false, (uint8_t[]) {0x89}, 1, source.reg, false, destination);
+    return true;
+  }
+  return false;
+}
+
+// the arithmetic instructions that have the same forms, and the ModRM reg field of their immediate form
+static const struct {
+  const char * name;
+  uint8_t opcode;
+  uint8_t immediate_field;
+} arithmetic_instructions[] = {
+  {"add", 0x01, 0}, {"or", 0x09, 1}, {"and", 0x21, 4}, {"sub", 0x29, 5}, {"xor", 0x31, 6}, {"cmp", 0x39, 7}
+};
+
+// the vector instructions that add, subtract and xor 64 bits integers, their AVX names begin with `v`
+static const struct {
+  const char * name;
+  uint8_t opcode;
+} vector_arithmetic_instructions[] = {
+  {"paddq", 0xd4}, {"psubq", 0xfb}, {"pxor", 0xef}
+};
+
+// a vector register or a memory operand of its size
+static bool is_vector_operand(const Operand operand, const int size) {
+  return (operand.type == operand_vector_register || operand.type == operand_memory)
+      && (operand.size == size || (operand.type == operand_memory && operand.size == 0));
+}
+
+// encodes one SSE2 or AVX2 instruction, returns false if it is not one or its operands are not valid for it
+static bool assemble_vector_instruction(Assembler * assembler, const char * name, const int name_length, const Operand * operands, const int operands_count) {
+  if (operands_count == 0 && is_asm_word(name, name_length, "vzeroupper")) {
+    emit_byte(assembler, 0xc5);
+    emit_byte(assembler, 0xf8);
+    emit_byte(assembler, 0x77);
+    return true;
+  }
+  const Operand first = operands[0];
+  const Operand second = operands[1];
+  const bool is_avx = name_length > 1 && name[0] == 'v';
+  const char * sse_name = is_avx ? name + 1 : name;
+  const int sse_name_length = is_avx ? name_length - 1 : name_length;
+  if (operands_count == 2 && is_asm_word(sse_name, sse_name_length, "movdqu")) {
+    const int size = first.type == operand_vector_register ? first.size : second.size;
+    if ((size != 16 && !is_avx) || (size != 16 && size != 32) || !is_vector_operand(first, size) || !is_vector_operand(second, size)) {
+      return false;
+    }
+    // the load form has the register in the ModRM reg field, and the store form the other way around
+    const bool is_load = first.type == operand_vector_register;
+    const Operand reg = is_load ? first : second;
+    const Operand rm = is_load ? second : first;
+    if (is_avx) {
+      emit_vex_instruction(assembler, VEX_PP_F3, size == 32, is_load ? 0x6f : 0x7f, reg.reg, 0, rm);
+    }
+    else {
+      emit_sse_instruction(assembler, SSE_PREFIX_F3, is_load ? 0x6f : 0x7f, reg.reg, rm);
+    }
+    return true;
+  }
+  for (int i = 0; i < (int)(sizeof(vector_arithmetic_instructions) / sizeof(*vector_arithmetic_instructions)); i++) {
+    if (!is_asm_word(sse_name, sse_name_length, vector_arithmetic_instructions[i].name)) {
+      continue;
+    }
+    const uint8_t opcode = vector_arithmetic_instructions[i].opcode;
+    // the SSE memory operands must be aligned, the generator only uses them with registers
+    if (!is_avx && operands_count == 2 && first.type == operand_vector_register && first.size == 16
+        && second.type == operand_vector_register && second.size == 16) {
+      emit_sse_instruction(assembler, SSE_PREFIX_66, opcode, first.reg, second);
+      return true;
+    }
+    // the destination and the first source are registers of the same size
+    if (is_avx && operands_count == 3 && first.type == operand_vector_register && second.type == operand_vector_register
+        && first.size == second.size && is_vector_operand(operands[2], first.size)) {
+      emit_vex_instruction(assembler, VEX_PP_66, first.size == 32, opcode, first.reg, second.reg, operands[2]);
+      return true;
+    }
+    return false;
+  }
+  return false;
+}
+
+// encodes one instruction, returns false if it is not known or its operands are not valid for it
+static bool assemble_instruction(Assembler * assembler, const char * name, const int name_length, const Operand * operands, const int operands_count) {
+  if (assemble_vector_instruction(assembler, name, name_length, operands, operands_count)) {
+    return true;
+  }
+  const Operand first = operands[0];
+  const Operand second = operands[1];
+  if (operands_count == 0) {
+    if (is_asm_word(name, name_length, "syscall") && assembler->syscall_code != NULL) {
+      // the replacement has no syscalls, and its errors are about the line of the syscall
+      const char * syscall_code = assembler->syscall_code;
+      const int line_number = assembler->line_number;
+      assembler->syscall_code = NULL;
+      assemble_NASM_text(assembler, syscall_code, strlen(syscall_code));
+      assembler->syscall_code = syscall_code;
+      assembler->line_number = line_number;
+      return true;
+    }
+    if (is_asm_word(name, name_length, "syscall")) {
+      emit_byte(assembler, 0x0f);
+      emit_byte(assembler, 0x05);
+      return true;
+    }
+    if (is_asm_word(name, name_length, "ret")) {
+      emit_byte(assembler, 0xc3);
+      return true;
+    }
+    return false;
+  }
+
+  if (operands_count == 1) {
+    if (is_asm_word(name, name_length, "push") || is_asm_word(name, name_length, "pop")) {
+      if (first.type != operand_register) {
+        return false;
+      }
+      emit_rex(assembler, false, reg_none, false, first);
+      emit_byte(assembler, (name[1] == 'u' ? 0x50 : 0x58) + (first.reg & 7));
+      return true;
+    }
+    // the only string instruction, it copies rcx qwords from rsi to rdi
+    if (is_asm_word(name, name_length, "rep") && first.type == operand_label && is_asm_word(first.label, first.label_length, "movsq")) {
+      emit_byte(assembler, 0xf3);
+      emit_byte(assembler, 0x48);
+      emit_byte(assembler, 0xa5);
+      return true;
+    }
+    if (is_asm_word(name, name_length, "call") && first.type == operand_register) {
+      emit_rex(assembler, false, reg_none, false, first);
+      emit_byte(assembler, 0xff);
+      emit_modrm(assembler, 2, first);
+      return true;
+    }
+    if (is_asm_word(name, name_length, "mul") || is_asm_word(name, name_length, "div")) {
+      if (first.type != operand_register && (first.type != operand_memory || first.size != 8)) {
+        return false;
+      }
+      emit_modrm_instruction(assembler, true, (uint8_t[]) {0xf7}, 1, name[0] == 'm' ? 4 : 6, false, first);
+      return true;
+    }
+    if (first.type == operand_label && is_asm_word(name, name_length, "jmp")) {
+      emit_byte(assembler, 0xe9);
+      add_asm_fixup(assembler, first);
+      return true;
+    }
+    if (name_length > 1 && name[0] == 'j' && first.type == operand_label) {
+      const int condition = find_condition_code(name + 1, name_length - 1);
+      if (condition < 0) {
+        return false;
+      }
+      emit_byte(assembler, 0x0f);
+      emit_byte(assembler, 0x80 + condition);
+      add_asm_fixup(assembler, first);
+      return true;
+    }
+    if (name_length > 3 && strncmp(name, "set", 3) == 0) {
+      const int condition = find_condition_code(name + 3, name_length - 3);
+      if (condition < 0 || (first.type != operand_byte_register && (first.type != operand_memory || first.size != 1))) {
+        return false;
+      }
+      emit_modrm_instruction(assembler, false, (uint8_t[]) {0x0f, 0x90 + condition}, 2, 0, false, first);
+      return true;
+    }
+    return false;
+  }
+
+  if (operands_count != 2) {
+    return false;
+  }
+  if (is_asm_word(name, name_length, "mov")) {
+    return assemble_mov(assembler, first, second);
+  }
+  if (is_asm_word(name, name_length, "lea")) {
+    if (first.type != operand_register || second.type != operand_memory) {
+      return false;
+    }
+    emit_modrm_instruction(assembler, true, (uint8_t[]) {0x8d}, 1, first.reg, false, second);
+    return true;
+  }
+  if (is_asm_word(name, name_length, "movzx")) {
+    const bool is_byte = second.type == operand_byte_register || (second.type == operand_memory && second.size == 1);
+    const bool is_word = second.type == operand_word_register || (second.type == operand_memory && second.size == 2);
+    if (first.type != operand_register || (!is_byte && !is_word)) {
+      return false;
+    }
+    emit_modrm_instruction(assembler, true, (uint8_t[]) {0x0f, is_byte ? 0xb6 : 0xb7}, 2, first.reg, false, second);
+    return true;
+  }
+  if (is_asm_word(name, name_length, "test")) {
+    if (!is_register_operand(second) || (first.type != second.type && first.type != operand_memory)) {
+      return false;
+    }
+    const bool is_byte = second.type == operand_byte_register;
+    emit_modrm_instruction(assembler, !is_byte, (uint8_t[]) {is_byte ? 0x84 : 0x85}, 1, second.reg, is_byte, first);
+    return true;
+  }
+  for (int i = 0; i < (int)(sizeof(arithmetic_instructions) / sizeof(*arithmetic_instructions)); i++) {
+    if (!is_asm_word(name, name_length, arithmetic_instructions[i].name)) {
+      continue;
+    }
+    const uint8_t opcode = arithmetic_instructions[i].opcode;
+    // register or memory with a register
+    if (second.type == operand_register && (first.type == operand_register || (first.type == operand_memory && first.size != 1))) {
+      emit_modrm_instruction(assembler, true, (uint8_t[]) {opcode}, 1, second.reg, false, first);
+      return true;
+    }
+    // register with memory
+    if (first.type == operand_register && second.type == operand_memory && second.size != 1) {
+      emit_modrm_instruction(assembler, true, (uint8_t[]) {opcode + 2}, 1, first.reg, false, second);
+      return true;
+    }
+    // register or memory with a number
+    if (second.type == operand_immediate && fits_in_int32(second.immediate)
+        && (first.type == operand_register || (first.type == operand_memory && first.size == 8))) {
+      const bool is_small = (int64_t)second.immediate >= INT8_MIN && (int64_t)second.immediate <= INT8_MAX;
+      emit_modrm_instruction(assembler, true, (uint8_t[]) {is_small ? 0x83 : 0x81}, 1, arithmetic_instructions[i].immediate_field, false, first);
+      emit_number(assembler, second.immediate, is_small ? 1 : 4);
+      return true;
+    }
+    return false;
+  }
+  return false;
+}
+
+// assembles a line of NASM code: a directive, a label, an instruction or nothing
+static void assemble_line(Assembler * assembler, const char * line, const char * end) {
+  const char * line_beginning = line;
+  // remove the comment
+  const char * comment = memchr(line, ';', end - line);
+  if (comment != NULL) {
+    end = comment;
+  }
+  line = skip_asm_spaces(line, end);
+  while (end > line && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+    end--;
+  }
+  if (line == end) {
+    return;
+  }
+  const char * name = line;
+  while (line < end && is_asm_name_symbol(*line)) {
+    line++;
+  }
+  const int name_length = line - name;
+  if (name_length == 0) {
+    assembler_error(assembler, "the assembler can not read the line", line_beginning, end - line_beginning);
+  }
+  // a label
+  if (line < end && *line == ':') {
+    add_asm_label(assembler, name, name_length);
+    return;
+  }
+  // the directives do not change the code, the output is always 64 bits and the addresses of labels relative to rip
+  if (is_asm_word(name, name_length, "bits") || is_asm_word(name, name_length, "default") || is_asm_word(name, name_length, "global")) {
+    return;
+  }
+  // the sections of the data are together after the code, they are read only, and the bss is the only memory written
+  if (is_asm_word(name, name_length, "section")) {
+    line = skip_asm_spaces(line, end);
+    if (is_asm_word(line, end - line, ".text")) {
+      assembler->section = asm_section_text;
+    }
+    else if (is_asm_word(line, end - line, ".rodata") || is_asm_word(line, end - line, ".data")) {
+      assembler->section = asm_section_data;
+    }
+    else if (is_asm_word(line, end - line, ".bss")) {
+      assembler->section = asm_section_bss;
+    }
+    else {
+      assembler_error(assembler, "the assembler does not know the section", line_beginning, end - line_beginning);
+    }
+    return;
+  }
+  // bytes, words, dwords or qwords of data, the numbers are separated by commas
+  if (is_asm_word(name, name_length, "db") || is_asm_word(name, name_length, "dw") || is_asm_word(name, name_length, "dd")
+      || is_asm_word(name, name_length, "dq")) {
+    const int number_size = name[1] == 'b' ? 1 : name[1] == 'w' ? 2 : name[1] == 'd' ? 4 : 8;
+    while (line < end) {
+      line = skip_asm_spaces(line, end);
+      const char * number_end = line;
+      while (number_end < end && *number_end != ',') {
+        number_end++;
+      }
+      const char * number_text_end = number_end;
+      while (number_text_end > line && (number_text_end[-1] == ' ' || number_text_end[-1] == '\t')) {
+        number_text_end--;
+      }
+      uint64_t number;
+      if (!parse_asm_number(line, number_text_end - line, &number)) {
+        assembler_error(assembler, "the assembler can not read the data", line_beginning, end - line_beginning);
+      }
+      emit_number(assembler, number, number_size);
+      line = number_end == end ? end : number_end + 1;
+    }
+    return;
+  }
+  // bytes, words, dwords or qwords of the bss
+  if (assembler->section == asm_section_bss) {
+    uint64_t count;
+    line = skip_asm_spaces(line, end);
+    if (name_length != 4 || strncmp(name, "res", 3) != 0 || strchr("bwdq", name[3]) == NULL || !parse_asm_number(line, end - line, &count)) {
+      assembler_error(assembler, "the assembler can not read the bss", line_beginning, end - line_beginning);
+    }
+    assembler->bss_size += count * (name[3] == 'b' ? 1 : name[3] == 'w' ? 2 : name[3] == 'd' ? 4 : 8);
+    return;
+  }
+  Operand operands[MAX_OPERANDS] = {};
+  int operands_count = 0;
+  line = skip_asm_spaces(line, end);
+  while (line < end) {
+    // the operands are separated by commas
+    const char * operand_end = memchr(line, ',', end - line);
+    if (operand_end == NULL) {
+      operand_end = end;
+    }
+    if (operands_count == MAX_OPERANDS || !parse_asm_operand(line, operand_end, &operands[operands_count])) {
+      assembler_error(assembler, "the assembler can not read the operands", line_beginning, end - line_beginning);
+    }
+    operands_count++;
+    line = operand_end == end ? end : operand_end + 1;
+  }
+  const int fixups_count = assembler->fixups_count;
+  if (!assemble_instruction(assembler, name, name_length, operands, operands_count)) {
+    assembler_error(assembler, "the assembler does not know the instruction", line_beginning, end - line_beginning);
+  }
+  for (int i = fixups_count; i < assembler->fixups_count; i++) {
+    assembler->fixups[i].instruction_end = assembler->code.size;
+  }
+}
+
+static int compare_asm_names(const char * name1, const int length1, const char * name2, const int length2) {
+  const int common_length = length1 < length2 ? length1 : length2;
+  const int comparison = strncmp(name1, name2, common_length);
+  return comparison != 0 ? comparison : length1 - length2;
+}
+
+static int compare_asm_labels(const void * label1, const void * label2) {
+  const Asm_label * first = label1;
+  const Asm_label * second = label2;
+  return compare_asm_names(first->name, first->length, second->name, second->length);
+}
+
+// fills the displacements of the jumps once the places of all the labels are known
+static void resolve_asm_fixups(Assembler * assembler) {
+  // the labels are sorted so each jump finds its label with a binary search
+  qsort(assembler->labels, assembler->labels_count, sizeof(*assembler->labels), compare_asm_labels);
+  for (int i = 1; i < assembler->labels_count; i++) {
+    if (compare_asm_labels(&assembler->labels[i -1], &assembler->labels[i]) == 0) {
+      assembler->line_number = 0;
+      assembler_error(assembler, "a label is defined more than once", assembler->labels[i].name, assembler->labels[i].length);
+    }
+  }
+  for (int i = 0; i < assembler->fixups_count; i++) {
+    const Asm_fixup fixup = assembler->fixups[i];
+    const Asm_label key = { .name = fixup.name, .length = fixup.length };
+    const Asm_label * label = bsearch(&key, assembler->labels, assembler->labels_count, sizeof(*assembler->labels), compare_asm_labels);
+    if (label == NULL) {
+      assembler->line_number = fixup.line_number;
+      assembler_error(assembler, "the jump goes to an unknown label", fixup.name, fixup.length);
+    }
+    // the displacement is from the end of the instruction
+    const int64_t displacement = (int64_t)label->place + fixup.addend - (int64_t)fixup.instruction_end;
+    if (displacement < INT32_MIN || displacement > INT32_MAX) {
+      implementation_error("a jump is too far for the assembler");
+    }
+    memcpy(assembler->code.bytes + fixup.place, &(int32_t){ (int32_t)displacement }, 4);
+  }
+}
+
+Assembler begin_assembler(const char * syscall_code) {
+  return (Assembler) {
+    .code = { .bytes = NULL, .size = 0, .capacity = 0, .bss_place = 0, .bss_size = 0 },
+    .data = { .bytes = NULL, .size = 0, .capacity = 0, .bss_place = 0, .bss_size = 0 },
+    .section = asm_section_text,
+    .bss_size = 0,
+    .page_offset = 0,
+    .labels = NULL, .labels_count = 0, .labels_capacity = 0,
+    .fixups = NULL, .fixups_count = 0, .fixups_capacity = 0,
+    .line_number = 0,
+    .syscall_code = syscall_code
+  };
+}
+
+// assembles the NASM code in the text after the code assembled before
+// the labels point into the text, so it must be kept until the end of the assembling
+void assemble_NASM_text(Assembler * assembler, const char * text, const size_t text_size) {
+  const char * end = text + text_size;
+  while (text < end) {
+    assembler->line_number++;
+    const char * line_end = memchr(text, '\n', end - text);
+    if (line_end == NULL) {
+      line_end = end;
+    }
+    assemble_line(assembler, text, line_end);
+    text = line_end + 1;
+  }
+}
+
+// ends the assembling, the jumps get the places of their labels
+Machine_code end_assembler(Assembler * assembler) {
+  // the data goes after the code, aligned for its qwords
+  assembler->section = asm_section_text;
+  while (assembler->code.size % 8 != 0) {
+    emit_byte(assembler, 0xcc);
+  }
+  const size_t data_place = assembler->code.size;
+  for (size_t i = 0; i < assembler->data.size; i++) {
+    emit_byte(assembler, assembler->data.bytes[i]);
+  }
+  // and the bss after them, in the next page
+  if (assembler->bss_size > 0) {
+    const size_t end_place = assembler->page_offset + assembler->code.size;
+    assembler->code.bss_place = (end_place + ASM_PAGE_SIZE -1) / ASM_PAGE_SIZE * ASM_PAGE_SIZE - assembler->page_offset;
+    assembler->code.bss_size = assembler->bss_size;
+  }
+  for (int i = 0; i < assembler->labels_count; i++) {
+    if (assembler->labels[i].section == asm_section_data) {
+      assembler->labels[i].place += data_place;
+    }
+    else if (assembler->labels[i].section == asm_section_bss) {
+      assembler->labels[i].place += assembler->code.bss_place;
+    }
+  }
+  free_machine_code(assembler->data);
+  resolve_asm_fixups(assembler);
+  sfree(assembler->labels);
+  sfree(assembler->fixups);
+  return assembler->code;
+}
+
+// assembles the NASM code in the text into machine code, the code begins with the first instruction
+// at the offset in its page of memory
+Machine_code assemble_NASM_code(const char * text, const size_t text_size, const size_t page_offset) {
+  Assembler assembler = begin_assembler(NULL);
+  assembler.page_offset = page_offset;
+  assemble_NASM_text(&assembler, text, text_size);
+  return end_assembler(&assembler);
+}
+
+#endif
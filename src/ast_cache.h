@@ -0,0 +1,348 @@
+#ifndef AST_CACHE_H_
+#define AST_CACHE_H_
+
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mlib.h"
+#include "errors.h"
+#include "tokenizer.h"
+#include "parser.h"
+
+
+/* * * * * * * * * * * * * *
+ * Syntax tree cache files *
+ * * * * * * * * * * * * * */
+
+// the checked syntax tree of a program is saved in a file, so the code can be generated from it
+// later without lexing, parsing and checking the program again
+// the file has the text of the source code, the top level statements and the node pools one after the other,
+// the nodes reference each other by their index in the pools, so the pools use the file mapped in memory
+// as it is, only the tokens point into the text and have their offset in it in the file
+
+#define AST_CACHE_MAGIC "BONEAST"
+// it changes every time the format of the file changes
+#define AST_CACHE_VERSION 3
+// every part of the file begins at a multiple of it, so the nodes are aligned when the file is mapped
+#define AST_CACHE_ALIGNMENT 16
+#define NODE_POOLS_COUNT 6
+
+// a part of the file, the count is in bytes for the text and in nodes for the rest
+typedef struct Ast_cache_section {
+  uint64_t offset;
+  uint64_t count;
+} Ast_cache_section;
+
+typedef struct Ast_cache_header {
+  char magic[8];
+  uint32_t version;
+  // the sizes of the tokens and the nodes, a compiler where they are not the same can not read the file
+  uint32_t token_size;
+  uint32_t node_sizes[NODE_POOLS_COUNT];
+  Ast_cache_section text;
+  Ast_cache_section statements;
+  Ast_cache_section pools[NODE_POOLS_COUNT];
+} Ast_cache_header;
+
+// a syntax tree cache file mapped in memory
+typedef struct Ast_cache {
+  char * mapping;
+  size_t mapping_size;
+  char * text;
+  // the top level statements are in the mapping
+  Node_Program syntax_tree;
+  Node_pools * pools;
+} Ast_cache;
+
+static Pool * get_node_pool(Node_pools * pools, const int idx) {
+  Pool * node_pools[NODE_POOLS_COUNT] = {
+    &pools->statements,
+    &pools->expresions,
+    &pools->binary_operations,
+    &pools->unary_operations,
+    &pools->types,
+    &pools->array_types
+  };
+  return node_pools[idx];
+}
+
+static void check_ast_cache(const bool is_correct) {
+  if (!is_correct) {
+    error("the syntax tree cache file is damaged, save it again");
+  }
+}
+
+
+/* moving the tokens between the text and the file */
+
+// in the file the beginning of a token is its offset in the text plus 1, or 0 if it has no text
+typedef struct Token_relocation {
+  char * text;
+  size_t text_size;
+  bool is_loading;
+} Token_relocation;
+
+static void relocate_token(const Token_relocation * relocation, Token * token) {
+  if (relocation->is_loading) {
+    const uintptr_t place = (uintptr_t) token->beginning;
+    check_ast_cache(place == 0 || (token->length >= 0 && place - 1 + token->length <= relocation->text_size));
+    token->beginning = place == 0 ? NULL : relocation->text + (place - 1);
+  }
+  else if (token->beginning != NULL) {
+    if (token->beginning < relocation->text || token->beginning > relocation->text + relocation->text_size) {
+      implementation_error("a token of the syntax tree is not in the source code");
+    }
+    token->beginning = (char *) (uintptr_t) (token->beginning - relocation->text + 1);
+  }
+}
+
+// the indexes of a file can not be trusted, the nodes they reference must be in the pool
+static void check_node_indexes(const Token_relocation * relocation, const Pool * pool, const Node_index idx, const int count) {
+  if (relocation->is_loading) {
+    check_ast_cache(count >= 0 && (uint64_t) idx + count <= pool->items_count);
+  }
+}
+
+static void relocate_type(const Token_relocation * relocation, Node_Type * type) {
+  relocate_token(relocation, &type->token);
+  switch (type->type_type) {
+    case type_primitive_type:
+      relocate_token(relocation, &type->type_value.type_primitive_value);
+      break;
+    case type_ptr_type:
+      check_node_indexes(relocation, &active_node_pools->types, type->type_value.type_ptr_value, 1);
+      relocate_type(relocation, get_pointed_type(*type));
+      break;
+    case type_array_type: {
+      check_node_indexes(relocation, &active_node_pools->array_types, type->type_value.type_array_value, 1);
+      Node_Array_type * array_type = get_array_type(*type);
+      relocate_token(relocation, &array_type->elements_count);
+      check_node_indexes(relocation, &active_node_pools->types, array_type->primitive_type, 1);
+      relocate_type(relocation, get_type(array_type->primitive_type));
+      break;
+    }
+    default:
+      check_ast_cache(false);
+  }
+}
+
+static void relocate_expresion(const Token_relocation * relocation, Node_Expresion * expresion) {
+  switch (expresion->expresion_type) {
+    case expresion_number_type:
+      relocate_token(relocation, &expresion->expresion_value.expresion_number_value);
+      break;
+    case expresion_identifier_type:
+      relocate_token(relocation, &expresion->expresion_value.expresion_identifier_value);
+      break;
+    case expresion_binary_operation_type:
+      check_node_indexes(relocation, &active_node_pools->binary_operations, expresion->expresion_value.expresion_binary_operation_value, 1);
+      relocate_expresion(relocation, &get_binary_operation(*expresion)->left_side);
+      relocate_expresion(relocation, &get_binary_operation(*expresion)->right_side);
+      break;
+    case expresion_unary_operation_type:
+      check_node_indexes(relocation, &active_node_pools->unary_operations, expresion->expresion_value.expresion_unary_operation_value, 1);
+      relocate_expresion(relocation, &get_unary_operation(*expresion)->expresion);
+      break;
+    case expresion_array_type: {
+      const Node_Array array = expresion->expresion_value.expresion_array_value;
+      check_node_indexes(relocation, &active_node_pools->expresions, array.elements, array.elements_count);
+      for (int i = 0; i < array.elements_count; i++) {
+        relocate_expresion(relocation, &get_array_elements(array)[i]);
+      }
+      break;
+    }
+    default:
+      check_ast_cache(false);
+  }
+}
+
+static void relocate_statement(const Token_relocation * relocation, Node_Statement * stmt);
+
+static void relocate_scope(const Token_relocation * relocation, const Node_Scope scope) {
+  check_node_indexes(relocation, &active_node_pools->statements, scope.statements, scope.statements_count);
+  for (int i = 0; i < scope.statements_count; i++) {
+    relocate_statement(relocation, &get_scope_statements(scope)[i]);
+  }
+}
+
+static void relocate_statement(const Token_relocation * relocation, Node_Statement * stmt) {
+  switch (stmt->statement_type) {
+    case var_declaration_type:
+      relocate_token(relocation, &stmt->statement_value.var_declaration.var_name);
+      relocate_type(relocation, &stmt->statement_value.var_declaration.type);
+      relocate_expresion(relocation, &stmt->statement_value.var_declaration.value);
+      break;
+    case exit_node_type:
+      relocate_expresion(relocation, &stmt->statement_value.exit_node.exit_code);
+      break;
+    case var_assignment_type:
+      relocate_token(relocation, &stmt->statement_value.var_assignment.var_name);
+      relocate_expresion(relocation, &stmt->statement_value.var_assignment.value);
+      break;
+    case scope_type:
+      relocate_scope(relocation, stmt->statement_value.scope);
+      break;
+    case if_type:
+      relocate_expresion(relocation, &stmt->statement_value.if_node.condition);
+      relocate_scope(relocation, stmt->statement_value.if_node.scope);
+      if (stmt->statement_value.if_node.has_else_block) {
+        relocate_scope(relocation, stmt->statement_value.if_node.else_block);
+      }
+      break;
+    case print_type:
+      relocate_expresion(relocation, &stmt->statement_value.print.chr);
+      break;
+    case while_type:
+      relocate_expresion(relocation, &stmt->statement_value.while_node.condition);
+      relocate_scope(relocation, stmt->statement_value.while_node.scope);
+      break;
+    default:
+      check_ast_cache(false);
+  }
+}
+
+static void relocate_syntax_tree(const Token_relocation * relocation, const Node_Program syntax_tree) {
+  for (int i = 0; i < syntax_tree.statements_count; i++) {
+    relocate_statement(relocation, &syntax_tree.statements_node[i]);
+  }
+}
+
+
+/* writing and loading the files */
+
+static uint64_t align_ast_cache_offset(const uint64_t offset) {
+  return (offset + AST_CACHE_ALIGNMENT - 1) / AST_CACHE_ALIGNMENT * AST_CACHE_ALIGNMENT;
+}
+
+static void write_ast_cache_padding(FILE * file_ptr, const uint64_t offset) {
+  for (uint64_t i = offset; i < align_ast_cache_offset(offset); i++) {
+    fputc('\0', file_ptr);
+  }
+}
+
+// saves the syntax tree of the text in the file, its nodes are the ones in the active pools
+// the tokens must point into the text, and the checker must not have added nodes to the pools
+void write_ast_cache(const char * file_path, char * text, const Node_Program syntax_tree) {
+  const size_t text_size = strlen(text);
+  Ast_cache_header header = {
+    .magic = AST_CACHE_MAGIC,
+    .version = AST_CACHE_VERSION,
+    .token_size = sizeof(Token)
+  };
+  uint64_t offset = align_ast_cache_offset(sizeof(header));
+  header.text = (Ast_cache_section) { .offset = offset, .count = text_size + 1 };
+  offset = align_ast_cache_offset(offset + header.text.count);
+  header.statements = (Ast_cache_section) { .offset = offset, .count = syntax_tree.statements_count };
+  offset = align_ast_cache_offset(offset + header.statements.count * sizeof(Node_Statement));
+  for (int i = 0; i < NODE_POOLS_COUNT; i++) {
+    const Pool * pool = get_node_pool(active_node_pools, i);
+    header.node_sizes[i] = pool->item_size;
+    header.pools[i] = (Ast_cache_section) { .offset = offset, .count = pool->items_count };
+    offset = align_ast_cache_offset(offset + header.pools[i].count * pool->item_size);
+  }
+
+  // a process that has mapped the old file keeps reading it
+  remove(file_path);
+  FILE * file_ptr = create_file(file_path);
+  // the tokens have their offsets in the text only while the nodes are written
+  Token_relocation relocation = { .text = text, .text_size = text_size, .is_loading = false };
+  relocate_syntax_tree(&relocation, syntax_tree);
+  fwrite(&header, sizeof(header), 1, file_ptr);
+  write_ast_cache_padding(file_ptr, sizeof(header));
+  fwrite(text, 1, header.text.count, file_ptr);
+  write_ast_cache_padding(file_ptr, header.text.offset + header.text.count);
+  fwrite(syntax_tree.statements_node, sizeof(Node_Statement), header.statements.count, file_ptr);
+  write_ast_cache_padding(file_ptr, header.statements.offset + header.statements.count * sizeof(Node_Statement));
+  for (int i = 0; i < NODE_POOLS_COUNT; i++) {
+    const Pool * pool = get_node_pool(active_node_pools, i);
+    write_pool(file_ptr, pool);
+    write_ast_cache_padding(file_ptr, header.pools[i].offset + header.pools[i].count * pool->item_size);
+  }
+  relocation.is_loading = true;
+  relocate_syntax_tree(&relocation, syntax_tree);
+
+  const bool is_written = !ferror(file_ptr);
+  if (fclose(file_ptr) != 0 || !is_written) {
+    remove(file_path);
+    errorf("File Error: Can not write the syntax tree cache file: %s\n", file_path);
+  }
+}
+
+static bool is_section_in_file(const Ast_cache_section section, const size_t item_size, const size_t file_size) {
+  return section.offset % AST_CACHE_ALIGNMENT == 0 && section.offset <= file_size
+      && section.count <= (file_size - section.offset) / item_size;
+}
+
+// maps the file in memory, only the pages with tokens are copied when the tokens are moved into the text
+Ast_cache * load_ast_cache(const char * file_path) {
+  const int file_descriptor = open(file_path, O_RDONLY);
+  if (file_descriptor < 0) {
+    errorf("File Error: Can not open the syntax tree cache file: %s\n", file_path);
+  }
+  struct stat file_info;
+  if (fstat(file_descriptor, &file_info) != 0 || file_info.st_size < (off_t) sizeof(Ast_cache_header)) {
+    close(file_descriptor);
+    check_ast_cache(false);
+  }
+  const size_t file_size = file_info.st_size;
+  // private, so moving the tokens does not change the file
+  char * mapping = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file_descriptor, 0);
+  close(file_descriptor);
+  if (mapping == MAP_FAILED) {
+    errorf("File Error: Can not map the syntax tree cache file: %s\n", file_path);
+  }
+
+  Ast_cache_header header;
+  memcpy(&header, mapping, sizeof(header));
+  Node_pools * pools = create_node_pools();
+  bool is_correct = memcmp(header.magic, AST_CACHE_MAGIC, sizeof(header.magic)) == 0
+                 && header.version == AST_CACHE_VERSION && header.token_size == sizeof(Token)
+                 && is_section_in_file(header.text, 1, file_size) && header.text.count > 0
+                 && mapping[header.text.offset + header.text.count - 1] == '\0'
+                 && is_section_in_file(header.statements, sizeof(Node_Statement), file_size)
+                 && header.statements.count <= INT_MAX;
+  for (int i = 0; i < NODE_POOLS_COUNT; i++) {
+    const Pool * pool = get_node_pool(pools, i);
+    is_correct = is_correct && header.node_sizes[i] == pool->item_size
+              && is_section_in_file(header.pools[i], pool->item_size, file_size) && header.pools[i].count <= UINT32_MAX;
+  }
+  if (!is_correct) {
+    destroy_node_pools(pools);
+    munmap(mapping, file_size);
+    check_ast_cache(false);
+  }
+  for (int i = 0; i < NODE_POOLS_COUNT; i++) {
+    Pool * pool = get_node_pool(pools, i);
+    *pool = map_pool(pool->item_size, mapping + header.pools[i].offset, header.pools[i].count);
+  }
+
+  Ast_cache * ast_cache = smalloc(sizeof(*ast_cache));
+  *ast_cache = (Ast_cache) {
+    .mapping = mapping,
+    .mapping_size = file_size,
+    .text = mapping + header.text.offset,
+    .syntax_tree = {
+      .statements_node = (Node_Statement *) (mapping + header.statements.offset),
+      .statements_count = header.statements.count
+    },
+    .pools = pools
+  };
+  const Token_relocation relocation = { .text = ast_cache->text, .text_size = header.text.count - 1, .is_loading = true };
+  Node_pools * previous_node_pools = active_node_pools;
+  active_node_pools = pools;
+  relocate_syntax_tree(&relocation, ast_cache->syntax_tree);
+  active_node_pools = previous_node_pools;
+  return ast_cache;
+}
+
+void close_ast_cache(Ast_cache * ast_cache) {
+  destroy_node_pools(ast_cache->pools);
+  munmap(ast_cache->mapping, ast_cache->mapping_size);
+  sfree(ast_cache);
+}
+
+#endif
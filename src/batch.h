@@ -0,0 +1,235 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <threads.h>
+#include <stdatomic.h>
+
+#include "mlib.h"
+#include "errors.h"
+#include "comp.h"
+
+
+// a pair of files to compile in batch mode
+typedef struct Batch_job {
+  char * input_file;
+  char * output_file;
+} Batch_job;
+
+typedef struct Batch_jobs {
+  int jobs_count;
+  Batch_job * jobs;
+} Batch_jobs;
+
+// counters of the compilations done in batch mode
+typedef struct Batch_result {
+  int compiled_count;
+  int failed_count;
+} Batch_result;
+
+// a thread that takes jobs from the list until there are no more left
+typedef struct Batch_worker {
+  thrd_t thread;
+  const Batch_jobs * jobs;
+  // index of the next job that has not been taken, shared by all the workers
+  atomic_int * next_job;
+  Batch_result result;
+} Batch_worker;
+
+static char * copy_string(const char * string) {
+  char * copy = smalloc(strlen(string) + 1);
+  strcpy(copy, string);
+  return copy;
+}
+
+static void append_batch_job(Batch_jobs * jobs, const char * input_file, const char * output_file) {
+  jobs->jobs_count++;
+  jobs->jobs = srealloc(jobs->jobs, jobs->jobs_count * sizeof(*jobs->jobs));
+  jobs->jobs[jobs->jobs_count -1].input_file = copy_string(input_file);
+  jobs->jobs[jobs->jobs_count -1].output_file = copy_string(output_file);
+}
+
+void free_batch_jobs(Batch_jobs jobs) {
+  for (int i = 0; i < jobs.jobs_count; i++) {
+    sfree(jobs.jobs[i].input_file);
+    sfree(jobs.jobs[i].output_file);
+  }
+  sfree(jobs.jobs);
+}
+
+// reads the pairs of files of the manifest, each line of it must be:
+//   [input file path] [output file path]
+// empty lines and lines starting with '#' are ignored
+// the lines that are not valid are reported and counted as failed in the result
+Batch_jobs read_batch_manifest(const char * manifest_file, Batch_result * result) {
+  Batch_jobs jobs = { .jobs_count = 0, .jobs = NULL };
+  char * manifest = file_contents(manifest_file);
+
+  char * line = manifest;
+  int line_number = 1;
+  while (*line != '\0') {
+    char * line_end = strchr(line, '\n');
+    if (line_end != NULL) {
+      *line_end = '\0';
+    }
+    char * input_file = strtok(line, " \t\r");
+    char * output_file = input_file == NULL ? NULL : strtok(NULL, " \t\r");
+    if (input_file != NULL && input_file[0] != '#') {
+      if (output_file == NULL || strtok(NULL, " \t\r") != NULL) {
+        printf("Error: line %d of the manifest must have an input and an output file path\n", line_number);
+        result->failed_count++;
+      }
+      else {
+        append_batch_job(&jobs, input_file, output_file);
+      }
+    }
+    if (line_end == NULL) {
+      break;
+    }
+    line = line_end + 1;
+    line_number++;
+  }
+
+  sfree(manifest);
+  return jobs;
+}
+
+// lists every file in the input directory to be compiled into the output directory,
+// the output files have the same name as the input ones but with the given extension,
+// that can be written with or without its dot, the output directory is created if it does not exist
+Batch_jobs list_batch_directory(const char * input_dir, const char * output_dir, const char * extension) {
+  char * dotted_extension = smalloc(strlen(extension) + 2);
+  sprintf(dotted_extension, "%s%s", extension[0] == '.' || extension[0] == '\0' ? "" : ".", extension);
+  if (!is_supported_extension(dotted_extension)) {
+    errorf("the output extension of the batch must be c, asm, ll, o or empty, not: %s\n", extension);
+  }
+  extension = dotted_extension;
+
+  Batch_jobs jobs = { .jobs_count = 0, .jobs = NULL };
+  DIR * dir = opendir(input_dir);
+  if (dir == NULL) {
+    errorf("File Error: Can not open the input directory: %s\n", input_dir);
+  }
+  struct stat output_dir_info;
+  if ((mkdir(output_dir, 0777) != 0 && errno != EEXIST) || stat(output_dir, &output_dir_info) != 0 || !S_ISDIR(output_dir_info.st_mode)) {
+    closedir(dir);
+    errorf("File Error: Can not create the output directory: %s\n", output_dir);
+  }
+  // the paths are reused for every file
+  int input_path_size = 0;
+  char * input_path = NULL;
+  int output_path_size = 0;
+  char * output_path = NULL;
+
+  struct dirent * entry;
+  while ((entry = readdir(dir)) != NULL) {
+    const char * name = entry->d_name;
+    int input_size = strlen(input_dir) + strlen(name) + 2;
+    if (input_size > input_path_size) {
+      input_path_size = input_size;
+      input_path = srealloc(input_path, input_path_size);
+    }
+    sprintf(input_path, "%s/%s", input_dir, name);
+    // only compile regular files
+    struct stat file_info;
+    if (stat(input_path, &file_info) != 0 || !S_ISREG(file_info.st_mode)) {
+      continue;
+    }
+    // replace the extension of the file name
+    int name_size = get_file_extension(name) - name;
+    if (name_size == 0) {
+      name_size = strlen(name);
+    }
+    int output_size = strlen(output_dir) + name_size + strlen(extension) + 2;
+    if (output_size > output_path_size) {
+      output_path_size = output_size;
+      output_path = srealloc(output_path, output_path_size);
+    }
+    sprintf(output_path, "%s/%.*s%s", output_dir, name_size, name, extension);
+
+    append_batch_job(&jobs, input_path, output_path);
+  }
+
+  closedir(dir);
+  sfree(input_path);
+  sfree(output_path);
+  sfree(dotted_extension);
+  return jobs;
+}
+
+// compiles one file of the batch, if it fails it reports it and continues
+// all the memory used by the compilation comes from the arena, that is reset after it
+static void compile_batch_job(Arena * arena, Batch_result * result, const Batch_job job) {
+  jmp_buf recovery_point;
+  error_recovery_point = &recovery_point;
+  active_arena = arena;
+
+  if (setjmp(recovery_point) == 0) {
+    compile(job.input_file, &job.output_file, 1);
+    result->compiled_count++;
+  }
+  else {
+    printf("Error: could not compile %s\n", job.input_file);
+    result->failed_count++;
+  }
+
+  active_arena = NULL;
+  error_recovery_point = NULL;
+  reset_arena(arena);
+}
+
+static int batch_worker(void * worker_ptr) {
+  Batch_worker * worker = worker_ptr;
+  // every worker has its own arena, so they never wait for each other when allocating
+  Arena arena = create_arena();
+  while (true) {
+    int job = atomic_fetch_add(worker->next_job, 1);
+    if (job >= worker->jobs->jobs_count) {
+      break;
+    }
+    compile_batch_job(&arena, &worker->result, worker->jobs->jobs[job]);
+  }
+  destroy_arena(&arena);
+  return 0;
+}
+
+// compiles all the jobs distributing them between a number of threads
+// with a single worker everything is done in the calling thread
+Batch_result run_batch(const Batch_jobs jobs, int workers_count) {
+  if (workers_count > jobs.jobs_count) {
+    workers_count = jobs.jobs_count > 0 ? jobs.jobs_count : 1;
+  }
+  atomic_int next_job = 0;
+  Batch_worker * workers = smalloc(workers_count * sizeof(*workers));
+  for (int i = 0; i < workers_count; i++) {
+    workers[i].jobs = &jobs;
+    workers[i].next_job = &next_job;
+    workers[i].result = (Batch_result) {0};
+  }
+
+  if (workers_count == 1) {
+    batch_worker(&workers[0]);
+  }
+  else {
+    for (int i = 0; i < workers_count; i++) {
+      if (thrd_create(&workers[i].thread, batch_worker, &workers[i]) != thrd_success) {
+        errorf("Execution Error: can not create the worker thread %d\n", i);
+      }
+    }
+    for (int i = 0; i < workers_count; i++) {
+      thrd_join(workers[i].thread, NULL);
+    }
+  }
+
+  Batch_result result = {0};
+  for (int i = 0; i < workers_count; i++) {
+    result.compiled_count += workers[i].result.compiled_count;
+    result.failed_count += workers[i].result.failed_count;
+  }
+  sfree(workers);
+  return result;
+}
+
+#endif
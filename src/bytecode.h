@@ -0,0 +1,659 @@
+#ifndef BYTECODE_H_
+#define BYTECODE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "errors.h"
+#include "mlib.h"
+#include "tokenizer.h"
+#include "parser.h"
+#include "checker.h"
+
+
+/* * * * * * * * * * * * * * * * *
+ * Compiling the program to bytecode *
+ * * * * * * * * * * * * * * * * */
+
+// the bytecode works on registers of 64 bits, every value of the program is in one or more of them:
+// the integers and the pointers use one and the arrays one for each of their elements in order,
+// the integers smaller than u64 are masked to their size when they are given a value
+// the registers are a single frame for the whole program, the variables have fixed registers
+// and the values of the expressions go in the registers after the ones of the variables in use,
+// the numbers of the program are in registers before the first one, with negative indexes
+// the pointers are the addresses of the registers, they can only point to variables
+
+typedef enum Opcode {
+  op_move,                   // r[a] = r[b]
+  op_copy,                   // r[a .. a+c] = r[b .. b+c]
+  op_add,                    // r[a] = r[b] + r[c]
+  op_sub,                    // r[a] = r[b] - r[c]
+  op_mul,                    // r[a] = r[b] * r[c]
+  op_div,                    // r[a] = r[b] / r[c]
+  op_mod,                    // r[a] = r[b] % r[c]
+  op_equ,                    // r[a] = r[b] == r[c]
+  op_big,                    // r[a] = r[b] > r[c]
+  op_les,                    // r[a] = r[b] < r[c]
+  op_and,                    // r[a] = r[b] & r[c]
+  op_address,                // r[a] = &r[b]
+  op_load,                   // r[a] = *r[b]
+  op_load_block,             // r[a .. a+c] = r[b][0 .. c]
+  // the arrays in registers and the arrays pointed by a register, d is the index of their shape
+  op_frame_element,          // r[a] = r[b + r[c] * stride]
+  op_frame_element_address,  // r[a] = &r[b + r[c] * stride]
+  op_element,                // r[a] = r[b][r[c] * stride]
+  op_element_address,        // r[a] = &r[b][r[c] * stride]
+  op_jump,                   // go to the instruction a
+  op_jump_if_zero,           // go to a if r[b] == 0
+  op_jump_if_not_equ,        // go to a if not r[b] == r[c]
+  op_jump_if_not_big,        // go to a if not r[b] > r[c]
+  op_jump_if_not_les,        // go to a if not r[b] < r[c]
+  op_print,                  // print the character r[a]
+  op_exit,                   // end the program with the exit code r[a]
+  op_end,                    // end the program with the exit code 0
+  OPCODES_COUNT
+} Opcode;
+
+typedef struct Instruction {
+  uint32_t opcode : 8;
+  uint32_t d : 24;
+  int32_t a;
+  int32_t b;
+  int32_t c;
+} Instruction;
+
+// the elements count of an array and the registers of each element, for checking and computing its indexes
+typedef struct Array_shape {
+  uint32_t length;
+  uint32_t stride;
+} Array_shape;
+
+// the place in the code of an instruction that can fail, for its error
+typedef struct Code_place {
+  int line_number;
+  int column_number;
+} Code_place;
+
+typedef struct Bytecode_program {
+  int instructions_count;
+  Instruction * instructions;
+  // the place of every instruction
+  Code_place * places;
+  int constants_count;
+  uint64_t * constants;
+  int shapes_count;
+  Array_shape * shapes;
+  // the registers of the variables and the values of the expressions
+  int frame_size;
+} Bytecode_program;
+
+void free_bytecode_program(const Bytecode_program program) {
+  sfree(program.instructions);
+  sfree(program.places);
+  sfree(program.constants);
+  sfree(program.shapes);
+}
+
+// a variable in the scope of the compilation
+typedef struct Bytecode_variable {
+  Token name;
+  Node_Type type;
+  int32_t first_register;
+} Bytecode_variable;
+
+typedef struct Bytecode_compiler {
+  Bytecode_program program;
+  int instructions_capacity;
+  int constants_capacity;
+  int shapes_capacity;
+  Bytecode_variable * variables;
+  int variables_count;
+  int variables_capacity;
+  // the first register after the variables in use, and after the values being computed
+  int32_t variables_end;
+  int32_t next_register;
+} Bytecode_compiler;
+
+// the type of a value in the compilation, the type nodes are not created for the array literals and the addresses
+typedef struct Bytecode_type {
+  // the type of an array literal is an array of the type of its first element
+  const Node_Expresion * literal_elements;
+  int literal_length;
+  // the type of `&variable`, a pointer to the type of the node
+  bool is_address;
+  Node_Type node;
+} Bytecode_type;
+
+static Bytecode_type get_bytecode_type(const Bytecode_compiler * compiler, const Node_Expresion expresion);
+
+static const Bytecode_type bytecode_u64_type = {
+  .literal_elements = NULL,
+  .is_address = false,
+  .node = { .type_type = type_primitive_type }
+};
+
+static bool is_bytecode_array_type(const Bytecode_type type) {
+  return type.literal_elements != NULL || (!type.is_address && type.node.type_type == type_array_type);
+}
+
+static int get_node_type_registers_count(const Node_Type type) {
+  if (type.type_type == type_array_type) {
+    return get_node_type_registers_count(*get_type(get_array_type(type)->primitive_type)) * (int) get_array_type(type)->elements_count.value;
+  }
+  return 1;
+}
+
+static int get_bytecode_array_length(const Bytecode_type type) {
+  if (type.literal_elements != NULL) {
+    return type.literal_length;
+  }
+  return (int) get_array_type(type.node)->elements_count.value;
+}
+
+static Bytecode_type get_bytecode_element_type(const Bytecode_compiler * compiler, const Bytecode_type type) {
+  if (type.literal_elements != NULL) {
+    return get_bytecode_type(compiler, type.literal_elements[0]);
+  }
+  return (Bytecode_type) { .literal_elements = NULL, .is_address = false, .node = *get_type(get_array_type(type.node)->primitive_type) };
+}
+
+static int get_bytecode_registers_count(const Bytecode_compiler * compiler, const Bytecode_type type) {
+  if (type.literal_elements != NULL) {
+    return type.literal_length * get_bytecode_registers_count(compiler, get_bytecode_element_type(compiler, type));
+  }
+  if (type.is_address) {
+    return 1;
+  }
+  return get_node_type_registers_count(type.node);
+}
+
+static const Bytecode_variable * find_bytecode_variable(const Bytecode_compiler * compiler, const Token name) {
+  // the most recent declaration first, the variables of the blocks are after the global ones
+  for (int i = compiler->variables_count -1; i >= 0; i--) {
+    if (compare_str_of_tokens(compiler->variables[i].name, name)) {
+      return &compiler->variables[i];
+    }
+  }
+  implementation_error("could not find variable in the bytecode compilation");
+  // unreachable
+  return NULL;
+}
+
+static Bytecode_type get_bytecode_type(const Bytecode_compiler * compiler, const Node_Expresion expresion) {
+  switch (expresion.expresion_type) {
+    case expresion_number_type:
+      return bytecode_u64_type;
+
+    case expresion_identifier_type: {
+      const Node_Type type = find_bytecode_variable(compiler, expresion.expresion_value.expresion_identifier_value)->type;
+      return (Bytecode_type) { .literal_elements = NULL, .is_address = false, .node = type };
+    }
+
+    case expresion_binary_operation_type: {
+      const Node_Binary_Operation operation = *get_binary_operation(expresion);
+      if (operation.operation_type == binary_operation_access_type) {
+        return get_bytecode_element_type(compiler, get_bytecode_type(compiler, operation.left_side));
+      }
+      return bytecode_u64_type;
+    }
+
+    case expresion_unary_operation_type: {
+      const Node_Unary_Operation operation = *get_unary_operation(expresion);
+      const Bytecode_type operand_type = get_bytecode_type(compiler, operation.expresion);
+      if (operation.operation_type == unary_operation_addr_type) {
+        return (Bytecode_type) { .literal_elements = NULL, .is_address = true, .node = operand_type.node };
+      }
+      if (operand_type.is_address) {
+        return (Bytecode_type) { .literal_elements = NULL, .is_address = false, .node = operand_type.node };
+      }
+      return (Bytecode_type) { .literal_elements = NULL, .is_address = false, .node = *get_pointed_type(operand_type.node) };
+    }
+
+    case expresion_array_type: {
+      const Node_Array array = expresion.expresion_value.expresion_array_value;
+      return (Bytecode_type) { .literal_elements = get_array_elements(array), .literal_length = array.elements_count, .is_address = false };
+    }
+  }
+  implementation_error("unkown type of expresion while trying to get its type in the bytecode compilation");
+  return bytecode_u64_type;
+}
+
+static int emit_bytecode(Bytecode_compiler * compiler, const Opcode opcode, const int32_t a, const int32_t b, const int32_t c, const uint32_t d, const Token place) {
+  Bytecode_program * program = &compiler->program;
+  if (program->instructions_count == compiler->instructions_capacity) {
+    compiler->instructions_capacity = compiler->instructions_capacity == 0 ? 256 : 2 * compiler->instructions_capacity;
+    program->instructions = srealloc(program->instructions, compiler->instructions_capacity * sizeof(*program->instructions));
+    program->places = srealloc(program->places, compiler->instructions_capacity * sizeof(*program->places));
+  }
+  program->instructions[program->instructions_count] = (Instruction) { .opcode = opcode, .d = d, .a = a, .b = b, .c = c };
+  // the places are kept for the errors of the running program, also when the bytecode is saved
+  const Token_place token_place = get_token_place(place);
+  program->places[program->instructions_count] = (Code_place) { .line_number = token_place.line_number, .column_number = token_place.column_number };
+  return program->instructions_count++;
+}
+
+// the jumps are emitted before their destination is known
+static void set_jump_destination(Bytecode_compiler * compiler, const int jump, const int destination) {
+  compiler->program.instructions[jump].a = destination;
+}
+
+static int32_t add_bytecode_constant(Bytecode_compiler * compiler, const uint64_t value) {
+  Bytecode_program * program = &compiler->program;
+  if (program->constants_count == compiler->constants_capacity) {
+    compiler->constants_capacity = compiler->constants_capacity == 0 ? 64 : 2 * compiler->constants_capacity;
+    program->constants = srealloc(program->constants, compiler->constants_capacity * sizeof(*program->constants));
+  }
+  program->constants[program->constants_count] = value;
+  // the constants go before the register 0, the first one in the register -1
+  return -1 - program->constants_count++;
+}
+
+static uint32_t add_array_shape(Bytecode_compiler * compiler, const Array_shape shape) {
+  Bytecode_program * program = &compiler->program;
+  // the shapes repeat a lot, and the last one is the most likely
+  for (int i = program->shapes_count -1; i >= 0 && i >= program->shapes_count - 8; i--) {
+    if (program->shapes[i].length == shape.length && program->shapes[i].stride == shape.stride) {
+      return i;
+    }
+  }
+  if (program->shapes_count == compiler->shapes_capacity) {
+    compiler->shapes_capacity = compiler->shapes_capacity == 0 ? 16 : 2 * compiler->shapes_capacity;
+    program->shapes = srealloc(program->shapes, compiler->shapes_capacity * sizeof(*program->shapes));
+  }
+  program->shapes[program->shapes_count] = shape;
+  return program->shapes_count++;
+}
+
+// reserves registers for a value being computed, they are free again after the statement
+static int32_t new_bytecode_registers(Bytecode_compiler * compiler, const int count) {
+  const int32_t first_register = compiler->next_register;
+  compiler->next_register += count;
+  if (compiler->next_register > compiler->program.frame_size) {
+    compiler->program.frame_size = compiler->next_register;
+  }
+  return first_register;
+}
+
+static void compile_bytecode_scalar_into(Bytecode_compiler * compiler, const Node_Expresion expresion, const int32_t destination);
+static void compile_bytecode_value_into(Bytecode_compiler * compiler, const Node_Expresion expresion, const int32_t destination);
+
+// returns the register with the value of a u64 or pointer expression,
+// the variables and the numbers are used from their own registers
+static int32_t compile_bytecode_scalar(Bytecode_compiler * compiler, const Node_Expresion expresion) {
+  if (expresion.expresion_type == expresion_number_type) {
+    return add_bytecode_constant(compiler, expresion.expresion_value.expresion_number_value.value);
+  }
+  if (expresion.expresion_type == expresion_identifier_type) {
+    return find_bytecode_variable(compiler, expresion.expresion_value.expresion_identifier_value)->first_register;
+  }
+  const int32_t result = new_bytecode_registers(compiler, 1);
+  compile_bytecode_scalar_into(compiler, expresion, result);
+  return result;
+}
+
+// an array is in registers, or in the memory pointed by a register
+typedef struct Array_place {
+  bool is_pointed;
+  int32_t reg;
+} Array_place;
+
+static Array_place compile_bytecode_array_place(Bytecode_compiler * compiler, const Node_Expresion expresion) {
+  switch (expresion.expresion_type) {
+    case expresion_identifier_type:
+      return (Array_place) { .is_pointed = false, .reg = find_bytecode_variable(compiler, expresion.expresion_value.expresion_identifier_value)->first_register };
+
+    case expresion_binary_operation_type: {
+      // an array inside an array
+      const Node_Binary_Operation operation = *get_binary_operation(expresion);
+      const Bytecode_type array_type = get_bytecode_type(compiler, operation.left_side);
+      const Array_shape shape = {
+        .length = get_bytecode_array_length(array_type),
+        .stride = get_bytecode_registers_count(compiler, get_bytecode_element_type(compiler, array_type))
+      };
+      const Array_place array = compile_bytecode_array_place(compiler, operation.left_side);
+      const int32_t index = compile_bytecode_scalar(compiler, operation.right_side);
+      const int32_t address = new_bytecode_registers(compiler, 1);
+      emit_bytecode(compiler, array.is_pointed ? op_element_address : op_frame_element_address, address, array.reg, index,
+                    add_array_shape(compiler, shape), get_first_token_of_expresion(operation.right_side));
+      return (Array_place) { .is_pointed = true, .reg = address };
+    }
+
+    case expresion_unary_operation_type:
+      // the dereference of a pointer to an array
+      return (Array_place) { .is_pointed = true, .reg = compile_bytecode_scalar(compiler, get_unary_operation(expresion)->expresion) };
+
+    case expresion_array_type: {
+      const int32_t first_register = new_bytecode_registers(compiler, get_bytecode_registers_count(compiler, get_bytecode_type(compiler, expresion)));
+      compile_bytecode_value_into(compiler, expresion, first_register);
+      return (Array_place) { .is_pointed = false, .reg = first_register };
+    }
+
+    case expresion_number_type:
+      break;
+  }
+  implementation_error("the expression is not an array in the bytecode compilation");
+  return (Array_place) { .is_pointed = false, .reg = 0 };
+}
+
+// compiles a u64 or pointer expression, its value goes into the destination register
+static void compile_bytecode_scalar_into(Bytecode_compiler * compiler, const Node_Expresion expresion, const int32_t destination) {
+  // the registers of the operands are free after the operation
+  const int32_t operands_beginning = compiler->next_register;
+  switch (expresion.expresion_type) {
+    case expresion_number_type:
+    case expresion_identifier_type:
+      emit_bytecode(compiler, op_move, destination, compile_bytecode_scalar(compiler, expresion), 0, 0, NULL_TOKEN);
+      break;
+
+    case expresion_binary_operation_type: {
+      const Node_Binary_Operation operation = *get_binary_operation(expresion);
+      if (operation.operation_type == binary_operation_access_type) {
+        const Bytecode_type array_type = get_bytecode_type(compiler, operation.left_side);
+        const Array_shape shape = {
+          .length = get_bytecode_array_length(array_type),
+          .stride = get_bytecode_registers_count(compiler, get_bytecode_element_type(compiler, array_type))
+        };
+        const Array_place array = compile_bytecode_array_place(compiler, operation.left_side);
+        const int32_t index = compile_bytecode_scalar(compiler, operation.right_side);
+        emit_bytecode(compiler, array.is_pointed ? op_element : op_frame_element, destination, array.reg, index,
+                      add_array_shape(compiler, shape), get_first_token_of_expresion(operation.right_side));
+        break;
+      }
+      Opcode opcode;
+      switch (operation.operation_type) {
+        case binary_operation_sum_type: opcode = op_add; break;
+        case binary_operation_sub_type: opcode = op_sub; break;
+        case binary_operation_mul_type: opcode = op_mul; break;
+        case binary_operation_div_type: opcode = op_div; break;
+        case binary_operation_mod_type: opcode = op_mod; break;
+        case binary_operation_big_type: opcode = op_big; break;
+        case binary_operation_les_type: opcode = op_les; break;
+        case binary_operation_equ_type: opcode = op_equ; break;
+        default:
+          implementation_error("exponentation not implemented");
+          return;
+      }
+      const int32_t left_side = compile_bytecode_scalar(compiler, operation.left_side);
+      const int32_t right_side = compile_bytecode_scalar(compiler, operation.right_side);
+      // the division by 0 is reported at the divisor
+      emit_bytecode(compiler, opcode, destination, left_side, right_side, 0, get_first_token_of_expresion(operation.right_side));
+      break;
+    }
+
+    case expresion_unary_operation_type: {
+      const Node_Unary_Operation operation = *get_unary_operation(expresion);
+      if (operation.operation_type == unary_operation_addr_type) {
+        const Token variable = operation.expresion.expresion_value.expresion_identifier_value;
+        emit_bytecode(compiler, op_address, destination, find_bytecode_variable(compiler, variable)->first_register, 0, 0, NULL_TOKEN);
+      }
+      else {
+        emit_bytecode(compiler, op_load, destination, compile_bytecode_scalar(compiler, operation.expresion), 0, 0, NULL_TOKEN);
+      }
+      break;
+    }
+
+    case expresion_array_type:
+      implementation_error("an array can not be in a register in the bytecode compilation");
+      break;
+  }
+  compiler->next_register = operands_beginning;
+}
+
+// compiles an expression of any type, its value goes into the registers after the destination
+static void compile_bytecode_value_into(Bytecode_compiler * compiler, const Node_Expresion expresion, const int32_t destination) {
+  const Bytecode_type type = get_bytecode_type(compiler, expresion);
+  if (!is_bytecode_array_type(type)) {
+    compile_bytecode_scalar_into(compiler, expresion, destination);
+    return;
+  }
+  const int32_t operands_beginning = compiler->next_register;
+  if (expresion.expresion_type == expresion_array_type) {
+    const Node_Array array = expresion.expresion_value.expresion_array_value;
+    const int element_size = get_bytecode_registers_count(compiler, get_bytecode_element_type(compiler, type));
+    for (int i = 0; i < array.elements_count; i++) {
+      compile_bytecode_value_into(compiler, get_array_elements(array)[i], destination + i * element_size);
+    }
+  }
+  else {
+    const Array_place array = compile_bytecode_array_place(compiler, expresion);
+    emit_bytecode(compiler, array.is_pointed ? op_load_block : op_copy, destination, array.reg,
+                  get_bytecode_registers_count(compiler, type), 0, NULL_TOKEN);
+  }
+  compiler->next_register = operands_beginning;
+}
+
+// compiles the condition and a jump for when it is false, returns the jump
+static int compile_bytecode_condition(Bytecode_compiler * compiler, const Node_Expresion condition) {
+  const int32_t operands_beginning = compiler->next_register;
+  int jump;
+  const bool is_comparison = condition.expresion_type == expresion_binary_operation_type
+                          && (get_binary_operation(condition)->operation_type == binary_operation_equ_type
+                              || get_binary_operation(condition)->operation_type == binary_operation_big_type
+                              || get_binary_operation(condition)->operation_type == binary_operation_les_type);
+  if (is_comparison) {
+    // the comparisons jump by themselves
+    const Node_Binary_Operation operation = *get_binary_operation(condition);
+    const Opcode opcode = operation.operation_type == binary_operation_equ_type ? op_jump_if_not_equ
+                        : operation.operation_type == binary_operation_big_type ? op_jump_if_not_big : op_jump_if_not_les;
+    const int32_t left_side = compile_bytecode_scalar(compiler, operation.left_side);
+    const int32_t right_side = compile_bytecode_scalar(compiler, operation.right_side);
+    jump = emit_bytecode(compiler, opcode, -1, left_side, right_side, 0, NULL_TOKEN);
+  }
+  else {
+    jump = emit_bytecode(compiler, op_jump_if_zero, -1, compile_bytecode_scalar(compiler, condition), 0, 0, NULL_TOKEN);
+  }
+  compiler->next_register = operands_beginning;
+  return jump;
+}
+
+// keeps only the lower bits of the integers smaller than u64 in the registers of a value of the type,
+// the values copied from the arrays of the same type already have them
+static void compile_bytecode_truncation(Bytecode_compiler * compiler, const Node_Type type, const int32_t first_register) {
+  if (type.type_type == type_array_type) {
+    const Node_Type element_type = *get_type(get_array_type(type)->primitive_type);
+    const int element_size = get_node_type_registers_count(element_type);
+    for (int i = 0; i < (int) get_array_type(type)->elements_count.value; i++) {
+      compile_bytecode_truncation(compiler, element_type, first_register + i * element_size);
+    }
+    return;
+  }
+  const int size = type.type_type == type_primitive_type ? get_primitive_type_size(type.type_value.type_primitive_value) : 8;
+  if (size < 8) {
+    const int32_t mask = add_bytecode_constant(compiler, (UINT64_C(1) << (8 * size)) - 1);
+    emit_bytecode(compiler, op_and, first_register, first_register, mask, 0, NULL_TOKEN);
+  }
+}
+
+static void compile_bytecode_statement(Bytecode_compiler * compiler, const Node_Statement stmt);
+
+// the variables declared inside a block are forgotten at its end, and their registers are free again
+static void compile_bytecode_block(Bytecode_compiler * compiler, const Node_Scope scope) {
+  const int variables_count = compiler->variables_count;
+  const int32_t variables_end = compiler->variables_end;
+  for (int i = 0; i < scope.statements_count; i++) {
+    compile_bytecode_statement(compiler, get_scope_statements(scope)[i]);
+  }
+  compiler->variables_count = variables_count;
+  compiler->variables_end = variables_end;
+  compiler->next_register = variables_end;
+}
+
+static void compile_bytecode_statement(Bytecode_compiler * compiler, const Node_Statement stmt) {
+  switch (stmt.statement_type) {
+    case var_declaration_type: {
+      const Node_Var_declaration declaration = stmt.statement_value.var_declaration;
+      const int32_t first_register = new_bytecode_registers(compiler, get_node_type_registers_count(declaration.type));
+      compile_bytecode_value_into(compiler, declaration.value, first_register);
+      if (declaration.type.type_type != type_array_type || declaration.value.expresion_type == expresion_array_type) {
+        compile_bytecode_truncation(compiler, declaration.type, first_register);
+      }
+      if (compiler->variables_count == compiler->variables_capacity) {
+        compiler->variables_capacity = compiler->variables_capacity == 0 ? 64 : 2 * compiler->variables_capacity;
+        compiler->variables = srealloc(compiler->variables, compiler->variables_capacity * sizeof(*compiler->variables));
+      }
+      compiler->variables[compiler->variables_count++] = (Bytecode_variable) {
+        .name = declaration.var_name,
+        .type = declaration.type,
+        .first_register = first_register
+      };
+      compiler->variables_end = compiler->next_register;
+      break;
+    }
+
+    case var_assignment_type: {
+      const Node_Var_assignment assignment = stmt.statement_value.var_assignment;
+      const Bytecode_variable variable = *find_bytecode_variable(compiler, assignment.var_name);
+      if (variable.type.type_type != type_array_type) {
+        compile_bytecode_scalar_into(compiler, assignment.value, variable.first_register);
+        compile_bytecode_truncation(compiler, variable.type, variable.first_register);
+      }
+      else if (assignment.value.expresion_type == expresion_array_type) {
+        // the elements can use the variable, so the new value is only copied into it at the end
+        const int registers_count = get_node_type_registers_count(variable.type);
+        const int32_t value = new_bytecode_registers(compiler, registers_count);
+        compile_bytecode_value_into(compiler, assignment.value, value);
+        emit_bytecode(compiler, op_copy, variable.first_register, value, registers_count, 0, NULL_TOKEN);
+        compile_bytecode_truncation(compiler, variable.type, variable.first_register);
+      }
+      else {
+        compile_bytecode_value_into(compiler, assignment.value, variable.first_register);
+      }
+      break;
+    }
+
+    case exit_node_type:
+      emit_bytecode(compiler, op_exit, compile_bytecode_scalar(compiler, stmt.statement_value.exit_node.exit_code), 0, 0, 0, NULL_TOKEN);
+      break;
+
+    case print_type:
+      emit_bytecode(compiler, op_print, compile_bytecode_scalar(compiler, stmt.statement_value.print.chr), 0, 0, 0, NULL_TOKEN);
+      break;
+
+    case scope_type:
+      compile_bytecode_block(compiler, stmt.statement_value.scope);
+      break;
+
+    case if_type: {
+      const Node_If if_node = stmt.statement_value.if_node;
+      const int condition_jump = compile_bytecode_condition(compiler, if_node.condition);
+      compile_bytecode_block(compiler, if_node.scope);
+      if (if_node.has_else_block) {
+        const int end_jump = emit_bytecode(compiler, op_jump, -1, 0, 0, 0, NULL_TOKEN);
+        set_jump_destination(compiler, condition_jump, compiler->program.instructions_count);
+        compile_bytecode_block(compiler, if_node.else_block);
+        set_jump_destination(compiler, end_jump, compiler->program.instructions_count);
+      }
+      else {
+        set_jump_destination(compiler, condition_jump, compiler->program.instructions_count);
+      }
+      break;
+    }
+
+    case while_type: {
+      const Node_While while_node = stmt.statement_value.while_node;
+      const int beginning = compiler->program.instructions_count;
+      const int condition_jump = compile_bytecode_condition(compiler, while_node.condition);
+      compile_bytecode_block(compiler, while_node.scope);
+      emit_bytecode(compiler, op_jump, beginning, 0, 0, 0, NULL_TOKEN);
+      set_jump_destination(compiler, condition_jump, compiler->program.instructions_count);
+      break;
+    }
+  }
+  // the values computed by the statement are not needed anymore
+  compiler->next_register = compiler->variables_end;
+}
+
+// compiles the checked syntax tree into bytecode
+Bytecode_program compile_bytecode(const Node_Program syntax_tree) {
+  Bytecode_compiler compiler = {
+    .program = {
+      .instructions_count = 0, .instructions = NULL, .places = NULL,
+      .constants_count = 0, .constants = NULL,
+      .shapes_count = 0, .shapes = NULL,
+      .frame_size = 0
+    },
+    .instructions_capacity = 0, .constants_capacity = 0, .shapes_capacity = 0,
+    .variables = NULL, .variables_count = 0, .variables_capacity = 0,
+    .variables_end = 0,
+    .next_register = 0
+  };
+  for (int i = 0; i < syntax_tree.statements_count; i++) {
+    compile_bytecode_statement(&compiler, syntax_tree.statements_node[i]);
+  }
+  emit_bytecode(&compiler, op_end, 0, 0, 0, 0, NULL_TOKEN);
+  sfree(compiler.variables);
+  return compiler.program;
+}
+
+
+/* the bytecode in a file */
+
+// the programs are written as this header and then the arrays of the program in its order
+typedef struct Bytecode_header {
+  char magic[8];
+  int32_t instructions_count;
+  int32_t constants_count;
+  int32_t shapes_count;
+  int32_t frame_size;
+} Bytecode_header;
+
+#define BYTECODE_MAGIC "BONEBC1"
+
+void write_bytecode(FILE * out_file_ptr, const Bytecode_program program) {
+  Bytecode_header header = {
+    .instructions_count = program.instructions_count,
+    .constants_count = program.constants_count,
+    .shapes_count = program.shapes_count,
+    .frame_size = program.frame_size
+  };
+  memcpy(header.magic, BYTECODE_MAGIC, sizeof(header.magic));
+  fwrite(&header, sizeof(header), 1, out_file_ptr);
+  fwrite(program.instructions, sizeof(*program.instructions), program.instructions_count, out_file_ptr);
+  fwrite(program.places, sizeof(*program.places), program.instructions_count, out_file_ptr);
+  fwrite(program.constants, sizeof(*program.constants), program.constants_count, out_file_ptr);
+  fwrite(program.shapes, sizeof(*program.shapes), program.shapes_count, out_file_ptr);
+}
+
+// reads a program written by write_bytecode()
+Bytecode_program read_bytecode(const char * data, const size_t data_size) {
+  Bytecode_header header;
+  if (data_size < sizeof(header)) {
+    implementation_error("the bytecode is damaged");
+  }
+  memcpy(&header, data, sizeof(header));
+  const size_t size = sizeof(header)
+                    + (size_t)header.instructions_count * (sizeof(Instruction) + sizeof(Code_place))
+                    + (size_t)header.constants_count * sizeof(uint64_t)
+                    + (size_t)header.shapes_count * sizeof(Array_shape);
+  if (memcmp(header.magic, BYTECODE_MAGIC, sizeof(header.magic)) != 0 || size != data_size) {
+    implementation_error("the bytecode is damaged");
+  }
+  Bytecode_program program = {
+    .instructions_count = header.instructions_count,
+    .instructions = smalloc(header.instructions_count * sizeof(Instruction)),
+    .places = smalloc(header.instructions_count * sizeof(Code_place)),
+    .constants_count = header.constants_count,
+    .constants = smalloc(header.constants_count * sizeof(uint64_t)),
+    .shapes_count = header.shapes_count,
+    .shapes = smalloc(header.shapes_count * sizeof(Array_shape)),
+    .frame_size = header.frame_size
+  };
+  data += sizeof(header);
+  memcpy(program.instructions, data, header.instructions_count * sizeof(Instruction));
+  data += header.instructions_count * sizeof(Instruction);
+  memcpy(program.places, data, header.instructions_count * sizeof(Code_place));
+  data += header.instructions_count * sizeof(Code_place);
+  memcpy(program.constants, data, header.constants_count * sizeof(uint64_t));
+  data += header.constants_count * sizeof(uint64_t);
+  memcpy(program.shapes, data, header.shapes_count * sizeof(Array_shape));
+  return program;
+}
+
+// it generates the bytecode of the program into the file
+void gen_bytecode(const Node_Program syntax_tree, FILE * out_file_ptr) {
+  const Bytecode_program program = compile_bytecode(syntax_tree);
+  write_bytecode(out_file_ptr, program);
+  free_bytecode_program(program);
+}
+
+#endif
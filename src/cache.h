@@ -0,0 +1,615 @@
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <unistd.h>
+#include <threads.h>
+#include <sys/stat.h>
+#include <stdatomic.h>
+
+#include "mlib.h"
+#include "errors.h"
+
+
+/* * * * * * * * * * * * * *
+ * Content addressed cache *
+ * * * * * * * * * * * * * */
+
+// the outputs of the compilations are saved in a directory, named by a hash of everything that
+// changes them: the source code, the compiler version, the output extension and the options
+// an unchanged program is then copied from the cache without even lexing it
+// the least recently used outputs are removed when the directory gets bigger than its limit,
+// the times of their last use are kept in the stats file, so the outputs copied from them keep their own times
+// the size of the outputs is also kept there, so the directory is only listed when they have to be removed
+
+#define COMPILER_VERSION "0.1"
+// the build time is part of the version in the key, so a rebuilt compiler never uses the old outputs
+#define CACHE_COMPILER_VERSION COMPILER_VERSION " " __DATE__ " " __TIME__
+
+#define CACHE_DEFAULT_SIZE_LIMIT (256 << 20)
+#define CACHE_STATS_FILE "stats"
+// the uses of a process are written in the stats file when there are this many, or before removing outputs
+#define CACHE_USES_FLUSH_COUNT 4096
+// the names of the outputs in the cache are the 32 digits of the key and the extension
+#define CACHE_ENTRY_NAME_SIZE 64
+
+// 128 bits hash made of 2 different 64 bits hashes, so a collision is not a practical concern
+typedef struct Cache_key {
+  uint64_t hash1;
+  uint64_t hash2;
+} Cache_key;
+
+// the last time an output of the cache was used
+typedef struct Cache_use {
+  char name[CACHE_ENTRY_NAME_SIZE];
+  struct timespec time;
+} Cache_use;
+
+typedef struct Cache_uses {
+  int uses_count;
+  Cache_use * uses;
+} Cache_uses;
+
+typedef struct Cache {
+  char * directory;
+  // max size of all the outputs in bytes
+  long long size_limit;
+  // the options that change the generated code, they are part of the key
+  char * options;
+  // counters of this process, they are added to the stats file when the cache is closed
+  atomic_int hits;
+  atomic_int misses;
+  atomic_int evictions;
+  // size of all the outputs as this process knows it: the one in the stats file when it was last opened,
+  // and the outputs saved since then, their size is added to the file the next time it is opened
+  atomic_llong size;
+  atomic_llong added_size;
+  // the uses of this process that are not in the stats file yet, in the order they happened,
+  // they are shared by all the threads and do not belong to the arena of any of them
+  mtx_t uses_mutex;
+  Cache_uses uses;
+  // the lock of the stats file is for the processes, the threads of this one take turns with it
+  mtx_t stats_mutex;
+} Cache;
+
+// when it is set the compilations use it, it is set before starting the worker threads
+Cache * output_cache = NULL;
+
+static void hash_cache_bytes(Cache_key * key, const char * bytes, const size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    const uint8_t byte = bytes[i];
+    // FNV-1a
+    key->hash1 = (key->hash1 ^ byte) * 0x100000001b3;
+    // multiply and xorshift
+    key->hash2 = (key->hash2 + byte + 1) * 0x9e3779b97f4a7c15;
+    key->hash2 ^= key->hash2 >> 29;
+  }
+}
+
+// hashes a field of the key, with its size so different fields can not be confused
+static void hash_cache_field(Cache_key * key, const char * field, const size_t size) {
+  const uint64_t size_bytes = size;
+  hash_cache_bytes(key, (const char *) &size_bytes, sizeof(size_bytes));
+  hash_cache_bytes(key, field, size);
+}
+
+Cache_key get_cache_key(const Cache * cache, const char * code, const char * extension) {
+  Cache_key key = {
+    .hash1 = 0xcbf29ce484222325,
+    .hash2 = 0x84222325cbf29ce4
+  };
+  hash_cache_field(&key, code, strlen(code));
+  hash_cache_field(&key, CACHE_COMPILER_VERSION, strlen(CACHE_COMPILER_VERSION));
+  hash_cache_field(&key, extension, strlen(extension));
+  hash_cache_field(&key, cache->options, strlen(cache->options));
+  return key;
+}
+
+// returns the path of the output of the key in the cache, it has to be freed
+static char * get_cache_entry_path(const Cache * cache, const Cache_key key, const char * extension) {
+  const int size = strlen(cache->directory) + 1 + 32 + strlen(extension) + 1;
+  char * path = smalloc(size);
+  snprintf(path, size, "%s/%016llx%016llx%s", cache->directory, (unsigned long long) key.hash1, (unsigned long long) key.hash2, extension);
+  return path;
+}
+
+// writes the data of the source file in the destination file and closes it, returns false if it could not
+static bool copy_file_data(FILE * source_ptr, FILE * destination_ptr) {
+  char buffer[8192];
+  size_t size;
+  bool is_copied = true;
+  while ((size = fread(buffer, 1, sizeof(buffer), source_ptr)) > 0) {
+    if (fwrite(buffer, 1, size, destination_ptr) != size) {
+      is_copied = false;
+      break;
+    }
+  }
+  if (ferror(source_ptr)) {
+    is_copied = false;
+  }
+  if (fclose(destination_ptr) != 0) {
+    is_copied = false;
+  }
+  return is_copied;
+}
+
+// copies the file with its permissions, so the executables can still be run, returns false if it could not
+// the copies never share their data with the cache, so changing one of them does not change the other
+static bool copy_file(const char * source_file, const char * destination_file) {
+  FILE * source_ptr = fopen(source_file, "rb");
+  if (source_ptr == NULL) {
+    return false;
+  }
+  struct stat file_info;
+  const int destination_descriptor = fstat(fileno(source_ptr), &file_info) != 0 ? -1
+    : open(destination_file, O_WRONLY | O_CREAT | O_TRUNC, file_info.st_mode & 0777);
+  FILE * destination_ptr = destination_descriptor < 0 ? NULL : fdopen(destination_descriptor, "wb");
+  if (destination_ptr == NULL) {
+    if (destination_descriptor >= 0) {
+      close(destination_descriptor);
+    }
+    fclose(source_ptr);
+    return false;
+  }
+  const bool is_copied = copy_file_data(source_ptr, destination_ptr);
+  fclose(source_ptr);
+  return is_copied;
+}
+
+// the name of the output in the cache directory, without the directory
+static const char * get_cache_entry_name(const char * entry_path) {
+  const char * last_slash = strrchr(entry_path, '/');
+  return last_slash == NULL ? entry_path : last_slash + 1;
+}
+
+
+/* the times of the last uses of the outputs */
+
+static int compare_cache_uses(const void * use1_ptr, const void * use2_ptr) {
+  const Cache_use * use1 = use1_ptr;
+  const Cache_use * use2 = use2_ptr;
+  const int names_order = strcmp(use1->name, use2->name);
+  if (names_order != 0) {
+    return names_order;
+  }
+  if (use1->time.tv_sec != use2->time.tv_sec) {
+    return use1->time.tv_sec < use2->time.tv_sec ? -1 : 1;
+  }
+  if (use1->time.tv_nsec != use2->time.tv_nsec) {
+    return use1->time.tv_nsec < use2->time.tv_nsec ? -1 : 1;
+  }
+  return 0;
+}
+
+// the uses can outlive the arena of the thread that adds them, so they are allocated without it
+static void append_cache_use(Cache_uses * uses, const char * name, const struct timespec time) {
+  Arena * previous_arena = active_arena;
+  active_arena = NULL;
+  uses->uses_count++;
+  uses->uses = srealloc(uses->uses, uses->uses_count * sizeof(*uses->uses));
+  active_arena = previous_arena;
+  Cache_use * use = &uses->uses[uses->uses_count -1];
+  snprintf(use->name, sizeof(use->name), "%s", name);
+  use->time = time;
+}
+
+static void free_cache_uses(Cache_uses * uses) {
+  // they were not allocated in the arena
+  free(uses->uses);
+  *uses = (Cache_uses) { .uses_count = 0, .uses = NULL };
+}
+
+// sorts the uses by name and keeps only the last use of every output
+static void merge_cache_uses(Cache_uses * uses) {
+  if (uses->uses_count == 0) {
+    return;
+  }
+  qsort(uses->uses, uses->uses_count, sizeof(*uses->uses), compare_cache_uses);
+  int merged_count = 0;
+  for (int i = 0; i < uses->uses_count; i++) {
+    if (i + 1 < uses->uses_count && strcmp(uses->uses[i].name, uses->uses[i + 1].name) == 0) {
+      continue;
+    }
+    uses->uses[merged_count++] = uses->uses[i];
+  }
+  uses->uses_count = merged_count;
+}
+
+// returns the last use of the output in the merged uses, or NULL if it was not used
+static const Cache_use * find_cache_use(const Cache_uses * uses, const char * name) {
+  int first = 0;
+  int last = uses->uses_count -1;
+  while (first <= last) {
+    const int middle = (first + last) / 2;
+    const int order = strcmp(uses->uses[middle].name, name);
+    if (order == 0) {
+      return &uses->uses[middle];
+    }
+    if (order < 0) {
+      first = middle + 1;
+    }
+    else {
+      last = middle -1;
+    }
+  }
+  return NULL;
+}
+
+// moves the uses of this process to the uses read from the stats file
+static void take_cache_uses(Cache * cache, Cache_uses * uses) {
+  mtx_lock(&cache->uses_mutex);
+  for (int i = 0; i < cache->uses.uses_count; i++) {
+    append_cache_use(uses, cache->uses.uses[i].name, cache->uses.uses[i].time);
+  }
+  free_cache_uses(&cache->uses);
+  mtx_unlock(&cache->uses_mutex);
+  merge_cache_uses(uses);
+}
+
+
+/* the stats file */
+
+// the stats of all the processes that used the cache
+typedef struct Cache_stats {
+  long long hits;
+  long long misses;
+  long long evictions;
+  // size of all the outputs, or -1 if the file does not have it
+  long long size;
+  Cache_uses uses;
+} Cache_stats;
+
+static long long get_cache_entries_size(const Cache * cache);
+
+// opens the stats file locked, so the processes using the cache at the same time do not lose counts
+// the uses in it are merged, the outputs saved by this process are added to its size, that is the size
+// this process knows then, and it has to be closed with close_cache_stats
+static FILE * open_cache_stats(Cache * cache, Cache_stats * stats) {
+  *stats = (Cache_stats) { .uses = { .uses_count = 0, .uses = NULL } };
+  const int size = strlen(cache->directory) + strlen(CACHE_STATS_FILE) + 2;
+  char * path = smalloc(size);
+  snprintf(path, size, "%s/%s", cache->directory, CACHE_STATS_FILE);
+  mtx_lock(&cache->stats_mutex);
+  const int stats_file = open(path, O_RDWR | O_CREAT, 0666);
+  sfree(path);
+  if (stats_file < 0) {
+    mtx_unlock(&cache->stats_mutex);
+    return NULL;
+  }
+  struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 0 };
+  fcntl(stats_file, F_SETLKW, &lock);
+  FILE * stats_ptr = fdopen(stats_file, "r+");
+  if (fscanf(stats_ptr, "hits %lld misses %lld evictions %lld", &stats->hits, &stats->misses, &stats->evictions) != 3) {
+    stats->hits = 0;
+    stats->misses = 0;
+    stats->evictions = 0;
+  }
+  // the first time the cache is used by a compiler that keeps its size, the outputs in it are listed once
+  if (fscanf(stats_ptr, " size %lld", &stats->size) != 1) {
+    stats->size = -1;
+  }
+  // every output that was used has a line: use [name] [seconds] [nanoseconds], the name fits in CACHE_ENTRY_NAME_SIZE
+  char name[CACHE_ENTRY_NAME_SIZE];
+  long long seconds;
+  long nanoseconds;
+  while (fscanf(stats_ptr, " use %63s %lld %ld", name, &seconds, &nanoseconds) == 3) {
+    append_cache_use(&stats->uses, name, (struct timespec) { .tv_sec = seconds, .tv_nsec = nanoseconds });
+  }
+  merge_cache_uses(&stats->uses);
+  if (stats->size < 0) {
+    stats->size = get_cache_entries_size(cache);
+    atomic_store(&cache->added_size, 0);
+  }
+  stats->size += atomic_exchange(&cache->added_size, 0);
+  atomic_store(&cache->size, stats->size);
+  return stats_ptr;
+}
+
+// writes the stats over the ones in the file, frees their uses and closes the file, that releases its lock
+static void close_cache_stats(Cache * cache, FILE * stats_ptr, Cache_stats * stats) {
+  rewind(stats_ptr);
+  fprintf(stats_ptr, "hits %lld\nmisses %lld\nevictions %lld\nsize %lld\n", stats->hits, stats->misses, stats->evictions, stats->size);
+  for (int i = 0; i < stats->uses.uses_count; i++) {
+    const Cache_use use = stats->uses.uses[i];
+    fprintf(stats_ptr, "use %s %lld %ld\n", use.name, (long long) use.time.tv_sec, (long) use.time.tv_nsec);
+  }
+  // the uses of the removed outputs are not written again, so the file can get shorter,
+  // if it can not be cut the old uses left after the new ones are dropped by the next eviction
+  fflush(stats_ptr);
+  const int truncated = ftruncate(fileno(stats_ptr), ftell(stats_ptr));
+  (void) truncated;
+  fclose(stats_ptr);
+  mtx_unlock(&cache->stats_mutex);
+  free_cache_uses(&stats->uses);
+}
+
+// writes the uses of this process in the stats file
+static void flush_cache_uses(Cache * cache) {
+  Cache_stats stats;
+  FILE * stats_ptr = open_cache_stats(cache, &stats);
+  if (stats_ptr != NULL) {
+    take_cache_uses(cache, &stats.uses);
+    close_cache_stats(cache, stats_ptr, &stats);
+  }
+}
+
+// the output in the cache was used now, it is written in the stats file later
+static void use_cache_entry(Cache * cache, const char * entry_path) {
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  mtx_lock(&cache->uses_mutex);
+  append_cache_use(&cache->uses, get_cache_entry_name(entry_path), now);
+  const bool is_flushed = cache->uses.uses_count >= CACHE_USES_FLUSH_COUNT;
+  mtx_unlock(&cache->uses_mutex);
+  if (is_flushed) {
+    flush_cache_uses(cache);
+  }
+}
+
+// puts a copy of the cached output of the key in the output file, returns false if it is not in the cache
+bool load_from_cache(Cache * cache, const Cache_key key, const char * result_file) {
+  char * entry_path = get_cache_entry_path(cache, key, get_file_extension(result_file));
+  bool is_hit = access(entry_path, F_OK) == 0;
+  if (is_hit) {
+    // the copy gets the permissions of the output in the cache, and they are only set when the file is created
+    // only regular files are removed, the output could be something like /dev/stdout
+    struct stat file_info;
+    if (stat(result_file, &file_info) == 0 && S_ISREG(file_info.st_mode)) {
+      remove(result_file);
+    }
+    is_hit = copy_file(entry_path, result_file);
+  }
+  if (is_hit) {
+    use_cache_entry(cache, entry_path);
+    atomic_fetch_add(&cache->hits, 1);
+  }
+  else {
+    atomic_fetch_add(&cache->misses, 1);
+  }
+  sfree(entry_path);
+  return is_hit;
+}
+
+// a file in the cache directory, for sorting them by last use
+typedef struct Cache_entry {
+  char * path;
+  long long size;
+  struct timespec last_use;
+} Cache_entry;
+
+static int compare_cache_entries(const void * entry1_ptr, const void * entry2_ptr) {
+  const Cache_entry * entry1 = entry1_ptr;
+  const Cache_entry * entry2 = entry2_ptr;
+  if (entry1->last_use.tv_sec != entry2->last_use.tv_sec) {
+    return entry1->last_use.tv_sec < entry2->last_use.tv_sec ? -1 : 1;
+  }
+  if (entry1->last_use.tv_nsec != entry2->last_use.tv_nsec) {
+    return entry1->last_use.tv_nsec < entry2->last_use.tv_nsec ? -1 : 1;
+  }
+  return 0;
+}
+
+// lists the outputs saved in the cache, the stats and the temporary files are not outputs
+static int list_cache_entries(const Cache * cache, Cache_entry ** entries) {
+  int entries_count = 0;
+  *entries = NULL;
+  DIR * dir = opendir(cache->directory);
+  if (dir == NULL) {
+    return 0;
+  }
+  struct dirent * dir_entry;
+  while ((dir_entry = readdir(dir)) != NULL) {
+    const char * name = dir_entry->d_name;
+    if (name[0] == '.' || strcmp(name, CACHE_STATS_FILE) == 0) {
+      continue;
+    }
+    const int size = strlen(cache->directory) + strlen(name) + 2;
+    char * path = smalloc(size);
+    snprintf(path, size, "%s/%s", cache->directory, name);
+    struct stat file_info;
+    if (stat(path, &file_info) != 0 || !S_ISREG(file_info.st_mode)) {
+      sfree(path);
+      continue;
+    }
+    entries_count++;
+    *entries = srealloc(*entries, entries_count * sizeof(**entries));
+    (*entries)[entries_count -1] = (Cache_entry) {
+      .path = path,
+      .size = file_info.st_size,
+      .last_use = file_info.st_mtim
+    };
+  }
+  closedir(dir);
+  return entries_count;
+}
+
+static void free_cache_entries(Cache_entry * entries, const int entries_count) {
+  for (int i = 0; i < entries_count; i++) {
+    sfree(entries[i].path);
+  }
+  sfree(entries);
+}
+
+static long long get_cache_entries_size(const Cache * cache) {
+  Cache_entry * entries;
+  const int entries_count = list_cache_entries(cache, &entries);
+  long long total_size = 0;
+  for (int i = 0; i < entries_count; i++) {
+    total_size += entries[i].size;
+  }
+  free_cache_entries(entries, entries_count);
+  return total_size;
+}
+
+// removes the least recently used outputs until the cache fits in its size limit
+// the outputs that were never used since they were saved have the time they were saved
+// the stats file stays locked, so the uses of the other processes are not lost
+static void evict_cache_entries(Cache * cache) {
+  Cache_stats stats;
+  FILE * stats_ptr = open_cache_stats(cache, &stats);
+  if (stats_ptr == NULL) {
+    return;
+  }
+  take_cache_uses(cache, &stats.uses);
+  Cache_entry * entries;
+  const int entries_count = list_cache_entries(cache, &entries);
+  long long total_size = 0;
+  Cache_uses kept_uses = { .uses_count = 0, .uses = NULL };
+  for (int i = 0; i < entries_count; i++) {
+    total_size += entries[i].size;
+    const Cache_use * use = find_cache_use(&stats.uses, get_cache_entry_name(entries[i].path));
+    if (use != NULL) {
+      entries[i].last_use = use->time;
+    }
+  }
+  if (total_size > cache->size_limit) {
+    qsort(entries, entries_count, sizeof(*entries), compare_cache_entries);
+  }
+  // only the uses of the outputs that are still in the cache are kept
+  for (int i = 0; i < entries_count; i++) {
+    if (total_size > cache->size_limit && remove(entries[i].path) == 0) {
+      total_size -= entries[i].size;
+      atomic_fetch_add(&cache->evictions, 1);
+    }
+    else if (find_cache_use(&stats.uses, get_cache_entry_name(entries[i].path)) != NULL) {
+      append_cache_use(&kept_uses, get_cache_entry_name(entries[i].path), entries[i].last_use);
+    }
+  }
+  free_cache_entries(entries, entries_count);
+  free_cache_uses(&stats.uses);
+  merge_cache_uses(&kept_uses);
+  stats.uses = kept_uses;
+  // the size is counted again from the outputs, it corrects the one kept in the file
+  stats.size = total_size;
+  atomic_store(&cache->size, total_size);
+  close_cache_stats(cache, stats_ptr, &stats);
+}
+
+// saves the output file in the cache
+// it is written in a temporary file and then renamed, so other processes never see it half written,
+// the temporary file is only written through the descriptor that created it, it is never opened again by its name
+// the outputs are only listed to remove some of them when the size of the cache goes over its limit
+void store_in_cache(Cache * cache, const Cache_key key, const char * result_file) {
+  FILE * source_ptr = fopen(result_file, "rb");
+  struct stat file_info;
+  if (source_ptr == NULL || fstat(fileno(source_ptr), &file_info) != 0) {
+    if (source_ptr != NULL) {
+      fclose(source_ptr);
+    }
+    return;
+  }
+  char * entry_path = get_cache_entry_path(cache, key, get_file_extension(result_file));
+  const int size = strlen(cache->directory) + 16;
+  char * temporary_path = smalloc(size);
+  snprintf(temporary_path, size, "%s/.tmp-XXXXXX", cache->directory);
+  const int temporary_file = mkstemp(temporary_path);
+  FILE * temporary_ptr = temporary_file < 0 ? NULL : fdopen(temporary_file, "wb");
+  if (temporary_ptr == NULL) {
+    if (temporary_file >= 0) {
+      close(temporary_file);
+      remove(temporary_path);
+    }
+  }
+  else {
+    // the temporary file is only for its owner, the output gets the permissions of the compiled one
+    const bool is_permitted = fchmod(temporary_file, file_info.st_mode & 0777) == 0;
+    const bool is_copied = copy_file_data(source_ptr, temporary_ptr) && is_permitted;
+    // an output saved again by another compilation is replaced, its size is not counted twice
+    struct stat replaced_info;
+    const long long replaced_size = stat(entry_path, &replaced_info) == 0 ? replaced_info.st_size : 0;
+    if (is_copied && rename(temporary_path, entry_path) == 0) {
+      const long long added_size = file_info.st_size - replaced_size;
+      atomic_fetch_add(&cache->added_size, added_size);
+      if (atomic_fetch_add(&cache->size, added_size) + added_size > cache->size_limit) {
+        evict_cache_entries(cache);
+      }
+    }
+    else {
+      remove(temporary_path);
+    }
+  }
+  fclose(source_ptr);
+  sfree(temporary_path);
+  sfree(entry_path);
+}
+
+Cache * open_cache(const char * directory, const long long size_limit) {
+  if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+    errorf("File Error: Can not create the cache directory: %s\n", directory);
+  }
+  Cache * cache = smalloc(sizeof(*cache));
+  cache->directory = smalloc(strlen(directory) + 1);
+  strcpy(cache->directory, directory);
+  cache->size_limit = size_limit;
+  cache->options = smalloc(1);
+  cache->options[0] = '\0';
+  atomic_init(&cache->hits, 0);
+  atomic_init(&cache->misses, 0);
+  atomic_init(&cache->evictions, 0);
+  atomic_init(&cache->size, 0);
+  atomic_init(&cache->added_size, 0);
+  mtx_init(&cache->uses_mutex, mtx_plain);
+  cache->uses = (Cache_uses) { .uses_count = 0, .uses = NULL };
+  mtx_init(&cache->stats_mutex, mtx_plain);
+  // the size of the outputs saved by the other processes
+  flush_cache_uses(cache);
+  return cache;
+}
+
+// sets the options that change the generated code, the outputs of other options are not used
+void set_cache_options(Cache * cache, const char * options) {
+  sfree(cache->options);
+  cache->options = smalloc(strlen(options) + 1);
+  strcpy(cache->options, options);
+}
+
+// adds the counters and the uses of this process to the stats file and frees the cache
+void close_cache(Cache * cache) {
+  Cache_stats stats;
+  FILE * stats_ptr = open_cache_stats(cache, &stats);
+  if (stats_ptr != NULL) {
+    stats.hits += atomic_load(&cache->hits);
+    stats.misses += atomic_load(&cache->misses);
+    stats.evictions += atomic_load(&cache->evictions);
+    take_cache_uses(cache, &stats.uses);
+    close_cache_stats(cache, stats_ptr, &stats);
+  }
+  free_cache_uses(&cache->uses);
+  mtx_destroy(&cache->uses_mutex);
+  mtx_destroy(&cache->stats_mutex);
+  sfree(cache->options);
+  sfree(cache->directory);
+  sfree(cache);
+}
+
+void print_cache_stats(Cache * cache) {
+  Cache_stats stats;
+  FILE * stats_ptr = open_cache_stats(cache, &stats);
+  if (stats_ptr != NULL) {
+    close_cache_stats(cache, stats_ptr, &stats);
+  }
+  // the counters of this process are not in the file yet
+  stats.hits += atomic_load(&cache->hits);
+  stats.misses += atomic_load(&cache->misses);
+  stats.evictions += atomic_load(&cache->evictions);
+  Cache_entry * entries;
+  const int entries_count = list_cache_entries(cache, &entries);
+  long long total_size = 0;
+  for (int i = 0; i < entries_count; i++) {
+    total_size += entries[i].size;
+  }
+  free_cache_entries(entries, entries_count);
+
+  const long long lookups = stats.hits + stats.misses;
+  printf("cache directory: %s\n", cache->directory);
+  printf("entries: %d\n", entries_count);
+  printf("size: %lld bytes, limit: %lld bytes\n", total_size, cache->size_limit);
+  printf("hits: %lld, misses: %lld, hit rate: %.1f%%\n", stats.hits, stats.misses, lookups == 0 ? 0.0 : 100.0 * stats.hits / lookups);
+  printf("evictions: %lld\n", stats.evictions);
+}
+
+#endif
@@ -36,14 +36,14 @@ static bool compare_2_types(const Node_Type type1, const Node_Type type2) {
     return compare_str_of_tokens(token_type1, token_type2);
   }
   else if (type1.type_type == type_ptr_type) {
-    Node_Type tmp_type1 = *type1.type_value.type_ptr_value;
-    Node_Type tmp_type2 = *type2.type_value.type_ptr_value;
+    Node_Type tmp_type1 = *get_pointed_type(type1);
+    Node_Type tmp_type2 = *get_pointed_type(type2);
     return compare_2_types(tmp_type1, tmp_type2);
   }
   else if (type1.type_type == type_array_type) {
-    Node_Array_type tmp_type1 = *type1.type_value.type_array_value;
-    Node_Array_type tmp_type2 = *type2.type_value.type_array_value;
-    return compare_2_types(*tmp_type1.primitive_type, *tmp_type2.primitive_type) && compare_str_of_tokens(tmp_type1.elements_count, tmp_type2.elements_count);
+    Node_Array_type tmp_type1 = *get_array_type(type1);
+    Node_Array_type tmp_type2 = *get_array_type(type2);
+    return compare_2_types(*get_type(tmp_type1.primitive_type), *get_type(tmp_type2.primitive_type)) && compare_str_of_tokens(tmp_type1.elements_count, tmp_type2.elements_count);
   }
   else {
     implementation_error("checking this type of type not implemented");
@@ -69,18 +69,32 @@ static Symbol get_symbol_from_token(const Symbol_table vars, const Token token)
   return (Symbol) {};
 }
 
+// returns the first token of an expresion, used for reporting errors at the place of the expresion
+static Token get_first_token_of_expresion(const Node_Expresion expresion) {
+  switch (expresion.expresion_type) {
+    case expresion_number_type:
+      return expresion.expresion_value.expresion_number_value;
+    case expresion_identifier_type:
+      return expresion.expresion_value.expresion_identifier_value;
+    case expresion_binary_operation_type:
+      return get_first_token_of_expresion(get_binary_operation(expresion)->left_side);
+    case expresion_unary_operation_type:
+      return get_first_token_of_expresion(get_unary_operation(expresion)->expresion);
+    case expresion_array_type:
+      if (expresion.expresion_value.expresion_array_value.elements_count == 0) {
+        return NULL_TOKEN;
+      }
+      return get_first_token_of_expresion(get_array_elements(expresion.expresion_value.expresion_array_value)[0]);
+  }
+  return NULL_TOKEN;
+}
+
 // returns the type of a given expresion
 Node_Type get_type_of_expresion(const Symbol_table vars, const Node_Expresion expresion) {
   switch (expresion.expresion_type) {
     case expresion_number_type: {
       // FIX: can not get the type of an integer literal so assume it is `u64`
-      Node_Type type;
-      type.token.beginning = smalloc(4); // FIX: this leaks memory
-      strcpy(type.token.beginning, "u64");
-      type.token.length = 3;
-      type.type_type = type_primitive_type;
-      type.type_value.type_primitive_value = type.token;
-      return type;
+      return get_literal_type();
       break;
     }
     case expresion_identifier_type: {
@@ -90,19 +104,18 @@ Node_Type get_type_of_expresion(const Symbol_table vars, const Node_Expresion ex
       break;
     }
     case expresion_unary_operation_type: {
-      Node_Unary_Operation uni_operation = *expresion.expresion_value.expresion_unary_operation_value;
+      Node_Unary_Operation uni_operation = *get_unary_operation(expresion);
       Node_Expresion uni_expresion = uni_operation.expresion;
       Node_Type type;
       // if the operation is the address operator `&`, the returned type is a pointer to the type of the expression
       if (uni_operation.operation_type == unary_operation_addr_type) {
         type.token = NULL_TOKEN;
         type.type_type = type_ptr_type;
-        type.type_value.type_ptr_value = smalloc(sizeof(*type.type_value.type_ptr_value)); // FIX: this leaks memory
-        *type.type_value.type_ptr_value = get_type_of_expresion(vars, uni_expresion);
+        type.type_value.type_ptr_value = add_type(get_type_of_expresion(vars, uni_expresion));
       }
       // if the operation is the dereference operator `*`, the returned type is type the pointer holds
       else if (uni_operation.operation_type == unary_operation_deref_type) {
-        type = *get_type_of_expresion(vars, uni_expresion).type_value.type_ptr_value;
+        type = *get_pointed_type(get_type_of_expresion(vars, uni_expresion));
       }
       else {
         type = get_type_of_expresion(vars, uni_expresion);
@@ -111,19 +124,19 @@ Node_Type get_type_of_expresion(const Symbol_table vars, const Node_Expresion ex
       break;
     }
     case expresion_binary_operation_type: {
-      Node_Binary_Operation bin_operation = *expresion.expresion_value.expresion_binary_operation_value;
+      Node_Binary_Operation bin_operation = *get_binary_operation(expresion);
       Node_Expresion lhs_expr = bin_operation.left_side;
       Node_Expresion rhs_expr = bin_operation.right_side;
       Node_Type lhs_type = get_type_of_expresion(vars, lhs_expr);
       Node_Type rhs_type = get_type_of_expresion(vars, rhs_expr);
       // if any of the operands is a pointer throw an error
       if (lhs_type.type_type == type_ptr_type || rhs_type.type_type == type_ptr_type) {
-        error("can not operate with a pointer");
+        errorf_at(get_first_token_of_expresion(expresion), "can not operate with a pointer\n");
       }
       // if the operation is an array access
       if (bin_operation.operation_type == binary_operation_access_type) {
         // return the type the array contains
-        return *lhs_type.type_value.type_array_value->primitive_type;
+        return *get_type(get_array_type(lhs_type)->primitive_type);
       }
       // does not matter if its `lhs_type` or `rhs_type` 
       return lhs_type;
@@ -133,15 +146,14 @@ Node_Type get_type_of_expresion(const Symbol_table vars, const Node_Expresion ex
       Node_Type type;
       type.token = NULL_TOKEN;
       type.type_type = type_array_type;
-      type.type_value.type_array_value = smalloc(sizeof(*type.type_value.type_array_value));
-      type.type_value.type_array_value->primitive_type = smalloc(sizeof(*type.type_value.type_array_value->primitive_type));
-      *type.type_value.type_array_value->primitive_type = get_type_of_expresion(vars, expresion.expresion_value.expresion_array_value->elements[0]);
-      // FIX: convert the number to token in a more reasonable way
-      type.type_value.type_array_value->elements_count.beginning = smalloc(2);
-      type.type_value.type_array_value->elements_count.length = 2;
-      type.type_value.type_array_value->elements_count.beginning[0] = '0' + expresion.expresion_value.expresion_array_value->elements_count / 10;
-      type.type_value.type_array_value->elements_count.beginning[1] = '0' + expresion.expresion_value.expresion_array_value->elements_count % 10;
-      type.type_value.type_array_value->elements_count.type = Number;
+      Node_Type element_type = get_type_of_expresion(vars, get_array_elements(expresion.expresion_value.expresion_array_value)[0]);
+      // the integers inside an array literal are u64, they are converted when it is given to an array of other integers
+      if (element_type.type_type == type_primitive_type) {
+        element_type = get_literal_type();
+      }
+      const Node_index primitive_type = add_type(element_type);
+      type.type_value.type_array_value = add_array_type((Node_Array_type) { .primitive_type = primitive_type });
+      get_array_type(type)->elements_count = get_number_token(expresion.expresion_value.expresion_array_value.elements_count);
       return type;
       break;
     }
@@ -172,46 +184,47 @@ static bool is_expresion_valid(const Symbol_table scopes, const Node_Expresion e
   else if (expresion.expresion_type == expresion_identifier_type) {
     Token variable = expresion.expresion_value.expresion_identifier_value;
     if (!is_var_in_var_list(scopes, variable)) {
-      errorf("Line:%d, column:%d.  Error: undeclared variable used\n", variable.line_number, variable.column_number);
+      errorf_at(variable, "undeclared variable used\n");
     }
   }
   else if (expresion.expresion_type == expresion_binary_operation_type) {
-    Node_Expresion lhs_expr = expresion.expresion_value.expresion_binary_operation_value->left_side;
-    Node_Expresion rhs_expr = expresion.expresion_value.expresion_binary_operation_value->right_side;
-    Node_Binary_Operation bin_operation = *expresion.expresion_value.expresion_binary_operation_value;
+    Node_Expresion lhs_expr = get_binary_operation(expresion)->left_side;
+    Node_Expresion rhs_expr = get_binary_operation(expresion)->right_side;
+    Node_Binary_Operation bin_operation = *get_binary_operation(expresion);
+    // check the operands first, so their types can be known
+    is_expresion_valid(scopes, lhs_expr);
+    is_expresion_valid(scopes, rhs_expr);
     if (bin_operation.operation_type == binary_operation_access_type) {
       Node_Type lhs_type = get_type_of_expresion(scopes, lhs_expr);
       Node_Type rhs_type = get_type_of_expresion(scopes, rhs_expr);
-      // the type for the left side has to be an array and for the right side an 'u64'
-      // TODO: make this condition nicer
-      if (!(lhs_type.type_type == type_array_type && rhs_type.type_type == type_primitive_type && compare_token_to_string(rhs_type.token, "u64"))) {
-        error("can only access an value that has array type, and with an integer index");
+      // the type for the left side has to be an array and for the right side an integer
+      if (!(lhs_type.type_type == type_array_type && rhs_type.type_type == type_primitive_type)) {
+        errorf_at(get_first_token_of_expresion(lhs_expr), "can only access an value that has array type, and with an integer index\n");
       }
     }
-    is_expresion_valid(scopes, lhs_expr);
-    is_expresion_valid(scopes, rhs_expr);
   }
   else if (expresion.expresion_type == expresion_unary_operation_type) {
-    Node_Unary_Operation uni_operation = *expresion.expresion_value.expresion_unary_operation_value;
+    Node_Unary_Operation uni_operation = *get_unary_operation(expresion);
+    // check the operand first, so its type can be known
+    is_expresion_valid(scopes, uni_operation.expresion);
     if (uni_operation.operation_type == unary_operation_addr_type) {
       // can only get the address of a variable
       if (uni_operation.expresion.expresion_type != expresion_identifier_type) {
-        error("can only take the address of a variable");
+        errorf_at(get_first_token_of_expresion(uni_operation.expresion), "can only take the address of a variable\n");
       }
     }
     else if (uni_operation.operation_type == unary_operation_deref_type) {
       // can only dereference a pointer
       if (get_type_of_expresion(scopes, uni_operation.expresion).type_type != type_ptr_type) {
-        error("can only dereference a pointer");
+        errorf_at(get_first_token_of_expresion(uni_operation.expresion), "can only dereference a pointer\n");
       }
     }
     else {
       implementation_error("unkown type of unary operation while checking");
     }
-    is_expresion_valid(scopes, uni_operation.expresion);
   }
   else if (expresion.expresion_type == expresion_array_type) {
-    Node_Array array = *expresion.expresion_value.expresion_array_value;
+    Node_Array array = expresion.expresion_value.expresion_array_value;
     if (array.elements_count == 0) {
       error("can not have an empty array in expresion");
       return false;
@@ -219,16 +232,17 @@ static bool is_expresion_valid(const Symbol_table scopes, const Node_Expresion e
 
     // check that every expresion inside the array is valid
     for (int i = 0; i < array.elements_count; i++) {
-      if (!is_expresion_valid(scopes, array.elements[i])) {
+      if (!is_expresion_valid(scopes, get_array_elements(array)[i])) {
         return false;
       }
     }
-    // also check that every expression inside has the same type
-    const Node_Type expected_type = get_type_of_expresion(scopes, array.elements[0]); 
+    // also check that every expression inside has the same type, the integers of any size are the same
+    const Node_Type expected_type = get_type_of_expresion(scopes, get_array_elements(array)[0]); 
     for (int i = 0; i < array.elements_count; i++) {
-      Node_Type sub_expresion_type = get_type_of_expresion(scopes, array.elements[i]);
-      if (!compare_2_types(expected_type, sub_expresion_type)) {
-        errorf("Line:%d, column:%d.  Error: the elements inside the array does not have the same type\n", sub_expresion_type.token.line_number, sub_expresion_type.token.column_number);
+      Node_Type sub_expresion_type = get_type_of_expresion(scopes, get_array_elements(array)[i]);
+      const bool are_integers = expected_type.type_type == type_primitive_type && sub_expresion_type.type_type == type_primitive_type;
+      if (!are_integers && !compare_2_types(expected_type, sub_expresion_type)) {
+        errorf_at(get_first_token_of_expresion(get_array_elements(array)[i]), "the elements inside the array does not have the same type\n");
       }
     }
   }
@@ -238,6 +252,29 @@ static bool is_expresion_valid(const Symbol_table scopes, const Node_Expresion e
   return true;
 }
 
+// returns if the value of the expresion can be given to something of the type,
+// the integers are converted between their sizes, keeping the lower bits when they do not fit,
+// and so are the elements of an array literal, but the arrays and the pointers in memory must have the same type
+static bool is_expresion_convertible(const Symbol_table vars, const Node_Type type, const Node_Expresion expresion) {
+  const Node_Type expresion_type = get_type_of_expresion(vars, expresion);
+  if (type.type_type == type_primitive_type && expresion_type.type_type == type_primitive_type) {
+    return true;
+  }
+  if (type.type_type == type_array_type && expresion.expresion_type == expresion_array_type) {
+    const Node_Array array = expresion.expresion_value.expresion_array_value;
+    if (array.elements_count != (int) get_array_type(type)->elements_count.value) {
+      return false;
+    }
+    for (int i = 0; i < array.elements_count; i++) {
+      if (!is_expresion_convertible(vars, *get_type(get_array_type(type)->primitive_type), get_array_elements(array)[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return compare_2_types(type, expresion_type);
+}
+
 // append a variable to the array of variables in the last scope
 static void append_var_to_var_list(const Symbol variable, Symbol_table * scopes) {
   Symbols_scope * last_scope = &scopes->scopes[scopes->scopes_count -1];
@@ -254,30 +291,26 @@ static void create_scope(Symbol_table * scopes) {
   scopes->scopes[scopes->scopes_count -1].vars = smalloc(scopes->scopes[scopes->scopes_count -1].vars_count * sizeof(*scopes->scopes[scopes->scopes_count -1].vars));
 }
 
-// create a copy of the scopes and its variables
-static Symbol_table copy_Symbol_table(Symbol_table scopes) {
-  Symbol_table result;
-  result.scopes_count = scopes.scopes_count;
-  result.scopes = smalloc(scopes.scopes_count * sizeof(*scopes.scopes));
-  for (int i = 0; i < scopes.scopes_count; i++) {
-    result.scopes[i].vars_count = scopes.scopes[i].vars_count;
-    result.scopes[i].vars = smalloc(result.scopes[i].vars_count * sizeof(*result.scopes[i].vars));
-    // TODO; use memcpy() here
-    for (int j = 0; j < result.scopes[i].vars_count; j++) {
-      result.scopes[i].vars[j] = scopes.scopes[i].vars[j];
-    }
-  }
-  return result;
+// the variables declared inside a block are forgotten at its end,
+// they are in the last scope after the ones from before the block
+static int get_block_beginning(const Symbol_table * scopes) {
+  return scopes->scopes[scopes->scopes_count -1].vars_count;
+}
+
+static void forget_block_variables(Symbol_table * scopes, const int block_beginning) {
+  scopes->scopes[scopes->scopes_count -1].vars_count = block_beginning;
 }
 
 // free the memory of the scopes
 static void free_Symbol_table(Symbol_table variables) {
   for (int i = 0; i < variables.scopes_count; i++ ) {
-    free(variables.scopes[i].vars);
+    sfree(variables.scopes[i].vars);
   }
-  free(variables.scopes);
+  sfree(variables.scopes);
 }
 
+void check_statements(Symbol_table * variables, const Node_Statement * statements, const int statements_count);
+
 // check if a statement is valid, if it is not, report it and halt
 void check_statement(Symbol_table * variables, const Node_Statement stmt) {
   switch (stmt.statement_type) {
@@ -292,16 +325,16 @@ void check_statement(Symbol_table * variables, const Node_Statement stmt) {
         .type=stmt.statement_value.var_declaration.type
       };
       if (is_var_in_var_list(*variables, variable.value)) {
-        const Token previous_var = get_symbol_from_token(*variables, variable.value).value;
-        errorf("Line:%d, column:%d.  Error: variable already declared in line:%d, column:%d.\n", previous_var.line_number, previous_var.column_number, previous_var.line_number, previous_var.column_number);
+        const Token_place previous_place = get_token_place(get_symbol_from_token(*variables, variable.value).value);
+        errorf_at(variable.value, "variable already declared in line:%d, column:%d.\n", previous_place.line_number, previous_place.column_number);
       }
       else {
         append_var_to_var_list(variable, variables);
       }
 
       // check that the types of the declaration are valid with the ones of the expresion
-      if (!compare_2_types(variable.type, get_type_of_expresion(*variables, expresion))) {
-        error("the type in variable declaration does not match the expresion type");
+      if (!is_expresion_convertible(*variables, variable.type, expresion)) {
+        errorf_at(variable.value, "the type in variable declaration does not match the expresion type\n");
       }
       break;
     }
@@ -319,68 +352,93 @@ void check_statement(Symbol_table * variables, const Node_Statement stmt) {
       // check that when assigning to a var there is another var with the same name
       Token variable = stmt.statement_value.var_assignment.var_name;
       if (!is_var_in_var_list(*variables, variable)) {
-        errorf("Line:%d, column:%d.  Error: variable has not been declared before.\n", variable.line_number, variable.column_number);
+        errorf_at(variable, "variable has not been declared before.\n");
       }
       // check that the expresion is valid
       Node_Expresion expresion = stmt.statement_value.var_assignment.value;
       is_expresion_valid(*variables, expresion);
       // check that the types of the variable and the expression match
       Node_Type var_type = get_symbol_from_token(*variables, variable).type;
-      Node_Type expr_type = get_type_of_expresion(*variables, expresion);
-      if (!compare_2_types(var_type, expr_type)) {
-        error("the type of the expression and the variable does not match");
+      if (!is_expresion_convertible(*variables, var_type, expresion)) {
+        errorf_at(variable, "the type of the expression and the variable does not match\n");
       }
       break;
     }
     case scope_type: {
-      Symbol_table scope_vars = copy_Symbol_table(*variables);
-      for (int i = 0; i < stmt.statement_value.scope.statements_count; i++) {
-        check_statement(&scope_vars, stmt.statement_value.scope.statements_node[i]);
-      }
-      free_Symbol_table(scope_vars);
+      const int block_beginning = get_block_beginning(variables);
+      check_statements(variables, get_scope_statements(stmt.statement_value.scope), stmt.statement_value.scope.statements_count);
+      forget_block_variables(variables, block_beginning);
       break;
     }
     case if_type: {
       Node_Expresion condition = stmt.statement_value.if_node.condition;
       is_expresion_valid(*variables, condition);
-      Symbol_table scope_vars = copy_Symbol_table(*variables);
-      for (int i = 0; i < stmt.statement_value.if_node.scope.statements_count; i++) {
-        check_statement(&scope_vars, stmt.statement_value.if_node.scope.statements_node[i]);
-      }
+      const int block_beginning = get_block_beginning(variables);
+      check_statements(variables, get_scope_statements(stmt.statement_value.if_node.scope), stmt.statement_value.if_node.scope.statements_count);
       if (stmt.statement_value.if_node.has_else_block) {
-        for (int i = 0; i < stmt.statement_value.if_node.else_block.statements_count; i++) {
-          check_statement(&scope_vars, stmt.statement_value.if_node.else_block.statements_node[i]);
-        }
+        check_statements(variables, get_scope_statements(stmt.statement_value.if_node.else_block), stmt.statement_value.if_node.else_block.statements_count);
       }
-      free_Symbol_table(scope_vars);
+      forget_block_variables(variables, block_beginning);
       break;
     }
     case while_type: {
       Node_Expresion condition = stmt.statement_value.while_node.condition;
       is_expresion_valid(*variables, condition);
-      Symbol_table scope_vars = copy_Symbol_table(*variables);
-      for (int i = 0; i < stmt.statement_value.while_node.scope.statements_count; i++) {
-        check_statement(&scope_vars, stmt.statement_value.while_node.scope.statements_node[i]);
-      }
-      free_Symbol_table(scope_vars);
+      const int block_beginning = get_block_beginning(variables);
+      check_statements(variables, get_scope_statements(stmt.statement_value.while_node.scope), stmt.statement_value.while_node.scope.statements_count);
+      forget_block_variables(variables, block_beginning);
       break;
     }
   }
 }
 
+// checks a list of statements
+// when the errors are being collected, a statement with errors is skipped
+// and the checking continues with the next one, so the errors of the next ones are found too
+void check_statements(Symbol_table * variables, const Node_Statement * statements, const int statements_count) {
+  // volatile because it must keep its value after jumping back from an error
+  volatile int i = 0;
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  jmp_buf recovery_point;
+  if (diagnostic_sink != NULL) {
+    if (setjmp(recovery_point) != 0) {
+      if (error_exit_code != 1) {
+        // implementation errors are not recovered
+        error_recovery_point = previous_recovery_point;
+        stop_compilation(error_exit_code);
+      }
+      // a variable whose declaration has errors is still declared, so its uses are not reported too
+      if (statements[i].statement_type == var_declaration_type) {
+        Symbol variable = {
+          .value=statements[i].statement_value.var_declaration.var_name,
+          .type=statements[i].statement_value.var_declaration.type
+        };
+        if (!is_var_in_var_list(*variables, variable.value)) {
+          append_var_to_var_list(variable, variables);
+        }
+      }
+      i++;
+    }
+    error_recovery_point = &recovery_point;
+  }
+  // check each statement correctness
+  for (; i < statements_count; i++) {
+    check_statement(variables, statements[i]);
+  }
+  error_recovery_point = previous_recovery_point;
+}
+
 // checks if the program follows the grammar rules and the language specifications
 bool is_valid_program(Node_Program program) {
+  const int previous_errors_count = diagnostic_sink == NULL ? 0 : diagnostic_sink->diagnostics_count;
   Symbol_table scopes;
   scopes.scopes_count = 0;
-  scopes.scopes = malloc(scopes.scopes_count * sizeof(Symbols_scope));
+  scopes.scopes = smalloc(scopes.scopes_count * sizeof(Symbols_scope));
   create_scope(&scopes); // create the first global scope
-  // check each statement correctness
-  for (int i = 0; i < program.statements_count; i++) {
-    Node_Statement statement = program.statements_node[i];
-    check_statement(&scopes, statement);
-  }
+  check_statements(&scopes, program.statements_node, program.statements_count);
   free_Symbol_table(scopes);
-  return true;
+  // without a sink the errors stop the compilation, so reaching here means there were none
+  return diagnostic_sink == NULL || diagnostic_sink->diagnostics_count == previous_errors_count;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,203 @@
+#ifndef CHUNKS_H_
+#define CHUNKS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <setjmp.h>
+
+#include "errors.h"
+#include "mlib.h"
+#include "parser.h"
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * *
+ * Generating the chunks of a program in parallel *
+ * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// the top level statements of a big program are split in chunks, and the code of every chunk is generated
+// into buffers of its own by the threads given with -j, then the buffers are written in the order of the chunks
+// the chunks only depend on the number of statements, not on the threads, so the code is always the same
+// the generators lay out the state at the beginning of every chunk before, like the variables and their places
+
+// the chunks have at least this many statements, and there are never more than CODE_CHUNKS_MAX of them,
+// every chunk starts with a copy of the variables declared before it
+#define CODE_CHUNK_MIN_STATEMENTS 256
+#define CODE_CHUNKS_MAX 64
+
+// the threads that generate the chunks of a program
+int code_generation_workers_count = 1;
+
+// the code of a chunk, and the code that goes after the code of all the chunks, like the cold blocks of NASM,
+// that the generator puts in its place
+typedef struct Code_chunk {
+  char * code;
+  size_t code_size;
+  char * end_code;
+  size_t end_code_size;
+} Code_chunk;
+
+typedef struct Code_chunks {
+  int chunks_count;
+  int chunk_statements_count;
+  Code_chunk * chunks;
+} Code_chunks;
+
+// generates the code of the chunk of the generator into the files
+typedef void (*Chunk_generator)(void * generator, const int chunk_index, FILE * code_file_ptr, FILE * end_file_ptr);
+
+// splits the statements in chunks, a program with few statements is a single chunk
+Code_chunks split_code_chunks(const int statements_count) {
+  int chunk_statements_count = (statements_count + CODE_CHUNKS_MAX -1) / CODE_CHUNKS_MAX;
+  if (chunk_statements_count < CODE_CHUNK_MIN_STATEMENTS) {
+    chunk_statements_count = CODE_CHUNK_MIN_STATEMENTS;
+  }
+  const int chunks_count = statements_count == 0 ? 1 : (statements_count + chunk_statements_count -1) / chunk_statements_count;
+  Code_chunks chunks = {
+    .chunks_count = chunks_count,
+    .chunk_statements_count = chunk_statements_count,
+    .chunks = smalloc(chunks_count * sizeof(*chunks.chunks))
+  };
+  for (int i = 0; i < chunks_count; i++) {
+    chunks.chunks[i] = (Code_chunk) { .code = NULL, .code_size = 0, .end_code = NULL, .end_code_size = 0 };
+  }
+  return chunks;
+}
+
+// the index of the first top level statement of the chunk, and of the one after its last one
+int get_chunk_first_statement(const Code_chunks chunks, const int chunk_index) {
+  return chunk_index * chunks.chunk_statements_count;
+}
+
+int get_chunk_end_statement(const Code_chunks chunks, const int chunk_index, const int statements_count) {
+  const int end = (chunk_index + 1) * chunks.chunk_statements_count;
+  return end < statements_count ? end : statements_count;
+}
+
+typedef struct Chunk_worker {
+  thrd_t thread;
+  bool is_thread_started;
+  Code_chunks * chunks;
+  Chunk_generator generate;
+  void * generator;
+  atomic_int * next_chunk;
+  // the worker reads the nodes of the tree from them, and adds its type nodes to blocks of its own
+  Node_pools node_pools;
+  // the places of the tokens of the tree are found in them
+  Token_texts * token_texts;
+  // exit code of the error that stopped the worker, or 0
+  int exit_code;
+} Chunk_worker;
+
+static void generate_code_chunk(Chunk_worker * worker, const int chunk_index) {
+  Code_chunk * chunk = &worker->chunks->chunks[chunk_index];
+  FILE * code_file_ptr = open_memstream(&chunk->code, &chunk->code_size);
+  FILE * end_file_ptr = open_memstream(&chunk->end_code, &chunk->end_code_size);
+  if (code_file_ptr == NULL || end_file_ptr == NULL) {
+    implementation_error("can not create the streams of a chunk of code");
+  }
+  worker->generate(worker->generator, chunk_index, code_file_ptr, end_file_ptr);
+  fclose(code_file_ptr);
+  fclose(end_file_ptr);
+}
+
+static int run_chunk_worker(void * worker_ptr) {
+  Chunk_worker * worker = worker_ptr;
+  Node_pools * previous_node_pools = active_node_pools;
+  Token_texts * previous_token_texts = active_token_texts;
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  active_node_pools = &worker->node_pools;
+  active_token_texts = worker->token_texts;
+  jmp_buf recovery_point;
+  error_recovery_point = &recovery_point;
+  if (setjmp(recovery_point) == 0) {
+    while (true) {
+      const int chunk_index = atomic_fetch_add(worker->next_chunk, 1);
+      if (chunk_index >= worker->chunks->chunks_count) {
+        break;
+      }
+      generate_code_chunk(worker, chunk_index);
+    }
+    worker->exit_code = 0;
+  }
+  else {
+    worker->exit_code = error_exit_code;
+  }
+  error_recovery_point = previous_recovery_point;
+  active_node_pools = previous_node_pools;
+  active_token_texts = previous_token_texts;
+  release_node_pools(&worker->node_pools);
+  return 0;
+}
+
+// generates the code of all the chunks, with a single worker or a single chunk everything is done in the calling thread
+// the memory of the arena of a batch worker belongs to its thread, so its compilations do not start other threads either
+void generate_code_chunks(Code_chunks * chunks, const Chunk_generator generate, void * generator, int workers_count) {
+  if (workers_count > chunks->chunks_count) {
+    workers_count = chunks->chunks_count;
+  }
+  if (workers_count <= 1 || active_arena != NULL) {
+    Chunk_worker worker = { .chunks = chunks, .generate = generate, .generator = generator };
+    for (int i = 0; i < chunks->chunks_count; i++) {
+      generate_code_chunk(&worker, i);
+    }
+    return;
+  }
+  // all the pools are forked before any worker adds nodes to them
+  atomic_int next_chunk = 0;
+  Chunk_worker * workers = smalloc(workers_count * sizeof(*workers));
+  for (int i = 0; i < workers_count; i++) {
+    workers[i] = (Chunk_worker) {
+      .is_thread_started = false,
+      .chunks = chunks,
+      .generate = generate,
+      .generator = generator,
+      .next_chunk = &next_chunk,
+      .node_pools = fork_node_pools(active_node_pools),
+      .token_texts = active_token_texts,
+      .exit_code = 0
+    };
+  }
+  for (int i = 1; i < workers_count; i++) {
+    workers[i].is_thread_started = thrd_create(&workers[i].thread, run_chunk_worker, &workers[i]) == thrd_success;
+  }
+  // the calling thread is a worker too, and it does the work of the threads that could not be created
+  run_chunk_worker(&workers[0]);
+
+  // the first error stops the compilation after all the workers end
+  int exit_code = 0;
+  for (int i = 0; i < workers_count; i++) {
+    if (workers[i].is_thread_started) {
+      thrd_join(workers[i].thread, NULL);
+    }
+    else if (i > 0) {
+      release_node_pools(&workers[i].node_pools);
+    }
+    if (exit_code == 0) {
+      exit_code = workers[i].exit_code;
+    }
+  }
+  sfree(workers);
+  if (exit_code != 0) {
+    stop_compilation(exit_code);
+  }
+}
+
+// writes the code of the chunks in their order
+void write_code_chunks(FILE * out_file_ptr, const Code_chunks chunks) {
+  for (int i = 0; i < chunks.chunks_count; i++) {
+    fwrite(chunks.chunks[i].code, 1, chunks.chunks[i].code_size, out_file_ptr);
+  }
+}
+
+void free_code_chunks(const Code_chunks chunks) {
+  for (int i = 0; i < chunks.chunks_count; i++) {
+    // the streams allocate with the system allocator
+    free(chunks.chunks[i].code);
+    free(chunks.chunks[i].end_code);
+  }
+  sfree(chunks.chunks);
+}
+
+#endif
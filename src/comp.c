@@ -1,23 +1,261 @@
+// the compiler uses some POSIX functions, not only the standard C ones
+#define _POSIX_C_SOURCE 200809L
+// and the anonymous memory mappings of Linux and the BSDs, for running the programs in memory
+#define _DEFAULT_SOURCE
+
 #include "comp.h"
+#include "batch.h"
+#include "server.h"
+
 
+static const char * usage =
+  "  compiler [-j workers] [input file path] [output file path]...\n"
+  "or:\n"
+  "  compiler [-j workers] --batch [manifest file path]\n"
+  "  compiler [-j workers] --batch [input directory] [output directory] [output extension]\n"
+  "  compiler [-j workers] --server [socket path]\n"
+  "  compiler --client [socket path] [input file path] [output file path]\n"
+  "  compiler --client [socket path] --stop\n"
+  "  compiler [-j workers] --from-ast-cache [syntax tree cache path] [output file path]...\n"
+  "  compiler --run [input file path]\n"
+  "  compiler --interpret [input file path]\n"
+  "adding --stream reads and compiles the input files statement by statement, for huge programs\n"
+  "the options for caching the outputs of the compilations are:\n"
+  "  --cache [directory]         reuse the outputs of unchanged programs saved in the directory\n"
+  "  --cache-size [megabytes]    max size of the cache, the least recently used outputs are removed\n"
+  "  --cache-stats               print the stats of the cache\n"
+  "adding --emit-ast-cache [path] saves the checked syntax tree of the program, to generate the outputs from it\n"
+  "the options of the NASM code and the executables are:\n"
+  "  -march=[processors]         the vector instructions of the loops: x86-64 (the default) and x86-64-v2 use SSE2,\n"
+  "                              x86-64-v3 and x86-64-v4 use AVX2, and native the best of this processor\n"
+  "  -fno-vectorize              do not vectorize the loops\n"
+  "  -funroll=[copies]           the copies of the body of the counted loops, 1 does not unroll them, 4 by default\n"
+  "  --unroll-report             print the loops that are unrolled\n"
+  "  --profile-use=[file]        lay out the ifs and unroll the loops with the counts of the profile file\n"
+  "the options of the C code are:\n"
+  "  --c-opt                     write C code that the C compilers optimize better, with the --profile-use hints\n"
+  "the options of the C code, the NASM code, the LLVM IR and the executables are:\n"
+  "  --bounds-check              stop the programs with an error when an index is out of the range of its array\n"
+  "  --bounds-check-report       the same, and print how many checks are removed because they can not fail\n"
+  "the options of the C code, the NASM code and the executables are:\n"
+  "  --profile-generate[=file]   the programs count the runs of their ifs and loops and write them in the profile file\n"
+  "                              when they exit, default.profile by default";
 
 int main(int argc, char ** argv) {
-  if (argc != 3) {
-    error("invalid number of cmd arguments, you must write:\n  compiler [input file path] [output file path]");
+  // separate the options from the rest of the arguments
+  int workers_count = 1;
+  const char * cache_directory = NULL;
+  long long cache_size_limit = CACHE_DEFAULT_SIZE_LIMIT;
+  bool print_stats = false;
+  const char * ast_cache_input_file = NULL;
+  bool is_run_mode = false;
+  bool is_interpret_mode = false;
+  bool is_vectorizing = true;
+  const char * profile_input_file = NULL;
+  int args_count = 0;
+  char ** args = smalloc(argc * sizeof(*args));
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "-j", 2) == 0) {
+      const char * number = argv[i][2] != '\0' ? &argv[i][2] : (i + 1 < argc ? argv[++i] : "");
+      workers_count = atoi(number);
+      if (workers_count < 1) {
+        errorf("the number of workers must be a positive integer, you must write:\n%s\n", usage);
+      }
+    }
+    else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+      cache_directory = argv[++i];
+    }
+    else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+      cache_size_limit = atof(argv[++i]) * (1 << 20);
+      if (cache_size_limit <= 0) {
+        errorf("the size of the cache must be a positive number of megabytes, you must write:\n%s\n", usage);
+      }
+    }
+    else if (strcmp(argv[i], "--cache-stats") == 0) {
+      print_stats = true;
+    }
+    else if (strcmp(argv[i], "--stream") == 0) {
+      is_streaming_enabled = true;
+    }
+    else if (strncmp(argv[i], "-march=", 7) == 0) {
+      if (!select_NASM_march(&argv[i][7])) {
+        errorf("unknown -march value: %s, you must write:\n%s\n", &argv[i][7], usage);
+      }
+    }
+    else if (strcmp(argv[i], "-fno-vectorize") == 0) {
+      is_vectorizing = false;
+    }
+    else if (strncmp(argv[i], "-funroll=", 9) == 0) {
+      NASM_unroll_factor = atoi(&argv[i][9]);
+      if (NASM_unroll_factor < 1 || NASM_unroll_factor > MAX_UNROLL_FACTOR) {
+        errorf("the copies of the unrolled loops must be between 1 and %d, you must write:\n%s\n", MAX_UNROLL_FACTOR, usage);
+      }
+    }
+    else if (strcmp(argv[i], "--unroll-report") == 0) {
+      is_reporting_unrolls = true;
+    }
+    else if (strcmp(argv[i], "--c-opt") == 0) {
+      is_optimizing_C = true;
+    }
+    else if (strcmp(argv[i], "--bounds-check") == 0) {
+      is_bounds_checking = true;
+    }
+    else if (strcmp(argv[i], "--bounds-check-report") == 0) {
+      is_bounds_checking = true;
+      is_reporting_bounds_checks = true;
+    }
+    else if (strcmp(argv[i], "--profile-generate") == 0) {
+      profile_output_file = "default.profile";
+    }
+    else if (strncmp(argv[i], "--profile-generate=", 19) == 0 && argv[i][19] != '\0') {
+      profile_output_file = &argv[i][19];
+    }
+    else if (strncmp(argv[i], "--profile-use=", 14) == 0 && argv[i][14] != '\0') {
+      profile_input_file = &argv[i][14];
+    }
+    else if (strcmp(argv[i], "--emit-ast-cache") == 0 && i + 1 < argc) {
+      ast_cache_output_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--from-ast-cache") == 0 && i + 1 < argc) {
+      ast_cache_input_file = argv[++i];
+    }
+    else if (strcmp(argv[i], "--run") == 0) {
+      is_run_mode = true;
+    }
+    else if (strcmp(argv[i], "--interpret") == 0) {
+      is_interpret_mode = true;
+    }
+    else {
+      args[args_count++] = argv[i];
+    }
+  }
+
+  if (!is_vectorizing) {
+    NASM_vector_extension = vector_extension_none;
+  }
+  if (is_interpret_mode && profile_output_file != NULL) {
+    errorf("the interpreted programs can not generate profiles, you must write:\n%s\n", usage);
+  }
+  if (profile_input_file != NULL) {
+    used_profile = load_profile(profile_input_file);
+  }
+  if (cache_directory != NULL) {
+    output_cache = open_cache(cache_directory, cache_size_limit);
+    // the outputs depend on the path of the generated profile and on the contents of the used one
+    const size_t options_size = 128 + (profile_output_file != NULL ? strlen(profile_output_file) : 0);
+    char * options = smalloc(options_size);
+    snprintf(options, options_size, "vector=%s unroll=%d bounds=%d c-opt=%d profile=%s use=%016llx",
+             vector_extension_names[NASM_vector_extension], NASM_unroll_factor, is_bounds_checking, is_optimizing_C,
+             profile_output_file != NULL ? profile_output_file : "", used_profile != NULL ? (unsigned long long) used_profile->hash : 0ull);
+    set_cache_options(output_cache, options);
+    sfree(options);
+  }
+  else if (print_stats) {
+    errorf("the stats of the cache need its directory, you must write:\n%s\n", usage);
+  }
+  // only printing the stats
+  if (print_stats && args_count == 0) {
+    print_cache_stats(output_cache);
+    close_cache(output_cache);
+    return 0;
+  }
+
+  bool is_batch_mode = args_count >= 1 && strcmp(args[0], "--batch") == 0;
+  bool is_server_mode = args_count >= 1 && strcmp(args[0], "--server") == 0;
+  bool is_client_mode = args_count >= 1 && strcmp(args[0], "--client") == 0;
+  bool is_ast_cache_mode = ast_cache_input_file != NULL;
+  if (is_ast_cache_mode && (is_batch_mode || is_server_mode || is_client_mode || args_count < 1)) {
+    errorf("invalid cmd arguments for generating the outputs from a syntax tree cache, you must write:\n%s\n", usage);
+  }
+  // the program is run from a single source file, the output is only what the program prints
+  if ((is_run_mode || is_interpret_mode) && ((is_run_mode && is_interpret_mode) || is_batch_mode || is_server_mode || is_client_mode || is_ast_cache_mode || is_streaming_enabled
+                      || args_count != 1 || workers_count != 1 || output_cache != NULL)) {
+    errorf("invalid cmd arguments for running a program, you must write:\n%s\n", usage);
+  }
+  if (is_run_mode || is_interpret_mode) {
+    const int exit_code = is_run_mode ? run_source_file(args[0]) : interpret_source_file(args[0]);
+    sfree(args);
+    return exit_code;
+  }
+  if (!is_batch_mode && !is_server_mode && !is_client_mode && !is_ast_cache_mode && args_count < 2) {
+    errorf("invalid number of cmd arguments, you must write:\n%s\n", usage);
+  }
+  // the workers of a single compilation generate the chunks of its program, the ones of a batch or a server compile the files
+  if (!is_batch_mode && !is_server_mode) {
+    code_generation_workers_count = workers_count;
+  }
+  // the syntax tree is saved from the compilation of a single file
+  if (ast_cache_output_file != NULL && (is_batch_mode || is_server_mode || is_client_mode || is_ast_cache_mode || is_streaming_enabled)) {
+    errorf("the syntax tree cache is only saved when a single file is compiled without --stream, you must write:\n%s\n", usage);
   }
   // start clock
   clock_t start = clock();
+  int exit_code = 0;
 
   // TODO: improve cmd args handling
-  char * code = argv[1];
-  char * out_file = argv[2];
+  if (is_batch_mode) {
+    Batch_result result = {0};
+    Batch_jobs jobs;
+    if (args_count == 2) {
+      jobs = read_batch_manifest(args[1], &result);
+    }
+    else if (args_count == 4) {
+      jobs = list_batch_directory(args[1], args[2], args[3]);
+    }
+    else {
+      errorf("invalid number of cmd arguments for the batch mode, you must write:\n%s\n", usage);
+    }
+    Batch_result jobs_result = run_batch(jobs, workers_count);
+    free_batch_jobs(jobs);
+    result.compiled_count += jobs_result.compiled_count;
+    result.failed_count += jobs_result.failed_count;
+
+    printf("compiled: %d, failed: %d\n", result.compiled_count, result.failed_count);
+    if (result.failed_count != 0) {
+      exit_code = 1;
+    }
+  }
+  else if (is_server_mode) {
+    if (args_count != 2) {
+      errorf("invalid number of cmd arguments for the server mode, you must write:\n%s\n", usage);
+    }
+    run_server(args[1], workers_count);
+  }
+  else if (is_client_mode) {
+    if (args_count == 3 && strcmp(args[2], "--stop") == 0 && workers_count == 1) {
+      stop_server(args[1]);
+    }
+    else if (args_count == 4 && workers_count == 1) {
+      if (!run_client(args[1], args[2], args[3])) {
+        exit_code = 1;
+      }
+    }
+    else {
+      errorf("invalid number of cmd arguments for the client mode, you must write:\n%s\n", usage);
+    }
+  }
+  else if (is_ast_cache_mode) {
+    compile_from_ast_cache(ast_cache_input_file, args, args_count);
+  }
+  else {
+    char * code = args[0];
 
-  compile(code, out_file);
+    // the program is compiled once for all the output files
+    compile(code, &args[1], args_count -1);
+  }
+  sfree(args);
+
+  if (output_cache != NULL) {
+    if (print_stats) {
+      print_cache_stats(output_cache);
+    }
+    close_cache(output_cache);
+  }
 
   // time it
   float time = ((float) (clock() - start)) / CLOCKS_PER_SEC;
   printf("#######\ntime: %f\n", time);
 
   printf("compilation ended\n");
-  return 0;
+  return exit_code;
 }
@@ -3,6 +3,7 @@
 
 #include <time.h>
 #include <string.h>
+#include <threads.h>
 
 #include "mlib.h"
 //#include "errors.h"
@@ -10,125 +11,585 @@
 #include "parser.h"
 #include "checker.h"
 #include "generator.h"
+#include "cache.h"
+#include "stream.h"
+#include "ast_cache.h"
+#include "executable.h"
+#include "jit.h"
+#include "bytecode.h"
+#include "interpreter.h"
+#include "llvm.h"
 
 
-void free_type(Node_Type type) {
-  switch (type.type_type) {
-    case type_primitive_type: break;
-    case type_ptr_type:
-      free_type(*type.type_value.type_ptr_value);
-      free(type.type_value.type_ptr_value);
-      break;
-    case type_array_type:
-      free_type(*type.type_value.type_array_value->primitive_type);
-      free(type.type_value.type_array_value->primitive_type);
-      free(type.type_value.type_array_value);
-      break;
+// frees all the allocated memory, the nodes of the syntax tree are freed with their pools
+void free_all_memory(const Token_list tokens, Token_texts * token_texts, Node_Program syntax_tree) {
+  free_token_list(tokens);
+  sfree(token_texts->texts);
+  sfree(token_texts);
+  sfree(syntax_tree.statements_node);
+}
+
+// prints the errors collected during the compilation and frees them
+static void report_diagnostics(FILE * diagnostics_file_ptr, Diagnostics * diagnostics) {
+  print_diagnostics(diagnostics_file_ptr, *diagnostics);
+  free_diagnostics(*diagnostics);
+  sfree(diagnostics);
+}
+
+// returns if the output file extension is for a ready to run executable, a file without extension also is
+bool is_executable_extension(const char * extension) {
+  return strcmp(extension, ".o") == 0 || extension[0] == '\0';
+}
+
+// returns if there is a generator for the output file extension
+bool is_supported_extension(const char * extension) {
+  return strcmp(extension, ".c") == 0 || strcmp(extension, ".asm") == 0 || strcmp(extension, ".ll") == 0
+      || is_executable_extension(extension);
+}
+
+// creates the output file, the executables can be run by everyone that can read them
+FILE * create_output_file(const char * result_file) {
+  if (!is_executable_extension(get_file_extension(result_file))) {
+    return fopen(result_file, "w");
+  }
+  // the permissions are only set when the file is created, so an existing one is replaced
+  unlink(result_file);
+  const int file_descriptor = open(result_file, O_WRONLY | O_CREAT | O_TRUNC, 0777);
+  if (file_descriptor < 0) {
+    return NULL;
   }
+  return fdopen(file_descriptor, "w");
 }
 
-void free_expresion(Node_Expresion expresion) {
-  switch (expresion.expresion_type) {
-    case expresion_array_type:
-      for (int i = 0; i < expresion.expresion_value.expresion_array_value->elements_count; i++) {
-        free_expresion(expresion.expresion_value.expresion_array_value->elements[i]);
-      }
-      free(expresion.expresion_value.expresion_array_value->elements);
-      free(expresion.expresion_value.expresion_array_value);
-      break;
-    case expresion_binary_operation_type:
-      free_expresion(expresion.expresion_value.expresion_binary_operation_value->left_side);
-      free_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side);
-      free(expresion.expresion_value.expresion_binary_operation_value);
-      break;
-    case expresion_unary_operation_type:
-      free_expresion(expresion.expresion_value.expresion_unary_operation_value->expresion);
-      free(expresion.expresion_value.expresion_unary_operation_value);
-      break;
-    // nothing to free in this
-    case expresion_number_type: break;
-    case expresion_identifier_type: break;
+// when it is set the checked syntax tree of the compiled program is saved in this file, see ast_cache.h
+const char * ast_cache_output_file = NULL;
+
+// generates the code of the syntax tree, the extension of the output file selects its language
+static void generate_code(const Node_Program syntax_tree, const char * extension, FILE * out_file_ptr) {
+  if (strcmp(extension, ".c") == 0) {
+    gen_C_code(syntax_tree, out_file_ptr);
+  }
+  else if (strcmp(extension, ".asm") == 0) {
+    gen_NASM_code(syntax_tree, out_file_ptr);
+  }
+  else if (strcmp(extension, ".ll") == 0) {
+    gen_LLVM_code(syntax_tree, out_file_ptr);
+  }
+  else if (is_executable_extension(extension)) {
+    gen_ELF_executable(syntax_tree, out_file_ptr);
+  }
+  // only for interpreting the programs, it is not an output file of the compiler
+  else if (strcmp(extension, ".bytecode") == 0) {
+    gen_bytecode(syntax_tree, out_file_ptr);
+  }
+  else {
+    error("the output file must have a supported file extension");
   }
 }
 
-void free_scope(Node_Scope scope);
+// an output of a compilation, the extension selects its language
+typedef struct Compilation_output {
+  const char * extension;
+  FILE * file_ptr;
+} Compilation_output;
 
-void free_stmt(Node_Statement stmt) {
-  switch (stmt.statement_type) {
-    case var_declaration_type:
-      free_expresion(stmt.statement_value.var_declaration.value);
-      free_type(stmt.statement_value.var_declaration.type);
-      break;
-    case exit_node_type:
-      free_expresion(stmt.statement_value.exit_node.exit_code);
-      break;
-    case var_assignment_type:
-      free_expresion(stmt.statement_value.var_assignment.value);
+// a backend generating an output in its own thread
+typedef struct Backend_job {
+  thrd_t thread;
+  bool is_thread_started;
+  Node_Program syntax_tree;
+  // the backend reads the nodes of the tree from them, and adds its type nodes to blocks of its own
+  Node_pools node_pools;
+  Compilation_output output;
+  // the places of the tokens of the tree are found in them
+  Token_texts * token_texts;
+  // exit code of the error that stopped the backend, or 0
+  int exit_code;
+} Backend_job;
+
+static int run_backend_job(void * job_ptr) {
+  Backend_job * job = job_ptr;
+  Node_pools * previous_node_pools = active_node_pools;
+  Token_texts * previous_token_texts = active_token_texts;
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  active_node_pools = &job->node_pools;
+  active_token_texts = job->token_texts;
+  jmp_buf recovery_point;
+  error_recovery_point = &recovery_point;
+  if (setjmp(recovery_point) == 0) {
+    generate_code(job->syntax_tree, job->output.extension, job->output.file_ptr);
+    job->exit_code = 0;
+  }
+  else {
+    job->exit_code = error_exit_code;
+  }
+  error_recovery_point = previous_recovery_point;
+  active_node_pools = previous_node_pools;
+  active_token_texts = previous_token_texts;
+  release_node_pools(&job->node_pools);
+  return 0;
+}
+
+// generates the code of the syntax tree for every output, the backends only read the tree,
+// so the first output is generated in the calling thread and each one of the rest in a thread of its own
+static void generate_outputs(const Node_Program syntax_tree, const Compilation_output * outputs, const int outputs_count) {
+  if (outputs_count == 1) {
+    generate_code(syntax_tree, outputs[0].extension, outputs[0].file_ptr);
+    return;
+  }
+  // all the pools are forked before any backend adds nodes to them
+  Backend_job * jobs = smalloc(outputs_count * sizeof(*jobs));
+  for (int i = 0; i < outputs_count; i++) {
+    jobs[i] = (Backend_job) {
+      .is_thread_started = false,
+      .syntax_tree = syntax_tree,
+      .node_pools = fork_node_pools(active_node_pools),
+      .output = outputs[i],
+      .token_texts = active_token_texts,
+      .exit_code = 0
+    };
+  }
+  for (int i = 1; i < outputs_count; i++) {
+    jobs[i].is_thread_started = thrd_create(&jobs[i].thread, run_backend_job, &jobs[i]) == thrd_success;
+    if (!jobs[i].is_thread_started) {
+      run_backend_job(&jobs[i]);
+    }
+  }
+  run_backend_job(&jobs[0]);
+
+  // the first error stops the compilation after all the backends end
+  int exit_code = 0;
+  for (int i = 0; i < outputs_count; i++) {
+    if (jobs[i].is_thread_started) {
+      thrd_join(jobs[i].thread, NULL);
+    }
+    if (exit_code == 0) {
+      exit_code = jobs[i].exit_code;
+    }
+  }
+  sfree(jobs);
+  if (exit_code != 0) {
+    stop_compilation(exit_code);
+  }
+}
+
+// compiles the source code into the outputs, the program is lexed, parsed and checked once for all of them
+// the errors found are written into the diagnostics file
+void compile_source(char * code, const Compilation_output * outputs, const int outputs_count, FILE * diagnostics_file_ptr) {
+  // collect the errors of the whole compilation, so all of them are reported together
+  Diagnostics * volatile diagnostics = smalloc(sizeof(*diagnostics));
+  *diagnostics = (Diagnostics) { .diagnostics_count = 0, .diagnostics = NULL };
+  Diagnostics * previous_sink = diagnostic_sink;
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  Node_pools * previous_node_pools = active_node_pools;
+  Node_pools * volatile node_pools = create_node_pools();
+  Token_texts * previous_token_texts = active_token_texts;
+  Token_texts * volatile token_texts = smalloc(sizeof(*token_texts));
+  *token_texts = (Token_texts) { .texts_count = 0, .texts_capacity = 0, .texts = NULL };
+  jmp_buf recovery_point;
+  if (setjmp(recovery_point) != 0) {
+    // an error that could not be recovered from, report it with the ones found before it
+    diagnostic_sink = previous_sink;
+    error_recovery_point = previous_recovery_point;
+    active_node_pools = previous_node_pools;
+    active_token_texts = previous_token_texts;
+    destroy_node_pools(node_pools);
+    report_diagnostics(diagnostics_file_ptr, diagnostics);
+    stop_compilation(error_exit_code);
+  }
+  diagnostic_sink = diagnostics;
+  error_recovery_point = &recovery_point;
+  active_node_pools = node_pools;
+  active_token_texts = token_texts;
+
+  Token_list tokens = lexer(code);
+  add_token_list_text(token_texts, &tokens);
+
+  Node_Program syntax_tree = parse_token_list(&tokens);
+  // the tree has its own tokens, only the lines of the text are needed for their places
+  free_listed_tokens(&tokens);
+  const Node_pools parsed_sizes = *node_pools;
+
+  //D_print_syntax_tree(syntax_tree, 0);
+
+  // the checker also runs after parsing errors, to find the errors in the statements that could be parsed
+  const bool is_valid = is_valid_program(syntax_tree) && diagnostics->diagnostics_count == 0;
+  // the type nodes the checker added are not part of the tree
+  truncate_node_pools(node_pools, parsed_sizes);
+  if (is_valid && ast_cache_output_file != NULL) {
+    write_ast_cache(ast_cache_output_file, code, syntax_tree);
+  }
+  if (is_valid) {
+    generate_outputs(syntax_tree, outputs, outputs_count);
+  }
+
+  diagnostic_sink = previous_sink;
+  error_recovery_point = previous_recovery_point;
+  active_node_pools = previous_node_pools;
+  report_diagnostics(diagnostics_file_ptr, diagnostics);
+  active_token_texts = previous_token_texts;
+  free_all_memory(tokens, token_texts, syntax_tree);
+  destroy_node_pools(node_pools);
+  if (!is_valid) {
+    error("program is not valid");
+  }
+}
+
+// when it is set the source code files are read and compiled statement by statement
+bool is_streaming_enabled = false;
+
+// moves the tokens of the type that point into the old text to the same place in the new text
+static void move_type_tokens(Node_Type * type, const char * old_text, char * new_text) {
+  type->token.beginning = new_text + (type->token.beginning - old_text);
+  switch (type->type_type) {
+    case type_primitive_type:
+      type->type_value.type_primitive_value.beginning = new_text + (type->type_value.type_primitive_value.beginning - old_text);
       break;
-    case print_type:
-      free_expresion(stmt.statement_value.print.chr);
+    case type_ptr_type:
+      move_type_tokens(get_pointed_type(*type), old_text, new_text);
       break;
-    case scope_type:
-      free_scope(stmt.statement_value.scope);
+    case type_array_type: {
+      Node_Array_type * array_type = get_array_type(*type);
+      array_type->elements_count.beginning = new_text + (array_type->elements_count.beginning - old_text);
+      move_type_tokens(get_type(array_type->primitive_type), old_text, new_text);
       break;
-    case if_type:
-      free_expresion(stmt.statement_value.if_node.condition);
-      free_scope(stmt.statement_value.if_node.scope);
-      if (stmt.statement_value.if_node.has_else_block) {
-        free_scope(stmt.statement_value.if_node.else_block);
+    }
+  }
+}
+
+// a global variable of a streamed compilation, the name and the type of its declaration
+// are kept after the statement is freed, because the checker and the generators use them
+// the nodes of the type are kept in the pools, the other nodes of the statement are dropped
+// the copy of the text is in the active token texts, with the lines for the places of its tokens
+typedef struct Stream_global {
+  char * text;
+  Text_lines lines;
+  Node_Type type;
+} Stream_global;
+
+// copies the text of the name and the type of the declaration, that are before its '='
+static Stream_global keep_global_declaration(Node_Var_declaration * declaration, const Token_span tokens) {
+  int equal_idx = 0;
+  while (!compare_token_to_string(get_span_token(tokens, equal_idx), "=")) {
+    equal_idx++;
+  }
+  const char * old_text = get_span_token(tokens, 0).beginning;
+  const int text_size = get_span_token(tokens, equal_idx).beginning - old_text;
+  // the first column of the lines is one less than the one of the places, see get_text_place()
+  const Token_place text_place = get_text_place(&tokens.list->lines, tokens.list->offsets[tokens.first]);
+  Stream_global global = {
+    .text = smalloc(text_size),
+    .lines = get_text_lines(old_text, text_size, text_place.line_number, text_place.column_number - 1),
+    .type = declaration->type
+  };
+  memcpy(global.text, old_text, text_size);
+  add_token_text(active_token_texts, (Token_text) { .begin = global.text, .end = global.text + text_size, .text = global.text, .lines = global.lines });
+  declaration->var_name.beginning = global.text + (declaration->var_name.beginning - old_text);
+  move_type_tokens(&declaration->type, old_text, global.text);
+  global.type = declaration->type;
+  return global;
+}
+
+// lexes, parses, checks and generates the statements of the stream one by one
+// the errors are collected in the diagnostic sink, after the first one no more code is generated
+static void compile_stream_statements(Statement_stream * stream, const char * extension, FILE * out_file_ptr) {
+  const bool is_C = strcmp(extension, ".c") == 0;
+  C_Generator C_generator;
+  NASM_Generator NASM_generator;
+  if (is_C) {
+    C_generator = begin_C_code(out_file_ptr);
+  }
+  else {
+    NASM_generator = begin_NASM_code(out_file_ptr);
+  }
+  Symbol_table globals = { .scopes_count = 0, .scopes = NULL };
+  create_scope(&globals);
+  int globals_count = 0;
+  Stream_global * kept_globals = smalloc(0);
+
+  Node_pools * previous_node_pools = active_node_pools;
+  active_node_pools = create_node_pools();
+
+  Token_span tokens;
+  while (next_stream_statement(stream, &tokens)) {
+    // the nodes added after the mark are dropped when the statement is generated
+    Node_pools mark = *active_node_pools;
+    Node_Program syntax_tree = parse_tokens(tokens);
+    // a top level statement is parsed alone, so the tree has it or nothing
+    for (int i = 0; i < syntax_tree.statements_count; i++) {
+      Node_Statement * stmt = &syntax_tree.statements_node[i];
+      if (stmt->statement_type == var_declaration_type) {
+        globals_count++;
+        kept_globals = srealloc(kept_globals, globals_count * sizeof(*kept_globals));
+        kept_globals[globals_count -1] = keep_global_declaration(&stmt->statement_value.var_declaration, tokens);
+        // the parser only adds the type nodes of the declared type
+        mark.types = active_node_pools->types;
+        mark.array_types = active_node_pools->array_types;
       }
-      break;
-    case while_type:
-      free_expresion(stmt.statement_value.while_node.condition);
-      free_scope(stmt.statement_value.while_node.scope);
-      break;
+    }
+    check_statements(&globals, syntax_tree.statements_node, syntax_tree.statements_count);
+    const bool is_valid = diagnostic_sink->diagnostics_count == 0;
+    for (int i = 0; i < syntax_tree.statements_count; i++) {
+      Node_Statement stmt = syntax_tree.statements_node[i];
+      if (is_valid && is_C) {
+        gen_C_top_statement(&C_generator, stmt);
+      }
+      else if (is_valid) {
+        gen_NASM_top_statement(&NASM_generator, stmt);
+      }
+    }
+    sfree(syntax_tree.statements_node);
+    truncate_node_pools(active_node_pools, mark);
   }
+
+  if (is_C) {
+    end_C_code(&C_generator);
+  }
+  else {
+    end_NASM_code(&NASM_generator);
+  }
+  free_Symbol_table(globals);
+  for (int i = 0; i < globals_count; i++) {
+    remove_token_text(active_token_texts, kept_globals[i].text);
+    sfree(kept_globals[i].text);
+    sfree(kept_globals[i].lines.line_beginnings);
+  }
+  sfree(kept_globals);
+  destroy_node_pools(active_node_pools);
+  active_node_pools = previous_node_pools;
 }
 
-void free_scope(Node_Scope scope) {
-  for (int i = 0; i < scope.statements_count; i++) {
-    free_stmt(scope.statements_node[i]);
+// compiles the source code file into the output file reading it by chunks, so the memory used
+// depends on the size of the largest top level statement instead of the size of the file
+// the output file is removed if the compilation fails
+void compile_stream(const char * source_code_file, const char * result_file) {
+  Statement_stream * stream = open_statement_stream(source_code_file);
+  FILE * out_file_ptr = create_file(result_file);
+  // the texts of the stream and of the kept globals
+  Token_texts * previous_token_texts = active_token_texts;
+  Token_texts * volatile token_texts = smalloc(sizeof(*token_texts));
+  *token_texts = (Token_texts) { .texts_count = 0, .texts_capacity = 0, .texts = NULL };
+  active_token_texts = token_texts;
+
+  Diagnostics * volatile diagnostics = smalloc(sizeof(*diagnostics));
+  *diagnostics = (Diagnostics) { .diagnostics_count = 0, .diagnostics = NULL };
+  Diagnostics * previous_sink = diagnostic_sink;
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  Node_pools * previous_node_pools = active_node_pools;
+  jmp_buf recovery_point;
+  if (setjmp(recovery_point) != 0) {
+    diagnostic_sink = previous_sink;
+    error_recovery_point = previous_recovery_point;
+    active_node_pools = previous_node_pools;
+    report_diagnostics(stdout, diagnostics);
+    fclose(out_file_ptr);
+    remove(result_file);
+    close_statement_stream(stream);
+    active_token_texts = previous_token_texts;
+    stop_compilation(error_exit_code);
+  }
+  diagnostic_sink = diagnostics;
+  error_recovery_point = &recovery_point;
+
+  compile_stream_statements(stream, get_file_extension(result_file), out_file_ptr);
+
+  diagnostic_sink = previous_sink;
+  error_recovery_point = previous_recovery_point;
+  const bool is_valid = diagnostics->diagnostics_count == 0;
+  report_diagnostics(stdout, diagnostics);
+  fclose(out_file_ptr);
+  close_statement_stream(stream);
+  active_token_texts = previous_token_texts;
+  sfree(token_texts->texts);
+  sfree(token_texts);
+  if (!is_valid) {
+    remove(result_file);
+    error("program is not valid");
   }
-  free(scope.statements_node);
 }
 
-// frees all the allocated memory
-void free_all_memory(char * code, Token * tokens, Node_Program syntax_tree) {
-  free(code);
-  free(tokens);
-  // free the expresions of the program recursively
-  for (int i = 0; i < syntax_tree.statements_count; i++) {
-    Node_Statement node = syntax_tree.statements_node[i];
-    free_stmt(node);
+// creates the output files, the extension of each one selects its language
+static Compilation_output * create_output_files(char * const * result_files, const int result_files_count) {
+  Compilation_output * outputs = smalloc(result_files_count * sizeof(*outputs));
+  for (int i = 0; i < result_files_count; i++) {
+    FILE * file_ptr = create_output_file(result_files[i]);
+    if (file_ptr == NULL) {
+      for (int j = 0; j < i; j++) {
+        fclose(outputs[j].file_ptr);
+        remove(result_files[j]);
+      }
+      sfree(outputs);
+      errorf("File Error: Can not create the file: %s\n", result_files[i]);
+    }
+    outputs[i] = (Compilation_output) { .extension = get_file_extension(result_files[i]), .file_ptr = file_ptr };
   }
-  free(syntax_tree.statements_node);
+  return outputs;
 }
 
-void compile(const char * source_code_file, const char * result_file) {
-  char * code = file_contents(source_code_file);
+// closes the output files, and removes them if the compilation failed
+static void close_output_files(Compilation_output * outputs, char * const * result_files, const int result_files_count, const bool is_failed) {
+  for (int i = 0; i < result_files_count; i++) {
+    fclose(outputs[i].file_ptr);
+    if (is_failed) {
+      remove(result_files[i]);
+    }
+  }
+  sfree(outputs);
+}
 
-  Token * tokens = lexer(code);
+// compiles the source code into the output files, they are removed if the compilation fails
+static void compile_into_files(char * code, char * const * result_files, const int result_files_count) {
+  Compilation_output * outputs = create_output_files(result_files, result_files_count);
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  jmp_buf recovery_point;
+  if (setjmp(recovery_point) != 0) {
+    error_recovery_point = previous_recovery_point;
+    close_output_files(outputs, result_files, result_files_count, true);
+    stop_compilation(error_exit_code);
+  }
+  error_recovery_point = &recovery_point;
 
-  Node_Program syntax_tree = parser(tokens);
+  compile_source(code, outputs, result_files_count, stdout);
 
-  //D_print_syntax_tree(syntax_tree, 0);
+  error_recovery_point = previous_recovery_point;
+  close_output_files(outputs, result_files, result_files_count, false);
+}
 
-  if (is_valid_program(syntax_tree)) {
-    const char * extension = get_file_extension(result_file);
-    if (strcmp(extension, ".c") == 0) {
-      gen_C_code(syntax_tree, result_file);
+// compiles the source code file into every output file, lexing, parsing and checking it only once
+void compile(const char * source_code_file, char * const * result_files, const int result_files_count) {
+  for (int i = 0; i < result_files_count; i++) {
+    if (!is_supported_extension(get_file_extension(result_files[i]))) {
+      error("the output file must have a supported file extension");
+    }
+  }
+  // the streamed compilations do not use the cache, it would need all the code at once
+  if (is_streaming_enabled) {
+    if (result_files_count != 1) {
+      error("a streamed compilation can only have one output file");
     }
-    else if (strcmp(extension, ".asm") == 0) {
-      gen_NASM_code(syntax_tree, result_file);
+    // the jumps of an executable can only be resolved with all its code, and the allocas of LLVM IR are before it
+    const char * extension = get_file_extension(result_files[0]);
+    if (strcmp(extension, ".c") != 0 && strcmp(extension, ".asm") != 0) {
+      error("a streamed compilation can only generate C or NASM code");
     }
-    else {
+    compile_stream(source_code_file, result_files[0]);
+    return;
+  }
+  char * code = file_contents(source_code_file);
+  // the unchanged outputs are taken from the cache, and the program is only compiled for the rest,
+  // but the syntax tree is only saved when the program is compiled
+  const bool is_cached = output_cache != NULL && ast_cache_output_file == NULL;
+  Cache_key * cache_keys = smalloc(result_files_count * sizeof(*cache_keys));
+  char ** compiled_files = smalloc(result_files_count * sizeof(*compiled_files));
+  int compiled_count = 0;
+  for (int i = 0; i < result_files_count; i++) {
+    if (is_cached) {
+      cache_keys[compiled_count] = get_cache_key(output_cache, code, get_file_extension(result_files[i]));
+      if (load_from_cache(output_cache, cache_keys[compiled_count], result_files[i])) {
+        continue;
+      }
+    }
+    compiled_files[compiled_count++] = result_files[i];
+  }
+  if (compiled_count == 0) {
+    sfree(cache_keys);
+    sfree(compiled_files);
+    sfree(code);
+    return;
+  }
+  compile_into_files(code, compiled_files, compiled_count);
+  sfree(code);
+  if (is_cached) {
+    for (int i = 0; i < compiled_count; i++) {
+      store_in_cache(output_cache, cache_keys[i], compiled_files[i]);
+    }
+  }
+  sfree(cache_keys);
+  sfree(compiled_files);
+}
+
+// compiles the source code file and runs it inside the compiler, without writing any file
+// returns the exit code of the program
+int run_source_file(const char * source_code_file) {
+  char * code = file_contents(source_code_file);
+  char * text;
+  size_t text_size;
+  FILE * stream = open_memstream(&text, &text_size);
+  if (stream == NULL) {
+    implementation_error("can not create a stream for the NASM code");
+  }
+  const Compilation_output output = { .extension = ".asm", .file_ptr = stream };
+  compile_source(code, &output, 1, stdout);
+  fclose(stream);
+  sfree(code);
+  const int exit_code = run_NASM_code(text, text_size);
+  // the memory stream is allocated by the C library
+  free(text);
+  return exit_code;
+}
+
+// compiles the source code file to bytecode and interprets it, without writing any file
+// returns the exit code of the program
+int interpret_source_file(const char * source_code_file) {
+  char * code = file_contents(source_code_file);
+  char * data;
+  size_t data_size;
+  FILE * stream = open_memstream(&data, &data_size);
+  if (stream == NULL) {
+    implementation_error("can not create a stream for the bytecode");
+  }
+  const Compilation_output output = { .extension = ".bytecode", .file_ptr = stream };
+  compile_source(code, &output, 1, stdout);
+  fclose(stream);
+  sfree(code);
+  const Bytecode_program program = read_bytecode(data, data_size);
+  // the memory stream is allocated by the C library
+  free(data);
+  const int exit_code = run_bytecode(&program);
+  free_bytecode_program(program);
+  return exit_code;
+}
+
+// generates the output files from a syntax tree cache file, without lexing, parsing and checking the program
+void compile_from_ast_cache(const char * ast_cache_file, char * const * result_files, const int result_files_count) {
+  for (int i = 0; i < result_files_count; i++) {
+    if (!is_supported_extension(get_file_extension(result_files[i]))) {
       error("the output file must have a supported file extension");
     }
   }
-  else {
-    error("program is not valid");
+  Ast_cache * ast_cache = load_ast_cache(ast_cache_file);
+  Compilation_output * outputs = create_output_files(result_files, result_files_count);
+  Node_pools * previous_node_pools = active_node_pools;
+  active_node_pools = ast_cache->pools;
+  // the places of the tokens are found from the lines of the text of the cache
+  const int text_size = strlen(ast_cache->text);
+  Token_texts token_texts = { .texts_count = 0, .texts_capacity = 0, .texts = NULL };
+  add_token_text(&token_texts, (Token_text) { .begin = ast_cache->text, .end = ast_cache->text + text_size, .text = ast_cache->text,
+                                              .lines = get_text_lines(ast_cache->text, text_size, 1, 1) });
+  Token_texts * previous_token_texts = active_token_texts;
+  active_token_texts = &token_texts;
+
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  jmp_buf recovery_point;
+  if (setjmp(recovery_point) != 0) {
+    error_recovery_point = previous_recovery_point;
+    active_node_pools = previous_node_pools;
+    active_token_texts = previous_token_texts;
+    close_output_files(outputs, result_files, result_files_count, true);
+    close_ast_cache(ast_cache);
+    stop_compilation(error_exit_code);
   }
-  free_all_memory(code, tokens, syntax_tree);
+  error_recovery_point = &recovery_point;
+
+  generate_outputs(ast_cache->syntax_tree, outputs, result_files_count);
+
+  error_recovery_point = previous_recovery_point;
+  active_node_pools = previous_node_pools;
+  active_token_texts = previous_token_texts;
+  sfree(token_texts.texts[0].lines.line_beginnings);
+  sfree(token_texts.texts);
+  close_output_files(outputs, result_files, result_files_count, false);
+  close_ast_cache(ast_cache);
 }
 
 #endif
\ No newline at end of file
@@ -2,11 +2,15 @@
 #define ERRORS_H_
 
 #include <stdarg.h>
+#include <setjmp.h>
 
 
 // predefine symbols
+struct Token;
 void error(const char * string);
 void errorf(const char * string, ...);
+void errorf_at(const struct Token token, const char * format, ...);
+void report_error_at(int line_number, int column_number, const char * format, ...);
 void implementation_error(const char *);
 void warning(const char *);
 
@@ -14,32 +18,43 @@ void warning(const char *);
 #include "tokenizer.h"
 
 
-// general error function
-void error(const char * string) {
-  printf("Error: %s\n", string);
-  exit(1);
-}
+// an error found in the code that is being compiled
+typedef struct Diagnostic {
+  // the line is 0 if the error is not about a place in the code
+  int line_number;
+  int column_number;
+  char * message;
+} Diagnostic;
 
-// a printf() like error function, displays an error and exits the aplication
-// format is the string to be printed, and has to be null terminated
-// the format(s) must have the following syntax: %? . Being `?` the type of the format
-// the type of format available are:
-//  %t    prints a token
-//  %s    prints a string
-//  %c    prints a character as ASCII
-//  %d    prints a signed integer in decimal
-//  %%    prints a '%'
-void errorf(const char * format, ...) {
-  va_list args;
-  // count the number of format specifiers inside the format string
-  int count = 0;
-  for (int i = 0; format[i] != '\0'; i++) {
-    // if the string matches "%" at the current index increase the count
-    if (format[i] == '%') {
-      count++;
-    }
+typedef struct Diagnostics {
+  int diagnostics_count;
+  Diagnostic * diagnostics;
+} Diagnostics;
+
+// when it is set the errors jump back to it instead of exiting the program,
+// the value passed to longjmp() is the exit code the error would have had
+// it is used for continuing with other files after a failed compilation
+thread_local jmp_buf * error_recovery_point = NULL;
+
+// the exit code of the last error that stopped the compilation, for the code after the recovery point
+thread_local int error_exit_code = 0;
+
+// when it is set the errors are collected in it instead of being printed,
+// so all of them can be reported together after the compilation
+thread_local Diagnostics * diagnostic_sink = NULL;
+
+// stops the compilation after an error was reported
+static void stop_compilation(int exit_code) {
+  error_exit_code = exit_code;
+  if (error_recovery_point != NULL) {
+    fflush(stdout);
+    longjmp(*error_recovery_point, exit_code);
   }
-  va_start(args, count);
+  exit(exit_code);
+}
+
+// prints the text of the format in a file, see errorf() for the syntax of the format
+static void print_format(FILE * file_ptr, const char * format, va_list args) {
   // print the text interlaced with the format
   for (int i = 0; format[i] != '\0'; i++) {
     const char symbol = format[i];
@@ -48,35 +63,149 @@ void errorf(const char * format, ...) {
       const char next_sym = format[i+1];
       if (next_sym == 't') {
         Token token = va_arg(args, Token);
-        printf("%.*s", token.length, token.beginning);
+        fprintf(file_ptr, "%.*s", token.length, token.beginning);
       } else if (next_sym == 's') {
         char * str = va_arg(args, char *);
-        printf("%s", str);
+        fprintf(file_ptr, "%s", str);
       } else if (next_sym == 'c') {
         char chr = (char)va_arg(args, int);
-        putchar(chr);
+        putc(chr, file_ptr);
       } else if (next_sym == 'd') {
         int number = va_arg(args, int);
-        printf("%d", number);
+        fprintf(file_ptr, "%d", number);
       } else if (next_sym == '%') {
-        putchar('%');
+        putc('%', file_ptr);
       } else { // unkown format specifier
-        printf("\n[incorrect format in errorf() function]\n");
-        exit(1);
+        fprintf(file_ptr, "\n[incorrect format in errorf() function]\n");
+        return;
       }
       // skip the next symbol and continue
       i++; continue;
     }
-    putchar(symbol);
+    putc(symbol, file_ptr);
+  }
+}
+
+void append_diagnostic(Diagnostics * diagnostics, const Diagnostic diagnostic) {
+  diagnostics->diagnostics_count++;
+  diagnostics->diagnostics = srealloc(diagnostics->diagnostics, diagnostics->diagnostics_count * sizeof(*diagnostics->diagnostics));
+  diagnostics->diagnostics[diagnostics->diagnostics_count -1] = diagnostic;
+}
+
+// reports an error, it is saved in the diagnostic sink if there is one, otherwise it is printed
+static void report_diagnostic(const int line_number, const int column_number, const char * format, va_list args) {
+  if (diagnostic_sink == NULL) {
+    // keep the message together when many threads report errors at the same time
+    flockfile(stdout);
+    if (line_number > 0) {
+      printf("Line:%d, column:%d.  Error: ", line_number, column_number);
+    }
+    print_format(stdout, format, args);
+    funlockfile(stdout);
+    return;
+  }
+  // write the message into a string
+  char * stream_buffer;
+  size_t stream_size;
+  FILE * stream = open_memstream(&stream_buffer, &stream_size);
+  if (stream == NULL) {
+    implementation_error("can not create a stream for an error message");
+  }
+  print_format(stream, format, args);
+  fclose(stream);
+  Diagnostic diagnostic = {
+    .line_number = line_number,
+    .column_number = column_number,
+    .message = smalloc(stream_size + 1)
+  };
+  memcpy(diagnostic.message, stream_buffer, stream_size + 1);
+  free(stream_buffer);
+
+  append_diagnostic(diagnostic_sink, diagnostic);
+}
+
+static bool is_diagnostic_before(const Diagnostic diagnostic1, const Diagnostic diagnostic2) {
+  if (diagnostic1.line_number != diagnostic2.line_number) {
+    return diagnostic1.line_number < diagnostic2.line_number;
   }
-  exit(1);
+  return diagnostic1.column_number < diagnostic2.column_number;
+}
+
+// prints in the file all the errors of the sink sorted by their place in the code
+// the errors without a place go first, as they use the line 0
+void print_diagnostics(FILE * file_ptr, const Diagnostics diagnostics) {
+  // insertion sort, it keeps the order in which the errors of the same place were reported
+  for (int i = 1; i < diagnostics.diagnostics_count; i++) {
+    Diagnostic diagnostic = diagnostics.diagnostics[i];
+    int j;
+    for (j = i; j > 0 && is_diagnostic_before(diagnostic, diagnostics.diagnostics[j -1]); j--) {
+      diagnostics.diagnostics[j] = diagnostics.diagnostics[j -1];
+    }
+    diagnostics.diagnostics[j] = diagnostic;
+  }
+  flockfile(file_ptr);
+  for (int i = 0; i < diagnostics.diagnostics_count; i++) {
+    Diagnostic diagnostic = diagnostics.diagnostics[i];
+    if (diagnostic.line_number > 0) {
+      fprintf(file_ptr, "Line:%d, column:%d.  Error: ", diagnostic.line_number, diagnostic.column_number);
+    }
+    fputs(diagnostic.message, file_ptr);
+  }
+  funlockfile(file_ptr);
+}
+
+void free_diagnostics(const Diagnostics diagnostics) {
+  for (int i = 0; i < diagnostics.diagnostics_count; i++) {
+    sfree(diagnostics.diagnostics[i].message);
+  }
+  sfree(diagnostics.diagnostics);
+}
+
+// general error function
+void error(const char * string) {
+  errorf("Error: %s\n", string);
+}
+
+// a printf() like error function, displays an error and stops the compilation
+// format is the string to be printed, and has to be null terminated
+// the format(s) must have the following syntax: %? . Being `?` the type of the format
+// the type of format available are:
+//  %t    prints a token
+//  %s    prints a string
+//  %c    prints a character as ASCII
+//  %d    prints a signed integer in decimal
+//  %%    prints a '%'
+void errorf(const char * format, ...) {
+  va_list args;
+  va_start(args, format);
+  report_diagnostic(0, 0, format, args);
+  va_end(args);
+  stop_compilation(1);
+}
+
+// like errorf() but the error is about the place in the code where the token is
+void errorf_at(const Token token, const char * format, ...) {
+  const Token_place place = get_token_place(token);
+  va_list args;
+  va_start(args, format);
+  report_diagnostic(place.line_number, place.column_number, format, args);
+  va_end(args);
+  stop_compilation(1);
+}
+
+// like errorf() but it does not stop the compilation, so the caller can continue after the error
+void report_error_at(int line_number, int column_number, const char * format, ...) {
+  va_list args;
+  va_start(args, format);
+  report_diagnostic(line_number, column_number, format, args);
+  va_end(args);
 }
 
 // error that should only appeard while developing the compiler
 // the user of the language should not see this type of error
 void implementation_error(const char * string) {
-  printf("Implementation Error: %s\n", string);
-  exit(2);
+  report_error_at(0, 0, "Implementation Error: %s\n", string);
+  stop_compilation(2);
 }
 
 
@@ -85,4 +214,4 @@ void warning(const char * string) {
   printf("Warning: %s\n", string);
 }
 
-#endif
\ No newline at end of file
+#endif
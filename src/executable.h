@@ -0,0 +1,111 @@
+#ifndef EXECUTABLE_H_
+#define EXECUTABLE_H_
+
+#include <elf.h>
+
+#include "mlib.h"
+#include "errors.h"
+#include "parser.h"
+#include "generator.h"
+#include "assembler.h"
+
+
+/* * * * * * * * * * * * * * * *
+ * Generating ELF executables *
+ * * * * * * * * * * * * * * * */
+
+// the executables are static and for x86-64 linux, they only have the code of the program:
+// it is loaded at ELF_LOAD_ADDRESS together with the headers of the file, and begins right after them,
+// the bss of the program goes in the pages after it
+
+// the usual address of the static executables
+#define ELF_LOAD_ADDRESS 0x400000
+#define ELF_PAGE_SIZE 0x1000
+// the program headers: the code, the stack without execution permission, and the bss,
+// which is an empty header when the program has no bss, so the code always begins at the same place
+#define ELF_PROGRAM_HEADERS_COUNT 3
+#define ELF_HEADERS_SIZE (sizeof(Elf64_Ehdr) + ELF_PROGRAM_HEADERS_COUNT * sizeof(Elf64_Phdr))
+
+// writes an executable that runs the machine code, which begins with its first instruction
+void write_ELF_executable(FILE * out_file_ptr, const Machine_code code) {
+  const size_t headers_size = ELF_HEADERS_SIZE;
+  const Elf64_Ehdr header = {
+    .e_ident = {
+      ELFMAG0, ELFMAG1, ELFMAG2, ELFMAG3, ELFCLASS64, ELFDATA2LSB, EV_CURRENT, ELFOSABI_SYSV
+    },
+    .e_type = ET_EXEC,
+    .e_machine = EM_X86_64,
+    .e_version = EV_CURRENT,
+    .e_entry = ELF_LOAD_ADDRESS + headers_size,
+    .e_phoff = sizeof(Elf64_Ehdr),
+    .e_shoff = 0,
+    .e_flags = 0,
+    .e_ehsize = sizeof(Elf64_Ehdr),
+    .e_phentsize = sizeof(Elf64_Phdr),
+    .e_phnum = ELF_PROGRAM_HEADERS_COUNT,
+    .e_shentsize = sizeof(Elf64_Shdr),
+    .e_shnum = 0,
+    .e_shstrndx = SHN_UNDEF
+  };
+  Elf64_Phdr program_headers[ELF_PROGRAM_HEADERS_COUNT] = {
+    {
+      .p_type = PT_LOAD,
+      .p_flags = PF_R | PF_X,
+      .p_offset = 0,
+      .p_vaddr = ELF_LOAD_ADDRESS,
+      .p_paddr = ELF_LOAD_ADDRESS,
+      .p_filesz = headers_size + code.size,
+      .p_memsz = headers_size + code.size,
+      .p_align = ELF_PAGE_SIZE
+    },
+    {
+      .p_type = PT_GNU_STACK,
+      .p_flags = PF_R | PF_W,
+      .p_align = 16
+    },
+    {
+      .p_type = PT_NULL
+    }
+  };
+  // the bss is not in the file, its pages are zeroed when it is loaded
+  if (code.bss_size > 0) {
+    program_headers[2] = (Elf64_Phdr) {
+      .p_type = PT_LOAD,
+      .p_flags = PF_R | PF_W,
+      .p_offset = 0,
+      .p_vaddr = ELF_LOAD_ADDRESS + headers_size + code.bss_place,
+      .p_paddr = ELF_LOAD_ADDRESS + headers_size + code.bss_place,
+      .p_filesz = 0,
+      .p_memsz = code.bss_size,
+      .p_align = ELF_PAGE_SIZE
+    };
+  }
+  fwrite(&header, sizeof(header), 1, out_file_ptr);
+  fwrite(program_headers, sizeof(*program_headers), ELF_PROGRAM_HEADERS_COUNT, out_file_ptr);
+  fwrite(code.bytes, 1, code.size, out_file_ptr);
+}
+
+// generates the NASM code of the program into memory, so it can be assembled without writing it
+char * gen_NASM_code_in_memory(const Node_Program syntax_tree, size_t * code_size) {
+  char * text;
+  FILE * stream = open_memstream(&text, code_size);
+  if (stream == NULL) {
+    implementation_error("can not create a stream for the NASM code");
+  }
+  gen_NASM_code(syntax_tree, stream);
+  fclose(stream);
+  return text;
+}
+
+// generates a static executable of the program, its NASM code is assembled by the compiler itself
+void gen_ELF_executable(const Node_Program syntax_tree, FILE * out_file_ptr) {
+  size_t text_size;
+  char * text = gen_NASM_code_in_memory(syntax_tree, &text_size);
+  const Machine_code code = assemble_NASM_code(text, text_size, ELF_HEADERS_SIZE);
+  // the memory stream is allocated by the C library
+  free(text);
+  write_ELF_executable(out_file_ptr, code);
+  free_machine_code(code);
+}
+
+#endif
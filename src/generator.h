@@ -5,6 +5,10 @@
 #include "mlib.h"
 #include "tokenizer.h"
 #include "parser.h"
+#include "checker.h"
+#include "analysis.h"
+#include "profile.h"
+#include "chunks.h"
 
 
 static void add_token_to_file(FILE * file_ptr, const Token token) {
@@ -15,17 +19,22 @@ static void add_string_to_file(FILE * file_ptr, const char * string) {
   fputs(string, file_ptr);
 }
 
+// the numbers are written in decimal, whatever form they have in the code
+static void add_number_to_file(FILE * file_ptr, const Token number) {
+  fprintf(file_ptr, "%llu", (unsigned long long) number.value);
+}
+
 // the size of the native types in bytes
 enum Types_sizes {
   U64_sz = 8,
   PTR_sz = 8  // only in 64 bit platforms
 };
 
-// returns the size of the given type in bytes
+// returns the size of the given type in bytes, the arrays are packed
 static int get_size_of_type(const Node_Type type) {
   switch (type.type_type) {
     case type_primitive_type:
-      return U64_sz;
+      return get_primitive_type_size(type.type_value.type_primitive_value);
       break;
 
     case type_ptr_type:
@@ -33,7 +42,7 @@ static int get_size_of_type(const Node_Type type) {
       break;
 
     case type_array_type:
-      return get_size_of_type(*type.type_value.type_array_value->primitive_type) * number_token_to_int(type.type_value.type_array_value->elements_count);
+      return get_size_of_type(*get_type(get_array_type(type)->primitive_type)) * (int) get_array_type(type)->elements_count.value;
       break;
   }
   implementation_error("tried to get the size of an unkown type");
@@ -41,6 +50,51 @@ static int get_size_of_type(const Node_Type type) {
   return -1;
 }
 
+/* constant arrays */
+
+// the array literals made only of numbers are tables that are known before running the program,
+// so they are kept in the data of the program instead of being built element by element
+
+static bool is_constant_array_literal(const Node_Expresion expresion) {
+  if (expresion.expresion_type != expresion_array_type) {
+    return false;
+  }
+  const Node_Array array = expresion.expresion_value.expresion_array_value;
+  for (int i = 0; i < array.elements_count; i++) {
+    const Node_Expresion element = get_array_elements(array)[i];
+    if (element.expresion_type != expresion_number_type && !is_constant_array_literal(element)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// puts the numbers of the constant array in `numbers` in the order of the elements, returns how many there are
+// with `numbers` NULL they are only counted
+static int flatten_constant_array(const Node_Expresion expresion, Token * numbers) {
+  const Node_Array array = expresion.expresion_value.expresion_array_value;
+  int count = 0;
+  for (int i = 0; i < array.elements_count; i++) {
+    const Node_Expresion element = get_array_elements(array)[i];
+    if (element.expresion_type == expresion_number_type) {
+      if (numbers != NULL) {
+        numbers[count] = element.expresion_value.expresion_number_value;
+      }
+      count++;
+    }
+    else {
+      count += flatten_constant_array(element, numbers == NULL ? NULL : numbers + count);
+    }
+  }
+  return count;
+}
+
+// returns true if the declaration makes a constant table, the program is NULL when it is not known yet
+static bool is_constant_array_declaration(const Node_Program * program, const Node_Var_declaration var_declaration) {
+  return program != NULL && var_declaration.type.type_type == type_array_type && is_constant_array_literal(var_declaration.value)
+      && !is_variable_written(program->statements_node, program->statements_count, var_declaration.var_name);
+}
+
 
 /* * * * * * * * * * *
  * Generating C code *
@@ -88,16 +142,16 @@ static void C_create_scope(C_Scopes_List * scopes) {
   scopes->scopes_count++;
   scopes->variables = srealloc(scopes->variables, scopes->scopes_count * sizeof(*scopes->variables));
   scopes->variables[scopes->scopes_count -1].variables_count = 0;
-  scopes->variables[scopes->scopes_count -1].var_types_list = malloc(scopes->variables[scopes->scopes_count -1].variables_count * sizeof(int));
-  scopes->variables[scopes->scopes_count -1].var_tokens_list = malloc(scopes->variables[scopes->scopes_count -1].variables_count * sizeof(Token));
+  scopes->variables[scopes->scopes_count -1].var_types_list = smalloc(scopes->variables[scopes->scopes_count -1].variables_count * sizeof(int));
+  scopes->variables[scopes->scopes_count -1].var_tokens_list = smalloc(scopes->variables[scopes->scopes_count -1].variables_count * sizeof(Token));
 }
 
 static void C_free_scopes_list(const C_Scopes_List scopes) {
   for (int i = 0; i < scopes.scopes_count; i++) {
-    free(scopes.variables[i].var_types_list);
-    free(scopes.variables[i].var_tokens_list);
+    sfree(scopes.variables[i].var_types_list);
+    sfree(scopes.variables[i].var_tokens_list);
   }
-  free(scopes.variables);
+  sfree(scopes.variables);
 }
 
 Node_Type C_get_type_of_variable(const Token variable, const C_Scopes_List scopes) {
@@ -117,19 +171,18 @@ Node_Type C_get_type_of_expresion(Node_Expresion expresion, C_Scopes_List scopes
     return C_get_type_of_variable(expresion.expresion_value.expresion_identifier_value, scopes);
   }
   if (expresion.expresion_type == expresion_unary_operation_type) {
-    Node_Unary_Operation uni_operation = *expresion.expresion_value.expresion_unary_operation_value;
+    Node_Unary_Operation uni_operation = *get_unary_operation(expresion);
     Node_Expresion uni_expresion = uni_operation.expresion;
     Node_Type type;
     // if the operation is the address operator `&`, the returned type is a pointer to the type of the expression
     if (uni_operation.operation_type == unary_operation_addr_type) {
       type.token = NULL_TOKEN;
       type.type_type = type_ptr_type;
-      type.type_value.type_ptr_value = smalloc(sizeof(*type.type_value.type_ptr_value)); // FIX: this leaks memory
-      *type.type_value.type_ptr_value = C_get_type_of_expresion(uni_expresion, scopes);
+      type.type_value.type_ptr_value = add_type(C_get_type_of_expresion(uni_expresion, scopes));
     }
     // if the operation is the dereference operator `*`, the returned type is type the pointer holds
     else if (uni_operation.operation_type == unary_operation_deref_type) {
-      type = *C_get_type_of_expresion(uni_expresion, scopes).type_value.type_ptr_value;
+      type = *get_pointed_type(C_get_type_of_expresion(uni_expresion, scopes));
     }
     else {
       type = C_get_type_of_expresion(uni_expresion, scopes);
@@ -138,100 +191,212 @@ Node_Type C_get_type_of_expresion(Node_Expresion expresion, C_Scopes_List scopes
   }
   if (expresion.expresion_type == expresion_binary_operation_type) {
     // does not matter if its `left_side` or `right_side`
-    Node_Expresion lhs_expr = expresion.expresion_value.expresion_binary_operation_value->left_side;
-    return  C_get_type_of_expresion(lhs_expr, scopes);
+    Node_Expresion lhs_expr = get_binary_operation(expresion)->left_side;
+    const Node_Type lhs_type = C_get_type_of_expresion(lhs_expr, scopes);
+    // the access to an array has the type of its elements
+    if (get_binary_operation(expresion)->operation_type == binary_operation_access_type && lhs_type.type_type == type_array_type) {
+      return *get_type(get_array_type(lhs_type)->primitive_type);
+    }
+    return lhs_type;
   }
   if (expresion.expresion_type == expresion_array_type) {
     Node_Type type;
     type.token = NULL_TOKEN;
     type.type_type = type_array_type;
-    type.type_value.type_array_value = smalloc(sizeof(*type.type_value.type_array_value));
-    type.type_value.type_array_value->primitive_type = smalloc(sizeof(*type.type_value.type_array_value->primitive_type));
-    *type.type_value.type_array_value->primitive_type = C_get_type_of_expresion(expresion.expresion_value.expresion_array_value->elements[0], scopes);
-    // FIX: convert the number to token in a more reasonable way
-    type.type_value.type_array_value->elements_count.beginning = smalloc(2);
-    type.type_value.type_array_value->elements_count.length = 2;
-    type.type_value.type_array_value->elements_count.beginning[0] = '0' + expresion.expresion_value.expresion_array_value->elements_count / 10;
-    type.type_value.type_array_value->elements_count.beginning[1] = '0' + expresion.expresion_value.expresion_array_value->elements_count % 10;
-    type.type_value.type_array_value->elements_count.type = Number;
+    Node_Type element_type = C_get_type_of_expresion(get_array_elements(expresion.expresion_value.expresion_array_value)[0], scopes);
+    // the integers inside an array literal are u64
+    if (element_type.type_type == type_primitive_type) {
+      element_type = get_literal_type();
+    }
+    const Node_index primitive_type = add_type(element_type);
+    type.type_value.type_array_value = add_array_type((Node_Array_type) { .primitive_type = primitive_type });
+    get_array_type(type)->elements_count = get_number_token(expresion.expresion_value.expresion_array_value.elements_count);
     return type;
   }
   if (expresion.expresion_type == expresion_number_type) {
     // FIX: can not get the type of an integer literal so assume it is `u64`
-    Node_Type type;
-    type.token.beginning = smalloc(4); // FIX: this also leaks memory
-    strcpy(type.token.beginning, "u64");
-    type.token.length = 3;
-    type.type_type = type_primitive_type;
-    type.type_value.type_primitive_value = type.token;
-    return type;
+    return get_literal_type();
   }
   implementation_error("unkown type of expresion while trying to get its type");
   return (Node_Type) {};
 }
 
-static bool C_now_compiling_a_declaration_assignment = false;
+// the state of a C code generation, every generation has its own so many can run at the same time
+typedef struct C_Context {
+  // array literals outside of a declaration need a cast before them
+  bool now_compiling_a_declaration_assignment;
+  // the whole program, to find the constant tables, it is NULL when the statements come one by one
+  const Node_Program * program;
+  // the indexes that do not need to be checked with --bounds-check, and the counts of the checks
+  Index_bounds index_bounds;
+  int index_checks_count;
+  int removed_index_checks_count;
+  // the ifs and the whiles counted with --profile-generate
+  Profile_points profile_points;
+} C_Context;
+
+static void gen_C_scope(const Node_Scope scope, FILE * out_file_name, C_Scopes_List *, C_Context *);
+void gen_C_code(const Node_Program syntax_tree, FILE * out_file_ptr);
+
+// the type of the integers inside an array, also in the arrays inside it
+static Node_Type get_C_array_integer_type(const Node_Type type) {
+  if (type.type_type == type_array_type) {
+    return get_C_array_integer_type(*get_type(get_array_type(type)->primitive_type));
+  }
+  return type;
+}
 
-static void gen_C_scope(const Node_Scope scope, FILE * out_file_name, C_Scopes_List *);
-void gen_C_code(const Node_Program syntax_tree, const char * out_file_name);
+// the lengths of the array after its name, in C the length of the outer array goes first
+static void gen_C_array_lengths(FILE * out_file_ptr, const Node_Type type) {
+  for (Node_Type array_type = type; array_type.type_type == type_array_type; array_type = *get_type(get_array_type(array_type)->primitive_type)) {
+    add_string_to_file(out_file_ptr, "[");
+    add_number_to_file(out_file_ptr, get_array_type(array_type)->elements_count);
+    add_string_to_file(out_file_ptr, "]");
+  }
+}
 
 static void gen_C_type(FILE * out_file_ptr, const Node_Type type) {
   switch (type.type_type) {
     case type_primitive_type:
-      add_string_to_file(out_file_ptr, "uint64_t ");
+      // `u8` is `uint8_t` and so on
+      fprintf(out_file_ptr, "uint%.*s_t ", type.type_value.type_primitive_value.length - 1, type.type_value.type_primitive_value.beginning + 1);
       break;
 
     case type_ptr_type:
-      gen_C_type(out_file_ptr, *type.type_value.type_ptr_value);
+      gen_C_type(out_file_ptr, *get_pointed_type(type));
       add_string_to_file(out_file_ptr, "* ");
       break;
 
     case type_array_type:
-      gen_C_type(out_file_ptr, *type.type_value.type_array_value->primitive_type);
-      add_string_to_file(out_file_ptr, "[");
-      add_token_to_file(out_file_ptr, type.type_value.type_array_value->elements_count);
-      add_string_to_file(out_file_ptr, "]");
+      gen_C_type(out_file_ptr, get_C_array_integer_type(type));
+      gen_C_array_lengths(out_file_ptr, type);
       break;
   }
 }
 
-static void gen_C_expresion(const Node_Expresion expresion, FILE * file_ptr, const C_Scopes_List scopes) {
+// the integers smaller than u64 are read as u64, in C they would be promoted to int and the operations would not be the same
+static void gen_C_narrow_integer_cast(FILE * file_ptr, const Node_Type type) {
+  if (type.type_type == type_primitive_type && get_size_of_type(type) < U64_sz) {
+    add_string_to_file(file_ptr, "(uint64_t)");
+  }
+}
+
+/* the cleaner C code of --c-opt */
+
+// with --c-opt the C code is written for the C compilers to optimize it better: the operations only have
+// the brackets C needs, the variables whose address is not taken are `register`, the pointers to variables
+// that are never assigned are `restrict`, the conditions have the `__builtin_expect()` of the profile of --profile-use,
+// and the `#line` of every statement is its line in the program
+bool is_optimizing_C = false;
+
+// the precedences of the operations in C, the greater ones are grouped first
+#define C_COMPARISON_PRECEDENCE 1
+#define C_UNARY_PRECEDENCE 4
+#define C_ACCESS_PRECEDENCE 5
+
+static int get_C_operation_precedence(const int operation_type) {
+  switch (operation_type) {
+    case binary_operation_mul_type:
+    case binary_operation_div_type:
+    case binary_operation_mod_type:
+      return 3;
+    case binary_operation_sum_type:
+    case binary_operation_sub_type:
+      return 2;
+    case binary_operation_access_type:
+      return C_ACCESS_PRECEDENCE;
+  }
+  // the comparisons are one level, in C `==` is grouped after `<` and `>` but in the language they are the same
+  return C_COMPARISON_PRECEDENCE;
+}
+
+// the precedence of the C code of the expresion, the numbers and the variables are never split
+static int get_C_precedence(const Node_Expresion expresion, const C_Scopes_List scopes) {
+  switch (expresion.expresion_type) {
+    case expresion_binary_operation_type:;
+      const Node_Binary_Operation operation = *get_binary_operation(expresion);
+      // the cast of the narrow elements goes before the access
+      if (operation.operation_type == binary_operation_access_type) {
+        const Node_Type element_type = *get_type(get_array_type(C_get_type_of_expresion(operation.left_side, scopes))->primitive_type);
+        if (element_type.type_type == type_primitive_type && get_size_of_type(element_type) < U64_sz) {
+          return C_UNARY_PRECEDENCE;
+        }
+      }
+      return get_C_operation_precedence(operation.operation_type);
+
+    case expresion_unary_operation_type:
+      return C_UNARY_PRECEDENCE;
+
+    default:
+      return C_ACCESS_PRECEDENCE + 1;
+  }
+}
+
+static void gen_C_expresion(const Node_Expresion expresion, FILE * file_ptr, const C_Scopes_List scopes, C_Context * context);
+
+// generates an operand of an operation of the precedence, with --c-opt it only has brackets when C would group it in another way,
+// the operations are grouped from the left so the right operand of the same precedence needs them,
+// and the comparisons inside comparisons always have them
+static void gen_C_operand(const Node_Expresion operand, const int precedence, const bool is_right_side, FILE * file_ptr,
+                          const C_Scopes_List scopes, C_Context * context) {
+  const int operand_precedence = get_C_precedence(operand, scopes);
+  const bool has_brackets = is_optimizing_C && (operand_precedence < precedence
+      || (operand_precedence == precedence && (is_right_side || precedence == C_COMPARISON_PRECEDENCE)));
+  if (has_brackets) {
+    add_string_to_file(file_ptr, "(");
+  }
+  gen_C_expresion(operand, file_ptr, scopes, context);
+  if (has_brackets) {
+    add_string_to_file(file_ptr, ")");
+  }
+}
+
+static void gen_C_expresion(const Node_Expresion expresion, FILE * file_ptr, const C_Scopes_List scopes, C_Context * context) {
   switch (expresion.expresion_type) {
     case expresion_number_type:
-      add_token_to_file(file_ptr, expresion.expresion_value.expresion_number_value);
+      // the literals are u64 in C too, so the arithmetic on them wraps like in the language
+      add_number_to_file(file_ptr, expresion.expresion_value.expresion_number_value);
+      add_string_to_file(file_ptr, "ull");
       break;
 
     case expresion_identifier_type:
+      gen_C_narrow_integer_cast(file_ptr, C_get_type_of_expresion(expresion, scopes));
       add_token_to_file(file_ptr, expresion.expresion_value.expresion_identifier_value);
       break;
 
     case expresion_binary_operation_type:
-      add_string_to_file(file_ptr, "(");
-      gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->left_side, file_ptr, scopes);
-      switch (expresion.expresion_value.expresion_binary_operation_value->operation_type) {
+      if (get_binary_operation(expresion)->operation_type == binary_operation_access_type) {
+        gen_C_narrow_integer_cast(file_ptr, *get_type(get_array_type(C_get_type_of_expresion(get_binary_operation(expresion)->left_side, scopes))->primitive_type));
+      }
+      const int precedence = get_C_operation_precedence(get_binary_operation(expresion)->operation_type);
+      if (!is_optimizing_C) {
+        add_string_to_file(file_ptr, "(");
+      }
+      gen_C_operand(get_binary_operation(expresion)->left_side, precedence, false, file_ptr, scopes, context);
+      switch (get_binary_operation(expresion)->operation_type) {
         case binary_operation_sum_type:
           add_string_to_file(file_ptr, " + ");
-          gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, file_ptr, scopes);
+          gen_C_operand(get_binary_operation(expresion)->right_side, precedence, true, file_ptr, scopes, context);
           break;
 
         case binary_operation_sub_type:
           add_string_to_file(file_ptr, " - ");
-          gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, file_ptr, scopes);
+          gen_C_operand(get_binary_operation(expresion)->right_side, precedence, true, file_ptr, scopes, context);
           break;
 
         case binary_operation_mul_type:
           add_string_to_file(file_ptr, " * ");
-          gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, file_ptr, scopes);
+          gen_C_operand(get_binary_operation(expresion)->right_side, precedence, true, file_ptr, scopes, context);
           break;
 
         case binary_operation_div_type:
           add_string_to_file(file_ptr, " / ");
-          gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, file_ptr, scopes);
+          gen_C_operand(get_binary_operation(expresion)->right_side, precedence, true, file_ptr, scopes, context);
           break;
 
         case binary_operation_mod_type:
           add_string_to_file(file_ptr, " % ");
-          gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, file_ptr, scopes);
+          gen_C_operand(get_binary_operation(expresion)->right_side, precedence, true, file_ptr, scopes, context);
           break;
 
         case binary_operation_exp_type:
@@ -240,87 +405,103 @@ static void gen_C_expresion(const Node_Expresion expresion, FILE * file_ptr, con
 
         case binary_operation_big_type:
           add_string_to_file(file_ptr, " > ");
-          gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, file_ptr, scopes);
+          gen_C_operand(get_binary_operation(expresion)->right_side, precedence, true, file_ptr, scopes, context);
           break;
 
         case binary_operation_les_type:
           add_string_to_file(file_ptr, " < ");
-          gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, file_ptr, scopes);
+          gen_C_operand(get_binary_operation(expresion)->right_side, precedence, true, file_ptr, scopes, context);
           break;
 
         case binary_operation_equ_type:
           add_string_to_file(file_ptr, " == ");
-          gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, file_ptr, scopes);
+          gen_C_operand(get_binary_operation(expresion)->right_side, precedence, true, file_ptr, scopes, context);
           break;
 
-        case binary_operation_access_type:
+        case binary_operation_access_type:;
+          const Node_Type array_type = C_get_type_of_expresion(get_binary_operation(expresion)->left_side, scopes);
+          const int length = array_type.type_type == type_array_type ? (int) get_array_type(array_type)->elements_count.value : 0;
+          const bool is_checked = is_bounds_checking && array_type.type_type == type_array_type;
+          if (is_checked) {
+            context->index_checks_count++;
+          }
+          if (is_checked && is_index_in_range(context->index_bounds, expresion, length)) {
+            context->removed_index_checks_count++;
+          }
+          else if (is_checked) {
+            // the index goes through the function that checks it
+            const Token_place place = get_token_place(get_first_token_of_expresion(get_binary_operation(expresion)->right_side));
+            add_string_to_file(file_ptr, "[check_index(");
+            gen_C_expresion(get_binary_operation(expresion)->right_side, file_ptr, scopes, context);
+            fprintf(file_ptr, ", %d, %d, %d)]", length, place.line_number, place.column_number);
+            break;
+          }
           add_string_to_file(file_ptr, "[");
-          gen_C_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, file_ptr, scopes);
+          gen_C_expresion(get_binary_operation(expresion)->right_side, file_ptr, scopes, context);
           add_string_to_file(file_ptr, "]");
           break;
       }
-      add_string_to_file(file_ptr, ")");
+      if (!is_optimizing_C) {
+        add_string_to_file(file_ptr, ")");
+      }
       break;
 
     case expresion_unary_operation_type:
-      switch (expresion.expresion_value.expresion_unary_operation_value->operation_type) {
+      switch (get_unary_operation(expresion)->operation_type) {
         case unary_operation_addr_type:
+          // the address is of the variable itself, without the cast of its value
           add_string_to_file(file_ptr, "&");
-          break;
+          add_token_to_file(file_ptr, get_unary_operation(expresion)->expresion.expresion_value.expresion_identifier_value);
+          return;
 
         case unary_operation_deref_type:
+          gen_C_narrow_integer_cast(file_ptr, C_get_type_of_expresion(expresion, scopes));
           add_string_to_file(file_ptr, "*");
           break;
       }
       add_string_to_file(file_ptr, "(");
-      gen_C_expresion(expresion.expresion_value.expresion_unary_operation_value->expresion, file_ptr, scopes);
+      gen_C_expresion(get_unary_operation(expresion)->expresion, file_ptr, scopes, context);
       add_string_to_file(file_ptr, ")");
       break;
 
     case expresion_array_type:
       // this exists because stupid C rules
-      if (!C_now_compiling_a_declaration_assignment) {
+      if (!context->now_compiling_a_declaration_assignment) {
         add_string_to_file(file_ptr, "(");
         gen_C_type(file_ptr, C_get_type_of_expresion(expresion, scopes));
         add_string_to_file(file_ptr, ")");
       }
       add_string_to_file(file_ptr, "{");
       // generate each element with a preceding comma execept for the first one
-      if (expresion.expresion_value.expresion_array_value->elements_count >= 1) {
-        gen_C_expresion(expresion.expresion_value.expresion_array_value->elements[0], file_ptr, scopes);
+      if (expresion.expresion_value.expresion_array_value.elements_count >= 1) {
+        gen_C_expresion(get_array_elements(expresion.expresion_value.expresion_array_value)[0], file_ptr, scopes, context);
       }
-      for (int i = 1; i < expresion.expresion_value.expresion_array_value->elements_count; i++) {
+      for (int i = 1; i < expresion.expresion_value.expresion_array_value.elements_count; i++) {
         add_string_to_file(file_ptr, ", ");
-        gen_C_expresion(expresion.expresion_value.expresion_array_value->elements[i], file_ptr, scopes);
+        gen_C_expresion(get_array_elements(expresion.expresion_value.expresion_array_value)[i], file_ptr, scopes, context);
       }
       add_string_to_file(file_ptr, "}");
       break;
   }
 }
 
-static void gen_C_var_decl_type_and_name(FILE * out_file_ptr, const Token var_name, const Node_Type type) {
+static void gen_C_var_decl_type_and_name(FILE * out_file_ptr, const Token var_name, const Node_Type type, const bool is_restrict) {
   bool has_var_name_been_written = false;
   switch (type.type_type) {
     case type_primitive_type:
-      add_string_to_file(out_file_ptr, "uint64_t ");
+      gen_C_type(out_file_ptr, type);
       break;
 
     case type_ptr_type:
-      gen_C_type(out_file_ptr, *type.type_value.type_ptr_value);
-      add_string_to_file(out_file_ptr, "* ");
+      gen_C_type(out_file_ptr, *get_pointed_type(type));
+      add_string_to_file(out_file_ptr, is_restrict ? "* restrict " : "* ");
       break;
 
     case type_array_type:
-      // FIX: the recursive arrays translation to C in wrong (sometimes), it needs brackets
-      gen_C_type(out_file_ptr, *type.type_value.type_array_value->primitive_type);
-      if (!has_var_name_been_written) {
-        add_token_to_file(out_file_ptr, var_name);
-      }
+      gen_C_type(out_file_ptr, get_C_array_integer_type(type));
+      add_token_to_file(out_file_ptr, var_name);
       has_var_name_been_written = true;
-
-      add_string_to_file(out_file_ptr, "[");
-      add_token_to_file(out_file_ptr, type.type_value.type_array_value->elements_count);
-      add_string_to_file(out_file_ptr, "]");
+      gen_C_array_lengths(out_file_ptr, type);
       break;
   }
   if (!has_var_name_been_written) {
@@ -328,32 +509,108 @@ static void gen_C_var_decl_type_and_name(FILE * out_file_ptr, const Token var_na
   }
 }
 
-static void gen_C_statement(const Node_Statement stmt, FILE * out_file_ptr, C_Scopes_List * scopes) {
+// returns true if the variable of the declaration can be `register`, its address is never taken
+// the whole program is needed to know it
+static bool is_C_register_variable(const Node_Program * program, const Node_Var_declaration var_declaration) {
+  return program != NULL && var_declaration.type.type_type != type_array_type
+      && !is_variable_used_in(program->statements_node, program->statements_count, var_declaration.var_name, false, true);
+}
+
+// returns true if the pointer of the declaration can be `restrict`: it always points to the variable of its value,
+// and that variable is never assigned, so nothing changes the memory it points to
+static bool is_C_restrict_pointer(const Node_Program * program, const Node_Var_declaration var_declaration) {
+  if (program == NULL || var_declaration.type.type_type != type_ptr_type || var_declaration.value.expresion_type != expresion_unary_operation_type) {
+    return false;
+  }
+  const Node_Unary_Operation operation = *get_unary_operation(var_declaration.value);
+  return operation.operation_type == unary_operation_addr_type && operation.expresion.expresion_type == expresion_identifier_type
+      && !is_variable_written(program->statements_node, program->statements_count, var_declaration.var_name)
+      && !is_variable_used_in(program->statements_node, program->statements_count, operation.expresion.expresion_value.expresion_identifier_value, true, false);
+}
+
+// the line of the statement in the program, or 0 for a scope, that has the lines of its statements
+static int get_statement_line(const Node_Statement stmt) {
+  switch (stmt.statement_type) {
+    case var_declaration_type:
+      return get_token_place(stmt.statement_value.var_declaration.var_name).line_number;
+    case var_assignment_type:
+      return get_token_place(stmt.statement_value.var_assignment.var_name).line_number;
+    case exit_node_type:
+      return get_token_place(get_first_token_of_expresion(stmt.statement_value.exit_node.exit_code)).line_number;
+    case print_type:
+      return get_token_place(get_first_token_of_expresion(stmt.statement_value.print.chr)).line_number;
+    case if_type:
+      return get_token_place(get_first_token_of_expresion(stmt.statement_value.if_node.condition)).line_number;
+    case while_type:
+      return get_token_place(get_first_token_of_expresion(stmt.statement_value.while_node.condition)).line_number;
+    case scope_type:
+      break;
+  }
+  return 0;
+}
+
+// a condition is expected to be true when it is true this many times more than false in the profile, and the same for false
+#define C_EXPECT_RATIO 4
+
+// generates the condition of an if or a while, with --c-opt and a profile the usual value of the condition is given to the C compiler
+static void gen_C_condition(const Node_Expresion condition, const bool is_loop, FILE * out_file_ptr, const C_Scopes_List scopes, C_Context * context) {
+  Profile_counts counts;
+  if (is_optimizing_C && find_profile_counts(used_profile, condition, &counts)) {
+    // the condition of a loop is false once every time the loop runs
+    const uint64_t true_count = counts.block_runs;
+    const uint64_t false_count = is_loop ? counts.runs : counts.runs - counts.block_runs;
+    const int expected_value = true_count > 0 && true_count >= C_EXPECT_RATIO * false_count ? 1
+                             : false_count > 0 && false_count >= C_EXPECT_RATIO * true_count ? 0 : -1;
+    if (expected_value != -1) {
+      add_string_to_file(out_file_ptr, "__builtin_expect(!!(");
+      gen_C_expresion(condition, out_file_ptr, scopes, context);
+      fprintf(out_file_ptr, "), %d)", expected_value);
+      return;
+    }
+  }
+  gen_C_expresion(condition, out_file_ptr, scopes, context);
+}
+
+static void gen_C_statement(const Node_Statement stmt, FILE * out_file_ptr, C_Scopes_List * scopes, C_Context * context) {
+  // the errors of the C compiler and the debuggers show the lines of the program
+  if (is_optimizing_C && stmt.statement_type != scope_type) {
+    fprintf(out_file_ptr, "#line %d\n", get_statement_line(stmt));
+  }
   switch (stmt.statement_type) {
     case var_declaration_type:
-      C_now_compiling_a_declaration_assignment = true;
+      context->now_compiling_a_declaration_assignment = true;
       // var declaration node
       add_string_to_file(out_file_ptr, " ");
-      gen_C_var_decl_type_and_name(out_file_ptr, stmt.statement_value.var_declaration.var_name, stmt.statement_value.var_declaration.type);
+      // the constant tables are initialized once before the program runs
+      const bool is_constant_table = is_constant_array_declaration(context->program, stmt.statement_value.var_declaration);
+      if (is_constant_table) {
+        add_string_to_file(out_file_ptr, "static const ");
+      }
+      else if (is_optimizing_C && is_C_register_variable(context->program, stmt.statement_value.var_declaration)) {
+        add_string_to_file(out_file_ptr, "register ");
+      }
+      gen_C_var_decl_type_and_name(out_file_ptr, stmt.statement_value.var_declaration.var_name, stmt.statement_value.var_declaration.type,
+                                   is_optimizing_C && is_C_restrict_pointer(context->program, stmt.statement_value.var_declaration));
 
       add_string_to_file(out_file_ptr, " = ");
-      gen_C_expresion(stmt.statement_value.var_declaration.value, out_file_ptr, *scopes);
+      gen_C_expresion(stmt.statement_value.var_declaration.value, out_file_ptr, *scopes, context);
 
       C_append_var_to_var_list(scopes, stmt.statement_value.var_declaration.var_name, stmt.statement_value.var_declaration.type);
-      C_now_compiling_a_declaration_assignment = false;
+      context->now_compiling_a_declaration_assignment = false;
       break;
 
     case exit_node_type:
       // exit node
       add_string_to_file(out_file_ptr, " exit((uint64_t)");
-      gen_C_expresion(stmt.statement_value.exit_node.exit_code, out_file_ptr, *scopes);
+      gen_C_operand(stmt.statement_value.exit_node.exit_code, C_UNARY_PRECEDENCE, true, out_file_ptr, *scopes, context);
       add_string_to_file(out_file_ptr, ")");
       break;
 
     case print_type:
       // print node
       add_string_to_file(out_file_ptr, " putchar(");
-      gen_C_expresion(stmt.statement_value.print.chr, out_file_ptr, *scopes);
+      // the operations are in brackets before the `&`, that C groups after all of them
+      gen_C_operand(stmt.statement_value.print.chr, C_UNARY_PRECEDENCE, false, out_file_ptr, *scopes, context);
       add_string_to_file(out_file_ptr, "&0xff)");
       break;
 
@@ -362,77 +619,230 @@ static void gen_C_statement(const Node_Statement stmt, FILE * out_file_ptr, C_Sc
       add_string_to_file(out_file_ptr, " ");
       add_token_to_file(out_file_ptr, stmt.statement_value.var_assignment.var_name);
       add_string_to_file(out_file_ptr, " = ");
-      gen_C_expresion(stmt.statement_value.var_assignment.value, out_file_ptr, *scopes);
+      gen_C_expresion(stmt.statement_value.var_assignment.value, out_file_ptr, *scopes, context);
       break;
 
     case scope_type:
       // scope node
       add_string_to_file(out_file_ptr, " {\n");
-      gen_C_scope(stmt.statement_value.scope, out_file_ptr, scopes);
+      gen_C_scope(stmt.statement_value.scope, out_file_ptr, scopes, context);
       add_string_to_file(out_file_ptr, " }");
       break;
     
     case if_type:
       // if node
+      if (profile_output_file != NULL) {
+        fprintf(out_file_ptr, " profile_counters[%d]++;", find_profile_counter(context->profile_points, stmt.statement_value.if_node.condition));
+      }
       // generate the condition
       add_string_to_file(out_file_ptr, " if ( ");
-      gen_C_expresion(stmt.statement_value.if_node.condition, out_file_ptr, *scopes);
+      gen_C_condition(stmt.statement_value.if_node.condition, false, out_file_ptr, *scopes, context);
       // generate the scope
       add_string_to_file(out_file_ptr, " ) {\n");
-      gen_C_scope(stmt.statement_value.if_node.scope, out_file_ptr, scopes);
+      if (profile_output_file != NULL) {
+        fprintf(out_file_ptr, " profile_counters[%d]++;\n", find_profile_counter(context->profile_points, stmt.statement_value.if_node.condition) + 1);
+      }
+      gen_C_scope(stmt.statement_value.if_node.scope, out_file_ptr, scopes, context);
       add_string_to_file(out_file_ptr, " }");
       // generate the else block
       if (stmt.statement_value.if_node.has_else_block) {
         add_string_to_file(out_file_ptr, " else {\n");
-        gen_C_scope(stmt.statement_value.if_node.else_block, out_file_ptr, scopes);
+        gen_C_scope(stmt.statement_value.if_node.else_block, out_file_ptr, scopes, context);
         add_string_to_file(out_file_ptr, "}");
       }
       break;
 
     case while_type:
       // while node
+      if (profile_output_file != NULL) {
+        fprintf(out_file_ptr, " profile_counters[%d]++;", find_profile_counter(context->profile_points, stmt.statement_value.while_node.condition));
+      }
       // generate the condition
       add_string_to_file(out_file_ptr, " while ( ");
-      gen_C_expresion(stmt.statement_value.while_node.condition, out_file_ptr, *scopes);
+      gen_C_condition(stmt.statement_value.while_node.condition, true, out_file_ptr, *scopes, context);
       // generate the scope
       add_string_to_file(out_file_ptr, " ) {\n");
-      gen_C_scope(stmt.statement_value.while_node.scope, out_file_ptr, scopes);
+      if (profile_output_file != NULL) {
+        fprintf(out_file_ptr, " profile_counters[%d]++;\n", find_profile_counter(context->profile_points, stmt.statement_value.while_node.condition) + 1);
+      }
+      gen_C_scope(stmt.statement_value.while_node.scope, out_file_ptr, scopes, context);
       add_string_to_file(out_file_ptr, " }");
       break;
   }
   add_string_to_file(out_file_ptr, ";\n");
 }
 
-static void gen_C_scope(const Node_Scope scope, FILE * out_file_ptr, C_Scopes_List * scopes) {
+static void gen_C_scope(const Node_Scope scope, FILE * out_file_ptr, C_Scopes_List * scopes, C_Context * context) {
   // FIX: create new scope instead of copying all the vars
   C_Scopes_List temp_scopes = C_copy_scopes_list(*scopes);
   //C_create_scope(&temp_scopes);
   for (int i = 0; i < scope.statements_count; i++) {
-    gen_C_statement(scope.statements_node[i], out_file_ptr, &temp_scopes);
+    gen_C_statement(get_scope_statements(scope)[i], out_file_ptr, &temp_scopes, context);
   }
   C_free_scopes_list(temp_scopes);
 }
 
-// it generates C code
-void gen_C_code(const Node_Program syntax_tree, const char * out_file_name) {
-  FILE * out_file_ptr = create_file(out_file_name);
-
+// the state of a generation of C code that receives the top level statements one by one
+typedef struct C_Generator {
+  FILE * out_file_ptr;
   // this will hold all the variables from all the scopes
   C_Scopes_List scopes;
-  scopes.scopes_count = 0;
-  scopes.variables = malloc(scopes.scopes_count * sizeof(C_Scopes_List));
-  C_create_scope(&scopes); // create first global scope
+  C_Context context;
+} C_Generator;
+
+// starts the generation of C code into the file
+C_Generator begin_C_code(FILE * out_file_ptr) {
+  C_Generator generator = {
+    .out_file_ptr = out_file_ptr,
+    .scopes = { .scopes_count = 0, .variables = smalloc(0) },
+    .context = {
+      .now_compiling_a_declaration_assignment = false, .program = NULL,
+      .index_bounds = { .bounds_count = 0, .bounds = smalloc(0) }, .index_checks_count = 0, .removed_index_checks_count = 0,
+      .profile_points = { .points_count = 0, .points_capacity = 0, .places = NULL }
+    }
+  };
+  C_create_scope(&generator.scopes); // create first global scope
+
+  add_string_to_file(out_file_ptr, "#include <stdlib.h>\n#include <stdio.h>\n#include <stdint.h>\n");
+  if (is_bounds_checking) {
+    add_string_to_file(out_file_ptr,
+      "static uint64_t check_index(uint64_t index, uint64_t length, int line, int column) {\n"
+      " if (index >= length) {\n"
+      "  printf(\"Line:%d, column:%d.  Error: the index is out of the range of the array\\n\", line, column);\n"
+      "  exit(1);\n"
+      " }\n"
+      " return index;\n"
+      "}\n");
+  }
+  if (profile_output_file != NULL) {
+    // the counters and the function that writes them go after main, when all the points are known
+    add_string_to_file(out_file_ptr, "extern uint64_t profile_counters[];\nstatic void write_profile(void);\n");
+  }
+  add_string_to_file(out_file_ptr, "int main() {\n");
+  if (profile_output_file != NULL) {
+    add_string_to_file(out_file_ptr, " atexit(write_profile);\n");
+  }
+  return generator;
+}
+
+void gen_C_top_statement(C_Generator * generator, const Node_Statement stmt) {
+  // without the whole program the statements are analyzed one by one
+  if (is_bounds_checking && generator->context.program == NULL) {
+    free_index_bounds(generator->context.index_bounds);
+    generator->context.index_bounds = analyze_index_bounds(&stmt, 1);
+  }
+  if (profile_output_file != NULL) {
+    add_profile_points(&generator->context.profile_points, &stmt, 1);
+  }
+  gen_C_statement(stmt, generator->out_file_ptr, &generator->scopes, &generator->context);
+}
+
+// the counters of the points and the function that writes them into the profile file when the program exits
+static void gen_C_profile_writer(FILE * out_file_ptr, const Profile_points points) {
+  // one more counter and place so the arrays are never empty
+  fprintf(out_file_ptr, "\nuint64_t profile_counters[%d];\n", PROFILE_COUNTERS_PER_POINT * points.points_count + 1);
+  add_string_to_file(out_file_ptr, "static const uint32_t profile_places[] = {");
+  for (int i = 0; i < points.points_count; i++) {
+    fprintf(out_file_ptr, "%u, %u, ", points.places[i].line_number, points.places[i].column_number);
+  }
+  add_string_to_file(out_file_ptr, "0};\n");
+  add_string_to_file(out_file_ptr, "static void write_profile(void) {\n FILE * file = fopen(\"");
+  for (const char * c = profile_output_file; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', out_file_ptr);
+    }
+    fputc(*c, out_file_ptr);
+  }
+  fprintf(out_file_ptr,
+    "\", \"wb\");\n"
+    " if (file == NULL) {\n"
+    "  return;\n"
+    " }\n"
+    " const uint64_t points_count = %d;\n"
+    " fwrite(\"%s\", 1, %d, file);\n"
+    " fwrite(&points_count, sizeof(points_count), 1, file);\n"
+    " fwrite(profile_places, sizeof(*profile_places), 2 * points_count, file);\n"
+    " fwrite(profile_counters, sizeof(*profile_counters), %d * points_count, file);\n"
+    " fclose(file);\n"
+    "}\n", points.points_count, PROFILE_MAGIC, PROFILE_MAGIC_SIZE, PROFILE_COUNTERS_PER_POINT);
+}
+
+void end_C_code(C_Generator * generator) {
+  add_string_to_file(generator->out_file_ptr, "}");
+  if (profile_output_file != NULL) {
+    gen_C_profile_writer(generator->out_file_ptr, generator->context.profile_points);
+  }
+  free_profile_points(generator->context.profile_points);
+  C_free_scopes_list(generator->scopes);
+  free_index_bounds(generator->context.index_bounds);
+  if (is_bounds_checking) {
+    report_removed_index_checks(generator->context.index_checks_count, generator->context.removed_index_checks_count);
+  }
+}
+
+// the state of the generation at the beginning of a chunk of the program, see chunks.h
+typedef struct C_Chunk {
+  C_Context context;
+  C_Scopes_List scopes;
+  int first_statement;
+  int end_statement;
+} C_Chunk;
+
+// lays out the chunks of the program, the variables declared before every chunk are known without generating the code
+static C_Chunk * lay_out_C_chunks(C_Generator * generator, const Code_chunks chunks) {
+  const Node_Program * program = generator->context.program;
+  C_Chunk * states = smalloc(chunks.chunks_count * sizeof(*states));
+  for (int i = 0; i < chunks.chunks_count; i++) {
+    states[i] = (C_Chunk) {
+      .context = generator->context,
+      .scopes = C_copy_scopes_list(generator->scopes),
+      .first_statement = get_chunk_first_statement(chunks, i),
+      .end_statement = get_chunk_end_statement(chunks, i, program->statements_count)
+    };
+    for (int j = states[i].first_statement; j < states[i].end_statement; j++) {
+      const Node_Statement stmt = program->statements_node[j];
+      if (stmt.statement_type == var_declaration_type) {
+        C_append_var_to_var_list(&generator->scopes, stmt.statement_value.var_declaration.var_name, stmt.statement_value.var_declaration.type);
+      }
+    }
+  }
+  return states;
+}
 
-  add_string_to_file(out_file_ptr, "#include <stdlib.h>\n#include <stdio.h>\n#include <stdint.h>\nint main() {\n");
-  for (int i = 0; i < syntax_tree.statements_count; i++) {
-    Node_Statement node = syntax_tree.statements_node[i];
-    gen_C_statement(node, out_file_ptr, &scopes);
+static void gen_C_chunk(void * states, const int chunk_index, FILE * code_file_ptr, FILE * end_file_ptr) {
+  // the C code has nothing after main that comes from the chunks
+  (void) end_file_ptr;
+  C_Chunk * chunk = &((C_Chunk *) states)[chunk_index];
+  for (int i = chunk->first_statement; i < chunk->end_statement; i++) {
+    gen_C_statement(chunk->context.program->statements_node[i], code_file_ptr, &chunk->scopes, &chunk->context);
   }
-  add_string_to_file(out_file_ptr, "}");
+  C_free_scopes_list(chunk->scopes);
+}
 
-  C_free_scopes_list(scopes);
+// it generates C code into the file
+void gen_C_code(const Node_Program syntax_tree, FILE * out_file_ptr) {
+  C_Generator generator = begin_C_code(out_file_ptr);
+  generator.context.program = &syntax_tree;
+  if (is_bounds_checking) {
+    free_index_bounds(generator.context.index_bounds);
+    generator.context.index_bounds = analyze_index_bounds(syntax_tree.statements_node, syntax_tree.statements_count);
+  }
+  // the points of all the chunks are known before generating any of them
+  if (profile_output_file != NULL) {
+    add_profile_points(&generator.context.profile_points, syntax_tree.statements_node, syntax_tree.statements_count);
+  }
 
-  fclose(out_file_ptr);
+  Code_chunks chunks = split_code_chunks(syntax_tree.statements_count);
+  C_Chunk * states = lay_out_C_chunks(&generator, chunks);
+  generate_code_chunks(&chunks, gen_C_chunk, states, code_generation_workers_count);
+  write_code_chunks(out_file_ptr, chunks);
+  for (int i = 0; i < chunks.chunks_count; i++) {
+    generator.context.index_checks_count += states[i].context.index_checks_count;
+    generator.context.removed_index_checks_count += states[i].context.removed_index_checks_count;
+  }
+  sfree(states);
+  free_code_chunks(chunks);
+  end_C_code(&generator);
 }
 
 
@@ -441,12 +851,91 @@ void gen_C_code(const Node_Program syntax_tree, const char * out_file_name) {
  * Generating ASM code *
  * * * * * * * * * * * */
 
+// the vector instructions the NASM code can use for the vectorized loops
+typedef enum Vector_extension {
+  vector_extension_none,
+  vector_extension_sse2,
+  vector_extension_avx2
+} Vector_extension;
+
+// it is selected with -march before the compilations begin, SSE2 is in every x86-64 processor
+Vector_extension NASM_vector_extension = vector_extension_sse2;
+
+static const char * const vector_extension_names[] = {
+  [vector_extension_none] = "none",
+  [vector_extension_sse2] = "sse2",
+  [vector_extension_avx2] = "avx2"
+};
+
+// selects the vector instructions of the processors of the -march value, returns false if it is not known
+// the levels of x86-64 before AVX2 only add instructions the vectorized loops do not use
+bool select_NASM_march(const char * march) {
+  if (strcmp(march, "x86-64") == 0 || strcmp(march, "x86-64-v2") == 0) {
+    NASM_vector_extension = vector_extension_sse2;
+  }
+  else if (strcmp(march, "x86-64-v3") == 0 || strcmp(march, "x86-64-v4") == 0) {
+    NASM_vector_extension = vector_extension_avx2;
+  }
+  else if (strcmp(march, "native") == 0) {
+    // the processor running the compiler
+    NASM_vector_extension = vector_extension_sse2;
+#if defined(__GNUC__) && defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+      NASM_vector_extension = vector_extension_avx2;
+    }
+#endif
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+// the constant tables of the declarations of the program, by the places of their names in the code
+// they are laid out before the code, so every chunk of the program knows the tables of the chunks before it
+typedef struct NASM_Tables {
+  int tables_count;
+  Token * names;
+} NASM_Tables;
+
+// the state of a NASM code generation, every generation has its own so many can run at the same time
+typedef struct NASM_Context {
+  // keep track of an unique identification for the labels so there arent collisions with other labels
+  int uuid;
+  // the labels of every chunk of the program start with its own prefix, so they are unique in the whole program
+  char label_prefix[16];
+  // the label of a constant table is its index
+  NASM_Tables tables;
+  // the whole program, to find the constant tables, it is NULL when the statements come one by one
+  const Node_Program * program;
+  // the statements of the scope being generated and the index of the current one,
+  // the loops look at the ones before them to know their first iteration, it is NULL when they are not known
+  const Node_Statement * scope_statements;
+  int statement_index;
+  // the copies of an unrolled loop after the first one are not reported again
+  bool is_in_repeated_copy;
+  // the indexes that do not need to be checked with --bounds-check, and the counts of the checks
+  Index_bounds index_bounds;
+  int index_checks_count;
+  int removed_index_checks_count;
+  // the ifs and the whiles counted with --profile-generate
+  Profile_points profile_points;
+  // the blocks of the ifs that the profile of --profile-use says rarely run, they go after the end of the program
+  char * cold_code;
+  size_t cold_code_size;
+} NASM_Context;
+
+// the constant arrays with less elements are built in the stack, copying them would be slower
+#define MIN_COPIED_CONSTANT_ELEMENTS 4
+
 // type containning the variables of the program and their places in the stack
 typedef struct ASM_Variables_List {
   int var_stack_size;
   int * var_stack_places_list;
   Token * var_stack_tokens_list;
   Node_Type * var_stack_types_list;
+  // the label of the constant tables that are never copied to the stack, -1 for the rest
+  int * var_data_labels_list;
 } ASM_Variables_List;
 
 typedef struct ASM_Scopes_List {
@@ -470,6 +959,20 @@ static int find_var_stack_place(const ASM_Scopes_List vars_list, const Token var
   return -1;
 }
 
+// find the label of the data of the variable, -1 if it is in the stack
+static int find_var_data_label(const ASM_Scopes_List vars_list, const Token var) {
+  for (int i = 0; i < vars_list.scopes_count; i++) {
+    for (int j = 0; j < vars_list.variables[i].var_stack_size; j++) {
+      if (compare_str_of_tokens(var, vars_list.variables[i].var_stack_tokens_list[j])) {
+        return vars_list.variables[i].var_data_labels_list[j];
+      }
+    }
+  }
+  implementation_error("could not find variable in variable list");
+  // unreachable
+  return -1;
+}
+
 static ASM_Scopes_List NASM_copy_scopes_list(const ASM_Scopes_List scopes) {
   ASM_Scopes_List result;
   result.scopes_count = scopes.scopes_count;
@@ -485,12 +988,15 @@ static ASM_Scopes_List NASM_copy_scopes_list(const ASM_Scopes_List scopes) {
 
     result.variables[i].var_stack_types_list = smalloc(result.variables[i].var_stack_size * sizeof(*result.variables[i].var_stack_types_list));
     memcpy(result.variables[i].var_stack_types_list, scopes.variables[i].var_stack_types_list, result.variables[i].var_stack_size * sizeof(*result.variables[i].var_stack_types_list));
+
+    result.variables[i].var_data_labels_list = smalloc(result.variables[i].var_stack_size * sizeof(*result.variables[i].var_data_labels_list));
+    memcpy(result.variables[i].var_data_labels_list, scopes.variables[i].var_data_labels_list, result.variables[i].var_stack_size * sizeof(*result.variables[i].var_data_labels_list));
   }
   return result;
 }
 
-// add a variable to the last scope of list of variables, and its place on the stack
-static void NASM_append_var_to_var_list(ASM_Scopes_List * scopes, const Token variable, const int stack_place, const Node_Type type) {
+// add a variable to the last scope of list of variables, and its place on the stack or the label of its data
+static void NASM_append_var_to_var_list(ASM_Scopes_List * scopes, const Token variable, const int stack_place, const Node_Type type, const int data_label) {
   ASM_Variables_List * last_scope = &scopes->variables[scopes->scopes_count -1];
   last_scope->var_stack_size++;
 
@@ -502,6 +1008,9 @@ static void NASM_append_var_to_var_list(ASM_Scopes_List * scopes, const Token va
 
   last_scope->var_stack_types_list = srealloc(last_scope->var_stack_types_list, last_scope->var_stack_size * sizeof(*last_scope->var_stack_types_list));
   last_scope->var_stack_types_list[last_scope->var_stack_size -1] = type;
+
+  last_scope->var_data_labels_list = srealloc(last_scope->var_data_labels_list, last_scope->var_stack_size * sizeof(*last_scope->var_data_labels_list));
+  last_scope->var_data_labels_list[last_scope->var_stack_size -1] = data_label;
 }
 
 // create a new scope and append it to the end of the list of scopes
@@ -509,18 +1018,20 @@ static void NASM_create_scope(ASM_Scopes_List * scopes) {
   scopes->scopes_count++;
   scopes->variables = srealloc(scopes->variables, scopes->scopes_count * sizeof(*scopes->variables));
   scopes->variables[scopes->scopes_count -1].var_stack_size = 0;
-  scopes->variables[scopes->scopes_count -1].var_stack_tokens_list = malloc(scopes->variables[scopes->scopes_count -1].var_stack_size * sizeof(Token));
-  scopes->variables[scopes->scopes_count -1].var_stack_places_list = malloc(scopes->variables[scopes->scopes_count -1].var_stack_size * sizeof(int));
-  scopes->variables[scopes->scopes_count -1].var_stack_types_list = malloc(scopes->variables[scopes->scopes_count -1].var_stack_size * sizeof(Node_Type));
+  scopes->variables[scopes->scopes_count -1].var_stack_tokens_list = smalloc(scopes->variables[scopes->scopes_count -1].var_stack_size * sizeof(Token));
+  scopes->variables[scopes->scopes_count -1].var_stack_places_list = smalloc(scopes->variables[scopes->scopes_count -1].var_stack_size * sizeof(int));
+  scopes->variables[scopes->scopes_count -1].var_stack_types_list = smalloc(scopes->variables[scopes->scopes_count -1].var_stack_size * sizeof(Node_Type));
+  scopes->variables[scopes->scopes_count -1].var_data_labels_list = smalloc(scopes->variables[scopes->scopes_count -1].var_stack_size * sizeof(int));
 }
 
 static void NASM_free_scopes_list(ASM_Scopes_List scopes) {
   for (int i = 0; i < scopes.scopes_count; i++) {
-    free(scopes.variables[i].var_stack_places_list);
-    free(scopes.variables[i].var_stack_tokens_list);
-    free(scopes.variables[i].var_stack_types_list);
+    sfree(scopes.variables[i].var_stack_places_list);
+    sfree(scopes.variables[i].var_stack_tokens_list);
+    sfree(scopes.variables[i].var_stack_types_list);
+    sfree(scopes.variables[i].var_data_labels_list);
   }
-  free(scopes.variables);
+  sfree(scopes.variables);
 }
 
 Node_Type NASM_get_type_of_variable(const Token variable, const ASM_Scopes_List scopes) {
@@ -540,19 +1051,18 @@ Node_Type NASM_get_type_of_expresion(Node_Expresion expresion, ASM_Scopes_List s
     return NASM_get_type_of_variable(expresion.expresion_value.expresion_identifier_value, scopes);
   }
   if (expresion.expresion_type == expresion_unary_operation_type) {
-    Node_Unary_Operation uni_operation = *expresion.expresion_value.expresion_unary_operation_value;
+    Node_Unary_Operation uni_operation = *get_unary_operation(expresion);
     Node_Expresion uni_expresion = uni_operation.expresion;
     Node_Type type;
     // if the operation is the address operator `&`, the returned type is a pointer to the type of the expression
     if (uni_operation.operation_type == unary_operation_addr_type) {
       type.token = NULL_TOKEN;
       type.type_type = type_ptr_type;
-      type.type_value.type_ptr_value = smalloc(sizeof(*type.type_value.type_ptr_value)); // FIX: this leaks memory
-      *type.type_value.type_ptr_value = NASM_get_type_of_expresion(uni_expresion, scopes);
+      type.type_value.type_ptr_value = add_type(NASM_get_type_of_expresion(uni_expresion, scopes));
     }
     // if the operation is the dereference operator `*`, the returned type is type the pointer holds
     else if (uni_operation.operation_type == unary_operation_deref_type) {
-      type = *NASM_get_type_of_expresion(uni_expresion, scopes).type_value.type_ptr_value;
+      type = *get_pointed_type(NASM_get_type_of_expresion(uni_expresion, scopes));
     }
     else {
       type = NASM_get_type_of_expresion(uni_expresion, scopes);
@@ -561,47 +1071,272 @@ Node_Type NASM_get_type_of_expresion(Node_Expresion expresion, ASM_Scopes_List s
   }
   if (expresion.expresion_type == expresion_binary_operation_type) {
     // does not matter if its `left_side` or `right_side`
-    Node_Expresion lhs_expr = expresion.expresion_value.expresion_binary_operation_value->left_side;
-    return  NASM_get_type_of_expresion(lhs_expr, scopes);
+    Node_Expresion lhs_expr = get_binary_operation(expresion)->left_side;
+    const Node_Type lhs_type = NASM_get_type_of_expresion(lhs_expr, scopes);
+    // the access to an array has the type of its elements
+    if (get_binary_operation(expresion)->operation_type == binary_operation_access_type && lhs_type.type_type == type_array_type) {
+      return *get_type(get_array_type(lhs_type)->primitive_type);
+    }
+    return lhs_type;
   }
   if (expresion.expresion_type == expresion_array_type) {
     Node_Type type;
     type.token = NULL_TOKEN;
     type.type_type = type_array_type;
-    type.type_value.type_array_value = smalloc(sizeof(*type.type_value.type_array_value));
-    type.type_value.type_array_value->primitive_type = smalloc(sizeof(*type.type_value.type_array_value->primitive_type));
-    *type.type_value.type_array_value->primitive_type = NASM_get_type_of_expresion(expresion.expresion_value.expresion_array_value->elements[0], scopes);
-    // FIX: convert the number to token in a more reasonable way
-    type.type_value.type_array_value->elements_count.beginning = smalloc(2);
-    type.type_value.type_array_value->elements_count.length = 2;
-    type.type_value.type_array_value->elements_count.beginning[0] = '0' + expresion.expresion_value.expresion_array_value->elements_count / 10;
-    type.type_value.type_array_value->elements_count.beginning[1] = '0' + expresion.expresion_value.expresion_array_value->elements_count % 10;
-    type.type_value.type_array_value->elements_count.type = Number;
+    Node_Type element_type = NASM_get_type_of_expresion(get_array_elements(expresion.expresion_value.expresion_array_value)[0], scopes);
+    // the integers inside an array literal are u64
+    if (element_type.type_type == type_primitive_type) {
+      element_type = get_literal_type();
+    }
+    const Node_index primitive_type = add_type(element_type);
+    type.type_value.type_array_value = add_array_type((Node_Array_type) { .primitive_type = primitive_type });
+    get_array_type(type)->elements_count = get_number_token(expresion.expresion_value.expresion_array_value.elements_count);
     return type;
   }
   if (expresion.expresion_type == expresion_number_type) {
     // FIX: can not get the type of an integer literal so assume it is `u64`
-    Node_Type type;
-    type.token.beginning = smalloc(4); // FIX: this also leaks memory
-    strcpy(type.token.beginning, "u64");
-    type.token.length = 3;
-    type.type_type = type_primitive_type;
-    type.type_value.type_primitive_value = type.token;
-    return type;
+    return get_literal_type();
   }
   implementation_error("unkown type of expresion while trying to get its type");
   return (Node_Type) {};
 }
 
 
+/* sizes of the values */
+
+// in the stack the values take whole qwords: the integers are kept zero extended in 8 bytes,
+// and the arrays of smaller integers are packed with the first element at the end of their last qword,
+// so the element `i` of an array of elements of `size` bytes is at `address + 8 - size - i * size`,
+// and for the arrays of u64 that is the usual `address - i * 8`
+static int get_NASM_size_of_type(const Node_Type type) {
+  return (get_size_of_type(type) + U64_sz - 1) / U64_sz * U64_sz;
+}
+
+// the size of the integers inside an array, also in the arrays inside it
+static int get_NASM_size_of_array_integers(const Node_Type type) {
+  if (type.type_type == type_array_type) {
+    return get_NASM_size_of_array_integers(*get_type(get_array_type(type)->primitive_type));
+  }
+  return get_size_of_type(type);
+}
+
+// the size of the loads and the stores of a value of the type, the ones that are not integers use qwords
+static int get_NASM_integer_size(const Node_Type type) {
+  return type.type_type == type_primitive_type ? get_size_of_type(type) : U64_sz;
+}
+
+// the names of the memory operands and of rax for the sizes in bytes of the integers
+static const char * const NASM_size_names[] = { [1] = "byte", [2] = "word", [4] = "dword", [8] = "qword" };
+static const char * const NASM_rax_names[] = { [1] = "al", [2] = "ax", [4] = "eax", [8] = "rax" };
+
+// puts the integer of the size at `[base + displacement]` into rax, zero extended
+static void gen_NASM_integer_load(FILE * file_ptr, const int size, const char * base, const int displacement) {
+  if (size == 4) {
+    // writing eax clears the upper half of rax
+    fprintf(file_ptr, "mov eax, dword [%s + %d]\n", base, displacement);
+  }
+  else {
+    fprintf(file_ptr, "%s rax, %s [%s + %d]\n", size == U64_sz ? "mov" : "movzx", NASM_size_names[size], base, displacement);
+  }
+}
+
+// keeps in rax only the lower bytes that fit in the integer of the size
+static void gen_NASM_integer_truncation(FILE * file_ptr, const int size) {
+  if (size == 4) {
+    add_string_to_file(file_ptr, "mov eax, eax\n");
+  }
+  else if (size < U64_sz) {
+    fprintf(file_ptr, "movzx rax, %s\n", NASM_rax_names[size]);
+  }
+}
+
+// returns true if the array literal has to be packed into an array of smaller integers,
+// the integers of the array literals are always built as u64
+static bool is_NASM_packed_literal(const Node_Type type, const Node_Expresion value, const ASM_Scopes_List vars) {
+  return type.type_type == type_array_type && value.expresion_type == expresion_array_type
+      && get_size_of_type(type) != get_size_of_type(NASM_get_type_of_expresion(value, vars));
+}
+
+// packs the u64 of the array literal at the place of the stack into the array at the address in rdi
+static void gen_NASM_packed_array(FILE * file_ptr, const Node_Type type, const int literal_place) {
+  const int size = get_NASM_size_of_array_integers(type);
+  const int integers_count = get_size_of_type(type) / size;
+  for (int i = 0; i < integers_count; i++) {
+    fprintf(file_ptr, "mov rax, qword [rbp - %d]\n", literal_place + i * U64_sz);
+    const int displacement = U64_sz - size - i * size;
+    fprintf(file_ptr, "mov %s [rdi %c %d], %s\n", NASM_size_names[size], displacement < 0 ? '-' : '+', abs(displacement), NASM_rax_names[size]);
+  }
+}
+
+// writes the lower bytes of the number that fit in the size, the numbers of the program can be bigger than the data
+static void add_NASM_truncated_number(FILE * file_ptr, const Token number, const int size) {
+  if (size == U64_sz) {
+    add_number_to_file(file_ptr, number);
+    return;
+  }
+  fprintf(file_ptr, "%llu", (unsigned long long)(number.value & ((1ull << (size * 8)) - 1)));
+}
+
+// puts the numbers of the constant array after its label
+// the elements go downwards like in the stack, so the numbers are written from the last one,
+// the integers have the size of the ones of the array, and the data is padded before them to whole qwords
+static void gen_NASM_constant_data(FILE * file_ptr, const Node_Expresion expresion, const int size, int * numbers_count) {
+  *numbers_count = flatten_constant_array(expresion, NULL);
+  Token * numbers = smalloc(*numbers_count * sizeof(*numbers));
+  flatten_constant_array(expresion, numbers);
+  for (int i = *numbers_count * size; i % U64_sz != 0; i++) {
+    add_string_to_file(file_ptr, "db 0\n");
+  }
+  const char * directive = size == 1 ? "db " : size == 2 ? "dw " : size == 4 ? "dd " : "dq ";
+  for (int i = *numbers_count -1; i >= 0; i--) {
+    add_string_to_file(file_ptr, directive);
+    add_NASM_truncated_number(file_ptr, numbers[i], size);
+    add_string_to_file(file_ptr, "\n");
+  }
+  sfree(numbers);
+}
+
+// puts the numbers of the constant array in the read only data, returns the number of its label
+static int gen_NASM_constant_array(FILE * file_ptr, NASM_Context * context, const Node_Expresion expresion, const int size, int * numbers_count) {
+  const int data_label = context->uuid;
+  context->uuid++;
+  add_string_to_file(file_ptr, "section .rodata\n");
+  fprintf(file_ptr, ".CONST%s%d:\n", context->label_prefix, data_label);
+  gen_NASM_constant_data(file_ptr, expresion, size, numbers_count);
+  add_string_to_file(file_ptr, "section .text\n");
+  return data_label;
+}
+
+static void add_NASM_tables(FILE * file_ptr, const Node_Program * program, NASM_Tables * tables, const Node_Statement * statements,
+                            const int statements_count) {
+  for (int i = 0; i < statements_count; i++) {
+    const Node_Statement stmt = statements[i];
+    switch (stmt.statement_type) {
+      case var_declaration_type:;
+        const Node_Var_declaration var_declaration = stmt.statement_value.var_declaration;
+        if (is_constant_array_declaration(program, var_declaration)) {
+          if (tables->tables_count == 0) {
+            add_string_to_file(file_ptr, "section .rodata\n");
+          }
+          int numbers_count;
+          fprintf(file_ptr, ".TABLE%d:\n", tables->tables_count);
+          gen_NASM_constant_data(file_ptr, var_declaration.value, get_NASM_size_of_array_integers(var_declaration.type), &numbers_count);
+          tables->names = srealloc(tables->names, (tables->tables_count + 1) * sizeof(*tables->names));
+          tables->names[tables->tables_count] = var_declaration.var_name;
+          tables->tables_count++;
+        }
+        break;
+
+      case scope_type:
+        add_NASM_tables(file_ptr, program, tables, get_scope_statements(stmt.statement_value.scope), stmt.statement_value.scope.statements_count);
+        break;
+
+      case if_type:;
+        const Node_If if_node = stmt.statement_value.if_node;
+        add_NASM_tables(file_ptr, program, tables, get_scope_statements(if_node.scope), if_node.scope.statements_count);
+        if (if_node.has_else_block) {
+          add_NASM_tables(file_ptr, program, tables, get_scope_statements(if_node.else_block), if_node.else_block.statements_count);
+        }
+        break;
+
+      case while_type:;
+        const Node_While while_node = stmt.statement_value.while_node;
+        add_NASM_tables(file_ptr, program, tables, get_scope_statements(while_node.scope), while_node.scope.statements_count);
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+// puts the constant tables of the declarations of the program in the read only data, in the order of the code,
+// a declaration repeated by an unrolled loop uses the same table in every copy
+static NASM_Tables gen_NASM_tables(FILE * file_ptr, const Node_Program * program) {
+  NASM_Tables tables = { .tables_count = 0, .names = NULL };
+  add_NASM_tables(file_ptr, program, &tables, program->statements_node, program->statements_count);
+  if (tables.tables_count > 0) {
+    add_string_to_file(file_ptr, "section .text\n\n");
+  }
+  return tables;
+}
+
+// returns the label of the table of the declaration of the variable, or -1 if it has none
+static int find_NASM_table(const NASM_Tables tables, const Token name) {
+  int first = 0;
+  int last = tables.tables_count -1;
+  while (first <= last) {
+    const int middle = (first + last) / 2;
+    const Token table_name = tables.names[middle];
+    // the tables are in the order of the code, that is the order of the names in the text
+    if (table_name.beginning == name.beginning) {
+      return middle;
+    }
+    if (table_name.beginning < name.beginning) {
+      first = middle + 1;
+    }
+    else {
+      last = middle -1;
+    }
+  }
+  return -1;
+}
+
+// checks that the index in rbx is less than the length of the array, otherwise the program stops with an error
+static void gen_NASM_index_check(FILE * file_ptr, NASM_Context * context, const Node_Expresion access, const int length) {
+  if (!context->is_in_repeated_copy) {
+    context->index_checks_count++;
+  }
+  if (is_index_in_range(context->index_bounds, access, length)) {
+    if (!context->is_in_repeated_copy) {
+      context->removed_index_checks_count++;
+    }
+    return;
+  }
+  const int check_uid = context->uuid;
+  context->uuid++;
+  const Token_place place = get_token_place(get_first_token_of_expresion(get_binary_operation(access)->right_side));
+  // the same error of the interpreter
+  char message[128];
+  const int message_length = snprintf(message, sizeof(message), "Line:%d, column:%d.  Error: the index is out of the range of the array\n",
+                                      place.line_number, place.column_number);
+  fprintf(file_ptr, "cmp rbx, %d\n", length);
+  fprintf(file_ptr, "jb .IDX%s%d\n", context->label_prefix, check_uid); // IDX is for "index"
+  // the message of the error
+  add_string_to_file(file_ptr, "section .rodata\n");
+  fprintf(file_ptr, ".IDXM%s%d:\n", context->label_prefix, check_uid);
+  add_string_to_file(file_ptr, "db ");
+  for (int i = 0; i < message_length; i++) {
+    fprintf(file_ptr, i == 0 ? "%d" : ", %d", message[i]);
+  }
+  add_string_to_file(file_ptr, "\nsection .text\n");
+  fprintf(file_ptr, "lea rsi, [.IDXM%s%d]\n", context->label_prefix, check_uid);
+  fprintf(file_ptr, "mov rdx, %d\n", message_length);
+  add_string_to_file(file_ptr, "jmp .INDEX_ERROR\n");
+  fprintf(file_ptr, ".IDX%s%d:\n", context->label_prefix, check_uid);
+}
+
+// puts the address of the variable into the register, from the stack or from its data
+static void gen_NASM_variable_address(FILE * file_ptr, const char * register_name, const ASM_Scopes_List vars, const Token variable) {
+  const int data_label = find_var_data_label(vars, variable);
+  if (data_label == -1) {
+    fprintf(file_ptr, "lea %s, [rbp - %d]\n", register_name, find_var_stack_place(vars, variable));
+  }
+  else {
+    // the first element is the one with the highest address
+    const int last_element_offset = get_NASM_size_of_type(NASM_get_type_of_variable(variable, vars)) - U64_sz;
+    fprintf(file_ptr, "lea %s, [.TABLE%d + %d]\n", register_name, data_label, last_element_offset);
+  }
+}
+
 // generates asm from expresion the result will be put in the top of the stack
-static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion, int stack_size, const ASM_Scopes_List vars) {
+static void gen_NASM_expresion(FILE * file_ptr, NASM_Context * context, const Node_Expresion expresion, int stack_size, const ASM_Scopes_List vars) {
   switch (expresion.expresion_type) {
     case expresion_number_type:
       add_string_to_file(file_ptr, "mov qword [rbp - ");
       fprintf(file_ptr, "%d", stack_size);
       add_string_to_file(file_ptr, "], ");
-      add_token_to_file(file_ptr, expresion.expresion_value.expresion_number_value);
+      add_number_to_file(file_ptr, expresion.expresion_value.expresion_number_value);
       add_string_to_file(file_ptr, "\n");
       stack_size += U64_sz;
       break;
@@ -609,23 +1344,20 @@ static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion,
     case expresion_identifier_type:
       Token identifier = expresion.expresion_value.expresion_identifier_value;
       if (NASM_get_type_of_expresion(expresion, vars).type_type == type_array_type) {
-        int array_stack_place = find_var_stack_place(vars, identifier);
-        int array_size_bytes = get_size_of_type(NASM_get_type_of_expresion(expresion, vars));
+        int array_size_bytes = get_NASM_size_of_type(NASM_get_type_of_expresion(expresion, vars));
         // copy the array to the top of the stack
         // keep the address of the array
-        add_string_to_file(file_ptr, "lea rbx, [rbp - ");
-        fprintf(file_ptr, "%d", array_stack_place);
-        add_string_to_file(file_ptr, "]\n");
-        for (int i = 0; i < array_size_bytes; i++) {
-          stack_size += 1;
-          // read byte
-          add_string_to_file(file_ptr, "mov al, byte [rbx - ");
+        gen_NASM_variable_address(file_ptr, "rbx", vars, identifier);
+        // the elements go downwards from the address, like the variables
+        for (int i = 0; i < array_size_bytes; i += U64_sz) {
+          // read the element
+          add_string_to_file(file_ptr, "mov rax, qword [rbx - ");
           fprintf(file_ptr, "%d", i);
           add_string_to_file(file_ptr, "]\n");
-          // write byte
-          add_string_to_file(file_ptr, "mov byte [rbp - ");
-          fprintf(file_ptr, "%d", i);
-          add_string_to_file(file_ptr, "], al\n");
+          // write the element
+          add_string_to_file(file_ptr, "mov qword [rbp - ");
+          fprintf(file_ptr, "%d", stack_size + i);
+          add_string_to_file(file_ptr, "], rax\n");
         }
       }
       else {
@@ -643,21 +1375,16 @@ static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion,
 
     case expresion_binary_operation_type:
       // TODO: this should be handled in switch case like the other operations 
-      if (expresion.expresion_value.expresion_binary_operation_value->operation_type == binary_operation_access_type) {
-        printf("asjkdk\n");
-        printf("%d\n", stack_size);
+      if (get_binary_operation(expresion)->operation_type == binary_operation_access_type) {
         int old_stack_size = stack_size;
         // put the array onto the stack top
         int array_addr = stack_size;
-        gen_NASM_expresion(file_ptr, expresion.expresion_value.expresion_binary_operation_value->left_side, stack_size, vars);
-        stack_size += get_size_of_type(NASM_get_type_of_expresion(expresion.expresion_value.expresion_binary_operation_value->left_side, vars));
-        
-        printf("%d\n", stack_size);        
-        
+        gen_NASM_expresion(file_ptr, context, get_binary_operation(expresion)->left_side, stack_size, vars);
+        stack_size += get_NASM_size_of_type(NASM_get_type_of_expresion(get_binary_operation(expresion)->left_side, vars));
+
         // put the index onto the stack
         int index_addr = stack_size;
-        printf("%d\n", stack_size);
-        gen_NASM_expresion(file_ptr, expresion.expresion_value.expresion_binary_operation_value->right_side, stack_size, vars);
+        gen_NASM_expresion(file_ptr, context, get_binary_operation(expresion)->right_side, stack_size, vars);
         stack_size += 8;
         // load the address of the array
         add_string_to_file(file_ptr, "lea rax, [rbp - ");
@@ -667,14 +1394,34 @@ static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion,
         add_string_to_file(file_ptr, "mov rbx, qword [rbp - ");
         fprintf(file_ptr, "%d", index_addr);
         add_string_to_file(file_ptr, "]\n");
+        const Node_Type array_type = NASM_get_type_of_expresion(get_binary_operation(expresion)->left_side, vars);
+        if (is_bounds_checking && array_type.type_type == type_array_type) {
+          gen_NASM_index_check(file_ptr, context, expresion, (int) get_array_type(array_type)->elements_count.value);
+        }
+        const Node_Type element_type = array_type.type_type == type_array_type ? *get_type(get_array_type(array_type)->primitive_type) : get_literal_type();
+        if (element_type.type_type == type_array_type) {
+          // the arrays inside an array are packed one after the other, the element is copied whole to the stack top,
+          // it has the same layout there as in the array, so it is copied in qwords from its address
+          add_string_to_file(file_ptr, "mov rax, rbx\n");
+          fprintf(file_ptr, "mov rdx, %d\n", get_size_of_type(element_type));
+          add_string_to_file(file_ptr, "mul rdx\n");
+          fprintf(file_ptr, "lea rbx, [rbp - %d]\n", array_addr);
+          add_string_to_file(file_ptr, "sub rbx, rax\n");
+          for (int i = 0; i < get_NASM_size_of_type(element_type); i += U64_sz) {
+            fprintf(file_ptr, "mov rdx, qword [rbx - %d]\n", i);
+            fprintf(file_ptr, "mov qword [rbp - %d], rdx\n", old_stack_size + i);
+          }
+          return;
+        }
+        const int element_size = get_NASM_integer_size(element_type);
         // adjust the index to the size of the type inside the array
         add_string_to_file(file_ptr, "lea rbx, [rbx * ");
-        fprintf(file_ptr, "%d", U64_sz);
+        fprintf(file_ptr, "%d", element_size);
         add_string_to_file(file_ptr, "]\n");
         // the stack grows downwards
         add_string_to_file(file_ptr, "sub rax, rbx\n");
         // get the value at the index in the array
-        add_string_to_file(file_ptr, "mov rax, qword [rax]\n");
+        gen_NASM_integer_load(file_ptr, element_size, "rax", U64_sz - element_size);
         // put the result in stack top
         add_string_to_file(file_ptr, "mov qword [rbp - ");
         fprintf(file_ptr, "%d", old_stack_size);
@@ -685,11 +1432,11 @@ static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion,
       int old_stack_size = stack_size;
       // put left hand side expresion into stack top
       stack_size += 8;
-      gen_NASM_expresion(file_ptr, expresion.expresion_value.expresion_binary_operation_value->left_side, stack_size, vars);
+      gen_NASM_expresion(file_ptr, context, get_binary_operation(expresion)->left_side, stack_size, vars);
       int lhs_stack_place = stack_size;
       // put also the right side into the stack
       stack_size += 8;
-      gen_NASM_expresion(file_ptr, expresion.expresion_value.expresion_binary_operation_value->right_side, stack_size, vars);
+      gen_NASM_expresion(file_ptr, context, get_binary_operation(expresion)->right_side, stack_size, vars);
       int rhs_stack_place = stack_size;
       // load the first operand
       add_string_to_file(file_ptr, "mov rax, qword [rbp - ");
@@ -700,7 +1447,7 @@ static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion,
       fprintf(file_ptr, "%d", rhs_stack_place);
       add_string_to_file(file_ptr, "]\n");
       // perform the corresponding binary operation
-      switch (expresion.expresion_value.expresion_binary_operation_value->operation_type) {
+      switch (get_binary_operation(expresion)->operation_type) {
         // TODO: add the ^ operator
         case binary_operation_sum_type:
           // add them together
@@ -788,14 +1535,10 @@ static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion,
 
     case expresion_unary_operation_type:
       // perform the corresponding unary operation
-      switch (expresion.expresion_value.expresion_unary_operation_value->operation_type) {
+      switch (get_unary_operation(expresion)->operation_type) {
         case unary_operation_addr_type:
-          stack_size += PTR_sz;
           // get the address of a variable
-          int var_addr =  find_var_stack_place(vars, expresion.expresion_value.expresion_unary_operation_value->expresion.expresion_value.expresion_identifier_value);
-          add_string_to_file(file_ptr, "lea rax, [rbp - ");
-          fprintf(file_ptr, "%d", var_addr);
-          add_string_to_file(file_ptr, "]\n");
+          gen_NASM_variable_address(file_ptr, "rax", vars, get_unary_operation(expresion)->expresion.expresion_value.expresion_identifier_value);
           // put the result into the stack top
           add_string_to_file(file_ptr, "mov qword [rbp - ");
           fprintf(file_ptr, "%d", stack_size);
@@ -803,14 +1546,13 @@ static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion,
           break;
 
         case unary_operation_deref_type:
-          // generate the expression
-          stack_size += PTR_sz;
-          gen_NASM_expresion(file_ptr, expresion.expresion_value.expresion_unary_operation_value->expresion, stack_size, vars);
+          // generate the pointer in the stack top
+          gen_NASM_expresion(file_ptr, context, get_unary_operation(expresion)->expresion, stack_size, vars);
           // dereference the pointer
           add_string_to_file(file_ptr, "mov rax, qword [rbp - ");
-          fprintf(file_ptr, "%d", stack_size-PTR_sz);
+          fprintf(file_ptr, "%d", stack_size);
           add_string_to_file(file_ptr, "]\n");
-          add_string_to_file(file_ptr, "mov rax, qword [rax]\n");
+          gen_NASM_integer_load(file_ptr, get_NASM_integer_size(NASM_get_type_of_expresion(expresion, vars)), "rax", 0);
           // put the result into the stack top
           add_string_to_file(file_ptr, "mov qword [rbp - ");
           fprintf(file_ptr, "%d", stack_size);
@@ -820,11 +1562,21 @@ static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion,
       break;
 
   case expresion_array_type:;
-    Node_Array array = *expresion.expresion_value.expresion_array_value;
-    int single_element_size = get_size_of_type(NASM_get_type_of_expresion(array.elements[0], vars));
+    Node_Array array = expresion.expresion_value.expresion_array_value;
+    // the constant arrays are copied at once from their data
+    if (is_constant_array_literal(expresion) && flatten_constant_array(expresion, NULL) >= MIN_COPIED_CONSTANT_ELEMENTS) {
+      int numbers_count;
+      const int data_label = gen_NASM_constant_array(file_ptr, context, expresion, U64_sz, &numbers_count);
+      fprintf(file_ptr, "lea rsi, [.CONST%s%d]\n", context->label_prefix, data_label);
+      fprintf(file_ptr, "lea rdi, [rbp - %d]\n", stack_size + (numbers_count -1) * U64_sz);
+      fprintf(file_ptr, "mov rcx, %d\n", numbers_count);
+      add_string_to_file(file_ptr, "rep movsq\n");
+      break;
+    }
+    int single_element_size = get_NASM_size_of_type(NASM_get_type_of_expresion(get_array_elements(array)[0], vars));
     // generate every element in the array
     for (int i = 0; i < array.elements_count; i++) {
-      gen_NASM_expresion(file_ptr, array.elements[i], stack_size, vars);
+      gen_NASM_expresion(file_ptr, context, get_array_elements(array)[i], stack_size, vars);
       // progresively allocate space for the element in each iteration
       stack_size += single_element_size;
     }
@@ -832,30 +1584,41 @@ static void gen_NASM_expresion(FILE * file_ptr, const Node_Expresion expresion,
   }
 }
 
-// keep track of an unique identification for the labels so there arent collisions with other labels
-static int uuid = 0;
 
+static void gen_NASM_statement(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, const Node_Statement stmt, int * stack_size);
 
-static void gen_NASM_statement(FILE * out_file_ptr, ASM_Scopes_List * variables, const Node_Statement stmt, int * stack_size);
 
-
-static void gen_NASM_var_declaration(FILE * out_file_ptr, ASM_Scopes_List * variables, Node_Var_declaration var_declaration, int * stack_size) {
-  if (var_declaration.type.type_type == type_array_type) {
-    int array_size = get_size_of_type(var_declaration.type);
-    gen_NASM_expresion(out_file_ptr, var_declaration.value, *stack_size, *variables);
+static void gen_NASM_var_declaration(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, Node_Var_declaration var_declaration, int * stack_size) {
+  // the arrays that never change are used from their table without copying them
+  const int table_label = find_NASM_table(context->tables, var_declaration.var_name);
+  if (table_label != -1) {
+    NASM_append_var_to_var_list(variables, var_declaration.var_name, -1, var_declaration.type, table_label);
+  }
+  else if (var_declaration.type.type_type == type_array_type) {
+    int array_size = get_NASM_size_of_type(var_declaration.type);
+    if (is_NASM_packed_literal(var_declaration.type, var_declaration.value, *variables)) {
+      // the literal is built after the array, and then packed into it
+      gen_NASM_expresion(out_file_ptr, context, var_declaration.value, *stack_size + array_size, *variables);
+      fprintf(out_file_ptr, "lea rdi, [rbp - %d]\n", *stack_size);
+      gen_NASM_packed_array(out_file_ptr, var_declaration.type, *stack_size + array_size);
+    }
+    else {
+      gen_NASM_expresion(out_file_ptr, context, var_declaration.value, *stack_size, *variables);
+    }
     // add the location of the first elements to the list of vars
-    NASM_append_var_to_var_list(variables, var_declaration.var_name, *stack_size, var_declaration.type);
+    NASM_append_var_to_var_list(variables, var_declaration.var_name, *stack_size, var_declaration.type, -1);
     // allocate space for array in stack
     *stack_size += array_size;
   }
   else {
     int var_stack_place = *stack_size;
-    int expr_size = get_size_of_type(var_declaration.type);
-    gen_NASM_expresion(out_file_ptr, var_declaration.value, *stack_size, *variables);
+    int expr_size = get_NASM_size_of_type(var_declaration.type);
+    gen_NASM_expresion(out_file_ptr, context, var_declaration.value, *stack_size, *variables);
     // get the variable from the top of the stack into rax
     add_string_to_file(out_file_ptr, "mov rax, qword [rbp - ");
     fprintf(out_file_ptr, "%d", *stack_size);
     add_string_to_file(out_file_ptr, "]\n");
+    gen_NASM_integer_truncation(out_file_ptr, get_NASM_integer_size(var_declaration.type));
     // allocate space for variable in stack
     *stack_size += expr_size;
     // assign the value of the expresion from the stack
@@ -863,13 +1626,19 @@ static void gen_NASM_var_declaration(FILE * out_file_ptr, ASM_Scopes_List * vari
     fprintf(out_file_ptr, "%d", var_stack_place);
     add_string_to_file(out_file_ptr, "], rax"); // rax has the result of the expresion
     // add the variable to the list of vars
-    NASM_append_var_to_var_list(variables, var_declaration.var_name, var_stack_place, var_declaration.type);
+    NASM_append_var_to_var_list(variables, var_declaration.var_name, var_stack_place, var_declaration.type, -1);
   }
 }
 
-static void gen_NASM_exit_node(FILE * out_file_ptr, ASM_Scopes_List * variables, Node_Exit exit_node, int * stack_size) {
+static void gen_NASM_exit_node(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, Node_Exit exit_node, int * stack_size) {
   // NOTE: this only works for unix-like OSes
-  gen_NASM_expresion(out_file_ptr, exit_node.exit_code, *stack_size, *variables);
+  gen_NASM_expresion(out_file_ptr, context, exit_node.exit_code, *stack_size, *variables);
+  if (profile_output_file != NULL) {
+    // the profile is written before exiting, with the exit code in rbx
+    fprintf(out_file_ptr, "mov rbx, qword [rbp - %d]\n", *stack_size);
+    add_string_to_file(out_file_ptr, "jmp .PROFILE_EXIT\n");
+    return;
+  }
   add_string_to_file(out_file_ptr, "mov rax, 60\n");
   add_string_to_file(out_file_ptr, "mov rdi, qword [rbp - ");
   fprintf(out_file_ptr, "%d", *stack_size);
@@ -877,31 +1646,74 @@ static void gen_NASM_exit_node(FILE * out_file_ptr, ASM_Scopes_List * variables,
   add_string_to_file(out_file_ptr, "syscall\n");
 }
 
-static void gen_NASM_scope(FILE * out_file_ptr, ASM_Scopes_List * variables, Node_Scope scope, int * stack_size) {
+// generates the statements of a scope, its variables are removed after it
+static void gen_NASM_scope(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, Node_Scope scope, int * stack_size) {
   ASM_Scopes_List temp_scopes = NASM_copy_scopes_list(*variables); // FIX: create new scope instead of copying all the vars
   //NASM_create_scope(&temp_scopes);
   int temp_stack_size = *stack_size;
+  const Node_Statement * outer_statements = context->scope_statements;
+  const int outer_index = context->statement_index;
+  context->scope_statements = get_scope_statements(scope);
   for (int i = 0; i < scope.statements_count; i++) {
-    gen_NASM_statement(out_file_ptr, &temp_scopes, scope.statements_node[i], &temp_stack_size);
+    context->statement_index = i;
+    gen_NASM_statement(out_file_ptr, context, &temp_scopes, get_scope_statements(scope)[i], &temp_stack_size);
   }
+  context->scope_statements = outer_statements;
+  context->statement_index = outer_index;
   NASM_free_scopes_list(temp_scopes);
 }
 
-static void gen_NASM_var_assignment(FILE * out_file_ptr, ASM_Scopes_List * variables, Node_Var_assignment var_assignment, int * stack_size) {
-  gen_NASM_expresion(out_file_ptr, var_assignment.value, *stack_size, *variables);
+static void gen_NASM_var_assignment(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, Node_Var_assignment var_assignment, int * stack_size) {
+  const Node_Type var_type = NASM_get_type_of_variable(var_assignment.var_name, *variables);
+  if (var_type.type_type == type_array_type) {
+    const int var_stack_place = find_var_stack_place(*variables, var_assignment.var_name);
+    const int qwords_count = get_NASM_size_of_type(var_type) / U64_sz;
+    // the elements go downwards, so the copies start from the last one
+    const int last_element_offset = (qwords_count -1) * U64_sz;
+    if (is_constant_array_literal(var_assignment.value) && qwords_count >= MIN_COPIED_CONSTANT_ELEMENTS) {
+      // copy the constant array from its data directly into the variable
+      int numbers_count;
+      const int data_label = gen_NASM_constant_array(out_file_ptr, context, var_assignment.value, get_NASM_size_of_array_integers(var_type), &numbers_count);
+      fprintf(out_file_ptr, "lea rsi, [.CONST%s%d]\n", context->label_prefix, data_label);
+    }
+    else if (is_NASM_packed_literal(var_type, var_assignment.value, *variables)) {
+      // the elements can use the variable, so they are packed into it after building all of them
+      gen_NASM_expresion(out_file_ptr, context, var_assignment.value, *stack_size, *variables);
+      fprintf(out_file_ptr, "lea rdi, [rbp - %d]\n", var_stack_place);
+      gen_NASM_packed_array(out_file_ptr, var_type, *stack_size);
+      return;
+    }
+    else {
+      gen_NASM_expresion(out_file_ptr, context, var_assignment.value, *stack_size, *variables);
+      if (qwords_count < MIN_COPIED_CONSTANT_ELEMENTS) {
+        for (int i = 0; i < qwords_count * U64_sz; i += U64_sz) {
+          fprintf(out_file_ptr, "mov rax, qword [rbp - %d]\n", *stack_size + i);
+          fprintf(out_file_ptr, "mov qword [rbp - %d], rax\n", var_stack_place + i);
+        }
+        return;
+      }
+      fprintf(out_file_ptr, "lea rsi, [rbp - %d]\n", *stack_size + last_element_offset);
+    }
+    fprintf(out_file_ptr, "lea rdi, [rbp - %d]\n", var_stack_place + last_element_offset);
+    fprintf(out_file_ptr, "mov rcx, %d\n", qwords_count);
+    add_string_to_file(out_file_ptr, "rep movsq\n");
+    return;
+  }
+  gen_NASM_expresion(out_file_ptr, context, var_assignment.value, *stack_size, *variables);
   // get the variable from the top of the stack into rax
   add_string_to_file(out_file_ptr, "mov rax, qword [rbp - ");
   fprintf(out_file_ptr, "%d", *stack_size);
   add_string_to_file(out_file_ptr, "]\n");
+  gen_NASM_integer_truncation(out_file_ptr, get_NASM_integer_size(var_type));
   // assign the value of the expresion from the stack
   add_string_to_file(out_file_ptr, "mov qword [rbp - ");
   fprintf(out_file_ptr, "%d", find_var_stack_place(*variables, var_assignment.var_name));
   add_string_to_file(out_file_ptr, "], rax"); // rax has the result of the expresion
 }
 
-static void gen_NASM_print(FILE * out_file_ptr, ASM_Scopes_List * variables, Node_Print print_node, int * stack_size) {
+static void gen_NASM_print(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, Node_Print print_node, int * stack_size) {
   // NOTE: this only works for unix-like OSes
-  gen_NASM_expresion(out_file_ptr, print_node.chr, *stack_size, *variables);
+  gen_NASM_expresion(out_file_ptr, context, print_node.chr, *stack_size, *variables);
   add_string_to_file(out_file_ptr, "lea rsi, [rbp - ");
   fprintf(out_file_ptr, "%d", *stack_size);
   add_string_to_file(out_file_ptr, "]\n");
@@ -911,151 +1723,836 @@ static void gen_NASM_print(FILE * out_file_ptr, ASM_Scopes_List * variables, Nod
   add_string_to_file(out_file_ptr, "syscall\n");
 }
 
-static void gen_NASM_if_node(FILE * out_file_ptr, ASM_Scopes_List * variables, Node_If if_node, int * stack_size) {
+/* profiling the code */
+
+// adds 1 to the counter of the profile, the counters are in the bss
+static void gen_NASM_profile_count(FILE * out_file_ptr, const int counter) {
+  fprintf(out_file_ptr, "add qword [.PROFILE_COUNTERS + %d], 1\n", 8 * counter);
+}
+
+// generates a block of the if or the while of the condition, that counts its runs with --profile-generate
+static void gen_NASM_counted_scope(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, const Node_Expresion condition,
+                                   const Node_Scope scope, int * stack_size) {
+  if (profile_output_file != NULL) {
+    gen_NASM_profile_count(out_file_ptr, find_profile_counter(context->profile_points, condition) + 1);
+  }
+  gen_NASM_scope(out_file_ptr, context, variables, scope, stack_size);
+}
+
+// a block that runs less than once every this many runs of its if is moved out of the way of the code
+#define COLD_BLOCK_RATIO 8
+
+// moves the block of the if without else to the cold code, the if jumps there and it jumps back after the if
+static void gen_NASM_cold_block(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, const Node_If if_node,
+                                int * stack_size, const int if_uid) {
+  char * buffer;
+  size_t size;
+  FILE * stream = open_memstream(&buffer, &size);
+  if (stream == NULL) {
+    implementation_error("can not create a stream for the cold code");
+  }
+  fprintf(stream, ".IFC%s%d:\n", context->label_prefix, if_uid); // IFC is for "if cold"
+  gen_NASM_counted_scope(stream, context, variables, if_node.condition, if_node.scope, stack_size);
+  fprintf(stream, "jmp .IF%s%d\n", context->label_prefix, if_uid);
+  fclose(stream);
+  // the cold blocks inside this one are already in the cold code, before it
+  context->cold_code = srealloc(context->cold_code, context->cold_code_size + size);
+  memcpy(context->cold_code + context->cold_code_size, buffer, size);
+  context->cold_code_size += size;
+  free(buffer);
+
+  fprintf(out_file_ptr, "jnz .IFC%s%d\n", context->label_prefix, if_uid);
+  fprintf(out_file_ptr, ".IF%s%d:\n", context->label_prefix, if_uid);
+}
+
+static void gen_NASM_if_node(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, Node_If if_node, int * stack_size) {
+  if (profile_output_file != NULL) {
+    gen_NASM_profile_count(out_file_ptr, find_profile_counter(context->profile_points, if_node.condition));
+  }
   // generate the condition
   Node_Expresion condition = if_node.condition;
-  gen_NASM_expresion(out_file_ptr, condition, *stack_size, *variables);
+  gen_NASM_expresion(out_file_ptr, context, condition, *stack_size, *variables);
 
   // if the condition is not true skip the if body
   add_string_to_file(out_file_ptr, "mov rax, qword [rbp - ");
   fprintf(out_file_ptr, "%d", *stack_size);
   add_string_to_file(out_file_ptr, "]\n");
   add_string_to_file(out_file_ptr, "test rax, rax\n");
-  int if_uid = uuid; // save the uid in case it gets modified in the scope
-  uuid++;
+  int if_uid = context->uuid; // save the uid in case it gets modified in the scope
+  context->uuid++;
+
+  // with a profile the path the if usually takes goes straight after the condition
+  Profile_counts counts;
+  if (find_profile_counts(used_profile, condition, &counts)) {
+    const uint64_t else_runs = counts.runs - counts.block_runs;
+    if (if_node.has_else_block && else_runs > counts.block_runs) {
+      // the `else` block goes first and the `if` block after it
+      fprintf(out_file_ptr, "jnz .IF%s%d\n", context->label_prefix, if_uid);
+      gen_NASM_scope(out_file_ptr, context, variables, if_node.else_block, stack_size);
+      fprintf(out_file_ptr, "jmp .EL%s%d\n", context->label_prefix, if_uid);
+      fprintf(out_file_ptr, ".IF%s%d:\n", context->label_prefix, if_uid);
+      gen_NASM_counted_scope(out_file_ptr, context, variables, condition, if_node.scope, stack_size);
+      fprintf(out_file_ptr, ".EL%s%d:\n", context->label_prefix, if_uid);
+      return;
+    }
+    if (!if_node.has_else_block && counts.block_runs * COLD_BLOCK_RATIO < counts.runs) {
+      gen_NASM_cold_block(out_file_ptr, context, variables, if_node, stack_size, if_uid);
+      return;
+    }
+  }
   // if the condition is not met skip the `if` block
-  fprintf(out_file_ptr, "jz .IF%d\n", if_uid);
+  fprintf(out_file_ptr, "jz .IF%s%d\n", context->label_prefix, if_uid);
 
   // generate the `if` scope
-  ASM_Scopes_List temp_scopes = NASM_copy_scopes_list(*variables);
-  //NASM_create_scope(&temp_scopes);
-  int tmp_stack_sz = *stack_size;
-  for (int i = 0; i < if_node.scope.statements_count; i++) {
-    gen_NASM_statement(out_file_ptr, &temp_scopes, if_node.scope.statements_node[i], &tmp_stack_sz);
-  }
-  NASM_free_scopes_list(temp_scopes);
+  gen_NASM_counted_scope(out_file_ptr, context, variables, condition, if_node.scope, stack_size);
 
   if (if_node.has_else_block) {
     // if the `if` block is executed skip the `else` block
-    fprintf(out_file_ptr, "jmp .EL%d\n", if_uid);
+    fprintf(out_file_ptr, "jmp .EL%s%d\n", context->label_prefix, if_uid);
   }
   // generate the `if` label
-  fprintf(out_file_ptr, ".IF%d:\n", if_uid);
+  fprintf(out_file_ptr, ".IF%s%d:\n", context->label_prefix, if_uid);
   if (if_node.has_else_block) {
     // generate `else` block code
-    ASM_Scopes_List temp_scopes = NASM_copy_scopes_list(*variables);
-    //NASM_create_scope(&temp_scopes);
-    int tmp_stack_sz = *stack_size;
-    for (int i = 0; i < if_node.else_block.statements_count; i++) {
-      gen_NASM_statement(out_file_ptr, &temp_scopes, if_node.else_block.statements_node[i], &tmp_stack_sz);
+    gen_NASM_scope(out_file_ptr, context, variables, if_node.else_block, stack_size);
+    fprintf(out_file_ptr, ".EL%s%d:\n", context->label_prefix, if_uid); // generate the `else` label
+  }
+}
+
+/* vectorizing the loops */
+
+// the loops that add up elements of arrays run many iterations at once with vector instructions:
+//   while i < n { sum = sum + a[i] - b[i] + ...; i = i + 1; }
+// the arrays have u64 elements and are indexed by the counter, and only the sum and the counter change,
+// so the iterations do not depend on each other except through the sum, which is added in each lane
+// the vectorized loop goes before the normal one, which runs the iterations that are left
+
+#define MAX_VECTOR_TERMS 16
+
+// an array that is added or subtracted in every iteration
+typedef struct Vector_term {
+  Token array;
+  bool is_subtracted;
+} Vector_term;
+
+typedef struct Vector_loop {
+  Token counter;
+  Token sum;
+  // a number or a variable
+  Node_Expresion limit;
+  Vector_term terms[MAX_VECTOR_TERMS];
+  int terms_count;
+  // the length of the shortest array, the vectorized loop never reads past it
+  int min_length;
+} Vector_loop;
+
+static bool is_u64_variable(const Node_Expresion expresion, const ASM_Scopes_List vars) {
+  if (expresion.expresion_type != expresion_identifier_type) {
+    return false;
+  }
+  const Node_Type type = NASM_get_type_of_variable(expresion.expresion_value.expresion_identifier_value, vars);
+  return type.type_type == type_primitive_type && get_size_of_type(type) == U64_sz;
+}
+
+static bool is_number_one(const Node_Expresion expresion) {
+  return expresion.expresion_type == expresion_number_type && expresion.expresion_value.expresion_number_value.value == 1;
+}
+
+// returns true if the statement is `counter = counter + 1;` or `counter = 1 + counter;`
+static bool is_counter_increment(const Node_Statement stmt, const Token counter) {
+  if (stmt.statement_type != var_assignment_type) {
+    return false;
+  }
+  const Node_Var_assignment increment = stmt.statement_value.var_assignment;
+  if (!compare_str_of_tokens(increment.var_name, counter) || increment.value.expresion_type != expresion_binary_operation_type
+      || get_binary_operation(increment.value)->operation_type != binary_operation_sum_type) {
+    return false;
+  }
+  const Node_Binary_Operation addition = *get_binary_operation(increment.value);
+  const Node_Expresion other_side = is_number_one(addition.right_side) ? addition.left_side : addition.right_side;
+  if (!is_number_one(addition.left_side) && !is_number_one(addition.right_side)) {
+    return false;
+  }
+  return other_side.expresion_type == expresion_identifier_type && compare_str_of_tokens(other_side.expresion_value.expresion_identifier_value, counter);
+}
+
+// splits the sum of the loop into the sum itself and the arrays, returns false if it has other terms
+static bool find_vector_terms(const Node_Expresion expresion, const bool is_subtracted, const ASM_Scopes_List vars, Vector_loop * loop, int * sum_count) {
+  if (expresion.expresion_type == expresion_identifier_type && compare_str_of_tokens(expresion.expresion_value.expresion_identifier_value, loop->sum)) {
+    (*sum_count)++;
+    return !is_subtracted;
+  }
+  if (expresion.expresion_type != expresion_binary_operation_type) {
+    return false;
+  }
+  const Node_Binary_Operation operation = *get_binary_operation(expresion);
+  if (operation.operation_type == binary_operation_sum_type || operation.operation_type == binary_operation_sub_type) {
+    const bool is_right_subtracted = operation.operation_type == binary_operation_sub_type ? !is_subtracted : is_subtracted;
+    return find_vector_terms(operation.left_side, is_subtracted, vars, loop, sum_count)
+        && find_vector_terms(operation.right_side, is_right_subtracted, vars, loop, sum_count);
+  }
+  // an array of u64 indexed by the counter
+  if (operation.operation_type != binary_operation_access_type || operation.left_side.expresion_type != expresion_identifier_type
+      || operation.right_side.expresion_type != expresion_identifier_type
+      || !compare_str_of_tokens(operation.right_side.expresion_value.expresion_identifier_value, loop->counter)
+      || loop->terms_count == MAX_VECTOR_TERMS) {
+    return false;
+  }
+  const Token array = operation.left_side.expresion_value.expresion_identifier_value;
+  const Node_Type array_type = NASM_get_type_of_variable(array, vars);
+  if (array_type.type_type != type_array_type || get_type(get_array_type(array_type)->primitive_type)->type_type != type_primitive_type
+      || get_size_of_type(*get_type(get_array_type(array_type)->primitive_type)) != U64_sz) {
+    return false;
+  }
+  const int length = (int) get_array_type(array_type)->elements_count.value;
+  if (loop->terms_count == 0 || length < loop->min_length) {
+    loop->min_length = length;
+  }
+  loop->terms[loop->terms_count++] = (Vector_term) { .array = array, .is_subtracted = is_subtracted };
+  return true;
+}
+
+// returns true if the loop can be vectorized, and its parts in `loop`
+static bool find_vector_loop(const Node_While while_node, const ASM_Scopes_List vars, Vector_loop * loop) {
+  // the condition is `counter < limit`
+  const Node_Expresion condition = while_node.condition;
+  if (condition.expresion_type != expresion_binary_operation_type || get_binary_operation(condition)->operation_type != binary_operation_les_type) {
+    return false;
+  }
+  const Node_Expresion counter = get_binary_operation(condition)->left_side;
+  loop->limit = get_binary_operation(condition)->right_side;
+  const bool is_number_limit = loop->limit.expresion_type == expresion_number_type;
+  if (!is_u64_variable(counter, vars) || (!is_number_limit && !is_u64_variable(loop->limit, vars))) {
+    return false;
+  }
+  loop->counter = counter.expresion_value.expresion_identifier_value;
+  // the body is `sum = ...;` and then `counter = counter + 1;`
+  if (while_node.scope.statements_count != 2) {
+    return false;
+  }
+  const Node_Statement sum_statement = get_scope_statements(while_node.scope)[0];
+  const Node_Statement counter_statement = get_scope_statements(while_node.scope)[1];
+  if (sum_statement.statement_type != var_assignment_type || !is_counter_increment(counter_statement, loop->counter)) {
+    return false;
+  }
+  loop->sum = sum_statement.statement_value.var_assignment.var_name;
+  const Node_Expresion sum = { .expresion_type = expresion_identifier_type, .expresion_value.expresion_identifier_value = loop->sum };
+  if (!is_u64_variable(sum, vars) || compare_str_of_tokens(loop->sum, loop->counter)
+      || (loop->limit.expresion_type == expresion_identifier_type && compare_str_of_tokens(loop->limit.expresion_value.expresion_identifier_value, loop->sum))
+      || (loop->limit.expresion_type == expresion_identifier_type && compare_str_of_tokens(loop->limit.expresion_value.expresion_identifier_value, loop->counter))) {
+    return false;
+  }
+  // the sum appears once, and at least an array is added
+  loop->terms_count = 0;
+  loop->min_length = 0;
+  int sum_count = 0;
+  return find_vector_terms(sum_statement.statement_value.var_assignment.value, false, vars, loop, &sum_count)
+      && sum_count == 1 && loop->terms_count > 0;
+}
+
+// generates the vectorized loop, it leaves the sum and the counter for the normal loop that goes after it
+// the elements of the arrays go downwards in the stack, so the first element of a vector is the last one in memory
+static void gen_NASM_vector_loop(FILE * out_file_ptr, const NASM_Context * context, const Vector_loop loop, const ASM_Scopes_List vars, const int stack_size,
+                                 const int while_uid) {
+  const bool is_avx = NASM_vector_extension == vector_extension_avx2;
+  const int lanes = is_avx ? 4 : 2;
+  const char * sum_register = is_avx ? "ymm0" : "xmm0";
+  const char * element_register = is_avx ? "ymm1" : "xmm1";
+  fprintf(out_file_ptr, "; the loop runs %d iterations at once while it can, the next loop runs the rest\n", lanes);
+  // rcx is the counter, rdx the limit and rsi the offset of the elements in the arrays
+  fprintf(out_file_ptr, "mov rcx, qword [rbp - %d]\n", find_var_stack_place(vars, loop.counter));
+  if (loop.limit.expresion_type == expresion_number_type) {
+    add_string_to_file(out_file_ptr, "mov rdx, ");
+    add_number_to_file(out_file_ptr, loop.limit.expresion_value.expresion_number_value);
+    add_string_to_file(out_file_ptr, "\n");
+  }
+  else {
+    fprintf(out_file_ptr, "mov rdx, qword [rbp - %d]\n", find_var_stack_place(vars, loop.limit.expresion_value.expresion_identifier_value));
+  }
+  // the vectors never go past the shortest array
+  fprintf(out_file_ptr, "mov rax, %d\n", loop.min_length);
+  add_string_to_file(out_file_ptr, "cmp rdx, rax\n");
+  fprintf(out_file_ptr, "jbe .VLL%s%d\n", context->label_prefix, while_uid); // VLL is for "vector loop limit"
+  add_string_to_file(out_file_ptr, "mov rdx, rax\n");
+  fprintf(out_file_ptr, ".VLL%s%d:\n", context->label_prefix, while_uid);
+  fprintf(out_file_ptr, "lea rax, [rcx * %d]\n", U64_sz);
+  add_string_to_file(out_file_ptr, "xor rsi, rsi\n");
+  add_string_to_file(out_file_ptr, "sub rsi, rax\n");
+  if (is_avx) {
+    fprintf(out_file_ptr, "vpxor %s, %s, %s\n", sum_register, sum_register, sum_register);
+  }
+  else {
+    fprintf(out_file_ptr, "pxor %s, %s\n", sum_register, sum_register);
+  }
+  fprintf(out_file_ptr, ".VLB%s%d:\n", context->label_prefix, while_uid); // VLB is for "vector loop beginning"
+  // stop when less than a vector of iterations is left
+  add_string_to_file(out_file_ptr, "cmp rcx, rdx\n");
+  fprintf(out_file_ptr, "jae .VLE%s%d\n", context->label_prefix, while_uid); // VLE is for "vector loop end"
+  add_string_to_file(out_file_ptr, "mov rax, rdx\n");
+  add_string_to_file(out_file_ptr, "sub rax, rcx\n");
+  fprintf(out_file_ptr, "cmp rax, %d\n", lanes);
+  fprintf(out_file_ptr, "jb .VLE%s%d\n", context->label_prefix, while_uid);
+  for (int i = 0; i < loop.terms_count; i++) {
+    const char * operation = loop.terms[i].is_subtracted ? "psubq" : "paddq";
+    // the arrays in the data are addressed from rdi
+    const char * base_register = "rbp";
+    int vector_place = (lanes - 1) * U64_sz;
+    if (find_var_data_label(vars, loop.terms[i].array) == -1) {
+      vector_place += find_var_stack_place(vars, loop.terms[i].array);
+    }
+    else {
+      gen_NASM_variable_address(out_file_ptr, "rdi", vars, loop.terms[i].array);
+      base_register = "rdi";
+    }
+    if (is_avx) {
+      fprintf(out_file_ptr, "v%s %s, %s, [%s + rsi - %d]\n", operation, sum_register, sum_register, base_register, vector_place);
+    }
+    else {
+      // the SSE operations need aligned memory, the elements are loaded first
+      fprintf(out_file_ptr, "movdqu %s, [%s + rsi - %d]\n", element_register, base_register, vector_place);
+      fprintf(out_file_ptr, "%s %s, %s\n", operation, sum_register, element_register);
     }
-    NASM_free_scopes_list(temp_scopes);
-    fprintf(out_file_ptr, ".EL%d:\n", if_uid); // generate the `else` label
   }
+  fprintf(out_file_ptr, "add rcx, %d\n", lanes);
+  fprintf(out_file_ptr, "sub rsi, %d\n", lanes * U64_sz);
+  fprintf(out_file_ptr, "jmp .VLB%s%d\n", context->label_prefix, while_uid);
+  fprintf(out_file_ptr, ".VLE%s%d:\n", context->label_prefix, while_uid);
+  // add the lanes to the sum through the top of the stack
+  fprintf(out_file_ptr, "%s [rbp - %d], %s\n", is_avx ? "vmovdqu" : "movdqu", stack_size + (lanes - 1) * U64_sz, sum_register);
+  if (is_avx) {
+    // with the upper halves of the registers in use the SSE instructions are slower, even in other programs
+    add_string_to_file(out_file_ptr, "vzeroupper\n");
+  }
+  fprintf(out_file_ptr, "mov rax, qword [rbp - %d]\n", stack_size);
+  for (int i = 1; i < lanes; i++) {
+    fprintf(out_file_ptr, "add rax, qword [rbp - %d]\n", stack_size + i * U64_sz);
+  }
+  fprintf(out_file_ptr, "add qword [rbp - %d], rax\n", find_var_stack_place(vars, loop.sum));
+  fprintf(out_file_ptr, "mov qword [rbp - %d], rcx\n", find_var_stack_place(vars, loop.counter));
+}
+
+/* unrolling the loops */
+
+// the innermost loops with a counter that goes up by one to a bound that does not change in the loop:
+//   while i < n { ...; i = i + 1; }
+// check the condition once for many copies of their body, and then the normal loop runs the iterations that are left
+// when the loop begins with a known number of few iterations the copies replace it completely
+// the copies are limited by the size of their code, so the loops with large bodies get less of them
+
+// the number of copies of the body of the loops, 1 does not unroll them
+int NASM_unroll_factor = 4;
+// print a note for every unrolled loop
+bool is_reporting_unrolls = false;
+
+#define MAX_UNROLL_FACTOR 64
+// the max size in bytes of the NASM code of the copies of a body
+#define MAX_UNROLLED_CODE_SIZE 8192
+
+typedef struct Unroll_loop {
+  Token counter;
+  // a number or a variable
+  Node_Expresion limit;
+  // the number of iterations when it is known before the loop, -1 otherwise
+  long long iterations_count;
+} Unroll_loop;
+
+// the value of a number that fits in 63 bits, -1 for the rest
+static long long get_small_number_value(const Node_Expresion expresion) {
+  if (expresion.expresion_type != expresion_number_type || expresion.expresion_value.expresion_number_value.value > INT64_MAX) {
+    return -1;
+  }
+  return (long long) expresion.expresion_value.expresion_number_value.value;
+}
+
+// returns true if there is a loop in the scope or in the scopes inside it
+static bool has_scope_loops(const Node_Scope scope) {
+  for (int i = 0; i < scope.statements_count; i++) {
+    const Node_Statement stmt = get_scope_statements(scope)[i];
+    if (stmt.statement_type == while_type
+        || (stmt.statement_type == scope_type && has_scope_loops(stmt.statement_value.scope))
+        || (stmt.statement_type == if_type && has_scope_loops(stmt.statement_value.if_node.scope))
+        || (stmt.statement_type == if_type && stmt.statement_value.if_node.has_else_block && has_scope_loops(stmt.statement_value.if_node.else_block))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// returns true if the loop can be unrolled, and its parts in `loop`
+// the statements before it in its scope give the first value of the counter, they can be NULL
+static bool find_unroll_loop(const Node_While while_node, const ASM_Scopes_List vars, const Node_Statement * previous_statements,
+                             const int previous_statements_count, Unroll_loop * loop) {
+  // the condition is `counter < limit`
+  const Node_Expresion condition = while_node.condition;
+  if (condition.expresion_type != expresion_binary_operation_type || get_binary_operation(condition)->operation_type != binary_operation_les_type) {
+    return false;
+  }
+  const Node_Expresion counter = get_binary_operation(condition)->left_side;
+  loop->limit = get_binary_operation(condition)->right_side;
+  const long long limit_value = get_small_number_value(loop->limit);
+  if (!is_u64_variable(counter, vars) || (limit_value == -1 && !is_u64_variable(loop->limit, vars))) {
+    return false;
+  }
+  loop->counter = counter.expresion_value.expresion_identifier_value;
+  // the body ends with `counter = counter + 1;`, and nothing else changes the counter or the limit
+  const int statements_count = while_node.scope.statements_count;
+  if (statements_count == 0 || has_scope_loops(while_node.scope) || !is_counter_increment(get_scope_statements(while_node.scope)[statements_count -1], loop->counter)
+      || is_variable_written(get_scope_statements(while_node.scope), statements_count -1, loop->counter)) {
+    return false;
+  }
+  if (loop->limit.expresion_type == expresion_identifier_type
+      && (compare_str_of_tokens(loop->limit.expresion_value.expresion_identifier_value, loop->counter)
+          || is_variable_written(get_scope_statements(while_node.scope), statements_count, loop->limit.expresion_value.expresion_identifier_value))) {
+    return false;
+  }
+  // the number of iterations is known when the last statement before the loop that changes the counter sets it to a number
+  loop->iterations_count = -1;
+  long long first_value = -1;
+  for (int i = previous_statements_count -1; previous_statements != NULL && i >= 0; i--) {
+    const Node_Statement stmt = previous_statements[i];
+    if (stmt.statement_type == var_declaration_type && compare_str_of_tokens(stmt.statement_value.var_declaration.var_name, loop->counter)) {
+      first_value = get_small_number_value(stmt.statement_value.var_declaration.value);
+      break;
+    }
+    if (is_variable_written(&stmt, 1, loop->counter)) {
+      if (stmt.statement_type == var_assignment_type && compare_str_of_tokens(stmt.statement_value.var_assignment.var_name, loop->counter)) {
+        first_value = get_small_number_value(stmt.statement_value.var_assignment.value);
+      }
+      break;
+    }
+  }
+  if (first_value != -1 && limit_value != -1) {
+    loop->iterations_count = first_value < limit_value ? limit_value - first_value : 0;
+  }
+  return true;
+}
+
+// prints the note of an unrolled loop in the place of its counter
+static void report_unrolled_loop(const NASM_Context * context, const Unroll_loop loop, const char * format, const long long count) {
+  if (!is_reporting_unrolls || context->is_in_repeated_copy) {
+    return;
+  }
+  flockfile(stderr);
+  const Token_place place = get_token_place(loop.counter);
+  fprintf(stderr, "Line:%d, column:%d.  Note: the loop of `%.*s` ", place.line_number, place.column_number,
+          loop.counter.length, loop.counter.beginning);
+  fprintf(stderr, format, count);
+  fputc('\n', stderr);
+  funlockfile(stderr);
+}
+
+// returns the size of the NASM code of the scope, without generating it
+static long long measure_NASM_scope(NASM_Context * context, ASM_Scopes_List * variables, const Node_Scope scope, int * stack_size) {
+  char * buffer;
+  size_t size;
+  FILE * stream = open_memstream(&buffer, &size);
+  if (stream == NULL) {
+    implementation_error("can not create a stream for measuring the code of a loop");
+  }
+  const bool was_in_repeated_copy = context->is_in_repeated_copy;
+  // the cold blocks of the scope are not kept either
+  const size_t cold_code_size = context->cold_code_size;
+  context->is_in_repeated_copy = true;
+  gen_NASM_scope(stream, context, variables, scope, stack_size);
+  context->is_in_repeated_copy = was_in_repeated_copy;
+  context->cold_code_size = cold_code_size;
+  fclose(stream);
+  free(buffer);
+  return size;
+}
+
+// generates the body of the loop many times one after the other
+static void gen_NASM_scope_copies(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, const Node_While while_node,
+                                  int * stack_size, const long long copies_count) {
+  const bool was_in_repeated_copy = context->is_in_repeated_copy;
+  for (long long i = 0; i < copies_count; i++) {
+    gen_NASM_counted_scope(out_file_ptr, context, variables, while_node.condition, while_node.scope, stack_size);
+    context->is_in_repeated_copy = true;
+  }
+  context->is_in_repeated_copy = was_in_repeated_copy;
+}
+
+// generates the copies of the body that run while there are enough iterations left, the normal loop runs the rest
+static void gen_NASM_unrolled_loop(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, const Node_While while_node,
+                                   const Unroll_loop loop, const int copies_count, int * stack_size, const int while_uid) {
+  fprintf(out_file_ptr, ".URB%s%d:\n", context->label_prefix, while_uid); // URB is for "unrolled beginning"
+  // rdx is the number of iterations left
+  fprintf(out_file_ptr, "mov rax, qword [rbp - %d]\n", find_var_stack_place(*variables, loop.counter));
+  if (loop.limit.expresion_type == expresion_number_type) {
+    add_string_to_file(out_file_ptr, "mov rdx, ");
+    add_number_to_file(out_file_ptr, loop.limit.expresion_value.expresion_number_value);
+    add_string_to_file(out_file_ptr, "\n");
+  }
+  else {
+    fprintf(out_file_ptr, "mov rdx, qword [rbp - %d]\n", find_var_stack_place(*variables, loop.limit.expresion_value.expresion_identifier_value));
+  }
+  add_string_to_file(out_file_ptr, "cmp rax, rdx\n");
+  fprintf(out_file_ptr, "jae .URE%s%d\n", context->label_prefix, while_uid); // URE is for "unrolled end"
+  add_string_to_file(out_file_ptr, "sub rdx, rax\n");
+  fprintf(out_file_ptr, "cmp rdx, %d\n", copies_count);
+  fprintf(out_file_ptr, "jb .URE%s%d\n", context->label_prefix, while_uid);
+  gen_NASM_scope_copies(out_file_ptr, context, variables, while_node, stack_size, copies_count);
+  fprintf(out_file_ptr, "jmp .URB%s%d\n", context->label_prefix, while_uid);
+  fprintf(out_file_ptr, ".URE%s%d:\n", context->label_prefix, while_uid);
+}
+
+// a loop whose body runs at least this fraction of the most run block of the profile is hot
+#define HOT_LOOP_RATIO 8
+
+// the copies of the body of an unrolled loop, with a profile the loops that usually run few iterations get less of them
+// and the hot loops get more, the loops that never run are not unrolled
+static int get_NASM_unroll_factor(const Node_While while_node) {
+  Profile_counts counts;
+  if (!find_profile_counts(used_profile, while_node.condition, &counts)) {
+    return NASM_unroll_factor;
+  }
+  if (counts.runs == 0) {
+    return 1;
+  }
+  const uint64_t average_iterations = counts.block_runs / counts.runs;
+  if (average_iterations < (uint64_t) NASM_unroll_factor) {
+    return average_iterations;
+  }
+  if (counts.block_runs * HOT_LOOP_RATIO >= used_profile->max_block_runs) {
+    return 2 * NASM_unroll_factor < MAX_UNROLL_FACTOR ? 2 * NASM_unroll_factor : MAX_UNROLL_FACTOR;
+  }
+  return NASM_unroll_factor;
 }
 
-static void gen_NASM_while_node(FILE * out_file_ptr, ASM_Scopes_List * variables, Node_While while_node, int * stack_size) {
-  int while_uid = uuid; // save the uid in case it gets modified in the scope
-  uuid++;
+static void gen_NASM_while_node(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, Node_While while_node, int * stack_size) {
+  int while_uid = context->uuid; // save the uid in case it gets modified in the scope
+  context->uuid++;
+  Vector_loop vector_loop;
+  Unroll_loop unroll_loop;
+  Profile_counts counts;
+  if (profile_output_file != NULL) {
+    gen_NASM_profile_count(out_file_ptr, find_profile_counter(context->profile_points, while_node.condition));
+  }
+  // the body of the normal loop after an unrolled one is a copy too
+  const bool was_in_repeated_copy = context->is_in_repeated_copy;
+  // the vectorized loops do not count their iterations, so they are not used for the profiles
+  if (NASM_vector_extension != vector_extension_none && profile_output_file == NULL && find_vector_loop(while_node, *variables, &vector_loop)) {
+    gen_NASM_vector_loop(out_file_ptr, context, vector_loop, *variables, *stack_size, while_uid);
+  }
+  else if (NASM_unroll_factor > 1 && !(find_profile_counts(used_profile, while_node.condition, &counts) && counts.runs == 0)
+           && find_unroll_loop(while_node, *variables, context->scope_statements, context->statement_index, &unroll_loop)) {
+    const long long iterations_count = unroll_loop.iterations_count;
+    const long long body_size = measure_NASM_scope(context, variables, while_node.scope, stack_size);
+    const long long max_copies_count = MAX_UNROLLED_CODE_SIZE / (body_size > 0 ? body_size : 1);
+    if (iterations_count != -1 && iterations_count <= max_copies_count) {
+      // the body is only repeated, the condition is always true in the copies and false after them
+      report_unrolled_loop(context, unroll_loop, "is completely unrolled, %lld iterations", iterations_count);
+      gen_NASM_scope_copies(out_file_ptr, context, variables, while_node, stack_size, iterations_count);
+      return;
+    }
+    const int unroll_factor = get_NASM_unroll_factor(while_node);
+    const int copies_count = max_copies_count < unroll_factor ? max_copies_count : unroll_factor;
+    if (copies_count > 1) {
+      report_unrolled_loop(context, unroll_loop, "is unrolled %lld times", copies_count);
+      gen_NASM_unrolled_loop(out_file_ptr, context, variables, while_node, unroll_loop, copies_count, stack_size, while_uid);
+      context->is_in_repeated_copy = true;
+    }
+  }
   // generate the label for repeating the loop
-  fprintf(out_file_ptr, ".WHB%d:\n", while_uid); // WHB is for "while beginning"
+  fprintf(out_file_ptr, ".WHB%s%d:\n", context->label_prefix, while_uid); // WHB is for "while beginning"
   // generate the condition
   Node_Expresion condition = while_node.condition;
-  gen_NASM_expresion(out_file_ptr, condition, *stack_size, *variables);
+  gen_NASM_expresion(out_file_ptr, context, condition, *stack_size, *variables);
 
   // if the condition is not true skip the while body
   add_string_to_file(out_file_ptr, "mov rax, qword [rbp - ");
   fprintf(out_file_ptr, "%d", *stack_size);
   add_string_to_file(out_file_ptr, "]\n");
   add_string_to_file(out_file_ptr, "test rax, rax\n");
-  fprintf(out_file_ptr, "jz .WHE%d\n", while_uid); // WHE is for "while end"
+  fprintf(out_file_ptr, "jz .WHE%s%d\n", context->label_prefix, while_uid); // WHE is for "while end"
 
   // generate the scope
-  ASM_Scopes_List temp_scopes = NASM_copy_scopes_list(*variables);
-  //NASM_create_scope(&temp_scopes);
-  int temp_stack_size = *stack_size;
-  for (int i = 0; i < while_node.scope.statements_count; i++) {
-    gen_NASM_statement(out_file_ptr, &temp_scopes, while_node.scope.statements_node[i], &temp_stack_size);
-  }
-  NASM_free_scopes_list(temp_scopes);
+  gen_NASM_counted_scope(out_file_ptr, context, variables, condition, while_node.scope, stack_size);
+  context->is_in_repeated_copy = was_in_repeated_copy;
 
-  fprintf(out_file_ptr, "jmp .WHB%d\n", while_uid);
-  fprintf(out_file_ptr, ".WHE%d:\n", while_uid); // generate the label for finnishing the while loop
+  fprintf(out_file_ptr, "jmp .WHB%s%d\n", context->label_prefix, while_uid);
+  fprintf(out_file_ptr, ".WHE%s%d:\n", context->label_prefix, while_uid); // generate the label for finnishing the while loop
 }
 
 
-static void gen_NASM_statement(FILE * out_file_ptr, ASM_Scopes_List * variables, const Node_Statement stmt, int * stack_size) {
+static void gen_NASM_statement(FILE * out_file_ptr, NASM_Context * context, ASM_Scopes_List * variables, const Node_Statement stmt, int * stack_size) {
   switch (stmt.statement_type) {
     case var_declaration_type:
       Node_Var_declaration var_declaration = stmt.statement_value.var_declaration;
-      gen_NASM_var_declaration(out_file_ptr, variables, var_declaration, stack_size);
+      gen_NASM_var_declaration(out_file_ptr, context, variables, var_declaration, stack_size);
       break;
 
     case exit_node_type:
       Node_Exit exit_node = stmt.statement_value.exit_node;
-      gen_NASM_exit_node(out_file_ptr, variables, exit_node, stack_size);
+      gen_NASM_exit_node(out_file_ptr, context, variables, exit_node, stack_size);
       break;
 
     case var_assignment_type:
       Node_Var_assignment var_assignment = stmt.statement_value.var_assignment;
-      gen_NASM_var_assignment(out_file_ptr, variables, var_assignment, stack_size);
+      gen_NASM_var_assignment(out_file_ptr, context, variables, var_assignment, stack_size);
       break;
 
     case scope_type:
       Node_Scope scope = stmt.statement_value.scope;
-      gen_NASM_scope(out_file_ptr, variables, scope, stack_size);
+      gen_NASM_scope(out_file_ptr, context, variables, scope, stack_size);
       break;
 
     case if_type:
       Node_If if_node = stmt.statement_value.if_node;
-      gen_NASM_if_node(out_file_ptr, variables, if_node, stack_size);
+      gen_NASM_if_node(out_file_ptr, context, variables, if_node, stack_size);
       break;
 
     case while_type:
       Node_While while_node = stmt.statement_value.while_node;
-      gen_NASM_while_node(out_file_ptr, variables, while_node, stack_size);
+      gen_NASM_while_node(out_file_ptr, context, variables, while_node, stack_size);
       break;
     
     case print_type:
       Node_Print print_node = stmt.statement_value.print;
-      gen_NASM_print(out_file_ptr, variables, print_node, stack_size);
+      gen_NASM_print(out_file_ptr, context, variables, print_node, stack_size);
       break;
   }
   add_string_to_file(out_file_ptr, "\n\n");
 }
 
-// it generates NASM code
-void gen_NASM_code(const Node_Program syntax_tree, const char * out_file_name) {
-  FILE * out_file_ptr = create_file(out_file_name);
+// the state of a generation of NASM code that receives the top level statements one by one
+typedef struct NASM_Generator {
+  FILE * out_file_ptr;
+  // this will hold all the variables from all the scopes
+  ASM_Scopes_List scopes;
+  NASM_Context context;
+  int stack_size;
+} NASM_Generator;
+
+// starts the generation of NASM code into the file
+NASM_Generator begin_NASM_code(FILE * out_file_ptr) {
   add_string_to_file(out_file_ptr, "bits 64\n"); // targeting 64 bits
   add_string_to_file(out_file_ptr, "default rel\n"); // make all the pointers `rip` based
   add_string_to_file(out_file_ptr, "global _start\n"); // needed for linking in ELF format
   add_string_to_file(out_file_ptr, "_start:\n");
   add_string_to_file(out_file_ptr, "push rbp\n"); // setting up the stack
   add_string_to_file(out_file_ptr, "mov rbp, rsp\n\n");
-  int stack_size = 0;
 
-  // this will hold all the variables from all the scopes
-  ASM_Scopes_List scopes;
-  scopes.scopes_count = 0;
-  scopes.variables = malloc(scopes.scopes_count * sizeof(ASM_Scopes_List));
-  NASM_create_scope(&scopes); // create first global scope
+  NASM_Generator generator = {
+    .out_file_ptr = out_file_ptr,
+    .scopes = { .scopes_count = 0, .variables = smalloc(0) },
+    .context = {
+      .uuid = 0, .label_prefix = "", .tables = { .tables_count = 0, .names = NULL },
+      .program = NULL, .scope_statements = NULL, .statement_index = 0, .is_in_repeated_copy = false,
+      .index_bounds = { .bounds_count = 0, .bounds = smalloc(0) }, .index_checks_count = 0, .removed_index_checks_count = 0,
+      .profile_points = { .points_count = 0, .points_capacity = 0, .places = NULL }, .cold_code = NULL, .cold_code_size = 0
+    },
+    .stack_size = 0
+  };
+  NASM_create_scope(&generator.scopes); // create first global scope
+  return generator;
+}
+
+void gen_NASM_top_statement(NASM_Generator * generator, const Node_Statement stmt) {
+  // without the whole program the statements are analyzed one by one
+  if (is_bounds_checking && generator->context.program == NULL) {
+    free_index_bounds(generator->context.index_bounds);
+    generator->context.index_bounds = analyze_index_bounds(&stmt, 1);
+  }
+  if (profile_output_file != NULL) {
+    add_profile_points(&generator->context.profile_points, &stmt, 1);
+  }
+  gen_NASM_statement(generator->out_file_ptr, &generator->context, &generator->scopes, stmt, &generator->stack_size);
+}
 
-  for (int i = 0; i < syntax_tree.statements_count; i++) {
-    Node_Statement node = syntax_tree.statements_node[i];
-    gen_NASM_statement(out_file_ptr, &scopes, node, &stack_size);
+// the linux flags of open() for writing the profile file: O_WRONLY | O_CREAT | O_TRUNC
+#define PROFILE_OPEN_FLAGS 0x241
+#define PROFILE_FILE_MODE 0644
+
+// writes the profile file and exits with the exit code in rbx, the program still exits if the file can not be written
+static void gen_NASM_profile_exit(FILE * file_ptr, const Profile_points points) {
+  add_string_to_file(file_ptr, ".PROFILE_EXIT:\n");
+  add_string_to_file(file_ptr, "mov rax, 2\n");
+  add_string_to_file(file_ptr, "lea rdi, [.PROFILE_PATH]\n");
+  fprintf(file_ptr, "mov rsi, %d\n", PROFILE_OPEN_FLAGS);
+  fprintf(file_ptr, "mov rdx, %d\n", PROFILE_FILE_MODE);
+  add_string_to_file(file_ptr, "syscall\n");
+  add_string_to_file(file_ptr, "test rax, rax\n");
+  add_string_to_file(file_ptr, "js .PROFILE_END\n");
+  // the file descriptor is in r12, the syscalls keep it
+  add_string_to_file(file_ptr, "mov r12, rax\n");
+  add_string_to_file(file_ptr, "mov rax, 1\n");
+  add_string_to_file(file_ptr, "mov rdi, r12\n");
+  add_string_to_file(file_ptr, "lea rsi, [.PROFILE_HEADER]\n");
+  fprintf(file_ptr, "mov rdx, %d\n", PROFILE_MAGIC_SIZE + 8 + 8 * points.points_count);
+  add_string_to_file(file_ptr, "syscall\n");
+  add_string_to_file(file_ptr, "mov rax, 1\n");
+  add_string_to_file(file_ptr, "mov rdi, r12\n");
+  add_string_to_file(file_ptr, "lea rsi, [.PROFILE_COUNTERS]\n");
+  fprintf(file_ptr, "mov rdx, %d\n", 8 * PROFILE_COUNTERS_PER_POINT * points.points_count);
+  add_string_to_file(file_ptr, "syscall\n");
+  add_string_to_file(file_ptr, "mov rax, 3\n");
+  add_string_to_file(file_ptr, "mov rdi, r12\n");
+  add_string_to_file(file_ptr, "syscall\n");
+  add_string_to_file(file_ptr, ".PROFILE_END:\n");
+  add_string_to_file(file_ptr, "mov rax, 60\n");
+  add_string_to_file(file_ptr, "mov rdi, rbx\n");
+  add_string_to_file(file_ptr, "syscall\n");
+}
+
+// the header and the places of the profile file, its path, and the counters in the bss
+static void gen_NASM_profile_data(FILE * file_ptr, const Profile_points points) {
+  add_string_to_file(file_ptr, "section .rodata\n");
+  add_string_to_file(file_ptr, ".PROFILE_HEADER:\n");
+  fprintf(file_ptr, "dq 0x%016llx ; %s\n", (unsigned long long) read_profile_number((const uint8_t *) PROFILE_MAGIC, PROFILE_MAGIC_SIZE), PROFILE_MAGIC);
+  fprintf(file_ptr, "dq %d\n", points.points_count);
+  for (int i = 0; i < points.points_count; i++) {
+    fprintf(file_ptr, "dd %u, %u\n", points.places[i].line_number, points.places[i].column_number);
+  }
+  add_string_to_file(file_ptr, ".PROFILE_PATH:\n");
+  add_string_to_file(file_ptr, "db ");
+  for (const char * c = profile_output_file; *c != '\0'; c++) {
+    fprintf(file_ptr, "%d, ", (unsigned char) *c);
   }
+  add_string_to_file(file_ptr, "0\n");
+  add_string_to_file(file_ptr, "section .bss\n");
+  add_string_to_file(file_ptr, ".PROFILE_COUNTERS:\n");
+  fprintf(file_ptr, "resq %d\n", PROFILE_COUNTERS_PER_POINT * points.points_count);
+  add_string_to_file(file_ptr, "section .text\n");
+}
 
-  NASM_free_scopes_list(scopes);
+void end_NASM_code(NASM_Generator * generator) {
+  NASM_free_scopes_list(generator->scopes);
+  free_index_bounds(generator->context.index_bounds);
+  sfree(generator->context.tables.names);
 
   // exit the program safely with a syscall
   // NOTE: OS dependent
-  add_string_to_file(out_file_ptr, "mov rax, 60\n");
-  add_string_to_file(out_file_ptr, "xor rdi, rdi\n");
-  add_string_to_file(out_file_ptr, "syscall\n");
+  if (profile_output_file != NULL) {
+    add_string_to_file(generator->out_file_ptr, "xor rbx, rbx\n");
+    gen_NASM_profile_exit(generator->out_file_ptr, generator->context.profile_points);
+  }
+  else {
+    add_string_to_file(generator->out_file_ptr, "mov rax, 60\n");
+    add_string_to_file(generator->out_file_ptr, "xor rdi, rdi\n");
+    add_string_to_file(generator->out_file_ptr, "syscall\n");
+  }
+  // the cold blocks are after the exit, so they only run when their ifs jump to them
+  fwrite(generator->context.cold_code, 1, generator->context.cold_code_size, generator->out_file_ptr);
+  sfree(generator->context.cold_code);
+
+  if (is_bounds_checking) {
+    // the failed index checks print the message in rsi, of the length in rdx, and exit with 1
+    add_string_to_file(generator->out_file_ptr, ".INDEX_ERROR:\n");
+    add_string_to_file(generator->out_file_ptr, "mov rdi, 1\n");
+    add_string_to_file(generator->out_file_ptr, "mov rax, 1\n");
+    add_string_to_file(generator->out_file_ptr, "syscall\n");
+    if (profile_output_file != NULL) {
+      add_string_to_file(generator->out_file_ptr, "mov rbx, 1\n");
+      add_string_to_file(generator->out_file_ptr, "jmp .PROFILE_EXIT\n");
+    }
+    else {
+      add_string_to_file(generator->out_file_ptr, "mov rax, 60\n");
+      add_string_to_file(generator->out_file_ptr, "mov rdi, 1\n");
+      add_string_to_file(generator->out_file_ptr, "syscall\n");
+    }
+    report_removed_index_checks(generator->context.index_checks_count, generator->context.removed_index_checks_count);
+  }
+  if (profile_output_file != NULL) {
+    gen_NASM_profile_data(generator->out_file_ptr, generator->context.profile_points);
+  }
+  free_profile_points(generator->context.profile_points);
+}
 
-  fclose(out_file_ptr);
+/* generating the chunks of the program */
+
+// the state of the generation at the beginning of a chunk of the program, see chunks.h
+typedef struct NASM_Chunk {
+  NASM_Context context;
+  ASM_Scopes_List scopes;
+  int stack_size;
+  int first_statement;
+  int end_statement;
+} NASM_Chunk;
+
+// lays out the chunks of the program, the variables declared before every chunk and their places in the stack
+// are known without generating the code, the statements inside the blocks do not change them
+static NASM_Chunk * lay_out_NASM_chunks(NASM_Generator * generator, const Code_chunks chunks) {
+  const Node_Program * program = generator->context.program;
+  NASM_Chunk * states = smalloc(chunks.chunks_count * sizeof(*states));
+  for (int i = 0; i < chunks.chunks_count; i++) {
+    NASM_Context context = generator->context;
+    context.uuid = 0;
+    // the labels of the first chunk have no prefix, like the ones of a program with a single chunk
+    if (i > 0) {
+      snprintf(context.label_prefix, sizeof(context.label_prefix), "%d_", i);
+    }
+    states[i] = (NASM_Chunk) {
+      .context = context,
+      .scopes = NASM_copy_scopes_list(generator->scopes),
+      .stack_size = generator->stack_size,
+      .first_statement = get_chunk_first_statement(chunks, i),
+      .end_statement = get_chunk_end_statement(chunks, i, program->statements_count)
+    };
+    for (int j = states[i].first_statement; j < states[i].end_statement; j++) {
+      if (program->statements_node[j].statement_type != var_declaration_type) {
+        continue;
+      }
+      const Node_Var_declaration var_declaration = program->statements_node[j].statement_value.var_declaration;
+      const int table_label = find_NASM_table(generator->context.tables, var_declaration.var_name);
+      if (table_label != -1) {
+        NASM_append_var_to_var_list(&generator->scopes, var_declaration.var_name, -1, var_declaration.type, table_label);
+      }
+      else {
+        NASM_append_var_to_var_list(&generator->scopes, var_declaration.var_name, generator->stack_size, var_declaration.type, -1);
+        generator->stack_size += get_NASM_size_of_type(var_declaration.type);
+      }
+    }
+  }
+  return states;
+}
+
+// generates the statements of the chunk, its cold blocks go after the code of all the chunks
+static void gen_NASM_chunk(void * states, const int chunk_index, FILE * code_file_ptr, FILE * end_file_ptr) {
+  NASM_Chunk * chunk = &((NASM_Chunk *) states)[chunk_index];
+  for (int i = chunk->first_statement; i < chunk->end_statement; i++) {
+    chunk->context.statement_index = i;
+    gen_NASM_statement(code_file_ptr, &chunk->context, &chunk->scopes, chunk->context.program->statements_node[i], &chunk->stack_size);
+  }
+  fwrite(chunk->context.cold_code, 1, chunk->context.cold_code_size, end_file_ptr);
+  sfree(chunk->context.cold_code);
+  NASM_free_scopes_list(chunk->scopes);
 }
 
+// it generates NASM code into the file
+void gen_NASM_code(const Node_Program syntax_tree, FILE * out_file_ptr) {
+  NASM_Generator generator = begin_NASM_code(out_file_ptr);
+  generator.context.program = &syntax_tree;
+  generator.context.scope_statements = syntax_tree.statements_node;
+  if (is_bounds_checking) {
+    free_index_bounds(generator.context.index_bounds);
+    generator.context.index_bounds = analyze_index_bounds(syntax_tree.statements_node, syntax_tree.statements_count);
+  }
+  // the points of all the chunks are known before generating any of them
+  if (profile_output_file != NULL) {
+    add_profile_points(&generator.context.profile_points, syntax_tree.statements_node, syntax_tree.statements_count);
+  }
+  generator.context.tables = gen_NASM_tables(out_file_ptr, &syntax_tree);
+
+  Code_chunks chunks = split_code_chunks(syntax_tree.statements_count);
+  NASM_Chunk * states = lay_out_NASM_chunks(&generator, chunks);
+  // the notes of the unrolled loops are printed in the order of the code
+  generate_code_chunks(&chunks, gen_NASM_chunk, states, is_reporting_unrolls ? 1 : code_generation_workers_count);
+  write_code_chunks(out_file_ptr, chunks);
+  for (int i = 0; i < chunks.chunks_count; i++) {
+    generator.context.index_checks_count += states[i].context.index_checks_count;
+    generator.context.removed_index_checks_count += states[i].context.removed_index_checks_count;
+    // the cold blocks of the chunks go after the exit of the program, in the order of the chunks
+    const Code_chunk chunk = chunks.chunks[i];
+    if (chunk.end_code_size > 0) {
+      generator.context.cold_code = srealloc(generator.context.cold_code, generator.context.cold_code_size + chunk.end_code_size);
+      memcpy(generator.context.cold_code + generator.context.cold_code_size, chunk.end_code, chunk.end_code_size);
+      generator.context.cold_code_size += chunk.end_code_size;
+    }
+  }
+  sfree(states);
+  free_code_chunks(chunks);
+  end_NASM_code(&generator);
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,581 @@
+#ifndef INCREMENTAL_H_
+#define INCREMENTAL_H_
+
+#include "mlib.h"
+#include "errors.h"
+#include "tokenizer.h"
+#include "parser.h"
+#include "checker.h"
+
+
+/* * * * * * * * * * * * * * * * * *
+ * Incremental lexing and parsing  *
+ * * * * * * * * * * * * * * * * * */
+
+// a document is a source code that is edited many times, like the one open in an editor
+// it is kept split in its top level statements, so after an edit only the statements it
+// touches are lexed and parsed again, and the statements after it are checked again
+// only when the global variables they can see changed
+
+// an edit of the text, the bytes in [offset, offset + removed_length) are replaced by the inserted ones
+typedef struct Text_edit {
+  int offset;
+  int removed_length;
+  const char * inserted;
+  int inserted_length;
+} Text_edit;
+
+// a top level statement of the document and everything known about it
+typedef struct Document_statement {
+  // offset in the text of the beginning of its first token and of the end of its last token
+  int begin;
+  int end;
+  // its tokens are the ones in [first_token, first_token + tokens_count) of the list of its region,
+  // the text of the region from its first token is in the token texts of the document
+  const Token_list * tokens;
+  int first_token;
+  int tokens_count;
+  // a single statement, or none if it could not be parsed
+  Node_Program syntax_tree;
+  Diagnostics parse_diagnostics;
+  Diagnostics check_diagnostics;
+  // number of global variables declared before it, for checking again from it
+  int globals_count;
+} Document_statement;
+
+typedef struct Document {
+  // the text is not in the arena, it changes with every edit
+  char * text;
+  int text_size;
+  int text_capacity;
+  // the tokens, the syntax trees and the diagnostics of the statements
+  Arena arena;
+  // the nodes of the syntax trees, the pools are in the arena
+  Node_pools * node_pools;
+  // arena size after the last full parse, when it grows too much the document is parsed again from zero
+  size_t parsed_size;
+  int statements_count;
+  Document_statement * statements;
+  // the global scope of the checker, its variables are in the order of declaration
+  Symbol_table globals;
+  // the texts of the tokens of the statements, in the arena
+  Token_texts token_texts;
+} Document;
+
+
+/* the texts of the statements */
+
+// the text of the statement in the token texts of the document begins at its first token
+static const char * get_statement_text(const Document_statement * statement) {
+  return statement->tokens->text + statement->tokens->offsets[statement->first_token];
+}
+
+static Token get_statement_first_token(const Document_statement * statement) {
+  return get_token(statement->tokens, statement->first_token);
+}
+
+static void remove_statements_texts(Document * document, const Document_statement * statements, const int statements_count) {
+  for (int i = 0; i < statements_count; i++) {
+    if (statements[i].tokens_count > 0) {
+      remove_token_text(&document->token_texts, get_statement_text(&statements[i]));
+    }
+  }
+}
+
+
+/* shifting the lines of the statements after an edit */
+
+static void shift_diagnostics_lines(Diagnostics * diagnostics, const int lines) {
+  for (int i = 0; i < diagnostics->diagnostics_count; i++) {
+    if (diagnostics->diagnostics[i].line_number > 0) {
+      diagnostics->diagnostics[i].line_number += lines;
+    }
+  }
+}
+
+// the places of the tokens of the statement and of its tree are found from the lines of its text
+static void shift_document_statement_lines(Document * document, Document_statement * statement, const int lines) {
+  if (statement->tokens_count > 0) {
+    get_token_text(&document->token_texts, get_statement_text(statement))->lines.first_line_number += lines;
+  }
+  shift_diagnostics_lines(&statement->parse_diagnostics, lines);
+  shift_diagnostics_lines(&statement->check_diagnostics, lines);
+}
+
+
+/* lexing and parsing */
+
+// returns the line and column the lexer would have at the offset of the text
+// the line is counted from the beginning of the statement before it, that is already known
+static void get_document_position(const Document * document, const int statement_idx, const int offset, int * line_number, int * column_number) {
+  int anchor = 0;
+  *line_number = 1;
+  if (statement_idx > 0 && document->statements[statement_idx -1].tokens_count > 0) {
+    const Document_statement * previous = &document->statements[statement_idx -1];
+    anchor = previous->begin;
+    *line_number = get_token_place(get_statement_first_token(previous)).line_number;
+  }
+  int line_beginning = anchor;
+  for (int i = anchor; i < offset; i++) {
+    if (document->text[i] == '\n') {
+      *line_number += 1;
+      line_beginning = i + 1;
+    }
+  }
+  // the line can begin before the anchor
+  if (line_beginning == anchor) {
+    while (line_beginning > 0 && document->text[line_beginning -1] != '\n') {
+      line_beginning--;
+    }
+  }
+  *column_number = offset - line_beginning + 1;
+}
+
+// whether the statement has errors of the lexer from before its first token
+static bool has_errors_before_tokens(const Document_statement * statement) {
+  if (statement->tokens_count == 0) {
+    return statement->parse_diagnostics.diagnostics_count > 0;
+  }
+  const Token_place first_token_place = get_token_place(get_statement_first_token(statement));
+  const Diagnostic first_token_position = { .line_number = first_token_place.line_number, .column_number = first_token_place.column_number };
+  for (int i = 0; i < statement->parse_diagnostics.diagnostics_count; i++) {
+    if (is_diagnostic_before(statement->parse_diagnostics.diagnostics[i], first_token_position)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// lexes and parses the text in [begin, end), that has the top level statements from the index
+// returns the number of statements it had, or -1 if the region has to include the next statement too
+static int parse_document_region(Document * document, const int statement_idx, const int begin, const int end, Document_statement ** statements) {
+  int line_number, column_number;
+  get_document_position(document, statement_idx, begin, &line_number, &column_number);
+  // the tokens point to this copy of the text, it does not change with the edits
+  char * region = smalloc(end - begin + 1);
+  memcpy(region, document->text + begin, end - begin);
+  region[end - begin] = '\0';
+
+  Diagnostics lexer_diagnostics = { .diagnostics_count = 0, .diagnostics = NULL };
+  diagnostic_sink = &lexer_diagnostics;
+  // the statements keep the list, they are parsed from it
+  Token_list * tokens = smalloc(sizeof(*tokens));
+  *tokens = lexer_from(region, line_number, column_number);
+
+  int statements_count = 0;
+  *statements = NULL;
+  // the place of the symbol after the last token of every statement, from the beginning of the token,
+  // the place of the identifiers and the numbers is already after them, but the errors of the lexer are not
+  Diagnostic * statement_ends = NULL;
+  for (int i = 0; i < tokens->tokens_count; i++) {
+    bool is_complete;
+    const int last = statement_end_index(get_list_span(tokens), i, &is_complete);
+    if (!is_complete && end < document->text_size) {
+      remove_statements_texts(document, *statements, statements_count);
+      free_token_list(*tokens);
+      sfree(statement_ends);
+      return -1;
+    }
+    Document_statement statement = {
+      .begin = begin + tokens->offsets[i],
+      .end = begin + tokens->offsets[last] + tokens->lengths[last],
+      .tokens = tokens,
+      .first_token = i,
+      .tokens_count = last - i + 1,
+      .parse_diagnostics = { .diagnostics_count = 0, .diagnostics = NULL },
+      .check_diagnostics = { .diagnostics_count = 0, .diagnostics = NULL },
+      .globals_count = 0
+    };
+    add_token_text(&document->token_texts, (Token_text) {
+      .begin = region + tokens->offsets[i],
+      .end = region + tokens->offsets[last] + tokens->lengths[last],
+      .text = region,
+      .lines = tokens->lines
+    });
+    diagnostic_sink = &statement.parse_diagnostics;
+    statement.syntax_tree = parse_tokens((Token_span) { .list = tokens, .first = i, .end = last + 1 });
+
+    statements_count++;
+    *statements = srealloc(*statements, statements_count * sizeof(**statements));
+    (*statements)[statements_count -1] = statement;
+    statement_ends = srealloc(statement_ends, statements_count * sizeof(*statement_ends));
+    const Token_place last_token_place = get_text_place(&tokens->lines, tokens->offsets[last]);
+    statement_ends[statements_count -1] = (Diagnostic) { .line_number = last_token_place.line_number, .column_number = last_token_place.column_number + tokens->lengths[last] };
+    i = last;
+  }
+  // every error of the lexer goes with the statement it is in, or the one after it,
+  // so it is reported again only when that statement is parsed again
+  const int token_statements_count = statements_count;
+  int statement = 0;
+  for (int i = 0; i < lexer_diagnostics.diagnostics_count; i++) {
+    const Diagnostic diagnostic = lexer_diagnostics.diagnostics[i];
+    // the empty statement at the end takes all the errors left
+    while (statement < token_statements_count && !is_diagnostic_before(diagnostic, statement_ends[statement])) {
+      statement++;
+    }
+    // the errors after the last statement go with the next one, that is after the region,
+    // at the end of the text they are kept in an empty statement
+    if (statement == statements_count && end < document->text_size) {
+      remove_statements_texts(document, *statements, statements_count);
+      sfree(statement_ends);
+      return -1;
+    }
+    if (statement == statements_count) {
+      statements_count++;
+      *statements = srealloc(*statements, statements_count * sizeof(**statements));
+      (*statements)[statements_count -1] = (Document_statement) {
+        .begin = end,
+        .end = end,
+        .tokens = NULL,
+        .first_token = 0,
+        .tokens_count = 0,
+        .syntax_tree = { .statements_node = NULL, .statements_count = 0 },
+        .parse_diagnostics = { .diagnostics_count = 0, .diagnostics = NULL },
+        .check_diagnostics = { .diagnostics_count = 0, .diagnostics = NULL },
+        .globals_count = 0
+      };
+    }
+    append_diagnostic(&(*statements)[statement].parse_diagnostics, diagnostic);
+  }
+  sfree(statement_ends);
+  return statements_count;
+}
+
+static void check_document_statement(Document * document, const int statement_idx) {
+  Document_statement * statement = &document->statements[statement_idx];
+  statement->globals_count = document->globals.scopes[0].vars_count;
+  statement->check_diagnostics = (Diagnostics) { .diagnostics_count = 0, .diagnostics = NULL };
+  diagnostic_sink = &statement->check_diagnostics;
+  check_statements(&document->globals, statement->syntax_tree.statements_node, statement->syntax_tree.statements_count);
+}
+
+// checks the statements from the index to the end of the document
+// the global variables declared before the statement were the first ones of the global scope
+static void check_document_from(Document * document, const int statement_idx, const int globals_count) {
+  // forget the variables declared from the statement
+  document->globals.scopes[0].vars_count = globals_count;
+  for (int i = statement_idx; i < document->statements_count; i++) {
+    check_document_statement(document, i);
+  }
+}
+
+// the place of the old symbol was found before its statement was replaced
+static bool are_symbols_equal(const Symbol symbol, const Symbol old_symbol, const Token_place old_place) {
+  const Token_place place = get_token_place(symbol.value);
+  return compare_str_of_tokens(symbol.value, old_symbol.value) && compare_2_types(symbol.type, old_symbol.type)
+      && place.line_number == old_place.line_number && place.column_number == old_place.column_number;
+}
+
+// checks the statements changed by an edit, and the ones after them only if the global variables they see changed,
+// old_globals are the global variables declared from the first changed statement before the edit, with their places after it,
+// the ones from kept_beginning were declared by the statements from the kept index
+static void check_document_edit(Document * document, const int statement_idx, const int globals_count, const int kept_idx, const Symbols_scope old_globals,
+                                const Token_place * old_places, const int kept_beginning, const bool are_lines_moved) {
+  Symbols_scope * global_scope = &document->globals.scopes[0];
+  global_scope->vars_count = globals_count;
+  int i;
+  for (i = statement_idx; i < kept_idx; i++) {
+    check_document_statement(document, i);
+  }
+  bool are_globals_equal = global_scope->vars_count - globals_count == kept_beginning;
+  for (int j = 0; j < kept_beginning && are_globals_equal; j++) {
+    are_globals_equal = are_symbols_equal(global_scope->vars[globals_count + j], old_globals.vars[j], old_places[j]);
+  }
+  if (!are_globals_equal) {
+    for (; i < document->statements_count; i++) {
+      check_document_statement(document, i);
+    }
+    return;
+  }
+  // otherwise the kept statements have the same errors and declare the same variables as before,
+  // only the messages of their errors can have the old lines of the variables
+  for (; i < document->statements_count; i++) {
+    const Document_statement * statement = &document->statements[i];
+    if (are_lines_moved && statement->check_diagnostics.diagnostics_count > 0) {
+      check_document_statement(document, i);
+      continue;
+    }
+    const int next_beginning = i + 1 < document->statements_count ? document->statements[i + 1].globals_count - globals_count : old_globals.vars_count;
+    for (int j = statement->globals_count - globals_count; j < next_beginning; j++) {
+      append_var_to_var_list(old_globals.vars[j], &document->globals);
+    }
+  }
+}
+
+// an error that could not be recovered from stopped the work on the document
+// it is left without statements, so the next edit parses it all again
+static void recover_document(Document * document, Arena * previous_arena, Node_pools * previous_node_pools, Token_texts * previous_token_texts,
+                             Diagnostics * previous_sink, jmp_buf * previous_recovery_point) {
+  document->statements_count = 0;
+  document->globals.scopes[0].vars_count = 0;
+  active_arena = previous_arena;
+  active_node_pools = previous_node_pools;
+  active_token_texts = previous_token_texts;
+  diagnostic_sink = previous_sink;
+  error_recovery_point = previous_recovery_point;
+  stop_compilation(error_exit_code);
+}
+
+// lexes, parses and checks all the document
+static void parse_document(Document * document) {
+  document->arena = create_arena();
+  Arena * previous_arena = active_arena;
+  Node_pools * previous_node_pools = active_node_pools;
+  Token_texts * previous_token_texts = active_token_texts;
+  Diagnostics * previous_sink = diagnostic_sink;
+  active_arena = &document->arena;
+  document->node_pools = create_node_pools();
+  active_node_pools = document->node_pools;
+  document->token_texts = (Token_texts) { .texts_count = 0, .texts_capacity = 0, .texts = NULL };
+  active_token_texts = &document->token_texts;
+  document->statements_count = 0;
+  document->globals = (Symbol_table) { .scopes_count = 0, .scopes = NULL };
+  create_scope(&document->globals);
+
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  jmp_buf recovery_point;
+  if (setjmp(recovery_point) != 0) {
+    recover_document(document, previous_arena, previous_node_pools, previous_token_texts, previous_sink, previous_recovery_point);
+  }
+  error_recovery_point = &recovery_point;
+
+  document->statements_count = parse_document_region(document, 0, 0, document->text_size, &document->statements);
+  check_document_from(document, 0, 0);
+  document->parsed_size = arena_used_size(&document->arena);
+
+  error_recovery_point = previous_recovery_point;
+  active_arena = previous_arena;
+  active_node_pools = previous_node_pools;
+  active_token_texts = previous_token_texts;
+  diagnostic_sink = previous_sink;
+}
+
+Document * open_document(const char * code, const int code_size) {
+  Document * document = smalloc(sizeof(*document));
+  document->text_size = code_size;
+  document->text_capacity = code_size + 1;
+  document->text = smalloc(document->text_capacity);
+  memcpy(document->text, code, code_size);
+  document->text[code_size] = '\0';
+  parse_document(document);
+  return document;
+}
+
+void close_document(Document * document) {
+  destroy_arena(&document->arena);
+  sfree(document->text);
+  sfree(document);
+}
+
+// replaces the bytes of the edit in the text
+static void apply_text_edit(Document * document, const Text_edit edit) {
+  const int new_size = document->text_size - edit.removed_length + edit.inserted_length;
+  if (new_size + 1 > document->text_capacity) {
+    document->text_capacity = 2 * (new_size + 1);
+    document->text = srealloc(document->text, document->text_capacity);
+  }
+  const int old_end = edit.offset + edit.removed_length;
+  memmove(document->text + edit.offset + edit.inserted_length, document->text + old_end, document->text_size - old_end + 1);
+  memcpy(document->text + edit.offset, edit.inserted, edit.inserted_length);
+  document->text_size = new_size;
+}
+
+static int count_new_lines(const char * text, const int size) {
+  int lines = 0;
+  for (int i = 0; i < size; i++) {
+    lines += text[i] == '\n';
+  }
+  return lines;
+}
+
+// lexes and parses again the top level statements the edit changes, and checks again from the first of them
+static void reparse_document_edit(Document * document, const Text_edit edit) {
+  const int old_end = edit.offset + edit.removed_length;
+  const int size_change = edit.inserted_length - edit.removed_length;
+  const int lines_change = count_new_lines(edit.inserted, edit.inserted_length) - count_new_lines(document->text + edit.offset, edit.removed_length);
+
+  // the first statement changed is the first one that ends at the edit or after it,
+  // an edit touching its last token can change it
+  int first = 0;
+  int last = document->statements_count;
+  while (first < last) {
+    const int middle = (first + last) / 2;
+    if (document->statements[middle].end < edit.offset) {
+      first = middle + 1;
+    }
+    else {
+      last = middle;
+    }
+  }
+  // the last statement can be cut by the end of the text, then the text added after it continues it
+  while (first > 0 && (first == document->statements_count || document->statements[first].tokens_count == 0)) {
+    first--;
+  }
+  // the statements kept after the edit begin after the end of its line, so their columns do not change
+  int line_end = old_end;
+  while (line_end < document->text_size && document->text[line_end] != '\n') {
+    line_end++;
+  }
+  while (last < document->statements_count && document->statements[last].begin <= line_end) {
+    last++;
+  }
+  const int first_kept = last;
+
+  apply_text_edit(document, edit);
+  for (int i = first_kept; i < document->statements_count; i++) {
+    document->statements[i].begin += size_change;
+    document->statements[i].end += size_change;
+  }
+
+  active_arena = &document->arena;
+
+  // the region to parse again goes from the end of the statement before the first changed
+  // to the beginning of the first kept, it grows while the statements at its ends continue out of it
+  Document_statement * statements;
+  int statements_count;
+  int growth = 1;
+  while (true) {
+    // the empty statement at the end has the errors after the last one, that are in the region then
+    if (last == document->statements_count -1 && document->statements[last].tokens_count == 0) {
+      last++;
+    }
+    const int begin = first > 0 ? document->statements[first -1].end : 0;
+    const int end = last < document->statements_count ? document->statements[last].begin : document->text_size;
+    statements_count = parse_document_region(document, first, begin, end, &statements);
+    // the region grows twice as much every time, so an unclosed scope that takes the rest
+    // of the text is parsed a few times instead of once for each statement after it
+    if (statements_count < 0) {
+      last += growth;
+      growth *= 2;
+      if (last > document->statements_count) {
+        last = document->statements_count;
+      }
+      continue;
+    }
+    // an else block at the beginning of the region is part of the if statement before it
+    if (first > 0 && statements_count > 0 && statements[0].tokens_count > 0 && compare_token_to_string(get_statement_first_token(&statements[0]), "else")) {
+      remove_statements_texts(document, statements, statements_count);
+      first--;
+      continue;
+    }
+    // the errors of the lexer kept with the next statement can be before it, in the region
+    if (last < document->statements_count && has_errors_before_tokens(&document->statements[last])) {
+      remove_statements_texts(document, statements, statements_count);
+      last++;
+      continue;
+    }
+    // and an else block kept after the region is part of the if statement at its end
+    if (last < document->statements_count && document->statements[last].tokens_count > 0
+        && compare_token_to_string(get_statement_first_token(&document->statements[last]), "else")) {
+      remove_statements_texts(document, statements, statements_count);
+      last++;
+      continue;
+    }
+    break;
+  }
+
+  // the kept statements move to their new lines
+  if (lines_change != 0) {
+    for (int i = last; i < document->statements_count; i++) {
+      shift_document_statement_lines(document, &document->statements[i], lines_change);
+    }
+  }
+
+  // keep the global variables declared from the region, the kept statements are checked again only if they change
+  Symbols_scope * global_scope = &document->globals.scopes[0];
+  const int globals_count = first < document->statements_count ? document->statements[first].globals_count : global_scope->vars_count;
+  const int kept_globals_count = last < document->statements_count ? document->statements[last].globals_count : global_scope->vars_count;
+  // they are only needed during the edit, so they are not in the arena of the document
+  // their places are found before their statements are replaced, the kept ones already moved
+  active_arena = NULL;
+  Symbols_scope old_globals = {
+    .vars_count = global_scope->vars_count - globals_count,
+    .vars = smalloc((global_scope->vars_count - globals_count) * sizeof(Symbol))
+  };
+  Token_place * old_places = smalloc(old_globals.vars_count * sizeof(*old_places));
+  active_arena = &document->arena;
+  for (int i = 0; i < old_globals.vars_count; i++) {
+    old_globals.vars[i] = global_scope->vars[globals_count + i];
+    old_places[i] = get_token_place(old_globals.vars[i].value);
+  }
+
+  // replace the statements of the region
+  remove_statements_texts(document, &document->statements[first], last - first);
+  const int new_count = document->statements_count - (last - first) + statements_count;
+  if (new_count > document->statements_count) {
+    document->statements = srealloc(document->statements, new_count * sizeof(*document->statements));
+  }
+  memmove(&document->statements[first + statements_count], &document->statements[last], (document->statements_count - last) * sizeof(*document->statements));
+  if (statements_count > 0) {
+    memcpy(&document->statements[first], statements, statements_count * sizeof(*statements));
+  }
+  document->statements_count = new_count;
+
+  check_document_edit(document, first, globals_count, first + statements_count, old_globals, old_places, kept_globals_count - globals_count, lines_change != 0);
+  active_arena = NULL;
+  sfree(old_globals.vars);
+  sfree(old_places);
+  active_arena = &document->arena;
+}
+
+// applies the edit to the document, lexing and parsing again only the top level statements it changes
+// and checking again the statements from the first one it changes
+void edit_document(Document * document, const Text_edit edit) {
+  if (edit.offset < 0 || edit.removed_length < 0 || edit.inserted_length < 0 || edit.offset + edit.removed_length > document->text_size) {
+    errorf("Error: the edit is outside the document, its size is %d\n", document->text_size);
+  }
+  Arena * previous_arena = active_arena;
+  Node_pools * previous_node_pools = active_node_pools;
+  Token_texts * previous_token_texts = active_token_texts;
+  Diagnostics * previous_sink = diagnostic_sink;
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  jmp_buf recovery_point;
+  if (setjmp(recovery_point) != 0) {
+    recover_document(document, previous_arena, previous_node_pools, previous_token_texts, previous_sink, previous_recovery_point);
+  }
+  error_recovery_point = &recovery_point;
+  active_node_pools = document->node_pools;
+  active_token_texts = &document->token_texts;
+
+  reparse_document_edit(document, edit);
+
+  error_recovery_point = previous_recovery_point;
+  active_arena = previous_arena;
+  active_node_pools = previous_node_pools;
+  active_token_texts = previous_token_texts;
+  diagnostic_sink = previous_sink;
+
+  // everything replaced by the edits is still in the arena, when it is too much start again from zero
+  if (arena_used_size(&document->arena) > 4 * document->parsed_size + ARENA_BLOCK_SIZE) {
+    destroy_arena(&document->arena);
+    parse_document(document);
+  }
+}
+
+// returns the number of errors in the document
+int count_document_errors(const Document * document) {
+  int errors_count = 0;
+  for (int i = 0; i < document->statements_count; i++) {
+    errors_count += document->statements[i].parse_diagnostics.diagnostics_count;
+    errors_count += document->statements[i].check_diagnostics.diagnostics_count;
+  }
+  return errors_count;
+}
+
+// prints all the errors of the document sorted by their place
+void print_document_diagnostics(FILE * file_ptr, const Document * document) {
+  Diagnostics diagnostics = { .diagnostics_count = 0, .diagnostics = smalloc(count_document_errors(document) * sizeof(Diagnostic)) };
+  for (int i = 0; i < document->statements_count; i++) {
+    const Document_statement * statement = &document->statements[i];
+    for (int j = 0; j < statement->parse_diagnostics.diagnostics_count; j++) {
+      diagnostics.diagnostics[diagnostics.diagnostics_count++] = statement->parse_diagnostics.diagnostics[j];
+    }
+    for (int j = 0; j < statement->check_diagnostics.diagnostics_count; j++) {
+      diagnostics.diagnostics[diagnostics.diagnostics_count++] = statement->check_diagnostics.diagnostics[j];
+    }
+  }
+  print_diagnostics(file_ptr, diagnostics);
+  sfree(diagnostics.diagnostics);
+}
+
+#endif
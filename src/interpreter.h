@@ -0,0 +1,214 @@
+#ifndef INTERPRETER_H_
+#define INTERPRETER_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mlib.h"
+#include "errors.h"
+#include "bytecode.h"
+
+
+/* * * * * * * * * * * * * * * *
+ * Interpreting the bytecode   *
+ * * * * * * * * * * * * * * * */
+
+// every instruction jumps directly to the code of the next one with the computed gotos of GCC and clang,
+// so each one has its own indirect jump that the processor can predict,
+// with other compilers a switch is used instead
+#if defined(__GNUC__)
+#define INTERPRETER_COMPUTED_GOTO
+#endif
+
+// stops the program at the instruction, it can only fail in ways the program does not check
+static void bytecode_runtime_error(const Bytecode_program * program, const Instruction * instruction, const char * message) {
+  const Code_place place = program->places[instruction - program->instructions];
+  // the output of the program goes before the error
+  fflush(stdout);
+  report_error_at(place.line_number, place.column_number, "%s\n", message);
+}
+
+// the labels as values are an extension of GNU C
+#ifdef INTERPRETER_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+// runs the bytecode, returns the exit code of the program
+// the program can print, and an error in it is reported like a compilation error with the exit code 1
+int run_bytecode(const Bytecode_program * program) {
+  // the constants go right before the register 0
+  uint64_t * frame = smalloc((program->constants_count + program->frame_size + 1) * sizeof(*frame));
+  for (int i = 0; i < program->constants_count; i++) {
+    frame[program->constants_count -1 -i] = program->constants[i];
+  }
+  memset(frame + program->constants_count, 0, (program->frame_size + 1) * sizeof(*frame));
+  uint64_t * const r = frame + program->constants_count;
+  const Array_shape * const shapes = program->shapes;
+  const Instruction * const instructions = program->instructions;
+  const Instruction * ip = instructions;
+  int exit_code = 0;
+
+#ifdef INTERPRETER_COMPUTED_GOTO
+  static const void * const labels[OPCODES_COUNT] = {
+    [op_move] = &&do_op_move,
+    [op_copy] = &&do_op_copy,
+    [op_add] = &&do_op_add,
+    [op_sub] = &&do_op_sub,
+    [op_mul] = &&do_op_mul,
+    [op_div] = &&do_op_div,
+    [op_mod] = &&do_op_mod,
+    [op_equ] = &&do_op_equ,
+    [op_big] = &&do_op_big,
+    [op_les] = &&do_op_les,
+    [op_and] = &&do_op_and,
+    [op_address] = &&do_op_address,
+    [op_load] = &&do_op_load,
+    [op_load_block] = &&do_op_load_block,
+    [op_frame_element] = &&do_op_frame_element,
+    [op_frame_element_address] = &&do_op_frame_element_address,
+    [op_element] = &&do_op_element,
+    [op_element_address] = &&do_op_element_address,
+    [op_jump] = &&do_op_jump,
+    [op_jump_if_zero] = &&do_op_jump_if_zero,
+    [op_jump_if_not_equ] = &&do_op_jump_if_not_equ,
+    [op_jump_if_not_big] = &&do_op_jump_if_not_big,
+    [op_jump_if_not_les] = &&do_op_jump_if_not_les,
+    [op_print] = &&do_op_print,
+    [op_exit] = &&do_op_exit,
+    [op_end] = &&do_op_end
+  };
+#define INSTRUCTION(opcode) do_##opcode:
+#define DISPATCH() goto *labels[ip->opcode]
+  DISPATCH();
+#else
+#define INSTRUCTION(opcode) case opcode:
+#define DISPATCH() continue
+  for (;;) switch (ip->opcode) {
+#endif
+// not in a do while, its continue must go to the loop of the switch
+#define NEXT() ip++; DISPATCH()
+
+  INSTRUCTION(op_move)
+    r[ip->a] = r[ip->b];
+    NEXT();
+  INSTRUCTION(op_copy)
+    // the value can overlap with the destination, like in `a = [a[1], a[0]];`
+    memmove(&r[ip->a], &r[ip->b], ip->c * sizeof(*r));
+    NEXT();
+  INSTRUCTION(op_add)
+    r[ip->a] = r[ip->b] + r[ip->c];
+    NEXT();
+  INSTRUCTION(op_sub)
+    r[ip->a] = r[ip->b] - r[ip->c];
+    NEXT();
+  INSTRUCTION(op_mul)
+    r[ip->a] = r[ip->b] * r[ip->c];
+    NEXT();
+  INSTRUCTION(op_div)
+    if (r[ip->c] == 0) {
+      bytecode_runtime_error(program, ip, "division by zero");
+      exit_code = 1;
+      goto end;
+    }
+    r[ip->a] = r[ip->b] / r[ip->c];
+    NEXT();
+  INSTRUCTION(op_mod)
+    if (r[ip->c] == 0) {
+      bytecode_runtime_error(program, ip, "division by zero");
+      exit_code = 1;
+      goto end;
+    }
+    r[ip->a] = r[ip->b] % r[ip->c];
+    NEXT();
+  INSTRUCTION(op_equ)
+    r[ip->a] = r[ip->b] == r[ip->c];
+    NEXT();
+  INSTRUCTION(op_big)
+    r[ip->a] = r[ip->b] > r[ip->c];
+    NEXT();
+  INSTRUCTION(op_les)
+    r[ip->a] = r[ip->b] < r[ip->c];
+    NEXT();
+  INSTRUCTION(op_and)
+    r[ip->a] = r[ip->b] & r[ip->c];
+    NEXT();
+  INSTRUCTION(op_address)
+    r[ip->a] = (uint64_t)&r[ip->b];
+    NEXT();
+  INSTRUCTION(op_load)
+    r[ip->a] = *(const uint64_t *)r[ip->b];
+    NEXT();
+  INSTRUCTION(op_load_block)
+    memmove(&r[ip->a], (const uint64_t *)r[ip->b], ip->c * sizeof(*r));
+    NEXT();
+  INSTRUCTION(op_frame_element)
+    if (r[ip->c] >= shapes[ip->d].length) {
+      goto index_out_of_range;
+    }
+    r[ip->a] = r[ip->b + r[ip->c] * shapes[ip->d].stride];
+    NEXT();
+  INSTRUCTION(op_frame_element_address)
+    if (r[ip->c] >= shapes[ip->d].length) {
+      goto index_out_of_range;
+    }
+    r[ip->a] = (uint64_t)&r[ip->b + r[ip->c] * shapes[ip->d].stride];
+    NEXT();
+  INSTRUCTION(op_element)
+    if (r[ip->c] >= shapes[ip->d].length) {
+      goto index_out_of_range;
+    }
+    r[ip->a] = ((const uint64_t *)r[ip->b])[r[ip->c] * shapes[ip->d].stride];
+    NEXT();
+  INSTRUCTION(op_element_address)
+    if (r[ip->c] >= shapes[ip->d].length) {
+      goto index_out_of_range;
+    }
+    r[ip->a] = (uint64_t)&((uint64_t *)r[ip->b])[r[ip->c] * shapes[ip->d].stride];
+    NEXT();
+  INSTRUCTION(op_jump)
+    ip = &instructions[ip->a];
+    DISPATCH();
+  INSTRUCTION(op_jump_if_zero)
+    ip = r[ip->b] == 0 ? &instructions[ip->a] : ip + 1;
+    DISPATCH();
+  INSTRUCTION(op_jump_if_not_equ)
+    ip = r[ip->b] == r[ip->c] ? ip + 1 : &instructions[ip->a];
+    DISPATCH();
+  INSTRUCTION(op_jump_if_not_big)
+    ip = r[ip->b] > r[ip->c] ? ip + 1 : &instructions[ip->a];
+    DISPATCH();
+  INSTRUCTION(op_jump_if_not_les)
+    ip = r[ip->b] < r[ip->c] ? ip + 1 : &instructions[ip->a];
+    DISPATCH();
+  INSTRUCTION(op_print)
+    putchar(r[ip->a] & 0xff);
+    NEXT();
+  INSTRUCTION(op_exit)
+    exit_code = r[ip->a] & 0xff;
+    goto end;
+  INSTRUCTION(op_end)
+    exit_code = 0;
+    goto end;
+
+#ifndef INTERPRETER_COMPUTED_GOTO
+  }
+#endif
+#undef INSTRUCTION
+#undef DISPATCH
+#undef NEXT
+
+index_out_of_range:
+  bytecode_runtime_error(program, ip, "the index is out of the range of the array");
+  exit_code = 1;
+end:
+  fflush(stdout);
+  sfree(frame);
+  return exit_code;
+}
+
+#ifdef INTERPRETER_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+#endif
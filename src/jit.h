@@ -0,0 +1,184 @@
+#ifndef JIT_H_
+#define JIT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "mlib.h"
+#include "errors.h"
+#include "assembler.h"
+
+
+/* * * * * * * * * * * * * * * * * * *
+ * Running the programs in memory   *
+ * * * * * * * * * * * * * * * * * * */
+
+// the NASM code of a program is assembled into executable memory and run inside the compiler,
+// the program runs on a stack of its own and its syscalls become calls to jit_syscall(),
+// which prints into stdout, writes the files of the profiles and jumps back to the compiler when the program exits
+// when the program crashes the compiler jumps back too, and then it is stopped by the same signal
+
+// the size of the stack of the program, like the usual limit of the main thread
+#define JIT_STACK_SIZE (8 << 20)
+// the stack of the signal handlers, it is needed when the program overflows its stack
+#define JIT_SIGNAL_STACK_SIZE (64 << 10)
+#define JIT_PAGE_SIZE 4096
+
+typedef struct Jit_state {
+  // the stack pointer of the compiler while the program runs
+  uint64_t host_stack;
+  // the stack pointer of the program while a syscall runs, and its first one
+  uint64_t program_stack;
+  sigjmp_buf exit_point;
+  int exit_code;
+  // the signal that crashed the program, or 0
+  int signal;
+} Jit_state;
+
+// the signals of the crashes of a program
+static const int jit_crash_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL };
+#define JIT_CRASH_SIGNALS_COUNT ((int)(sizeof(jit_crash_signals) / sizeof(*jit_crash_signals)))
+
+// the program running in this thread, for the signal handler
+static thread_local Jit_state * running_jit_state = NULL;
+
+static void handle_jit_crash(const int signal) {
+  running_jit_state->signal = signal;
+  siglongjmp(running_jit_state->exit_point, 1);
+}
+
+// does the syscalls of the program, the ones it does not use are not implemented
+static uint64_t jit_syscall(const uint64_t argument1, const uint64_t argument2, const uint64_t argument3, const uint64_t number, Jit_state * state) {
+  switch (number) {
+    // write, the standard outputs go through the streams of the compiler so they keep their order
+    case 1: {
+      FILE * file_ptr = argument1 == 1 ? stdout : argument1 == 2 ? stderr : NULL;
+      if (file_ptr == NULL) {
+        const ssize_t written = write(argument1, (const void *)argument2, argument3);
+        return written < 0 ? (uint64_t)-errno : (uint64_t)written;
+      }
+      return fwrite((const void *)argument2, 1, argument3, file_ptr);
+    }
+    // open, only for the files of the profiles
+    case 2: {
+      const int file_descriptor = open((const char *)argument1, argument2, argument3);
+      return file_descriptor < 0 ? (uint64_t)-errno : (uint64_t)file_descriptor;
+    }
+    // close
+    case 3:
+      return close(argument1) < 0 ? (uint64_t)-errno : 0;
+    // exit
+    case 60:
+      state->exit_code = argument1 & 0xff;
+      siglongjmp(state->exit_point, 1);
+  }
+  return (uint64_t)-ENOSYS;
+}
+
+// the NASM code of the program is run after this one, that changes to the stack of the program
+static const char * jit_prologue_format =
+  "mov r11, %lu\n"
+  "mov qword [r11 + %d], rsp\n"
+  "mov rsp, qword [r11 + %d]\n";
+
+// every syscall is replaced by this, it changes to the stack of the compiler and calls jit_syscall()
+// with the registers of the syscall, the ones it keeps are the ones the syscall keeps
+static const char * jit_syscall_format =
+  "mov r11, %lu\n"
+  "mov qword [r11 + %d], rsp\n"
+  "mov rsp, qword [r11 + %d]\n"
+  // the stack of the compiler is 8 bytes after a 16 bytes alignment, and 3 pushes align it for the call
+  "push rdx\n"
+  "push rsi\n"
+  "push rdi\n"
+  "mov rcx, rax\n"
+  "mov r8, r11\n"
+  "mov rax, %lu\n"
+  "call rax\n"
+  "pop rdi\n"
+  "pop rsi\n"
+  "pop rdx\n"
+  "mov r11, %lu\n"
+  "mov rsp, qword [r11 + %d]\n";
+
+// calls the machine code, it only comes back here through the exit of the program
+static void enter_machine_code(void * code, Jit_state * state) {
+  void (*entry)(void);
+  // POSIX allows converting between data and function pointers
+  *(void **)&entry = code;
+  if (sigsetjmp(state->exit_point, 1) == 0) {
+    entry();
+  }
+}
+
+// assembles the NASM code of a program in memory and runs it, returns the exit code of the program
+// a program that crashes also stops the compiler, with the same signal
+int run_NASM_code(const char * text, const size_t text_size) {
+  Jit_state state = { .host_stack = 0, .program_stack = 0, .exit_code = 0, .signal = 0 };
+  char prologue[256];
+  char syscall_code[1024];
+  snprintf(prologue, sizeof(prologue), jit_prologue_format,
+           (unsigned long)&state, (int)offsetof(Jit_state, host_stack), (int)offsetof(Jit_state, program_stack));
+  snprintf(syscall_code, sizeof(syscall_code), jit_syscall_format,
+           (unsigned long)&state, (int)offsetof(Jit_state, program_stack), (int)offsetof(Jit_state, host_stack),
+           (unsigned long)jit_syscall, (unsigned long)&state, (int)offsetof(Jit_state, program_stack));
+  Assembler assembler = begin_assembler(syscall_code);
+  assemble_NASM_text(&assembler, prologue, strlen(prologue));
+  assemble_NASM_text(&assembler, text, text_size);
+  const Machine_code code = end_assembler(&assembler);
+
+  // the memory is never writable and executable at the same time,
+  // and the stack has a page without access below it so an overflow crashes the program
+  // the bss is in the pages after the code, that stay writable
+  const size_t code_size = code.bss_size > 0 ? code.bss_place + code.bss_size : code.size;
+  void * code_memory = mmap(NULL, code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  char * stack_memory = mmap(NULL, JIT_PAGE_SIZE + JIT_STACK_SIZE + JIT_SIGNAL_STACK_SIZE, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (code_memory == MAP_FAILED || stack_memory == MAP_FAILED) {
+    errorf("Error: can not get the memory for running the program\n");
+  }
+  memcpy(code_memory, code.bytes, code.size);
+  const size_t executable_size = code.bss_size > 0 ? code.bss_place : code.size;
+  free_machine_code(code);
+  if (mprotect(code_memory, executable_size, PROT_READ | PROT_EXEC) != 0 || mprotect(stack_memory, JIT_PAGE_SIZE, PROT_NONE) != 0) {
+    errorf("Error: can not set the permissions of the memory of the program\n");
+  }
+  state.program_stack = (uint64_t)(stack_memory + JIT_PAGE_SIZE + JIT_STACK_SIZE);
+
+  // catch the crashes of the program while it runs
+  const stack_t signal_stack = { .ss_sp = stack_memory + JIT_PAGE_SIZE + JIT_STACK_SIZE, .ss_size = JIT_SIGNAL_STACK_SIZE, .ss_flags = 0 };
+  stack_t previous_signal_stack;
+  sigaltstack(&signal_stack, &previous_signal_stack);
+  struct sigaction crash_action = { .sa_handler = handle_jit_crash, .sa_flags = SA_ONSTACK | SA_NODEFER };
+  sigemptyset(&crash_action.sa_mask);
+  struct sigaction previous_actions[JIT_CRASH_SIGNALS_COUNT];
+  for (int i = 0; i < JIT_CRASH_SIGNALS_COUNT; i++) {
+    sigaction(jit_crash_signals[i], &crash_action, &previous_actions[i]);
+  }
+  running_jit_state = &state;
+
+  enter_machine_code(code_memory, &state);
+
+  running_jit_state = NULL;
+  for (int i = 0; i < JIT_CRASH_SIGNALS_COUNT; i++) {
+    sigaction(jit_crash_signals[i], &previous_actions[i], NULL);
+  }
+  sigaltstack(&previous_signal_stack, NULL);
+  fflush(stdout);
+  munmap(code_memory, code_size);
+  munmap(stack_memory, JIT_PAGE_SIZE + JIT_STACK_SIZE + JIT_SIGNAL_STACK_SIZE);
+  if (state.signal != 0) {
+    // the crash stops the compiler like it would have stopped the program
+    signal(state.signal, SIG_DFL);
+    raise(state.signal);
+  }
+  return state.exit_code;
+}
+
+#endif
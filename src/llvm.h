@@ -0,0 +1,674 @@
+#ifndef LLVM_H_
+#define LLVM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "errors.h"
+#include "mlib.h"
+#include "tokenizer.h"
+#include "parser.h"
+#include "checker.h"
+#include "analysis.h"
+#include "generator.h"
+
+
+/* * * * * * * * * * * * * *
+ * Generating LLVM IR code *
+ * * * * * * * * * * * * * */
+
+// the program is the function main of a module of textual LLVM IR, that clang compiles and links with the C library,
+// every variable is an alloca in the entry block, which the optimizations of LLVM turn into registers,
+// the integers are i64 while they are computed and have their own size in memory, the arrays are accessed with
+// getelementptr, and the pointers are the opaque `ptr` of LLVM 15 and later
+// the constant tables are private constants of the module, like the read only data of the NASM code
+
+// a variable in the scope of the generation, the variables of the blocks are after the global ones
+typedef struct LLVM_Variable {
+  Token name;
+  Node_Type type;
+  // the number after the name of its alloca, or of its constant for the constant tables
+  int number;
+  bool is_constant;
+} LLVM_Variable;
+
+// a value of an expression, the integers are i64 and the arrays are the address of their memory
+typedef struct LLVM_Value {
+  enum {
+    llvm_value_number,
+    llvm_value_temporary,
+    llvm_value_variable
+  } kind;
+  // the number, or the number of the temporary
+  uint64_t number;
+  // the address of the variable that is an array
+  const LLVM_Variable * variable;
+  Node_Type type;
+} LLVM_Value;
+
+// the state of a generation of LLVM IR, every generation has its own so many can run at the same time
+typedef struct LLVM_Context {
+  // the allocas go in the entry block, before the code of the statements, and the constants before main
+  FILE * allocas;
+  char * allocas_text;
+  size_t allocas_size;
+  FILE * constants;
+  char * constants_text;
+  size_t constants_size;
+  int temporaries_count;
+  int labels_count;
+  int variables_numbers_count;
+  LLVM_Variable * variables;
+  int variables_count;
+  int variables_capacity;
+  // the whole program, to find the constant tables
+  const Node_Program * program;
+  // the indexes that do not need to be checked with --bounds-check, and the counts of the checks
+  Index_bounds index_bounds;
+  int index_checks_count;
+  int removed_index_checks_count;
+} LLVM_Context;
+
+static const LLVM_Variable * find_LLVM_variable(const LLVM_Context * context, const Token name) {
+  // the most recent declaration first
+  for (int i = context->variables_count -1; i >= 0; i--) {
+    if (compare_str_of_tokens(context->variables[i].name, name)) {
+      return &context->variables[i];
+    }
+  }
+  implementation_error("could not find variable in the LLVM IR generation");
+  // unreachable
+  return NULL;
+}
+
+static const LLVM_Variable * add_LLVM_variable(LLVM_Context * context, const Token name, const Node_Type type, const bool is_constant) {
+  if (context->variables_count == context->variables_capacity) {
+    context->variables_capacity = context->variables_capacity == 0 ? 64 : 2 * context->variables_capacity;
+    context->variables = srealloc(context->variables, context->variables_capacity * sizeof(*context->variables));
+  }
+  context->variables[context->variables_count] = (LLVM_Variable) {
+    .name = name,
+    .type = type,
+    .number = context->variables_numbers_count++,
+    .is_constant = is_constant
+  };
+  return &context->variables[context->variables_count++];
+}
+
+static bool is_LLVM_narrow_integer(const Node_Type type) {
+  return type.type_type == type_primitive_type && get_size_of_type(type) < U64_sz;
+}
+
+static void gen_LLVM_type(FILE * file_ptr, const Node_Type type) {
+  switch (type.type_type) {
+    case type_primitive_type:
+      fprintf(file_ptr, "i%d", 8 * get_size_of_type(type));
+      break;
+
+    case type_ptr_type:
+      add_string_to_file(file_ptr, "ptr");
+      break;
+
+    case type_array_type:
+      fprintf(file_ptr, "[%d x ", (int) get_array_type(type)->elements_count.value);
+      gen_LLVM_type(file_ptr, *get_type(get_array_type(type)->primitive_type));
+      add_string_to_file(file_ptr, "]");
+      break;
+  }
+}
+
+// returns true if the values of the types have the same memory
+static bool is_same_LLVM_type(const Node_Type type1, const Node_Type type2) {
+  if (type1.type_type != type2.type_type) {
+    return false;
+  }
+  switch (type1.type_type) {
+    case type_primitive_type:
+      return get_size_of_type(type1) == get_size_of_type(type2);
+
+    case type_ptr_type:
+      return true;
+
+    case type_array_type:
+      return get_array_type(type1)->elements_count.value == get_array_type(type2)->elements_count.value
+          && is_same_LLVM_type(*get_type(get_array_type(type1)->primitive_type), *get_type(get_array_type(type2)->primitive_type));
+  }
+  return false;
+}
+
+static void gen_LLVM_value(FILE * file_ptr, const LLVM_Value value) {
+  switch (value.kind) {
+    case llvm_value_number:
+      // the numbers are signed in LLVM IR, the bits are the same
+      fprintf(file_ptr, "%lld", (long long) value.number);
+      break;
+
+    case llvm_value_temporary:
+      fprintf(file_ptr, "%%t%llu", (unsigned long long) value.number);
+      break;
+
+    case llvm_value_variable:
+      fprintf(file_ptr, value.variable->is_constant ? "@%.*s.%d" : "%%%.*s.%d",
+              value.variable->name.length, value.variable->name.beginning, value.variable->number);
+      break;
+  }
+}
+
+// returns a new temporary, its instruction is written after it
+static LLVM_Value new_LLVM_temporary(FILE * file_ptr, LLVM_Context * context, const Node_Type type) {
+  const LLVM_Value temporary = { .kind = llvm_value_temporary, .number = context->temporaries_count++, .variable = NULL, .type = type };
+  add_string_to_file(file_ptr, "  ");
+  gen_LLVM_value(file_ptr, temporary);
+  add_string_to_file(file_ptr, " = ");
+  return temporary;
+}
+
+static int new_LLVM_label(LLVM_Context * context) {
+  return context->labels_count++;
+}
+
+static void gen_LLVM_label(FILE * file_ptr, const int label) {
+  fprintf(file_ptr, "L%d:\n", label);
+}
+
+// the memory of an array literal that is not given to a variable, in the entry block
+static LLVM_Value new_LLVM_alloca(LLVM_Context * context, const Node_Type type) {
+  const LLVM_Value address = new_LLVM_temporary(context->allocas, context, type);
+  add_string_to_file(context->allocas, "alloca ");
+  gen_LLVM_type(context->allocas, type);
+  add_string_to_file(context->allocas, "\n");
+  return address;
+}
+
+static Node_Type get_LLVM_type_of_expresion(const LLVM_Context * context, const Node_Expresion expresion) {
+  switch (expresion.expresion_type) {
+    case expresion_number_type:
+      return get_literal_type();
+
+    case expresion_identifier_type:
+      return find_LLVM_variable(context, expresion.expresion_value.expresion_identifier_value)->type;
+
+    case expresion_binary_operation_type: {
+      const Node_Binary_Operation operation = *get_binary_operation(expresion);
+      if (operation.operation_type == binary_operation_access_type) {
+        return *get_type(get_array_type(get_LLVM_type_of_expresion(context, operation.left_side))->primitive_type);
+      }
+      // the operations work with u64
+      return get_literal_type();
+    }
+
+    case expresion_unary_operation_type: {
+      const Node_Unary_Operation operation = *get_unary_operation(expresion);
+      const Node_Type operand_type = get_LLVM_type_of_expresion(context, operation.expresion);
+      if (operation.operation_type == unary_operation_addr_type) {
+        return (Node_Type) { .token = NULL_TOKEN, .type_type = type_ptr_type, .type_value.type_ptr_value = add_type(operand_type) };
+      }
+      return *get_pointed_type(operand_type);
+    }
+
+    case expresion_array_type: {
+      const Node_Array array = expresion.expresion_value.expresion_array_value;
+      Node_Type element_type = get_LLVM_type_of_expresion(context, get_array_elements(array)[0]);
+      // the integers inside an array literal are u64
+      if (element_type.type_type == type_primitive_type) {
+        element_type = get_literal_type();
+      }
+      Node_Type type = { .token = NULL_TOKEN, .type_type = type_array_type };
+      type.type_value.type_array_value = add_array_type((Node_Array_type) { .primitive_type = add_type(element_type) });
+      get_array_type(type)->elements_count = get_number_token(array.elements_count);
+      return type;
+    }
+  }
+  implementation_error("unkown type of expresion while trying to get its type in the LLVM IR generation");
+  return (Node_Type) {};
+}
+
+// returns the address of the element of the array
+static LLVM_Value gen_LLVM_element_address(FILE * file_ptr, LLVM_Context * context, const LLVM_Value array, const LLVM_Value index) {
+  const Node_Type element_type = *get_type(get_array_type(array.type)->primitive_type);
+  const LLVM_Value address = new_LLVM_temporary(file_ptr, context, element_type);
+  add_string_to_file(file_ptr, "getelementptr inbounds ");
+  gen_LLVM_type(file_ptr, array.type);
+  add_string_to_file(file_ptr, ", ptr ");
+  gen_LLVM_value(file_ptr, array);
+  add_string_to_file(file_ptr, ", i64 0, i64 ");
+  gen_LLVM_value(file_ptr, index);
+  add_string_to_file(file_ptr, "\n");
+  return address;
+}
+
+// returns the value of the type in the memory of the address, the integers are extended to i64
+// and the arrays are the address itself
+static LLVM_Value gen_LLVM_load(FILE * file_ptr, LLVM_Context * context, const LLVM_Value address, const Node_Type type) {
+  if (type.type_type == type_array_type) {
+    LLVM_Value array = address;
+    array.type = type;
+    return array;
+  }
+  LLVM_Value value = new_LLVM_temporary(file_ptr, context, type.type_type == type_ptr_type ? type : get_literal_type());
+  add_string_to_file(file_ptr, "load ");
+  gen_LLVM_type(file_ptr, type);
+  add_string_to_file(file_ptr, ", ptr ");
+  gen_LLVM_value(file_ptr, address);
+  add_string_to_file(file_ptr, "\n");
+  if (is_LLVM_narrow_integer(type)) {
+    const LLVM_Value narrow_value = value;
+    value = new_LLVM_temporary(file_ptr, context, get_literal_type());
+    add_string_to_file(file_ptr, "zext ");
+    gen_LLVM_type(file_ptr, type);
+    add_string_to_file(file_ptr, " ");
+    gen_LLVM_value(file_ptr, narrow_value);
+    add_string_to_file(file_ptr, " to i64\n");
+  }
+  return value;
+}
+
+// the failed index checks call the function of the error, at the place of the index
+static void gen_LLVM_index_check(FILE * file_ptr, LLVM_Context * context, const Node_Expresion access, const LLVM_Value index, const int length) {
+  context->index_checks_count++;
+  if (is_index_in_range(context->index_bounds, access, length)) {
+    context->removed_index_checks_count++;
+    return;
+  }
+  const LLVM_Value is_out_of_range = new_LLVM_temporary(file_ptr, context, get_literal_type());
+  add_string_to_file(file_ptr, "icmp uge i64 ");
+  gen_LLVM_value(file_ptr, index);
+  fprintf(file_ptr, ", %d\n", length);
+  const int error_label = new_LLVM_label(context);
+  const int next_label = new_LLVM_label(context);
+  add_string_to_file(file_ptr, "  br i1 ");
+  gen_LLVM_value(file_ptr, is_out_of_range);
+  fprintf(file_ptr, ", label %%L%d, label %%L%d\n", error_label, next_label);
+  gen_LLVM_label(file_ptr, error_label);
+  const Token_place place = get_token_place(get_first_token_of_expresion(get_binary_operation(access)->right_side));
+  fprintf(file_ptr, "  call void @index_error(i32 %d, i32 %d)\n", place.line_number, place.column_number);
+  add_string_to_file(file_ptr, "  unreachable\n");
+  gen_LLVM_label(file_ptr, next_label);
+}
+
+static void gen_LLVM_store(FILE * file_ptr, LLVM_Context * context, const Node_Expresion expresion, const LLVM_Value address, const Node_Type type);
+
+static LLVM_Value gen_LLVM_expresion(FILE * file_ptr, LLVM_Context * context, const Node_Expresion expresion) {
+  switch (expresion.expresion_type) {
+    case expresion_number_type:
+      return (LLVM_Value) {
+        .kind = llvm_value_number, .number = expresion.expresion_value.expresion_number_value.value, .variable = NULL, .type = get_literal_type()
+      };
+
+    case expresion_identifier_type: {
+      const LLVM_Variable * variable = find_LLVM_variable(context, expresion.expresion_value.expresion_identifier_value);
+      const LLVM_Value address = { .kind = llvm_value_variable, .number = 0, .variable = variable, .type = variable->type };
+      return gen_LLVM_load(file_ptr, context, address, variable->type);
+    }
+
+    case expresion_binary_operation_type: {
+      const Node_Binary_Operation operation = *get_binary_operation(expresion);
+      const LLVM_Value left_side = gen_LLVM_expresion(file_ptr, context, operation.left_side);
+      const LLVM_Value right_side = gen_LLVM_expresion(file_ptr, context, operation.right_side);
+      if (operation.operation_type == binary_operation_access_type) {
+        const int length = (int) get_array_type(left_side.type)->elements_count.value;
+        if (is_bounds_checking) {
+          gen_LLVM_index_check(file_ptr, context, expresion, right_side, length);
+        }
+        const LLVM_Value address = gen_LLVM_element_address(file_ptr, context, left_side, right_side);
+        return gen_LLVM_load(file_ptr, context, address, address.type);
+      }
+      const char * instruction = NULL;
+      const char * comparison = NULL;
+      switch (operation.operation_type) {
+        case binary_operation_sum_type: instruction = "add"; break;
+        case binary_operation_sub_type: instruction = "sub"; break;
+        case binary_operation_mul_type: instruction = "mul"; break;
+        case binary_operation_div_type: instruction = "udiv"; break;
+        case binary_operation_mod_type: instruction = "urem"; break;
+        case binary_operation_big_type: comparison = "ugt"; break;
+        case binary_operation_les_type: comparison = "ult"; break;
+        case binary_operation_equ_type: comparison = "eq"; break;
+        default:
+          implementation_error("exponentation not implemented");
+          break;
+      }
+      LLVM_Value result = new_LLVM_temporary(file_ptr, context, get_literal_type());
+      if (comparison != NULL) {
+        fprintf(file_ptr, "icmp %s i64 ", comparison);
+      }
+      else {
+        fprintf(file_ptr, "%s i64 ", instruction);
+      }
+      gen_LLVM_value(file_ptr, left_side);
+      add_string_to_file(file_ptr, ", ");
+      gen_LLVM_value(file_ptr, right_side);
+      add_string_to_file(file_ptr, "\n");
+      if (comparison != NULL) {
+        // the comparisons are 0 or 1
+        const LLVM_Value bit = result;
+        result = new_LLVM_temporary(file_ptr, context, get_literal_type());
+        add_string_to_file(file_ptr, "zext i1 ");
+        gen_LLVM_value(file_ptr, bit);
+        add_string_to_file(file_ptr, " to i64\n");
+      }
+      return result;
+    }
+
+    case expresion_unary_operation_type: {
+      const Node_Unary_Operation operation = *get_unary_operation(expresion);
+      if (operation.operation_type == unary_operation_addr_type) {
+        // the address of a variable is its alloca
+        const LLVM_Variable * variable = find_LLVM_variable(context, operation.expresion.expresion_value.expresion_identifier_value);
+        return (LLVM_Value) {
+          .kind = llvm_value_variable, .number = 0, .variable = variable, .type = get_LLVM_type_of_expresion(context, expresion)
+        };
+      }
+      const LLVM_Value pointer = gen_LLVM_expresion(file_ptr, context, operation.expresion);
+      return gen_LLVM_load(file_ptr, context, pointer, *get_pointed_type(pointer.type));
+    }
+
+    case expresion_array_type: {
+      const Node_Type type = get_LLVM_type_of_expresion(context, expresion);
+      const LLVM_Value address = new_LLVM_alloca(context, type);
+      gen_LLVM_store(file_ptr, context, expresion, address, type);
+      return address;
+    }
+  }
+  implementation_error("unkown type of expresion in the LLVM IR generation");
+  return (LLVM_Value) {};
+}
+
+// copies the array into the memory of an array of the type, the arrays of other integers are converted element by element
+static void gen_LLVM_array_copy(FILE * file_ptr, LLVM_Context * context, const LLVM_Value array, const LLVM_Value address, const Node_Type type) {
+  if (is_same_LLVM_type(array.type, type)) {
+    // the arrays can be copied into themselves
+    add_string_to_file(file_ptr, "  call void @llvm.memmove.p0.p0.i64(ptr ");
+    gen_LLVM_value(file_ptr, address);
+    add_string_to_file(file_ptr, ", ptr ");
+    gen_LLVM_value(file_ptr, array);
+    fprintf(file_ptr, ", i64 %d, i1 false)\n", get_size_of_type(type));
+    return;
+  }
+  LLVM_Value destination = address;
+  destination.type = type;
+  for (int i = 0; i < (int) get_array_type(type)->elements_count.value; i++) {
+    const LLVM_Value index = { .kind = llvm_value_number, .number = i, .variable = NULL, .type = get_literal_type() };
+    const LLVM_Value source_element = gen_LLVM_element_address(file_ptr, context, array, index);
+    const LLVM_Value destination_element = gen_LLVM_element_address(file_ptr, context, destination, index);
+    const LLVM_Value element = gen_LLVM_load(file_ptr, context, source_element, source_element.type);
+    if (destination_element.type.type_type == type_array_type) {
+      gen_LLVM_array_copy(file_ptr, context, element, destination_element, destination_element.type);
+      continue;
+    }
+    LLVM_Value stored = element;
+    if (is_LLVM_narrow_integer(destination_element.type)) {
+      stored = new_LLVM_temporary(file_ptr, context, destination_element.type);
+      add_string_to_file(file_ptr, "trunc i64 ");
+      gen_LLVM_value(file_ptr, element);
+      add_string_to_file(file_ptr, " to ");
+      gen_LLVM_type(file_ptr, destination_element.type);
+      add_string_to_file(file_ptr, "\n");
+    }
+    add_string_to_file(file_ptr, "  store ");
+    gen_LLVM_type(file_ptr, destination_element.type);
+    add_string_to_file(file_ptr, " ");
+    gen_LLVM_value(file_ptr, stored);
+    add_string_to_file(file_ptr, ", ptr ");
+    gen_LLVM_value(file_ptr, destination_element);
+    add_string_to_file(file_ptr, "\n");
+  }
+}
+
+// stores the value of the expression in the memory of the address, that has the type,
+// the elements of the array literals are stored one by one and the integers are cut to their size
+static void gen_LLVM_store(FILE * file_ptr, LLVM_Context * context, const Node_Expresion expresion, const LLVM_Value address, const Node_Type type) {
+  if (type.type_type == type_array_type && expresion.expresion_type == expresion_array_type) {
+    const Node_Array array = expresion.expresion_value.expresion_array_value;
+    LLVM_Value destination = address;
+    destination.type = type;
+    for (int i = 0; i < array.elements_count; i++) {
+      const LLVM_Value index = { .kind = llvm_value_number, .number = i, .variable = NULL, .type = get_literal_type() };
+      const LLVM_Value element_address = gen_LLVM_element_address(file_ptr, context, destination, index);
+      gen_LLVM_store(file_ptr, context, get_array_elements(array)[i], element_address, element_address.type);
+    }
+    return;
+  }
+  LLVM_Value value = gen_LLVM_expresion(file_ptr, context, expresion);
+  if (type.type_type == type_array_type) {
+    gen_LLVM_array_copy(file_ptr, context, value, address, type);
+    return;
+  }
+  if (is_LLVM_narrow_integer(type)) {
+    const LLVM_Value wide_value = value;
+    value = new_LLVM_temporary(file_ptr, context, type);
+    add_string_to_file(file_ptr, "trunc i64 ");
+    gen_LLVM_value(file_ptr, wide_value);
+    add_string_to_file(file_ptr, " to ");
+    gen_LLVM_type(file_ptr, type);
+    add_string_to_file(file_ptr, "\n");
+  }
+  add_string_to_file(file_ptr, "  store ");
+  gen_LLVM_type(file_ptr, type);
+  add_string_to_file(file_ptr, " ");
+  gen_LLVM_value(file_ptr, value);
+  add_string_to_file(file_ptr, ", ptr ");
+  gen_LLVM_value(file_ptr, address);
+  add_string_to_file(file_ptr, "\n");
+}
+
+// the numbers of a constant table, cut to the size of its integers
+static void gen_LLVM_constant(FILE * file_ptr, const Node_Expresion expresion, const Node_Type type) {
+  gen_LLVM_type(file_ptr, type);
+  add_string_to_file(file_ptr, " ");
+  if (type.type_type != type_array_type) {
+    const int bits = 8 * get_size_of_type(type);
+    const uint64_t number = expresion.expresion_value.expresion_number_value.value;
+    // the numbers are signed in LLVM IR
+    const int64_t value = bits == 64 ? (int64_t) number : (int64_t) (number << (64 - bits)) >> (64 - bits);
+    fprintf(file_ptr, "%lld", (long long) value);
+    return;
+  }
+  const Node_Array array = expresion.expresion_value.expresion_array_value;
+  const Node_Type element_type = *get_type(get_array_type(type)->primitive_type);
+  add_string_to_file(file_ptr, "[");
+  for (int i = 0; i < array.elements_count; i++) {
+    if (i > 0) {
+      add_string_to_file(file_ptr, ", ");
+    }
+    gen_LLVM_constant(file_ptr, get_array_elements(array)[i], element_type);
+  }
+  add_string_to_file(file_ptr, "]");
+}
+
+// generates the condition and a branch to the label when it is false, the code after it is of the label when it is true
+static void gen_LLVM_condition(FILE * file_ptr, LLVM_Context * context, const Node_Expresion condition, const int true_label, const int false_label) {
+  const LLVM_Value value = gen_LLVM_expresion(file_ptr, context, condition);
+  const LLVM_Value is_true = new_LLVM_temporary(file_ptr, context, get_literal_type());
+  add_string_to_file(file_ptr, "icmp ne i64 ");
+  gen_LLVM_value(file_ptr, value);
+  add_string_to_file(file_ptr, ", 0\n");
+  add_string_to_file(file_ptr, "  br i1 ");
+  gen_LLVM_value(file_ptr, is_true);
+  fprintf(file_ptr, ", label %%L%d, label %%L%d\n", true_label, false_label);
+  gen_LLVM_label(file_ptr, true_label);
+}
+
+static void gen_LLVM_statement(FILE * file_ptr, LLVM_Context * context, const Node_Statement stmt);
+
+// the variables declared inside a block are forgotten at its end
+static void gen_LLVM_block(FILE * file_ptr, LLVM_Context * context, const Node_Scope scope) {
+  const int variables_count = context->variables_count;
+  for (int i = 0; i < scope.statements_count; i++) {
+    gen_LLVM_statement(file_ptr, context, get_scope_statements(scope)[i]);
+  }
+  context->variables_count = variables_count;
+}
+
+static void gen_LLVM_statement(FILE * file_ptr, LLVM_Context * context, const Node_Statement stmt) {
+  switch (stmt.statement_type) {
+    case var_declaration_type: {
+      const Node_Var_declaration declaration = stmt.statement_value.var_declaration;
+      // the constant tables are initialized once before the program runs
+      if (is_constant_array_declaration(context->program, declaration)) {
+        const LLVM_Variable * variable = add_LLVM_variable(context, declaration.var_name, declaration.type, true);
+        fprintf(context->constants, "@%.*s.%d = private unnamed_addr constant ", declaration.var_name.length, declaration.var_name.beginning,
+                variable->number);
+        gen_LLVM_constant(context->constants, declaration.value, declaration.type);
+        add_string_to_file(context->constants, "\n");
+        break;
+      }
+      const LLVM_Variable * variable = add_LLVM_variable(context, declaration.var_name, declaration.type, false);
+      const LLVM_Value address = { .kind = llvm_value_variable, .number = 0, .variable = variable, .type = declaration.type };
+      add_string_to_file(context->allocas, "  ");
+      gen_LLVM_value(context->allocas, address);
+      add_string_to_file(context->allocas, " = alloca ");
+      gen_LLVM_type(context->allocas, declaration.type);
+      add_string_to_file(context->allocas, "\n");
+      gen_LLVM_store(file_ptr, context, declaration.value, address, declaration.type);
+      break;
+    }
+
+    case var_assignment_type: {
+      const Node_Var_assignment assignment = stmt.statement_value.var_assignment;
+      const LLVM_Variable * variable = find_LLVM_variable(context, assignment.var_name);
+      const LLVM_Value address = { .kind = llvm_value_variable, .number = 0, .variable = variable, .type = variable->type };
+      if (variable->type.type_type == type_array_type && assignment.value.expresion_type == expresion_array_type) {
+        // the elements can use the variable, so the new value is only copied into it at the end
+        const LLVM_Value value = new_LLVM_alloca(context, variable->type);
+        gen_LLVM_store(file_ptr, context, assignment.value, value, variable->type);
+        gen_LLVM_array_copy(file_ptr, context, value, address, variable->type);
+        break;
+      }
+      gen_LLVM_store(file_ptr, context, assignment.value, address, variable->type);
+      break;
+    }
+
+    case exit_node_type: {
+      const LLVM_Value exit_code = gen_LLVM_expresion(file_ptr, context, stmt.statement_value.exit_node.exit_code);
+      const LLVM_Value status = new_LLVM_temporary(file_ptr, context, get_literal_type());
+      add_string_to_file(file_ptr, "trunc i64 ");
+      gen_LLVM_value(file_ptr, exit_code);
+      add_string_to_file(file_ptr, " to i32\n");
+      add_string_to_file(file_ptr, "  call void @exit(i32 ");
+      gen_LLVM_value(file_ptr, status);
+      add_string_to_file(file_ptr, ")\n");
+      add_string_to_file(file_ptr, "  unreachable\n");
+      // the statements after it are in a block that is never reached
+      gen_LLVM_label(file_ptr, new_LLVM_label(context));
+      break;
+    }
+
+    case print_type: {
+      const LLVM_Value character = gen_LLVM_expresion(file_ptr, context, stmt.statement_value.print.chr);
+      const LLVM_Value byte = new_LLVM_temporary(file_ptr, context, get_literal_type());
+      add_string_to_file(file_ptr, "and i64 ");
+      gen_LLVM_value(file_ptr, character);
+      add_string_to_file(file_ptr, ", 255\n");
+      const LLVM_Value argument = new_LLVM_temporary(file_ptr, context, get_literal_type());
+      add_string_to_file(file_ptr, "trunc i64 ");
+      gen_LLVM_value(file_ptr, byte);
+      add_string_to_file(file_ptr, " to i32\n");
+      add_string_to_file(file_ptr, "  call i32 @putchar(i32 ");
+      gen_LLVM_value(file_ptr, argument);
+      add_string_to_file(file_ptr, ")\n");
+      break;
+    }
+
+    case scope_type:
+      gen_LLVM_block(file_ptr, context, stmt.statement_value.scope);
+      break;
+
+    case if_type: {
+      const Node_If if_node = stmt.statement_value.if_node;
+      const int if_label = new_LLVM_label(context);
+      const int else_label = new_LLVM_label(context);
+      const int end_label = if_node.has_else_block ? new_LLVM_label(context) : else_label;
+      gen_LLVM_condition(file_ptr, context, if_node.condition, if_label, else_label);
+      gen_LLVM_block(file_ptr, context, if_node.scope);
+      fprintf(file_ptr, "  br label %%L%d\n", end_label);
+      if (if_node.has_else_block) {
+        gen_LLVM_label(file_ptr, else_label);
+        gen_LLVM_block(file_ptr, context, if_node.else_block);
+        fprintf(file_ptr, "  br label %%L%d\n", end_label);
+      }
+      gen_LLVM_label(file_ptr, end_label);
+      break;
+    }
+
+    case while_type: {
+      const Node_While while_node = stmt.statement_value.while_node;
+      const int condition_label = new_LLVM_label(context);
+      const int body_label = new_LLVM_label(context);
+      const int end_label = new_LLVM_label(context);
+      fprintf(file_ptr, "  br label %%L%d\n", condition_label);
+      gen_LLVM_label(file_ptr, condition_label);
+      gen_LLVM_condition(file_ptr, context, while_node.condition, body_label, end_label);
+      gen_LLVM_block(file_ptr, context, while_node.scope);
+      fprintf(file_ptr, "  br label %%L%d\n", condition_label);
+      gen_LLVM_label(file_ptr, end_label);
+      break;
+    }
+  }
+}
+
+// the functions of the C library and of LLVM that the programs use
+static const char * LLVM_declarations =
+  "declare i32 @putchar(i32)\n"
+  "declare void @exit(i32) noreturn\n"
+  "declare i32 @printf(ptr, ...)\n"
+  "declare void @llvm.memmove.p0.p0.i64(ptr, ptr, i64, i1)\n";
+
+// the failed index checks print the error of the place of the index and exit with 1
+static const char * LLVM_index_error =
+  "@index_error_message = private unnamed_addr constant [72 x i8] c\"Line:%d, column:%d.  Error: the index is out of the range of the array\\0A\\00\"\n"
+  "define private void @index_error(i32 %line, i32 %column) noreturn cold noinline {\n"
+  "  call i32 (ptr, ...) @printf(ptr @index_error_message, i32 %line, i32 %column)\n"
+  "  call void @exit(i32 1)\n"
+  "  unreachable\n"
+  "}\n";
+
+// it generates LLVM IR code into the file
+void gen_LLVM_code(const Node_Program syntax_tree, FILE * out_file_ptr) {
+  LLVM_Context context = {
+    .temporaries_count = 0, .labels_count = 0, .variables_numbers_count = 0,
+    .variables = NULL, .variables_count = 0, .variables_capacity = 0,
+    .program = &syntax_tree,
+    .index_bounds = { .bounds_count = 0, .bounds = smalloc(0) }, .index_checks_count = 0, .removed_index_checks_count = 0
+  };
+  context.allocas = open_memstream(&context.allocas_text, &context.allocas_size);
+  context.constants = open_memstream(&context.constants_text, &context.constants_size);
+  char * code_text;
+  size_t code_size;
+  FILE * code = open_memstream(&code_text, &code_size);
+  if (context.allocas == NULL || context.constants == NULL || code == NULL) {
+    implementation_error("can not create the streams of the LLVM IR generation");
+  }
+  if (is_bounds_checking) {
+    free_index_bounds(context.index_bounds);
+    context.index_bounds = analyze_index_bounds(syntax_tree.statements_node, syntax_tree.statements_count);
+  }
+  for (int i = 0; i < syntax_tree.statements_count; i++) {
+    gen_LLVM_statement(code, &context, syntax_tree.statements_node[i]);
+  }
+  add_string_to_file(code, "  ret i32 0\n");
+  fclose(context.allocas);
+  fclose(context.constants);
+  fclose(code);
+
+  add_string_to_file(out_file_ptr, LLVM_declarations);
+  if (is_bounds_checking) {
+    add_string_to_file(out_file_ptr, LLVM_index_error);
+  }
+  fwrite(context.constants_text, 1, context.constants_size, out_file_ptr);
+  add_string_to_file(out_file_ptr, "define i32 @main() {\nentry:\n");
+  fwrite(context.allocas_text, 1, context.allocas_size, out_file_ptr);
+  fwrite(code_text, 1, code_size, out_file_ptr);
+  add_string_to_file(out_file_ptr, "}\n");
+  free(context.allocas_text);
+  free(context.constants_text);
+  free(code_text);
+  sfree(context.variables);
+  free_index_bounds(context.index_bounds);
+  if (is_bounds_checking) {
+    report_removed_index_checks(context.index_checks_count, context.removed_index_checks_count);
+  }
+}
+
+#endif
@@ -4,11 +4,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 
 
 // predefine symbols
 void * smalloc(size_t);
 void * srealloc(void *, size_t);
+void sfree(void *);
 char * file_contents(const char *);
 const char * get_file_extension(const char *);
 
@@ -16,10 +18,142 @@ const char * get_file_extension(const char *);
 #include "errors.h"
 
 
+/* * * * * * * * * * * *
+ * Arena memory allocator *
+ * * * * * * * * * * * * */
+
+// size of the blocks the arena asks to the system
+#define ARENA_BLOCK_SIZE (1 << 20)
+// every allocation is aligned to this, it is enough for every type used in the compiler
+#define ARENA_ALIGNMENT 16
+
+typedef struct Arena_block {
+  struct Arena_block * next;
+  size_t size;
+  size_t used;
+  // keeps the data aligned
+  alignas(ARENA_ALIGNMENT) char data[];
+} Arena_block;
+
+// an arena gives memory from big blocks, the memory is never freed individually,
+// instead all of it is reset at once and the blocks are reused for the next allocations
+typedef struct Arena {
+  Arena_block * first;
+  Arena_block * current;
+  // the last allocation, it can grow in place
+  void * last;
+} Arena;
+
+// every allocation in an arena is preceded by its capacity, so it can be reallocated
+typedef struct Arena_header {
+  alignas(ARENA_ALIGNMENT) size_t capacity;
+} Arena_header;
+
+// when it is set smalloc(), srealloc() and sfree() use this arena instead of the system allocator
+// each thread has its own, so the threads do not share the memory of their compilations
+thread_local Arena * active_arena = NULL;
+
+static size_t align_size(size_t nbytes) {
+  return (nbytes + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static Arena_block * new_arena_block(size_t min_size) {
+  size_t size = min_size > ARENA_BLOCK_SIZE ? min_size : ARENA_BLOCK_SIZE;
+  Arena_block * block = malloc(sizeof(Arena_block) + size);
+  if (block == NULL) {
+    errorf("Execution Error: can not allocate memory\n");
+  }
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+Arena create_arena(void) {
+  Arena arena;
+  arena.first = new_arena_block(ARENA_BLOCK_SIZE);
+  arena.current = arena.first;
+  arena.last = NULL;
+  return arena;
+}
+
+void * arena_alloc(Arena * arena, size_t nbytes) {
+  const size_t capacity = align_size(nbytes);
+  const size_t needed = sizeof(Arena_header) + capacity;
+  // look for a block with enough space, reusing the ones left by a reset
+  while (arena->current->used + needed > arena->current->size) {
+    if (arena->current->next == NULL) {
+      arena->current->next = new_arena_block(needed);
+    }
+    arena->current = arena->current->next;
+  }
+  Arena_header * header = (Arena_header *) (arena->current->data + arena->current->used);
+  header->capacity = capacity;
+  arena->current->used += needed;
+  arena->last = header + 1;
+  return arena->last;
+}
+
+void * arena_realloc(Arena * arena, void * ptr, size_t nbytes) {
+  if (ptr == NULL) {
+    return arena_alloc(arena, nbytes);
+  }
+  Arena_header * header = (Arena_header *) ptr - 1;
+  if (nbytes <= header->capacity) {
+    return ptr;
+  }
+  // the last allocation can grow in place if the block has space left
+  const size_t capacity = align_size(nbytes);
+  if (ptr == arena->last && arena->current->used + (capacity - header->capacity) <= arena->current->size) {
+    arena->current->used += capacity - header->capacity;
+    header->capacity = capacity;
+    return ptr;
+  }
+  // otherwise move it to a new place with double the size, so growing it many times is not quadratic
+  void * new_ptr = arena_alloc(arena, capacity > 2 * header->capacity ? capacity : 2 * header->capacity);
+  memcpy(new_ptr, ptr, header->capacity);
+  return new_ptr;
+}
+
+// frees all the memory of the arena at once but keeps the blocks for reusing them
+void reset_arena(Arena * arena) {
+  for (Arena_block * block = arena->first; block != NULL; block = block->next) {
+    block->used = 0;
+  }
+  arena->current = arena->first;
+  arena->last = NULL;
+}
+
+// returns the bytes allocated in the arena since it was created or reset
+size_t arena_used_size(const Arena * arena) {
+  size_t size = 0;
+  for (Arena_block * block = arena->first; block != NULL; block = block->next) {
+    size += block->used;
+  }
+  return size;
+}
+
+// gives back the memory of the blocks to the system
+void destroy_arena(Arena * arena) {
+  Arena_block * block = arena->first;
+  while (block != NULL) {
+    Arena_block * next = block->next;
+    free(block);
+    block = next;
+  }
+  arena->first = NULL;
+  arena->current = NULL;
+  arena->last = NULL;
+}
+
+
 // its like malloc() but it checks that it could allocate memory
 void * smalloc(size_t nbytes) {
+  if (active_arena != NULL) {
+    return arena_alloc(active_arena, nbytes);
+  }
   void * ptr = malloc(nbytes);
-  if (ptr == NULL) {
+  if (ptr == NULL && nbytes != 0) {
     errorf("Execution Error: can not allocate memory\n");
   }
   return ptr;
@@ -27,6 +161,9 @@ void * smalloc(size_t nbytes) {
 
 // its like realloc() but it checks that it could allocate memory
 void * srealloc(void * ptr, size_t nbytes) {
+  if (active_arena != NULL) {
+    return arena_realloc(active_arena, ptr, nbytes);
+  }
   void * new_ptr = realloc(ptr, nbytes);
   if (new_ptr == NULL) {
     errorf("Execution Error: can not reallocate memory\n");
@@ -34,6 +171,171 @@ void * srealloc(void * ptr, size_t nbytes) {
   return new_ptr;
 }
 
+// its like free() but the memory of an arena is only freed when the arena is reset
+void sfree(void * ptr) {
+  if (active_arena == NULL) {
+    free(ptr);
+  }
+}
+
+
+/* * * * * * * * * * * * * * * *
+ * Pools of items of one size  *
+ * * * * * * * * * * * * * * * */
+
+// a pool keeps items of the same size in blocks and they are referenced by their index,
+// the blocks are never moved, so the pointers to the items stay valid while the pool grows,
+// and every block is twice as large as the one before it
+#define POOL_FIRST_BLOCK_SIZE 16
+#define POOL_MAX_BLOCKS 28
+
+typedef struct Pool {
+  size_t item_size;
+  uint32_t items_count;
+  char * blocks[POOL_MAX_BLOCKS];
+  // the first blocks can be in memory that is not owned by the pool, see map_pool()
+  int mapped_blocks_count;
+} Pool;
+
+Pool create_pool(size_t item_size) {
+  Pool pool = { .item_size = item_size, .items_count = 0, .mapped_blocks_count = 0 };
+  for (int i = 0; i < POOL_MAX_BLOCKS; i++) {
+    pool.blocks[i] = NULL;
+  }
+  return pool;
+}
+
+// the block k has the items from POOL_FIRST_BLOCK_SIZE * (2^k - 1)
+static int get_pool_block(const uint32_t idx, uint32_t * offset) {
+  const uint64_t position = (uint64_t) idx / POOL_FIRST_BLOCK_SIZE + 1;
+  const int block = 63 - __builtin_clzll(position);
+  *offset = idx - (uint32_t) (POOL_FIRST_BLOCK_SIZE * ((1ull << block) - 1));
+  return block;
+}
+
+static inline void * get_pool_item(const Pool * pool, const uint32_t idx) {
+  uint32_t offset;
+  const int block = get_pool_block(idx, &offset);
+  return pool->blocks[block] + offset * pool->item_size;
+}
+
+static uint64_t get_pool_block_size(const int block) {
+  return (uint64_t) POOL_FIRST_BLOCK_SIZE << block;
+}
+
+// copies the items one after the other in the same block and returns the index of the first one,
+// so they can be used as an array, the places left at the end of the blocks that are skipped are not used
+uint32_t append_pool_items(Pool * pool, const void * items, const uint32_t items_count) {
+  if (items_count == 0) {
+    return pool->items_count;
+  }
+  uint32_t offset;
+  int block = get_pool_block(pool->items_count, &offset);
+  uint64_t idx = pool->items_count;
+  while (block < POOL_MAX_BLOCKS && offset + (uint64_t) items_count > get_pool_block_size(block)) {
+    // clear the places skipped, so the pool is written the same way every time
+    if (pool->blocks[block] != NULL) {
+      memset(pool->blocks[block] + offset * pool->item_size, 0, (get_pool_block_size(block) - offset) * pool->item_size);
+    }
+    idx += get_pool_block_size(block) - offset;
+    block++;
+    offset = 0;
+  }
+  if (block >= POOL_MAX_BLOCKS || idx + items_count > UINT32_MAX) {
+    error("too many items in a pool, the program is too large");
+  }
+  if (pool->blocks[block] == NULL) {
+    pool->blocks[block] = smalloc(get_pool_block_size(block) * pool->item_size);
+  }
+  memcpy(pool->blocks[block] + offset * pool->item_size, items, items_count * pool->item_size);
+  pool->items_count = idx + items_count;
+  return idx;
+}
+
+// copies the item to the end of the pool and returns its index
+uint32_t append_pool_item(Pool * pool, const void * item) {
+  return append_pool_items(pool, item, 1);
+}
+
+// forgets the items from the index, their blocks are reused by the next ones
+void truncate_pool(Pool * pool, const uint32_t items_count) {
+  if (items_count < pool->items_count) {
+    pool->items_count = items_count;
+  }
+}
+
+void destroy_pool(Pool * pool) {
+  for (int i = 0; i < POOL_MAX_BLOCKS; i++) {
+    if (i >= pool->mapped_blocks_count) {
+      sfree(pool->blocks[i]);
+    }
+    pool->blocks[i] = NULL;
+  }
+  pool->items_count = 0;
+  pool->mapped_blocks_count = 0;
+}
+
+// makes a pool that reads the items of the pool without copying them, the items added to it go to
+// blocks of its own after the last one of the pool, so both pools can add items at the same time
+Pool fork_pool(const Pool * pool) {
+  Pool fork = create_pool(pool->item_size);
+  if (pool->items_count > 0) {
+    uint32_t offset;
+    const int last_block = get_pool_block(pool->items_count -1, &offset);
+    for (int i = 0; i <= last_block; i++) {
+      fork.blocks[i] = pool->blocks[i];
+    }
+    fork.mapped_blocks_count = last_block + 1;
+    fork.items_count = POOL_FIRST_BLOCK_SIZE * ((1ull << (last_block + 1)) - 1);
+  }
+  return fork;
+}
+
+// writes the items of the pool one after the other, the places of the blocks that were skipped are zeros
+void write_pool(FILE * file_ptr, const Pool * pool) {
+  static const char zeros[256] = {0};
+  uint64_t written_count = 0;
+  for (int block = 0; written_count < pool->items_count; block++) {
+    uint64_t count = get_pool_block_size(block);
+    if (written_count + count > pool->items_count) {
+      count = pool->items_count - written_count;
+    }
+    if (pool->blocks[block] != NULL) {
+      fwrite(pool->blocks[block], pool->item_size, count, file_ptr);
+    }
+    else {
+      uint64_t size = count * pool->item_size;
+      while (size > 0) {
+        const size_t chunk_size = size < sizeof(zeros) ? size : sizeof(zeros);
+        fwrite(zeros, 1, chunk_size, file_ptr);
+        size -= chunk_size;
+      }
+    }
+    written_count += count;
+  }
+}
+
+// makes a pool with the items of an array written by write_pool(), the blocks that are whole
+// in the array use its memory without copying it, and the last one is copied so more items can be added
+Pool map_pool(const size_t item_size, char * items, const uint32_t items_count) {
+  Pool pool = create_pool(item_size);
+  uint64_t mapped_count = 0;
+  for (int block = 0; mapped_count < items_count; block++) {
+    const uint64_t block_size = get_pool_block_size(block);
+    if (mapped_count + block_size <= items_count) {
+      pool.blocks[block] = items + mapped_count * item_size;
+      pool.mapped_blocks_count = block + 1;
+    }
+    else {
+      pool.blocks[block] = smalloc(block_size * item_size);
+      memcpy(pool.blocks[block], items + mapped_count * item_size, (items_count - mapped_count) * item_size);
+    }
+    mapped_count += block_size;
+  }
+  pool.items_count = items_count;
+  return pool;
+}
+
 static int file_size(FILE * file) {
   fseek(file, 0, SEEK_END);
   int size = ftell(file);
@@ -68,15 +370,19 @@ FILE * create_file(const char * file_name) {
 }
 
 // returns a ptr to the beginning of the extension in the string
-// the extension start at the last dot in the file name, including the dot
+// the extension start at the last dot in the file name, including the dot,
+// the dots of the directories in the path are not part of the name
 const char * get_file_extension(const char * file_name) {
   const char * last_dot = NULL;
   int i;
   for (i = 0; file_name[i] != '\0'; i++) {
-    // find the last dot
+    // find the last dot after the last slash
     if (file_name[i] == '.') {
       last_dot = file_name + i;
     }
+    else if (file_name[i] == '/') {
+      last_dot = NULL;
+    }
   }
   // didnt find any dots in the name
   if (last_dot == NULL) {
@@ -1,6 +1,8 @@
 #ifndef PARSER_H_
 #define PARSER_H_
 
+#include <limits.h>
+
 #include "errors.h"
 #include "mlib.h"
 #include "tokenizer.h"
@@ -8,8 +10,13 @@
 // some near positive infinity number
 #define BIG_NUM 999999
 
+// the nodes of the syntax trees are not allocated one by one, they are kept in pools by their type
+// and they reference each other by their index in the pool, see Node_pools
+typedef uint32_t Node_index;
+
 typedef struct Node_Array_type {
-  struct Node_Type * primitive_type;
+  // index in the types pool
+  Node_index primitive_type;
   Token elements_count;
 } Node_Array_type;
 
@@ -22,16 +29,54 @@ typedef struct Node_Type {
   } type_type;
   union {
     Token type_primitive_value;
-    struct Node_Type * type_ptr_value;
-    struct Node_Array_type * type_array_value;
+    // index in the types pool
+    Node_index type_ptr_value;
+    // index in the array types pool
+    Node_index type_array_value;
   } type_value;
 
 } Node_Type;
 
+// the name of the type of the integer literals, it is not in the source code
+static char literal_type_name[] = "u64";
+
+// the type of the integer literals, the numbers inside the array literals also have it
+static Node_Type get_literal_type(void) {
+  Node_Type type;
+  type.token.beginning = literal_type_name;
+  type.token.length = 3;
+  type.type_type = type_primitive_type;
+  type.type_value.type_primitive_value = type.token;
+  return type;
+}
+
+// a number token that is not in the code, like the length of the type of an array literal
+static Token get_number_token(const uint64_t value) {
+  return (Token) { .beginning = NULL, .length = 0, .type = Number, .value = value };
+}
+
+// returns the size in bytes of the primitive type with the name, or 0 if there is none with it
+// the primitive types are the unsigned integers, the smaller ones take less memory in the arrays
+static int get_primitive_type_size(const Token type_name) {
+  if (compare_token_to_string(type_name, "u8")) {
+    return 1;
+  }
+  if (compare_token_to_string(type_name, "u16")) {
+    return 2;
+  }
+  if (compare_token_to_string(type_name, "u32")) {
+    return 4;
+  }
+  if (compare_token_to_string(type_name, "u64")) {
+    return 8;
+  }
+  return 0;
+}
+
 typedef struct Node_Array {
   int elements_count;
-  // list of all the elements inside the array
-  struct Node_Expresion * elements;
+  // index of the first element in the expresions pool, the rest go after it
+  Node_index elements;
 } Node_Array;
 
 typedef struct Node_Expresion {
@@ -45,9 +90,11 @@ typedef struct Node_Expresion {
   union {
     Token expresion_number_value;
     Token expresion_identifier_value;
-    struct Node_Binary_Operation * expresion_binary_operation_value;
-    struct Node_Unary_Operation * expresion_unary_operation_value;
-    struct Node_Array * expresion_array_value;
+    // index in the binary operations pool
+    Node_index expresion_binary_operation_value;
+    // index in the unary operations pool
+    Node_index expresion_unary_operation_value;
+    Node_Array expresion_array_value;
   } expresion_value;
 } Node_Expresion;
 
@@ -97,7 +144,8 @@ typedef struct Node_Var_assignment {
 
 
 typedef struct Node_Scope {
-  struct Node_Statement * statements_node;
+  // index of the first statement in the statements pool, the rest go after it
+  Node_index statements;
   int statements_count;
 } Node_Scope;
 
@@ -134,11 +182,141 @@ typedef struct Node_Statement {
   } statement_type;
 } Node_Statement;
 
+// the top level statements are not in a pool, so each one can be parsed, kept and freed on its own
 typedef struct Node_Program {
   Node_Statement * statements_node;
   int statements_count;
 } Node_Program;
 
+// the nodes of the syntax trees by their type, the nodes of a tree are in the same pools,
+// and the children are added before their parents, so the walks over a tree go mostly forward in memory
+typedef struct Node_pools {
+  Pool statements;
+  Pool expresions;
+  Pool binary_operations;
+  Pool unary_operations;
+  Pool types;
+  Pool array_types;
+} Node_pools;
+
+// the pools where the parser, the checker and the generators create and look up the nodes
+// each thread has its own, like the arena
+thread_local Node_pools * active_node_pools = NULL;
+
+Node_pools * create_node_pools(void) {
+  Node_pools * pools = smalloc(sizeof(*pools));
+  *pools = (Node_pools) {
+    .statements = create_pool(sizeof(Node_Statement)),
+    .expresions = create_pool(sizeof(Node_Expresion)),
+    .binary_operations = create_pool(sizeof(Node_Binary_Operation)),
+    .unary_operations = create_pool(sizeof(Node_Unary_Operation)),
+    .types = create_pool(sizeof(Node_Type)),
+    .array_types = create_pool(sizeof(Node_Array_type))
+  };
+  return pools;
+}
+
+// makes pools that read the nodes of the pools without copying them and add the new nodes to blocks
+// of their own, so a thread can use them while another thread adds nodes to the pools
+Node_pools fork_node_pools(const Node_pools * pools) {
+  return (Node_pools) {
+    .statements = fork_pool(&pools->statements),
+    .expresions = fork_pool(&pools->expresions),
+    .binary_operations = fork_pool(&pools->binary_operations),
+    .unary_operations = fork_pool(&pools->unary_operations),
+    .types = fork_pool(&pools->types),
+    .array_types = fork_pool(&pools->array_types)
+  };
+}
+
+// frees the blocks of the pools, for the pools made by fork_node_pools()
+void release_node_pools(Node_pools * pools) {
+  destroy_pool(&pools->statements);
+  destroy_pool(&pools->expresions);
+  destroy_pool(&pools->binary_operations);
+  destroy_pool(&pools->unary_operations);
+  destroy_pool(&pools->types);
+  destroy_pool(&pools->array_types);
+}
+
+void destroy_node_pools(Node_pools * pools) {
+  release_node_pools(pools);
+  sfree(pools);
+}
+
+// forgets the nodes added after the pools had the sizes of the copy
+void truncate_node_pools(Node_pools * pools, const Node_pools sizes) {
+  truncate_pool(&pools->statements, sizes.statements.items_count);
+  truncate_pool(&pools->expresions, sizes.expresions.items_count);
+  truncate_pool(&pools->binary_operations, sizes.binary_operations.items_count);
+  truncate_pool(&pools->unary_operations, sizes.unary_operations.items_count);
+  truncate_pool(&pools->types, sizes.types.items_count);
+  truncate_pool(&pools->array_types, sizes.array_types.items_count);
+}
+
+// the statements of a scope are one after the other in the pool, so they can be used as an array
+static inline Node_Statement * get_scope_statements(const Node_Scope scope) {
+  return scope.statements_count == 0 ? NULL : get_pool_item(&active_node_pools->statements, scope.statements);
+}
+
+// the elements of an array are one after the other in the pool, so they can be used as an array
+static inline Node_Expresion * get_array_elements(const Node_Array array) {
+  return array.elements_count == 0 ? NULL : get_pool_item(&active_node_pools->expresions, array.elements);
+}
+
+static inline Node_Binary_Operation * get_binary_operation(const Node_Expresion expresion) {
+  return get_pool_item(&active_node_pools->binary_operations, expresion.expresion_value.expresion_binary_operation_value);
+}
+
+static inline Node_Unary_Operation * get_unary_operation(const Node_Expresion expresion) {
+  return get_pool_item(&active_node_pools->unary_operations, expresion.expresion_value.expresion_unary_operation_value);
+}
+
+static inline Node_Type * get_type(const Node_index idx) {
+  return get_pool_item(&active_node_pools->types, idx);
+}
+
+// the type a pointer type points to
+static inline Node_Type * get_pointed_type(const Node_Type type) {
+  return get_type(type.type_value.type_ptr_value);
+}
+
+static inline Node_Array_type * get_array_type(const Node_Type type) {
+  return get_pool_item(&active_node_pools->array_types, type.type_value.type_array_value);
+}
+
+Node_index add_binary_operation(const Node_Binary_Operation operation) {
+  return append_pool_item(&active_node_pools->binary_operations, &operation);
+}
+
+Node_index add_unary_operation(const Node_Unary_Operation operation) {
+  return append_pool_item(&active_node_pools->unary_operations, &operation);
+}
+
+Node_index add_type(const Node_Type type) {
+  return append_pool_item(&active_node_pools->types, &type);
+}
+
+Node_index add_array_type(const Node_Array_type array_type) {
+  return append_pool_item(&active_node_pools->array_types, &array_type);
+}
+
+// adds the statements one after the other and returns the scope with them
+Node_Scope add_statements(const Node_Statement * statements, const int statements_count) {
+  return (Node_Scope) {
+    .statements = append_pool_items(&active_node_pools->statements, statements, statements_count),
+    .statements_count = statements_count
+  };
+}
+
+// adds the expresions one after the other and returns the array with them
+Node_Array add_array_elements(const Node_Expresion * elements, const int elements_count) {
+  return (Node_Array) {
+    .elements_count = elements_count,
+    .elements = append_pool_items(&active_node_pools->expresions, elements, elements_count)
+  };
+}
+
 
 #ifdef DEBUG
 
@@ -188,32 +366,32 @@ void D_print_expresion(Node_Expresion expresion, int depth) {
       printf("%*sNode binary operation:\n", depth, "");
       depth++;
 
-      printf("%*s%s\n", depth, "", enum_to_bin_op_type((int)expresion.expresion_value.expresion_binary_operation_value->operation_type));
+      printf("%*s%s\n", depth, "", enum_to_bin_op_type((int)get_binary_operation(expresion)->operation_type));
       depth++;
 
-      D_print_expresion(expresion.expresion_value.expresion_binary_operation_value->left_side, depth);
+      D_print_expresion(get_binary_operation(expresion)->left_side, depth);
 
-      D_print_expresion(expresion.expresion_value.expresion_binary_operation_value->right_side, depth);
+      D_print_expresion(get_binary_operation(expresion)->right_side, depth);
       break;
 
     case expresion_unary_operation_type:
       printf("%*sNode unary operation:\n", depth, "");
       depth++;
 
-      printf("%*s%s\n", depth, "", enum_to_uni_op_type((int)expresion.expresion_value.expresion_unary_operation_value->operation_type));
+      printf("%*s%s\n", depth, "", enum_to_uni_op_type((int)get_unary_operation(expresion)->operation_type));
 
-      D_print_expresion(expresion.expresion_value.expresion_unary_operation_value->expresion, depth);
+      D_print_expresion(get_unary_operation(expresion)->expresion, depth);
       break;
 
     case expresion_array_type:
       printf("%*sNode array:\n", depth, "");
       depth++;
 
-      printf("%*selements count: %d\n", depth, "", expresion.expresion_value.expresion_array_value->elements_count);
+      printf("%*selements count: %d\n", depth, "", expresion.expresion_value.expresion_array_value.elements_count);
 
-      for (int i = 0; i < expresion.expresion_value.expresion_array_value->elements_count; i++) {
+      for (int i = 0; i < expresion.expresion_value.expresion_array_value.elements_count; i++) {
         printf("%*selement idx: %d\n", depth, "", i);
-        D_print_expresion(expresion.expresion_value.expresion_array_value->elements[i], depth+1);
+        D_print_expresion(get_array_elements(expresion.expresion_value.expresion_array_value)[i], depth+1);
       }
       break;
 
@@ -235,18 +413,18 @@ void D_print_type(Node_Type type, int depth) {
     printf("%*sptr\n", depth, "");
     depth++;
 
-    D_print_type(*type.type_value.type_ptr_value, depth);
+    D_print_type(*get_pointed_type(type), depth);
   }
   else if (type.type_type == type_array_type) {
     printf("%*sNode type array:\n", depth, "");
     depth++;
 
     printf("%*selements count: ", depth, "");
-    D_print_token(type.type_value.type_array_value->elements_count);
+    D_print_token(get_array_type(type)->elements_count);
 
     printf("%*selement type:\n", depth, "");
     depth++;
-    D_print_type(*type.type_value.type_array_value->primitive_type, depth);
+    D_print_type(*get_type(get_array_type(type)->primitive_type), depth);
   }
   else {
     implementation_error("in debug function print type unkown type of type");
@@ -309,7 +487,7 @@ void D_print_statement(Node_Statement stmt, int depth) {
       printf("%*sStatements count: %d\n", depth, "", scope.statements_count);
 
       for (int i = 0; i < scope.statements_count; i++) {
-        D_print_statement(scope.statements_node[i], depth);
+        D_print_statement(get_scope_statements(scope)[i], depth);
         putchar('\n');
       }
       break;
@@ -326,7 +504,7 @@ void D_print_statement(Node_Statement stmt, int depth) {
 
       printf("%*sStatements count: %d\n", depth+1, "", if_node.scope.statements_count);
       for (int i = 0; i < if_node.scope.statements_count; i++) {
-        D_print_statement(if_node.scope.statements_node[i], depth+1);
+        D_print_statement(get_scope_statements(if_node.scope)[i], depth+1);
         putchar('\n');
       }
       if (if_node.has_else_block) {
@@ -334,7 +512,7 @@ void D_print_statement(Node_Statement stmt, int depth) {
 
         printf("%*sStatements count: %d\n", depth+1, "", if_node.else_block.statements_count);
         for (int i = 0; i < if_node.else_block.statements_count; i++) {
-          D_print_statement(if_node.else_block.statements_node[i], depth+1);
+          D_print_statement(get_scope_statements(if_node.else_block)[i], depth+1);
           putchar('\n');
         }
       }
@@ -353,7 +531,7 @@ void D_print_statement(Node_Statement stmt, int depth) {
       printf("%*sStatements count: %d\n", depth, "", while_node.scope.statements_count);
 
       for (int i = 0; i < while_node.scope.statements_count; i++) {
-        D_print_statement(while_node.scope.statements_node[i], depth);
+        D_print_statement(get_scope_statements(while_node.scope)[i], depth);
         putchar('\n');
       }
       break;
@@ -371,9 +549,41 @@ void D_print_syntax_tree(Node_Program tree, int depth) {
 #endif
 
 
+// the tokens the parser reads: the ones of the list from the first, and End_of_file from the end,
+// so a statement or a scope is parsed on its own without copying its tokens
+typedef struct Token_span {
+  const Token_list * list;
+  int first;
+  int end;
+} Token_span;
+
+// the span with all the tokens of the list
+static inline Token_span get_list_span(const Token_list * tokens) {
+  return (Token_span) { .list = tokens, .first = 0, .end = tokens->tokens_count };
+}
+
+// returns the token at the index of the span, or a NULL_TOKEN after its end
+static inline Token get_span_token(const Token_span tokens, const int idx) {
+  return tokens.first + idx < tokens.end ? get_token(tokens.list, tokens.first + idx) : NULL_TOKEN;
+}
+
+static inline Token_type get_span_token_type(const Token_span tokens, const int idx) {
+  return tokens.first + idx < tokens.end ? (Token_type) tokens.list->types[tokens.first + idx] : End_of_file;
+}
+
+// the first symbol of the token, it must be before the end of the span
+static inline char get_span_token_symbol(const Token_span tokens, const int idx) {
+  return tokens.list->text[tokens.list->offsets[tokens.first + idx]];
+}
+
+// the span from the index, the end is the same
+static inline Token_span skip_span_tokens(const Token_span tokens, const int count) {
+  return (Token_span) { .list = tokens.list, .first = tokens.first + count, .end = tokens.end };
+}
+
 // predeclare this functions to allow mutual recursion
-Node_Program parser(const Token * tokens);
-Node_Scope parse_scope(const Token * tokens, const int tokens_count);
+static Node_Program parse_statements(const Token_span tokens);
+Node_Scope parse_scope(const Token_span tokens, const int tokens_count);
 
 // convert the string of a binary operation token into a enum that is a more manageable form
 static int get_binary_operation_type(const Token operation) {
@@ -406,7 +616,7 @@ static int get_binary_operation_type(const Token operation) {
     type = binary_operation_equ_type;
   }
   else {
-    errorf("Line:%d, column:%d.  Error: unkown binary operation in expresion\n", operation.line_number, operation.column_number);
+    errorf_at(operation, "unkown binary operation in expresion\n");
   }
   return type;
 }
@@ -421,7 +631,7 @@ static int get_unary_operation_type(Token operation) {
     type = unary_operation_deref_type;
   }
   else {
-    errorf("Line:%d, column:%d.  Error: unkown unary operation in expresion\n", operation.line_number, operation.column_number);
+    errorf_at(operation, "unkown unary operation in expresion\n");
   }
   return type;
 }
@@ -437,7 +647,7 @@ static int get_binary_operation_precedence(Token operation) {
       return precedes[i];
     }
   }
-  errorf("Line:%d, column:%d.  Error: unkown precedence of binary operation\n", operation.line_number, operation.column_number);
+  errorf_at(operation, "unkown precedence of binary operation\n");
   // unreachable
   return -1;
 }
@@ -453,7 +663,7 @@ static int get_unary_operation_precedence(Token operation) {
       return precedes[i];
     }
   }
-  errorf("Line:%d, column:%d.  Error: unkown precedence of unary operation\n", operation.line_number, operation.column_number);
+  errorf_at(operation, "unkown precedence of unary operation\n");
   // unreachable
   return -1;
 }
@@ -462,8 +672,8 @@ static int get_unary_operation_precedence(Token operation) {
 // 'expr' must be the address of the first opening bracket in the expression
 // returns the offset off the matching closing bracket,
 //   if it couldnt find it prints an error an exits
-static int offset_of_match_bracket(const Token * expr, const int exprsz) {
-  if (expr->type != Bracket || *expr->beginning != '(') {
+static int offset_of_match_bracket(const Token_span expr, const int exprsz) {
+  if (get_span_token_type(expr, 0) != Bracket || get_span_token_symbol(expr, 0) != '(') {
     implementation_error("beginning of bracket expr is not open bracket");
   }
 
@@ -472,16 +682,16 @@ static int offset_of_match_bracket(const Token * expr, const int exprsz) {
   while (depth != 0) {
     if (offset >= exprsz) {
       if (offset > 0) {
-        errorf("Line:%d, column:%d.  Error: expected a closing bracket\n", expr->line_number, expr->column_number);
+        errorf_at(get_span_token(expr, 0), "expected a closing bracket\n");
       } else if (offset < 0) {
-        errorf("Line:%d, column:%d.  Error: expected an opening bracket\n", expr->line_number, expr->column_number);
+        errorf_at(get_span_token(expr, 0), "expected an opening bracket\n");
       }
     }
-    if (expr[offset].type == Bracket) {
-      if (expr[offset].beginning[0] == '(') {
+    if (get_span_token_type(expr, offset) == Bracket) {
+      if (get_span_token_symbol(expr, offset) == '(') {
         depth++;
       }
-      else if (expr[offset].beginning[0] == ')') {
+      else if (get_span_token_symbol(expr, offset) == ')') {
         depth--;
       }
       else {
@@ -496,8 +706,8 @@ static int offset_of_match_bracket(const Token * expr, const int exprsz) {
 // 'expr' must be the address of the first opening square bracket in the expression
 // returns the offset off the matching closing square bracket,
 //   if it couldnt find it prints an error an exits
-static int offset_of_match_square_bracket(const Token * expr, const int exprsz) {
-  if (expr->type != Square_bracket || *expr->beginning != '[') {
+static int offset_of_match_square_bracket(const Token_span expr, const int exprsz) {
+  if (get_span_token_type(expr, 0) != Square_bracket || get_span_token_symbol(expr, 0) != '[') {
     implementation_error("beginning of bracket expr is not open bracket");
   }
 
@@ -506,16 +716,16 @@ static int offset_of_match_square_bracket(const Token * expr, const int exprsz)
   while (depth != 0) {
     if (offset >= exprsz) {
       if (offset > 0) {
-        errorf("Line:%d, column:%d.  Error: expected a closing square bracket\n", expr->line_number, expr->column_number);
+        errorf_at(get_span_token(expr, 0), "expected a closing square bracket\n");
       } else if (offset < 0) {
-        errorf("Line:%d, column:%d.  Error: expected an opening square bracket\n", expr->line_number, expr->column_number);
+        errorf_at(get_span_token(expr, 0), "expected an opening square bracket\n");
       }
     }
-    if (expr[offset].type == Square_bracket) {
-      if (expr[offset].beginning[0] == '[') {
+    if (get_span_token_type(expr, offset) == Square_bracket) {
+      if (get_span_token_symbol(expr, offset) == '[') {
         depth++;
       }
-      else if (expr[offset].beginning[0] == ']') {
+      else if (get_span_token_symbol(expr, offset) == ']') {
         depth--;
       }
       else {
@@ -529,48 +739,48 @@ static int offset_of_match_square_bracket(const Token * expr, const int exprsz)
 
 
 // parses expresion recursively
-Node_Expresion parse_expresion(const Token * expresion_beginning, const int size) {
+Node_Expresion parse_expresion(const Token_span expresion_beginning, const int size) {
   Node_Expresion result;
   if (size == 0) {
-    errorf("Line:%d, column:%d.  Error: expression must not be empty\n", expresion_beginning->line_number, expresion_beginning->column_number);
+    errorf_at(get_span_token(expresion_beginning, 0), "expression must not be empty\n");
   }
   else if (size == 1) {
     // set the type of the expresion
-    if (expresion_beginning->type == Number) {
+    if (get_span_token_type(expresion_beginning, 0) == Number) {
       result.expresion_type = expresion_number_type;
-      result.expresion_value.expresion_number_value = *expresion_beginning;
+      result.expresion_value.expresion_number_value = get_span_token(expresion_beginning, 0);
     }
-    else if (expresion_beginning->type == Identifier) {
+    else if (get_span_token_type(expresion_beginning, 0) == Identifier) {
       result.expresion_type = expresion_identifier_type;
-      result.expresion_value.expresion_identifier_value = *expresion_beginning;
+      result.expresion_value.expresion_identifier_value = get_span_token(expresion_beginning, 0);
     }
     else {
-      errorf("Line:%d, column:%d.  Error: unexpected type of token in expresion\n", expresion_beginning->line_number, expresion_beginning->column_number);
+      errorf_at(get_span_token(expresion_beginning, 0), "unexpected type of token in expresion\n");
     }
   }
   else {
-    if (expresion_beginning[0].type == Bracket && expresion_beginning[0].beginning[0] == '(' &&
+    if (get_span_token_type(expresion_beginning, 0) == Bracket && get_span_token_symbol(expresion_beginning, 0) == '(' &&
         offset_of_match_bracket(expresion_beginning, size) == size -1) {
-      result = parse_expresion(&expresion_beginning[1], size -2); // substract to skip the '(' and the ending ')'
+      result = parse_expresion(skip_span_tokens(expresion_beginning, 1), size -2); // substract to skip the '(' and the ending ')'
       return result;
     }
-    if (expresion_beginning[0].type == Square_bracket && expresion_beginning[0].beginning[0] == '[' &&
+    if (get_span_token_type(expresion_beginning, 0) == Square_bracket && get_span_token_symbol(expresion_beginning, 0) == '[' &&
         offset_of_match_square_bracket(expresion_beginning, size) == size -1) {
       result.expresion_type = expresion_array_type;
-      result.expresion_value.expresion_array_value = smalloc(sizeof(*result.expresion_value.expresion_array_value));
       int elements_count = 0;
-      result.expresion_value.expresion_array_value->elements = smalloc(sizeof(*result.expresion_value.expresion_array_value->elements) * elements_count);
+      // the elements are added to the pool together when all of them are parsed, so they are one after the other
+      Node_Expresion * elements = smalloc(0);
       int expr_beginning_idx = 1;
       for (int i = 1; i < size -1; i++) { // start after the '[' and end before the ending ']';
         // if it finds a square bracket skip it
-        if (expresion_beginning[i].type == Square_bracket && expresion_beginning[i].beginning[0] == '[') {
-          i += offset_of_match_square_bracket(&expresion_beginning[i], size -2);
+        if (get_span_token_type(expresion_beginning, i) == Square_bracket && get_span_token_symbol(expresion_beginning, i) == '[') {
+          i += offset_of_match_square_bracket(skip_span_tokens(expresion_beginning, i), size -2);
         }
         // if it finds a comma parse the accummulated expresion and start accumulating another one
-        if (expresion_beginning[i].type == Comma) {
+        if (get_span_token_type(expresion_beginning, i) == Comma) {
           elements_count += 1;
-          result.expresion_value.expresion_array_value->elements = srealloc(result.expresion_value.expresion_array_value->elements, sizeof(*result.expresion_value.expresion_array_value->elements) * elements_count);
-          result.expresion_value.expresion_array_value->elements[elements_count -1] = parse_expresion(&expresion_beginning[expr_beginning_idx], i - expr_beginning_idx);
+          elements = srealloc(elements, sizeof(*elements) * elements_count);
+          elements[elements_count -1] = parse_expresion(skip_span_tokens(expresion_beginning, expr_beginning_idx), i - expr_beginning_idx);
           //i++;
           expr_beginning_idx = i +1;
         }
@@ -578,10 +788,11 @@ Node_Expresion parse_expresion(const Token * expresion_beginning, const int size
       // if there is are tokens left after the last expresion, also parse them and add them to the list
       if (expr_beginning_idx != size-1) {
         elements_count += 1;
-        result.expresion_value.expresion_array_value->elements = srealloc(result.expresion_value.expresion_array_value->elements, sizeof(*result.expresion_value.expresion_array_value->elements) * elements_count);
-        result.expresion_value.expresion_array_value->elements[elements_count -1] = parse_expresion(&expresion_beginning[expr_beginning_idx], (size-1) - expr_beginning_idx);
+        elements = srealloc(elements, sizeof(*elements) * elements_count);
+        elements[elements_count -1] = parse_expresion(skip_span_tokens(expresion_beginning, expr_beginning_idx), (size-1) - expr_beginning_idx);
       }
-      result.expresion_value.expresion_array_value->elements_count = elements_count;
+      result.expresion_value.expresion_array_value = add_array_elements(elements, elements_count);
+      sfree(elements);
       return result;
     }
     Token operation;
@@ -608,11 +819,11 @@ Node_Expresion parse_expresion(const Token * expresion_beginning, const int size
     int i;
     for (i = 0; i < size; i++) {
       // if it finds a bracket skip it
-      if (expresion_beginning[i].type == Bracket && expresion_beginning[i].beginning[0] == '(') {
-        i += offset_of_match_bracket(&expresion_beginning[i], size);
+      if (get_span_token_type(expresion_beginning, i) == Bracket && get_span_token_symbol(expresion_beginning, i) == '(') {
+        i += offset_of_match_bracket(skip_span_tokens(expresion_beginning, i), size - i);
       }
       // if it finds a square bracket skip it
-      if (expresion_beginning[i].type == Square_bracket && expresion_beginning[i].beginning[0] == '[') {
+      if (get_span_token_type(expresion_beginning, i) == Square_bracket && get_span_token_symbol(expresion_beginning, i) == '[') {
         // detect array access operation
         // it has lower precedence than binary and unary operation
         if (!was_last_op_or_null && !is_operation_bin && !is_operation_uni) {
@@ -620,26 +831,26 @@ Node_Expresion parse_expresion(const Token * expresion_beginning, const int size
           array_beginning = left_side_beginning;
           array_size = i - array_beginning;
           index_beginning = i + 1;
-          index_size = offset_of_match_square_bracket(&expresion_beginning[i], size) -1; // substract 1 to skip the ']'
+          index_size = offset_of_match_square_bracket(skip_span_tokens(expresion_beginning, i), size - i) -1; // substract 1 to skip the ']'
         }
-        i += offset_of_match_square_bracket(&expresion_beginning[i], size);
+        i += offset_of_match_square_bracket(skip_span_tokens(expresion_beginning, i), size - i);
       }
       // find the operation with the lowest precedence
-      if (expresion_beginning[i].type == Operation) {
+      if (get_span_token_type(expresion_beginning, i) == Operation) {
         if (was_last_op_or_null && !is_operation_bin && !is_operation_uni) {
           // found a unary operation
           is_operation_uni = true;
-          min_oper_preced = get_unary_operation_precedence(expresion_beginning[i]);
+          min_oper_preced = get_unary_operation_precedence(get_span_token(expresion_beginning, i));
           uni_expresion_beginning = i + 1;
-          operation = expresion_beginning[i];
+          operation = get_span_token(expresion_beginning, i);
         }
-        else if (!was_last_op_or_null && get_binary_operation_precedence(expresion_beginning[i]) <= min_oper_preced) {
+        else if (!was_last_op_or_null && get_binary_operation_precedence(get_span_token(expresion_beginning, i)) <= min_oper_preced) {
           is_operation_bin = true;
           is_operation_uni = false;
           is_operation_access = false;
-          min_oper_preced = get_binary_operation_precedence(expresion_beginning[i]);
+          min_oper_preced = get_binary_operation_precedence(get_span_token(expresion_beginning, i));
           left_side_size = i;
-          operation = expresion_beginning[i];
+          operation = get_span_token(expresion_beginning, i);
           right_side_beginning = i + 1;
         }
         was_last_op_or_null = true;
@@ -662,29 +873,29 @@ Node_Expresion parse_expresion(const Token * expresion_beginning, const int size
         right_side_size = i - right_side_beginning;
       }
       // create a new node and parse each side of the expresion
-      Node_Binary_Operation * bin_operation = smalloc(sizeof(Node_Binary_Operation));
+      Node_Binary_Operation bin_operation;
       // parse each side of the binary expresion recursively
-      bin_operation->left_side = parse_expresion(&expresion_beginning[left_side_beginning], left_side_size);
-      bin_operation->operation_type = enum_op_type;
-      bin_operation->right_side = parse_expresion(&expresion_beginning[right_side_beginning], right_side_size);
+      bin_operation.left_side = parse_expresion(skip_span_tokens(expresion_beginning, left_side_beginning), left_side_size);
+      bin_operation.operation_type = enum_op_type;
+      bin_operation.right_side = parse_expresion(skip_span_tokens(expresion_beginning, right_side_beginning), right_side_size);
 
-      result.expresion_value.expresion_binary_operation_value = bin_operation;
+      result.expresion_value.expresion_binary_operation_value = add_binary_operation(bin_operation);
       result.expresion_type = expresion_binary_operation_type;
     }
     else if (is_operation_uni) {
       uni_expresion_size = i - uni_expresion_beginning;
       // create a new node and parse the expresion
-      Node_Unary_Operation * uni_operation = smalloc(sizeof(Node_Unary_Operation));
+      Node_Unary_Operation uni_operation;
       // parse the unary expresion recursively
-      uni_operation->expresion = parse_expresion(&expresion_beginning[uni_expresion_beginning], uni_expresion_size);
-      uni_operation->operation_type = get_unary_operation_type(operation);
+      uni_operation.expresion = parse_expresion(skip_span_tokens(expresion_beginning, uni_expresion_beginning), uni_expresion_size);
+      uni_operation.operation_type = get_unary_operation_type(operation);
 
-      result.expresion_value.expresion_unary_operation_value = uni_operation;
+      result.expresion_value.expresion_unary_operation_value = add_unary_operation(uni_operation);
       result.expresion_type = expresion_unary_operation_type;
     }
     // if it did not found an operation report it
     else {
-      errorf("Line:%d, column:%d.  Error: expected an operation in expresion\n", expresion_beginning->line_number, expresion_beginning->column_number);
+      errorf_at(get_span_token(expresion_beginning, 0), "expected an operation in expresion\n");
     }
   }
   return result;
@@ -693,15 +904,15 @@ Node_Expresion parse_expresion(const Token * expresion_beginning, const int size
 
 // returns the offset of the next the semicolon token counting from the beginning pointer
 // in case there is no semicolon or something happend, reports an error and exits
-static int next_semicolon_offset(const Token * beginning) {
+static int next_semicolon_offset(const Token_span beginning) {
   int offset;
-  for (offset = 0; beginning[offset].type != Semi_colon; offset++) {
-    Token token = beginning[offset];
+  for (offset = 0; get_span_token_type(beginning, offset) != Semi_colon; offset++) {
+    Token token = get_span_token(beginning, offset);
     if (token.type == End_of_file) {
-      errorf("Line:%d, column:%d.  Error: could not find the expected semicolon\n", token.line_number, token.column_number);
+      errorf_at(token, "could not find the expected semicolon\n");
     }
     if (token.type == Curly_bracket) {
-      errorf("Line:%d, column:%d.  Error: expected a semicoln before curly bracket\n", token.line_number, token.column_number);
+      errorf_at(token, "expected a semicoln before curly bracket\n");
     }
   }
   return offset;
@@ -709,18 +920,18 @@ static int next_semicolon_offset(const Token * beginning) {
 
 // returns the offset of the next the '=' token counting from the beginning pointer
 // if it could not find it, reports an error and exits
-static int next_asign_offset(const Token * beginning) {
+static int next_asign_offset(const Token_span beginning) {
   int offset;
-  for (offset = 0; compare_token_to_string(beginning[offset], "=") == 0; offset++) {
-    Token token = beginning[offset];
+  for (offset = 0; compare_token_to_string(get_span_token(beginning, offset), "=") == 0; offset++) {
+    Token token = get_span_token(beginning, offset);
     if (token.type == End_of_file) {
-      errorf("Line:%d, column:%d.  Error: could not find the expected '='\n", token.line_number, token.column_number);
+      errorf_at(token, "could not find the expected '='\n");
     }
     if (token.type == Semi_colon) {
-      errorf("Line:%d, column:%d.  Error: expected a '=' and an expression\n", token.line_number, token.column_number);
+      errorf_at(token, "expected a '=' and an expression\n");
     }
     if (token.type == Curly_bracket) {
-      errorf("Line:%d, column:%d.  Error: expected a '=', an expression and a ':'\n", token.line_number, token.column_number);
+      errorf_at(token, "expected a '=', an expression and a ':'\n");
     }
   }
   return offset;
@@ -728,93 +939,87 @@ static int next_asign_offset(const Token * beginning) {
 }
 
 // parses a type definition
-Node_Type parse_type(const Token * type_beginning, const int type_sz) {
+Node_Type parse_type(const Token_span type_beginning, const int type_sz) {
   if (type_sz == 0) {
-    errorf("Line:%d, column:%d.  Error: expected a type\n", type_beginning->line_number, type_beginning->column_number);
+    errorf_at(get_span_token(type_beginning, 0), "expected a type\n");
   }
   if (type_sz == 1) {
-    if (!compare_token_to_string(type_beginning[0], "u64")) {
-      errorf("Line:%d, column:%d.  Error: expected the primitive type to be 'u64'\n", type_beginning->line_number, type_beginning->column_number);
+    if (get_primitive_type_size(get_span_token(type_beginning, 0)) == 0) {
+      errorf_at(get_span_token(type_beginning, 0), "expected the primitive type to be 'u8', 'u16', 'u32' or 'u64'\n");
     }
     Node_Type type = {
-      .token=type_beginning[0],
+      .token=get_span_token(type_beginning, 0),
       .type_type=type_primitive_type,
-      .type_value.type_primitive_value=type_beginning[0]
+      .type_value.type_primitive_value=get_span_token(type_beginning, 0)
     };
     return type;
   }
   Node_Type type;
   int i = 0;
-  if (compare_token_to_string(type_beginning[i], "ptr")) {
-    type.token = type_beginning[i];
+  if (compare_token_to_string(get_span_token(type_beginning, i), "ptr")) {
+    type.token = get_span_token(type_beginning, i);
     type.type_type = type_ptr_type;
-    type.type_value.type_ptr_value = smalloc(sizeof(*type.type_value.type_ptr_value));
-    *type.type_value.type_ptr_value = parse_type(&type_beginning[i + 1], type_sz - 1); // add 1 to skip the already parsed "ptr", and sub 1 to account for that
+    type.type_value.type_ptr_value = add_type(parse_type(skip_span_tokens(type_beginning, i + 1), type_sz - 1)); // add 1 to skip the already parsed "ptr", and sub 1 to account for that
     i += 1;
   }
-  else if (compare_token_to_string(type_beginning[i], "[")) {
-    int offset =  offset_of_match_square_bracket(&type_beginning[i],  type_sz - 1);
+  else if (compare_token_to_string(get_span_token(type_beginning, i), "[")) {
+    int offset =  offset_of_match_square_bracket(skip_span_tokens(type_beginning, i),  type_sz - 1);
     // expect a single token inside the brackets
     if (offset -1 != 1) { // substract 1 to skip the ending ']'
-      errorf("Line:%d, column:%d.  Error: expected a single token inside the brackets for the array size\n", type_beginning[i].line_number, type_beginning[i].column_number);
+      errorf_at(get_span_token(type_beginning, i), "expected a single token inside the brackets for the array size\n");
+    }
+    if (get_span_token_type(type_beginning, i + 1) != Number) {
+      errorf_at(get_span_token(type_beginning, i), "expected a number inside the brackets for the array size\n");
     }
-    if (type_beginning[i + 1].type != Number) {
-      errorf("Line:%d, column:%d.  Error: expected a number inside the brackets for the array size\n", type_beginning[i].line_number, type_beginning[i].column_number);
+    // the lengths and the sizes of the arrays are kept in int
+    if (get_span_token(type_beginning, i + 1).value > INT_MAX / 8) {
+      errorf_at(get_span_token(type_beginning, i + 1), "the size of the array is too large\n");
     }
-    type.token = type_beginning[i + 1];
+    type.token = get_span_token(type_beginning, i + 1);
     type.type_type = type_array_type;
-    type.type_value.type_array_value = smalloc(sizeof(*type.type_value.type_array_value));
-    type.type_value.type_array_value->elements_count = type_beginning[i + 1];
-    type.type_value.type_array_value->primitive_type = smalloc(sizeof(*type.type_value.type_array_value->primitive_type));
+    Node_Type primitive_type = parse_type(skip_span_tokens(type_beginning, i + 3), type_sz - 3); // the 3s are to skip the tokens: '[', number, ']'
 
-    Node_Type primitive_type = parse_type(&type_beginning[i + 3], type_sz - 3); // the 3s are to skip the tokens: '[', number, ']'
-
-    *type.type_value.type_array_value->primitive_type = primitive_type;
+    type.type_value.type_array_value = add_array_type((Node_Array_type) {
+      .primitive_type = add_type(primitive_type),
+      .elements_count = get_span_token(type_beginning, i + 1)
+    });
 
     i += offset;
     i += 1;
   }
   else {
-    errorf("Line:%d, column:%d.  Error: expected a type decorator\n", type_beginning->line_number, type_beginning->column_number);
+    errorf_at(get_span_token(type_beginning, 0), "expected a type decorator\n");
   }
   return type;
 }
 
-// parse a scope the same way as a program
-Node_Scope parse_scope(const Token * tokens, const int tokens_count) {
-  Token * new_tokens = smalloc((tokens_count + 1) * sizeof(Token)); // add 1 for space of the EOF token
-  // add EOF token so it can be parse tha same way as a program
-  new_tokens[tokens_count] = (Token) {  .beginning = NULL,
-                                        .length = 0,
-                                        .type = End_of_file
-                                     };
-  memcpy(new_tokens, tokens, tokens_count * sizeof(Token));
-  Node_Program temp_program = parser(new_tokens);
-  free(new_tokens);
-  Node_Scope scope;
-  scope.statements_count = temp_program.statements_count;
-  scope.statements_node = temp_program.statements_node;
+// parse a scope the same way as a program, its tokens end where it ends
+Node_Scope parse_scope(const Token_span tokens, const int tokens_count) {
+  const Token_span scope_tokens = { .list = tokens.list, .first = tokens.first, .end = tokens.first + tokens_count };
+  Node_Program temp_program = parse_statements(scope_tokens);
+  Node_Scope scope = add_statements(temp_program.statements_node, temp_program.statements_count);
+  sfree(temp_program.statements_node);
   return scope;
 }
 
 // tries to parse the scope the ptr points to
 // idx is a ptr to the index of the first '{' in the tokens
 // idx will be updated to the matching '}'
-Node_Scope parse_scope_at(const Token * tokens, int * idx) {
+Node_Scope parse_scope_at(const Token_span tokens, int * idx) {
   int scope_count = 1; // counter of nested scopes to allow recursive scopes
   int i = *idx;
   // match the beginning of the scope with its ending accounting for recursive scopes
   while (scope_count != 0) {
-    if (tokens[i].type == End_of_file) {
-      errorf("Line:%d, column:%d.  Error: unmatched open curly bracket\n", tokens->line_number, tokens->column_number);
+    if (get_span_token_type(tokens, i) == End_of_file) {
+      errorf_at(get_span_token(tokens, *idx), "unmatched open curly bracket\n");
     }
     i++;
-    if (tokens[i].type == Curly_bracket) {
-      if (compare_token_to_string(tokens[i], "{")) scope_count++;
-      if (compare_token_to_string(tokens[i], "}")) scope_count--;
+    if (get_span_token_type(tokens, i) == Curly_bracket) {
+      if (compare_token_to_string(get_span_token(tokens, i), "{")) scope_count++;
+      if (compare_token_to_string(get_span_token(tokens, i), "}")) scope_count--;
     }
   }
-  Node_Scope scope = parse_scope(&tokens[*idx + 1], i - *idx -1); // add and substract 1 to avoid the original `{`, `}`
+  Node_Scope scope = parse_scope(skip_span_tokens(tokens, *idx + 1), i - *idx -1); // add and substract 1 to avoid the original `{`, `}`
   *idx = i;
   return scope;
 }
@@ -823,12 +1028,12 @@ Node_Scope parse_scope_at(const Token * tokens, int * idx) {
 // tokens is the stream of tokens of the program
 // index is indicates the 'exit' token in the tokens
 // index will be updated to the corresponding ';'
-Node_Exit parse_exit_at(const Token * tokens, int * idx) {
+Node_Exit parse_exit_at(const Token_span tokens, int * idx) {
   int expresion_beginning = *idx +1; // add 1 to skip the "exit"
-  *idx += next_semicolon_offset(&tokens[*idx]);
+  *idx += next_semicolon_offset(skip_span_tokens(tokens, *idx));
   int expresion_size = *idx - expresion_beginning;
   Node_Exit node_exit;
-  node_exit.exit_code = parse_expresion(&tokens[expresion_beginning], expresion_size);
+  node_exit.exit_code = parse_expresion(skip_span_tokens(tokens, expresion_beginning), expresion_size);
   return node_exit;
 }
 
@@ -836,12 +1041,12 @@ Node_Exit parse_exit_at(const Token * tokens, int * idx) {
 // tokens is the stream of tokens of the program
 // index is indicates the 'print' token in the tokens
 // index will be updated to the corresponding ';'
-Node_Print parse_print_at(const Token * tokens, int * idx) {
+Node_Print parse_print_at(const Token_span tokens, int * idx) {
   int expresion_beginning = *idx +1; // add 1 to skip the "print"
-  *idx += next_semicolon_offset(&tokens[*idx]);
+  *idx += next_semicolon_offset(skip_span_tokens(tokens, *idx));
   int expresion_size = *idx - expresion_beginning;
   Node_Print node_print;
-  node_print.chr = parse_expresion(&tokens[expresion_beginning], expresion_size);
+  node_print.chr = parse_expresion(skip_span_tokens(tokens, expresion_beginning), expresion_size);
   return node_print;
 }
 
@@ -849,22 +1054,22 @@ Node_Print parse_print_at(const Token * tokens, int * idx) {
 // tokens is the stream of tokens of the program
 // index is indicates the variable name token in the tokens
 // index will be updated to the corresponding ';'
-Node_Var_declaration parse_var_declaration_at(const Token * tokens, int * idx) {
-  if (tokens[*idx].type != Identifier) {
-    errorf("Line:%d, column:%d.  Error: expected an identifier in variable declaration\n", tokens->line_number, tokens->column_number);
+Node_Var_declaration parse_var_declaration_at(const Token_span tokens, int * idx) {
+  if (get_span_token_type(tokens, *idx) != Identifier) {
+    errorf_at(get_span_token(tokens, 0), "expected an identifier in variable declaration\n");
   }
-  Token var_name = tokens[*idx];
+  Token var_name = get_span_token(tokens, *idx);
 
   *idx += 2; // add 2 to skip the variable name and the ':'
-  const Token * type_beginning = &tokens[*idx];
-  *idx += next_asign_offset(type_beginning);
-  int type_sz = &tokens[*idx] - type_beginning;
-  Node_Type type = parse_type(type_beginning, type_sz);
+  const int type_beginning = *idx;
+  *idx += next_asign_offset(skip_span_tokens(tokens, type_beginning));
+  int type_sz = *idx - type_beginning;
+  Node_Type type = parse_type(skip_span_tokens(tokens, type_beginning), type_sz);
 
   int expresion_beginning = *idx +1; // add 1 to skip the '='
-  *idx += next_semicolon_offset(&tokens[*idx]);
+  *idx += next_semicolon_offset(skip_span_tokens(tokens, *idx));
   int expresion_size = *idx - expresion_beginning;
-  Node_Expresion expresion = parse_expresion(&tokens[expresion_beginning], expresion_size);
+  Node_Expresion expresion = parse_expresion(skip_span_tokens(tokens, expresion_beginning), expresion_size);
 
   Node_Var_declaration node_var_declaration = {
     .var_name = var_name,
@@ -878,16 +1083,16 @@ Node_Var_declaration parse_var_declaration_at(const Token * tokens, int * idx) {
 // tokens is the stream of tokens of the program
 // index is indicates the variable name token in the tokens
 // index will be updated to the corresponding ';'
-Node_Var_assignment parse_var_assignment_at(const Token * tokens, int * idx) {
-  if (tokens[*idx].type != Identifier) {
-    errorf("Line:%d, column:%d.  Error: expected an identifier in variable assigment\n", tokens->line_number, tokens->column_number);
+Node_Var_assignment parse_var_assignment_at(const Token_span tokens, int * idx) {
+  if (get_span_token_type(tokens, *idx) != Identifier) {
+    errorf_at(get_span_token(tokens, 0), "expected an identifier in variable assigment\n");
   }
-  Token var_name = tokens[*idx];
+  Token var_name = get_span_token(tokens, *idx);
   // add 2 to skip the var name and the "="
   int expresion_beginning = *idx + 2;
-  *idx += next_semicolon_offset(&tokens[*idx]);
+  *idx += next_semicolon_offset(skip_span_tokens(tokens, *idx));
   int expresion_size = *idx - expresion_beginning;
-  Node_Expresion expresion = parse_expresion(&tokens[expresion_beginning], expresion_size);
+  Node_Expresion expresion = parse_expresion(skip_span_tokens(tokens, expresion_beginning), expresion_size);
 
   Node_Var_assignment node_var_assigment = {
     .var_name=var_name,
@@ -900,13 +1105,17 @@ Node_Var_assignment parse_var_assignment_at(const Token * tokens, int * idx) {
 // tokens is the stream of tokens of the program
 // index is indicates the 'if' token in the tokens
 // index will be updated to the corresponding '}'
-Node_If parse_if_at(const Token * tokens, int * idx) {
+Node_If parse_if_at(const Token_span tokens, int * idx) {
   // parse the condition
   *idx += 1; // add 1 to skip the 'if'
-  const Token * expr = &tokens[*idx];
+  const Token_span expr = skip_span_tokens(tokens, *idx);
   int expr_sz = *idx;
-  // FIX: improve this loop, it is very unsafe
-  do { ++*idx; } while (tokens[*idx].type != Curly_bracket);
+  do {
+    if (get_span_token_type(tokens, *idx) == End_of_file) {
+      errorf_at(get_span_token(tokens, *idx -1), "expected a curly bracket after the condition\n");
+    }
+    ++*idx;
+  } while (get_span_token_type(tokens, *idx) != Curly_bracket);
   expr_sz = *idx - expr_sz;
   Node_Expresion condition = parse_expresion(expr, expr_sz);
 
@@ -914,7 +1123,7 @@ Node_If parse_if_at(const Token * tokens, int * idx) {
   Node_Scope scope = parse_scope_at(tokens, idx);
   Node_If node_if = (Node_If) {.condition=condition, scope=scope};
 
-  if (compare_token_to_string(tokens[*idx + 1], "else")) {
+  if (compare_token_to_string(get_span_token(tokens, *idx + 1), "else")) {
     *idx += 2; // add 2 to skip the '}' and the 'else'
     node_if.has_else_block = true;
     node_if.else_block = parse_scope_at(tokens, idx);
@@ -928,13 +1137,17 @@ Node_If parse_if_at(const Token * tokens, int * idx) {
 // tokens is the stream of tokens of the program
 // index is indicates the 'while' token in the tokens
 // index will be updated to the corresponding '}'
-Node_While parse_while_at(const Token * tokens, int * idx) {
+Node_While parse_while_at(const Token_span tokens, int * idx) {
   // parse the condition
   *idx += 1; // add 1 to skip the 'while'
-  const Token * expr = &tokens[*idx];
+  const Token_span expr = skip_span_tokens(tokens, *idx);
   int expr_sz = *idx;
-  // FIX: improve this loop, it is very unsafe
-  do { ++*idx; } while (tokens[*idx].type != Curly_bracket);
+  do {
+    if (get_span_token_type(tokens, *idx) == End_of_file) {
+      errorf_at(get_span_token(tokens, *idx -1), "expected a curly bracket after the condition\n");
+    }
+    ++*idx;
+  } while (get_span_token_type(tokens, *idx) != Curly_bracket);
   expr_sz = *idx - expr_sz;
   Node_Expresion condition = parse_expresion(expr, expr_sz);
 
@@ -946,72 +1159,149 @@ Node_While parse_while_at(const Token * tokens, int * idx) {
   return node_while;
 }
 
-// parses the tokens into a syntax tree
-Node_Program parser(const Token * tokens) {
-  Node_Program result_tree;
-  int statements_num = 0;
-  result_tree.statements_node = malloc(statements_num * sizeof(Node_Statement));
-  result_tree.statements_count = 0;
-
-  for (int i = 0; tokens[i].type != End_of_file; i++) {
-    statements_num += 1;
-    Node_Statement * new_tree = srealloc(result_tree.statements_node, statements_num * sizeof(Node_Statement));
-    // exit node
-    if (compare_token_to_string(tokens[i], "exit")) {
-      Node_Statement stmt;
-      stmt.statement_type = exit_node_type;
-      stmt.statement_value.exit_node = parse_exit_at(tokens, &i);
-      new_tree[statements_num -1] = stmt;
-      result_tree.statements_node = new_tree;
-    }
-    else if (compare_token_to_string(tokens[i], "print")) {
-      Node_Statement stmt;
-      stmt.statement_type = print_type;
-      stmt.statement_value.print = parse_print_at(tokens, &i);
-      new_tree[statements_num -1] = stmt;
-      result_tree.statements_node = new_tree;
-    }
-    else if (compare_token_to_string(tokens[i + 1], ":")) {
-      Node_Statement stmt;
-      stmt.statement_type = var_declaration_type;
-      stmt.statement_value.var_declaration = parse_var_declaration_at(tokens, &i);
-      new_tree[statements_num -1] = stmt;
-      result_tree.statements_node = new_tree;
-    }
-    else if (compare_token_to_string(tokens[i + 1], "=")) {
-      Node_Statement stmt;
-      stmt.statement_type = var_assignment_type;
-      stmt.statement_value.var_assignment = parse_var_assignment_at(tokens, &i);
-      new_tree[statements_num -1] = stmt;
-      result_tree.statements_node = new_tree;
-    }
-    else if (compare_token_to_string(tokens[i], "{")) {
-      Node_Statement stmt;
-      stmt.statement_type = scope_type;
-      stmt.statement_value.scope = parse_scope_at(tokens, &i);;
-      new_tree[statements_num -1] = stmt;
-      result_tree.statements_node = new_tree;
-    }
-    else if (compare_token_to_string(tokens[i], "if")) {
-      Node_Statement stmt;
-      stmt.statement_type = if_type;
-      stmt.statement_value.if_node = parse_if_at(tokens, &i);;
-      new_tree[statements_num -1] = stmt;
-      result_tree.statements_node = new_tree;
-    }
-    else if (compare_token_to_string(tokens[i], "while")) {
-      Node_Statement stmt;
-      stmt.statement_type = while_type;
-      stmt.statement_value.while_node = parse_while_at(tokens, &i);;
-      new_tree[statements_num -1] = stmt;
-      result_tree.statements_node = new_tree;
+// returns the index of the last token of the top level statement that begins in the index
+// it ends in a ';' or a '}' outside of scopes, if the tokens end before it is_complete is false
+// it is used to skip a statement with errors and continue parsing after it
+// it only reads the types of the tokens and the text of the curly brackets
+int statement_end_index(const Token_span tokens, int idx, bool * is_complete) {
+  int scope_count = 0;
+  for (; get_span_token_type(tokens, idx) != End_of_file; idx++) {
+    const Token_type type = get_span_token_type(tokens, idx);
+    if (type == Semi_colon && scope_count == 0) {
+      *is_complete = true;
+      return idx;
+    }
+    if (type != Curly_bracket) {
+      continue;
+    }
+    if (get_span_token_symbol(tokens, idx) == '{') {
+      scope_count++;
     }
     else {
-      errorf("Line:%d, column:%d.  Error: unkown statement type\n", tokens[i].line_number, tokens[i].column_number);
+      scope_count--;
+      // the if statement continues in its else block
+      if (scope_count <= 0 && !compare_token_to_string(get_span_token(tokens, idx + 1), "else")) {
+        *is_complete = get_span_token_type(tokens, idx + 1) != End_of_file || scope_count == 0;
+        return idx;
+      }
+    }
+  }
+  *is_complete = false;
+  return idx - 1;
+}
+
+// parses the statement the index points to
+// index will be updated to the last token of the statement
+static Node_Statement parse_statement_at(const Token_span tokens, int * idx) {
+  Node_Statement stmt;
+  // exit node
+  if (compare_token_to_string(get_span_token(tokens, *idx), "exit")) {
+    stmt.statement_type = exit_node_type;
+    stmt.statement_value.exit_node = parse_exit_at(tokens, idx);
+  }
+  else if (compare_token_to_string(get_span_token(tokens, *idx), "print")) {
+    stmt.statement_type = print_type;
+    stmt.statement_value.print = parse_print_at(tokens, idx);
+  }
+  else if (compare_token_to_string(get_span_token(tokens, *idx + 1), ":")) {
+    stmt.statement_type = var_declaration_type;
+    stmt.statement_value.var_declaration = parse_var_declaration_at(tokens, idx);
+  }
+  else if (compare_token_to_string(get_span_token(tokens, *idx + 1), "=")) {
+    stmt.statement_type = var_assignment_type;
+    stmt.statement_value.var_assignment = parse_var_assignment_at(tokens, idx);
+  }
+  else if (compare_token_to_string(get_span_token(tokens, *idx), "{")) {
+    stmt.statement_type = scope_type;
+    stmt.statement_value.scope = parse_scope_at(tokens, idx);
+  }
+  else if (compare_token_to_string(get_span_token(tokens, *idx), "if")) {
+    stmt.statement_type = if_type;
+    stmt.statement_value.if_node = parse_if_at(tokens, idx);
+  }
+  else if (compare_token_to_string(get_span_token(tokens, *idx), "while")) {
+    stmt.statement_type = while_type;
+    stmt.statement_value.while_node = parse_while_at(tokens, idx);
+  }
+  else {
+    errorf_at(get_span_token(tokens, *idx), "unkown statement type\n");
+  }
+  return stmt;
+}
+
+// appends the statements of the tokens to the program, they are the tokens of one top level statement
+// and the ones after it that could not be part of it
+static void append_span_statements(Node_Program * program, const Token_span tokens) {
+  for (int i = 0; get_span_token_type(tokens, i) != End_of_file; i++) {
+    Node_Statement stmt = parse_statement_at(tokens, &i);
+    program->statements_count += 1;
+    program->statements_node = srealloc(program->statements_node, program->statements_count * sizeof(Node_Statement));
+    program->statements_node[program->statements_count -1] = stmt;
+  }
+}
+
+// the tokens of the statement in [beginning, end] of the tokens
+static Token_span get_statement_span(const Token_span tokens, const int beginning, const int end) {
+  return (Token_span) { .list = tokens.list, .first = tokens.first + beginning, .end = tokens.first + end + 1 };
+}
+
+// parses the tokens into a syntax tree, the first error stops it
+// every statement is parsed in a span that ends with it, so the errors in a statement can not
+// make it read the ones after it, and it is parsed the same way when it is alone
+static Node_Program parse_statements(const Token_span tokens) {
+  Node_Program program = { .statements_count = 0, .statements_node = smalloc(0) };
+  int statement_beginning = 0;
+  while (get_span_token_type(tokens, statement_beginning) != End_of_file) {
+    bool is_complete;
+    const int statement_end = statement_end_index(tokens, statement_beginning, &is_complete);
+    append_span_statements(&program, get_statement_span(tokens, statement_beginning, statement_end));
+    statement_beginning = statement_end + 1;
+  }
+  return program;
+}
+
+// parses the tokens into a syntax tree like parse_statements(), but when the errors are being collected
+// a top level statement with errors is skipped and the parsing continues after it, so the errors of the next ones are found too
+// the recovery point is set once, parsing the statements costs nothing more while there are no errors
+Node_Program parse_tokens(const Token_span tokens) {
+  if (diagnostic_sink == NULL) {
+    return parse_statements(tokens);
+  }
+  // volatile because they must keep their value after jumping back from an error,
+  // the program is not in the stack so it keeps the statements parsed before
+  Node_Program * volatile program = smalloc(sizeof(*program));
+  *program = (Node_Program) { .statements_count = 0, .statements_node = smalloc(0) };
+  volatile int statement_beginning = 0;
+  volatile int statement_end = -1;
+
+  jmp_buf * previous_recovery_point = error_recovery_point;
+  jmp_buf recovery_point;
+  if (setjmp(recovery_point) != 0) {
+    if (error_exit_code != 1) {
+      // implementation errors are not recovered
+      error_recovery_point = previous_recovery_point;
+      stop_compilation(error_exit_code);
     }
+    statement_beginning = statement_end + 1;
   }
-  result_tree.statements_count = statements_num;
+  error_recovery_point = &recovery_point;
+
+  while (get_span_token_type(tokens, statement_beginning) != End_of_file) {
+    bool is_complete;
+    statement_end = statement_end_index(tokens, statement_beginning, &is_complete);
+    append_span_statements(program, get_statement_span(tokens, statement_beginning, statement_end));
+    statement_beginning = statement_end + 1;
+  }
+  error_recovery_point = previous_recovery_point;
+
+  const Node_Program result_tree = *program;
+  sfree(program);
   return result_tree;
 }
 
-#endif
\ No newline at end of file
+// parses all the tokens of a list
+Node_Program parse_token_list(const Token_list * tokens) {
+  return parse_tokens(get_list_span(tokens));
+}
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "errors.h"
+#include "mlib.h"
+#include "tokenizer.h"
+#include "parser.h"
+#include "checker.h"
+
+
+/* * * * * * * * * * * * * * * *
+ * Profiles of the programs    *
+ * * * * * * * * * * * * * * * */
+
+// with --profile-generate the programs count how many times their ifs and their loops run,
+// and they write the counts into a profile file when they end,
+// then --profile-use gives the counts to the NASM generator, which lays out the ifs for the path they usually take
+// and unrolls the loops by the iterations they usually run
+// every if and while is a point of the profile, found by the place of the first token of its condition,
+// and it has 2 counters: the times it runs, and the times its block runs, that are the iterations of a loop
+
+// the file has the magic, the number of points as a qword, the place of every point as 2 dwords, the line and the column,
+// and the 2 counters of every point as qwords, in little endian like the x86-64 programs that write it
+#define PROFILE_MAGIC "BONEPROF"
+#define PROFILE_MAGIC_SIZE 8
+#define PROFILE_COUNTERS_PER_POINT 2
+
+// the programs write their profile in this file when it is set
+const char * profile_output_file = NULL;
+
+typedef struct Profile_place {
+  uint32_t line_number;
+  uint32_t column_number;
+} Profile_place;
+
+static Profile_place get_profile_place(const Node_Expresion condition) {
+  const Token_place place = get_token_place(get_first_token_of_expresion(condition));
+  return (Profile_place) { .line_number = place.line_number, .column_number = place.column_number };
+}
+
+static int compare_profile_places(const Profile_place place1, const Profile_place place2) {
+  if (place1.line_number != place2.line_number) {
+    return place1.line_number < place2.line_number ? -1 : 1;
+  }
+  if (place1.column_number != place2.column_number) {
+    return place1.column_number < place2.column_number ? -1 : 1;
+  }
+  return 0;
+}
+
+// returns the index of the place in the places sorted by the code, or -1 if it is not there
+static int find_profile_place(const Profile_place * places, const int places_count, const Profile_place place) {
+  int first = 0;
+  int last = places_count -1;
+  while (first <= last) {
+    const int middle = (first + last) / 2;
+    const int comparison = compare_profile_places(places[middle], place);
+    if (comparison == 0) {
+      return middle;
+    }
+    if (comparison < 0) {
+      first = middle + 1;
+    }
+    else {
+      last = middle -1;
+    }
+  }
+  return -1;
+}
+
+
+/* generating the profiles */
+
+// the points of the code generated, in the order of the code
+typedef struct Profile_points {
+  int points_count;
+  int points_capacity;
+  Profile_place * places;
+} Profile_points;
+
+static void append_profile_point(Profile_points * points, const Node_Expresion condition) {
+  if (points->points_count == points->points_capacity) {
+    points->points_capacity = 2 * points->points_capacity + 16;
+    points->places = srealloc(points->places, points->points_capacity * sizeof(*points->places));
+  }
+  points->places[points->points_count] = get_profile_place(condition);
+  points->points_count++;
+}
+
+// adds the points of the statements, every if and while before the ones inside its blocks
+// the statements come in the order of the code, so the places stay sorted
+void add_profile_points(Profile_points * points, const Node_Statement * statements, const int statements_count) {
+  for (int i = 0; i < statements_count; i++) {
+    const Node_Statement stmt = statements[i];
+    switch (stmt.statement_type) {
+      case scope_type:
+        add_profile_points(points, get_scope_statements(stmt.statement_value.scope), stmt.statement_value.scope.statements_count);
+        break;
+
+      case if_type:;
+        const Node_If if_node = stmt.statement_value.if_node;
+        append_profile_point(points, if_node.condition);
+        add_profile_points(points, get_scope_statements(if_node.scope), if_node.scope.statements_count);
+        if (if_node.has_else_block) {
+          add_profile_points(points, get_scope_statements(if_node.else_block), if_node.else_block.statements_count);
+        }
+        break;
+
+      case while_type:;
+        const Node_While while_node = stmt.statement_value.while_node;
+        append_profile_point(points, while_node.condition);
+        add_profile_points(points, get_scope_statements(while_node.scope), while_node.scope.statements_count);
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+// returns the index of the first counter of the point of the condition
+int find_profile_counter(const Profile_points points, const Node_Expresion condition) {
+  const int point = find_profile_place(points.places, points.points_count, get_profile_place(condition));
+  if (point == -1) {
+    implementation_error("the condition is not a point of the profile");
+  }
+  return point * PROFILE_COUNTERS_PER_POINT;
+}
+
+void free_profile_points(const Profile_points points) {
+  sfree(points.places);
+}
+
+
+/* using the profiles */
+
+typedef struct Profile_counts {
+  uint64_t runs;
+  uint64_t block_runs;
+} Profile_counts;
+
+// a point of the file, they are sorted by their places when it is read
+typedef struct Profile_point {
+  Profile_place place;
+  Profile_counts counts;
+} Profile_point;
+
+typedef struct Profile {
+  int points_count;
+  Profile_place * places;
+  Profile_counts * counts;
+  // the most times the block of a point runs, the loops near it are the hot ones
+  uint64_t max_block_runs;
+  // of the contents of the file, the cached outputs depend on them
+  uint64_t hash;
+} Profile;
+
+// the profile given with --profile-use, NULL when there is none
+Profile * used_profile = NULL;
+
+static uint64_t read_profile_number(const uint8_t * bytes, const int size) {
+  uint64_t number = 0;
+  for (int i = size -1; i >= 0; i--) {
+    number = (number << 8) | bytes[i];
+  }
+  return number;
+}
+
+static int compare_profile_points(const void * point1, const void * point2) {
+  return compare_profile_places(((const Profile_point *)point1)->place, ((const Profile_point *)point2)->place);
+}
+
+// reads the profile file, a file that is not a profile stops the compilation
+Profile * load_profile(const char * path) {
+  FILE * file_ptr = fopen(path, "rb");
+  if (file_ptr == NULL) {
+    errorf("File Error: Can not open the profile file: %s\n", path);
+  }
+  size_t size = 0;
+  size_t capacity = 4096;
+  uint8_t * bytes = smalloc(capacity);
+  size_t read_count;
+  while ((read_count = fread(bytes + size, 1, capacity - size, file_ptr)) > 0) {
+    size += read_count;
+    if (size == capacity) {
+      capacity *= 2;
+      bytes = srealloc(bytes, capacity);
+    }
+  }
+  fclose(file_ptr);
+
+  const size_t header_size = PROFILE_MAGIC_SIZE + 8;
+  const uint64_t points_count = size >= header_size ? read_profile_number(bytes + PROFILE_MAGIC_SIZE, 8) : 0;
+  const size_t point_size = 2 * 4 + PROFILE_COUNTERS_PER_POINT * 8;
+  if (size < header_size || memcmp(bytes, PROFILE_MAGIC, PROFILE_MAGIC_SIZE) != 0 || points_count > (size - header_size) / point_size
+      || size != header_size + points_count * point_size) {
+    sfree(bytes);
+    errorf("File Error: The file is not a profile of a program: %s\n", path);
+  }
+  Profile * profile = smalloc(sizeof(*profile));
+  *profile = (Profile) {
+    .points_count = points_count,
+    .places = smalloc(points_count * sizeof(*profile->places)),
+    .counts = smalloc(points_count * sizeof(*profile->counts)),
+    .max_block_runs = 0,
+    // FNV-1a
+    .hash = 0xcbf29ce484222325
+  };
+  for (size_t i = 0; i < size; i++) {
+    profile->hash = (profile->hash ^ bytes[i]) * 0x100000001b3;
+  }
+  const uint8_t * places = bytes + header_size;
+  const uint8_t * counters = places + points_count * 2 * 4;
+  // the places are sorted with their counts, to find them with a binary search
+  Profile_point * points = smalloc(points_count * sizeof(*points));
+  for (uint64_t i = 0; i < points_count; i++) {
+    points[i].place.line_number = read_profile_number(places + 8 * i, 4);
+    points[i].place.column_number = read_profile_number(places + 8 * i + 4, 4);
+    points[i].counts.runs = read_profile_number(counters + 16 * i, 8);
+    points[i].counts.block_runs = read_profile_number(counters + 16 * i + 8, 8);
+  }
+  qsort(points, points_count, sizeof(*points), compare_profile_points);
+  for (uint64_t i = 0; i < points_count; i++) {
+    profile->places[i] = points[i].place;
+    profile->counts[i] = points[i].counts;
+    if (points[i].counts.block_runs > profile->max_block_runs) {
+      profile->max_block_runs = points[i].counts.block_runs;
+    }
+  }
+  sfree(points);
+  sfree(bytes);
+  return profile;
+}
+
+void free_profile(Profile * profile) {
+  sfree(profile->places);
+  sfree(profile->counts);
+  sfree(profile);
+}
+
+// returns true if the profile has the counts of the point of the condition, a point of a changed program
+// may not be in it, and then nothing is known about it
+bool find_profile_counts(const Profile * profile, const Node_Expresion condition, Profile_counts * counts) {
+  if (profile == NULL) {
+    return false;
+  }
+  const int point = find_profile_place(profile->places, profile->points_count, get_profile_place(condition));
+  if (point == -1) {
+    return false;
+  }
+  *counts = profile->counts[point];
+  return true;
+}
+
+#endif
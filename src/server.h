@@ -0,0 +1,445 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <threads.h>
+#include <stdatomic.h>
+
+#include "mlib.h"
+#include "errors.h"
+#include "comp.h"
+#include "incremental.h"
+
+
+// the server and the client talk through a Unix domain socket,
+// every message is a header line followed by its payload:
+//   request:   [kind] [argument] [payload size]\n[payload]
+//     the kind "source" has the source code as payload and the output extension as argument
+//     the kind "file" has the path of the source code file as payload, the server reads it
+//     the kind "open" opens a document with the source code of the payload, for an editor
+//     the kind "edit" changes the document, the argument is [offset]:[removed length]
+//       and the payload has the inserted bytes
+//     the kind "stop" stops the server, its argument is ignored and its payload is empty
+//   response:  [status] [diagnostics size] [output size]\n[diagnostics][output]
+//     the status is "ok" or "error", the output is empty when the compilation failed
+//     the documents are only checked, their responses have all the errors and no output
+// a connection can send many requests one after the other, and has its own document
+// a payload larger than SERVER_MAX_PAYLOAD_SIZE is answered with an error and its connection is closed
+
+// max size of a header line, with the '\0'
+#define SERVER_HEADER_SIZE 128
+// max size of the payload of a request, the bigger ones are refused without reading them
+#define SERVER_MAX_PAYLOAD_SIZE ((size_t) 256 << 20)
+
+// reads from a socket through a buffer, so reading the header lines does not need a call per byte
+typedef struct Socket_reader {
+  int socket;
+  int begin;
+  int end;
+  char buffer[4096];
+} Socket_reader;
+
+// the socket the server listens on, shared by all the workers
+typedef struct Server {
+  int socket;
+  atomic_bool is_stopping;
+} Server;
+
+// a thread that serves connections until the server stops
+// the arena, the source buffer and the output streams are kept between requests,
+// so the memory they use is already there for the next compilation
+typedef struct Server_worker {
+  thrd_t thread;
+  Server * server;
+  Arena arena;
+  // the payload of the request, it grows to the size of the largest one
+  char * source;
+  size_t source_capacity;
+  FILE * output_stream;
+  char * output;
+  size_t output_size;
+  FILE * diagnostics_stream;
+  char * diagnostics;
+  size_t diagnostics_size;
+} Server_worker;
+
+// reads more data into the buffer, returns false if the connection was closed
+static bool fill_socket_reader(Socket_reader * reader) {
+  // move the data that was not read yet to the beginning
+  memmove(reader->buffer, reader->buffer + reader->begin, reader->end - reader->begin);
+  reader->end -= reader->begin;
+  reader->begin = 0;
+  ssize_t received;
+  do {
+    received = recv(reader->socket, reader->buffer + reader->end, sizeof(reader->buffer) - reader->end, 0);
+  } while (received < 0 && errno == EINTR);
+  if (received <= 0) {
+    return false;
+  }
+  reader->end += received;
+  return true;
+}
+
+// reads a line without its '\n', returns false if the connection was closed or the line does not fit
+static bool read_socket_line(Socket_reader * reader, char * line, const int line_capacity) {
+  int size = 0;
+  while (true) {
+    for (; reader->begin < reader->end; reader->begin++) {
+      const char symbol = reader->buffer[reader->begin];
+      if (symbol == '\n') {
+        reader->begin++;
+        line[size] = '\0';
+        return true;
+      }
+      if (size + 1 >= line_capacity) {
+        return false;
+      }
+      line[size++] = symbol;
+    }
+    if (!fill_socket_reader(reader)) {
+      return false;
+    }
+  }
+}
+
+// reads exactly the number of bytes, returns false if the connection was closed before
+static bool read_socket_bytes(Socket_reader * reader, char * bytes, const size_t size) {
+  size_t read_size = 0;
+  while (read_size < size) {
+    if (reader->begin == reader->end && !fill_socket_reader(reader)) {
+      return false;
+    }
+    const size_t available = reader->end - reader->begin;
+    const size_t count = size - read_size < available ? size - read_size : available;
+    memcpy(bytes + read_size, reader->buffer + reader->begin, count);
+    reader->begin += count;
+    read_size += count;
+  }
+  return true;
+}
+
+// returns false if the connection was closed before sending all the bytes
+static bool write_socket_bytes(const int socket, const char * bytes, size_t size) {
+  while (size > 0) {
+    // do not get killed by SIGPIPE if the other side closed the connection
+    ssize_t sent = send(socket, bytes, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+static bool write_socket_message(const int socket, const char * header, const char * payload1, const size_t payload1_size, const char * payload2, const size_t payload2_size) {
+  return write_socket_bytes(socket, header, strlen(header))
+      && write_socket_bytes(socket, payload1, payload1_size)
+      && write_socket_bytes(socket, payload2, payload2_size);
+}
+
+// answers a request that can not be served with the message as its diagnostics
+static void write_socket_error(const int socket, const char * message) {
+  char header[SERVER_HEADER_SIZE];
+  snprintf(header, sizeof(header), "error %zu 0\n", strlen(message));
+  write_socket_message(socket, header, message, strlen(message), NULL, 0);
+}
+
+// fills the address of the socket, if the path does not fit it throws an error
+static struct sockaddr_un get_socket_address(const char * socket_path) {
+  struct sockaddr_un address = { .sun_family = AF_UNIX };
+  if (strlen(socket_path) >= sizeof(address.sun_path)) {
+    errorf("Server Error: the socket path is too long: %s\n", socket_path);
+  }
+  strcpy(address.sun_path, socket_path);
+  return address;
+}
+
+// compiles the payload of the request into the output stream of the worker, returns if it succeeded
+// all the errors of the request, even the ones that are not in the code, go into the diagnostics stream
+static bool compile_server_request(Server_worker * worker, const bool is_file, const char * extension) {
+  active_arena = &worker->arena;
+  Diagnostics * volatile diagnostics = smalloc(sizeof(*diagnostics));
+  *diagnostics = (Diagnostics) { .diagnostics_count = 0, .diagnostics = NULL };
+  diagnostic_sink = diagnostics;
+  jmp_buf recovery_point;
+  error_recovery_point = &recovery_point;
+  volatile bool is_compiled = false;
+
+  if (setjmp(recovery_point) == 0) {
+    if (!is_supported_extension(extension)) {
+      error("the output file must have a supported file extension");
+    }
+    char * code = is_file ? file_contents(worker->source) : worker->source;
+    const Compilation_output output = { .extension = extension, .file_ptr = worker->output_stream };
+    compile_source(code, &output, 1, worker->diagnostics_stream);
+    is_compiled = true;
+  }
+
+  error_recovery_point = NULL;
+  diagnostic_sink = NULL;
+  print_diagnostics(worker->diagnostics_stream, *diagnostics);
+  // nothing of the compilation is needed anymore, the arena frees all of it at once
+  active_arena = NULL;
+  reset_arena(&worker->arena);
+  return is_compiled;
+}
+
+// opens or edits the document of the connection, and writes all its errors into the diagnostics stream
+// only the statements the edit changes are parsed again, returns if the document has no errors
+static bool serve_document_request(Server_worker * worker, Document ** document, const bool is_edit, const char * argument, const size_t payload_size) {
+  Diagnostics * volatile diagnostics = smalloc(sizeof(*diagnostics));
+  *diagnostics = (Diagnostics) { .diagnostics_count = 0, .diagnostics = NULL };
+  diagnostic_sink = diagnostics;
+  jmp_buf recovery_point;
+  error_recovery_point = &recovery_point;
+
+  if (setjmp(recovery_point) == 0) {
+    if (!is_edit) {
+      if (*document != NULL) {
+        close_document(*document);
+      }
+      *document = open_document(worker->source, payload_size);
+    }
+    else {
+      Text_edit edit = { .inserted = worker->source, .inserted_length = payload_size };
+      if (*document == NULL || sscanf(argument, "%d:%d", &edit.offset, &edit.removed_length) != 2) {
+        error("an edit needs an open document and the argument [offset]:[removed length]");
+      }
+      edit_document(*document, edit);
+    }
+  }
+
+  error_recovery_point = NULL;
+  diagnostic_sink = NULL;
+  bool is_valid = diagnostics->diagnostics_count == 0;
+  print_diagnostics(worker->diagnostics_stream, *diagnostics);
+  free_diagnostics(*diagnostics);
+  sfree(diagnostics);
+  if (*document != NULL) {
+    print_document_diagnostics(worker->diagnostics_stream, *document);
+    is_valid = is_valid && count_document_errors(*document) == 0;
+  }
+  return is_valid;
+}
+
+// answers the requests of a connection until it is closed
+static void serve_connection(Server_worker * worker, const int socket) {
+  Socket_reader * reader = smalloc(sizeof(*reader));
+  *reader = (Socket_reader) { .socket = socket, .begin = 0, .end = 0 };
+  char header[SERVER_HEADER_SIZE];
+  Document * document = NULL;
+
+  while (read_socket_line(reader, header, sizeof(header))) {
+    char kind[16];
+    char argument[32];
+    size_t payload_size;
+    if (sscanf(header, "%15s %31s %zu", kind, argument, &payload_size) != 3) {
+      write_socket_error(socket, "Error: invalid request to the server\n");
+      break;
+    }
+    if (strcmp(kind, "stop") == 0) {
+      atomic_store(&worker->server->is_stopping, true);
+      // wake up the workers waiting for a connection
+      shutdown(worker->server->socket, SHUT_RDWR);
+      write_socket_message(socket, "ok 0 0\n", NULL, 0, NULL, 0);
+      break;
+    }
+
+    // the payload is not read, so the connection can not go on after refusing it
+    if (payload_size > SERVER_MAX_PAYLOAD_SIZE) {
+      write_socket_error(socket, "Error: the request to the server is too large\n");
+      break;
+    }
+    // a request must never stop the server, so the memory that can not be allocated only ends the connection
+    if (payload_size + 1 > worker->source_capacity) {
+      char * source = realloc(worker->source, payload_size + 1);
+      if (source == NULL) {
+        write_socket_error(socket, "Error: the server does not have memory for the request\n");
+        break;
+      }
+      worker->source = source;
+      worker->source_capacity = payload_size + 1;
+    }
+    if (!read_socket_bytes(reader, worker->source, payload_size)) {
+      break;
+    }
+    worker->source[payload_size] = '\0';
+
+    // reuse the memory of the streams, overwriting the previous request
+    fseeko(worker->output_stream, 0, SEEK_SET);
+    fseeko(worker->diagnostics_stream, 0, SEEK_SET);
+    bool is_compiled;
+    if (strcmp(kind, "open") == 0 || strcmp(kind, "edit") == 0) {
+      is_compiled = serve_document_request(worker, &document, strcmp(kind, "edit") == 0, argument, payload_size);
+    }
+    else {
+      // a file without extension is sent as "-"
+      is_compiled = compile_server_request(worker, strcmp(kind, "file") == 0, strcmp(argument, "-") == 0 ? "" : argument);
+    }
+    fflush(worker->output_stream);
+    fflush(worker->diagnostics_stream);
+    const size_t output_size = is_compiled ? (size_t) ftello(worker->output_stream) : 0;
+    const size_t diagnostics_size = ftello(worker->diagnostics_stream);
+
+    snprintf(header, sizeof(header), "%s %zu %zu\n", is_compiled ? "ok" : "error", diagnostics_size, output_size);
+    if (!write_socket_message(socket, header, worker->diagnostics, diagnostics_size, worker->output, output_size)) {
+      break;
+    }
+  }
+
+  if (document != NULL) {
+    close_document(document);
+  }
+  sfree(reader);
+  close(socket);
+}
+
+static int server_worker(void * worker_ptr) {
+  Server_worker * worker = worker_ptr;
+  worker->arena = create_arena();
+  worker->source = NULL;
+  worker->source_capacity = 0;
+  worker->output_stream = open_memstream(&worker->output, &worker->output_size);
+  worker->diagnostics_stream = open_memstream(&worker->diagnostics, &worker->diagnostics_size);
+  if (worker->output_stream == NULL || worker->diagnostics_stream == NULL) {
+    errorf("Server Error: can not create the output streams\n");
+  }
+
+  while (!atomic_load(&worker->server->is_stopping)) {
+    int socket = accept(worker->server->socket, NULL, NULL);
+    if (socket < 0) {
+      // it fails when the server stops, or if the connection was closed before accepting it
+      continue;
+    }
+    serve_connection(worker, socket);
+  }
+
+  fclose(worker->output_stream);
+  free(worker->output);
+  fclose(worker->diagnostics_stream);
+  free(worker->diagnostics);
+  sfree(worker->source);
+  destroy_arena(&worker->arena);
+  return 0;
+}
+
+// listens on the socket and compiles the requests, until a request stops it
+// the connections are distributed between a number of threads
+void run_server(const char * socket_path, const int workers_count) {
+  struct sockaddr_un address = get_socket_address(socket_path);
+  Server server;
+  atomic_init(&server.is_stopping, false);
+  server.socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server.socket < 0) {
+    errorf("Server Error: can not create the socket\n");
+  }
+  // remove the socket left by a previous server, but never other type of file
+  struct stat file_info;
+  if (stat(socket_path, &file_info) == 0 && S_ISSOCK(file_info.st_mode)) {
+    unlink(socket_path);
+  }
+  if (bind(server.socket, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(server.socket, SOMAXCONN) != 0) {
+    errorf("Server Error: can not listen on the socket: %s\n", socket_path);
+  }
+  printf("server listening on %s\n", socket_path);
+  fflush(stdout);
+
+  Server_worker * workers = smalloc(workers_count * sizeof(*workers));
+  for (int i = 0; i < workers_count; i++) {
+    workers[i].server = &server;
+  }
+  if (workers_count == 1) {
+    server_worker(&workers[0]);
+  }
+  else {
+    for (int i = 0; i < workers_count; i++) {
+      if (thrd_create(&workers[i].thread, server_worker, &workers[i]) != thrd_success) {
+        errorf("Execution Error: can not create the worker thread %d\n", i);
+      }
+    }
+    for (int i = 0; i < workers_count; i++) {
+      thrd_join(workers[i].thread, NULL);
+    }
+  }
+  sfree(workers);
+
+  close(server.socket);
+  unlink(socket_path);
+}
+
+static int connect_to_server(const char * socket_path) {
+  struct sockaddr_un address = get_socket_address(socket_path);
+  int server_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server_socket < 0 || connect(server_socket, (struct sockaddr *) &address, sizeof(address)) != 0) {
+    errorf("Server Error: can not connect to the server at: %s\n", socket_path);
+  }
+  return server_socket;
+}
+
+// sends a request to the server and reads its response
+// the diagnostics are printed and the output is written in the output file, if there is one
+// returns if the server could do the request
+static bool send_server_request(const char * socket_path, const char * header, const char * payload, const size_t payload_size, const char * result_file) {
+  const int server_socket = connect_to_server(socket_path);
+  if (!write_socket_message(server_socket, header, payload, payload_size, NULL, 0)) {
+    errorf("Server Error: the server closed the connection\n");
+  }
+
+  Socket_reader * reader = smalloc(sizeof(*reader));
+  *reader = (Socket_reader) { .socket = server_socket, .begin = 0, .end = 0 };
+  char response_header[SERVER_HEADER_SIZE];
+  char status[16];
+  size_t diagnostics_size;
+  size_t output_size;
+  if (!read_socket_line(reader, response_header, sizeof(response_header))
+   || sscanf(response_header, "%15s %zu %zu", status, &diagnostics_size, &output_size) != 3) {
+    errorf("Server Error: invalid response from the server\n");
+  }
+  char * response = smalloc(diagnostics_size + output_size);
+  if (!read_socket_bytes(reader, response, diagnostics_size + output_size)) {
+    errorf("Server Error: the server closed the connection\n");
+  }
+  close(server_socket);
+
+  fwrite(response, 1, diagnostics_size, stdout);
+  const bool is_ok = strcmp(status, "ok") == 0;
+  if (is_ok && result_file != NULL) {
+    FILE * out_file_ptr = create_output_file(result_file);
+    if (out_file_ptr == NULL) {
+      errorf("File Error: Can not create the file: %s\n", result_file);
+    }
+    fwrite(response + diagnostics_size, 1, output_size, out_file_ptr);
+    fclose(out_file_ptr);
+  }
+  sfree(response);
+  sfree(reader);
+  return is_ok;
+}
+
+// compiles the file in the server listening on the socket, returns if the compilation succeeded
+bool run_client(const char * socket_path, const char * source_code_file, const char * result_file) {
+  char * code = file_contents(source_code_file);
+  const size_t code_size = strlen(code);
+  char header[SERVER_HEADER_SIZE];
+  // a file without extension is sent as "-", so the header always has all its fields
+  const char * extension = get_file_extension(result_file);
+  snprintf(header, sizeof(header), "source %s %zu\n", extension[0] != '\0' ? extension : "-", code_size);
+  const bool is_compiled = send_server_request(socket_path, header, code, code_size, result_file);
+  sfree(code);
+  return is_compiled;
+}
+
+// stops the server listening on the socket
+void stop_server(const char * socket_path) {
+  send_server_request(socket_path, "stop - 0\n", NULL, 0, NULL);
+}
+
+#endif
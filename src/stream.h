@@ -0,0 +1,180 @@
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include "mlib.h"
+#include "errors.h"
+#include "tokenizer.h"
+#include "parser.h"
+
+
+/* * * * * * * * * * * * * * * * * *
+ * Streaming lexing of source code *
+ * * * * * * * * * * * * * * * * * */
+
+// a statement stream reads a source code file by chunks and gives its top level statements one by one,
+// so only the text and the tokens of the statements that have not been given yet are in memory
+
+// bytes read from the file at once, more are read when a statement does not fit
+#define STREAM_CHUNK_SIZE (1 << 16)
+
+typedef struct Statement_stream {
+  FILE * file_ptr;
+  bool is_file_ended;
+  // the text read and not given yet, it begins after the end of the last statement given
+  char * text;
+  size_t text_size;
+  size_t text_capacity;
+  // the place in the file of the beginning of the text, for the lexer
+  int line_number;
+  int column_number;
+  // the tokens of the text, its text is in the active token texts while they are in use
+  Token_list tokens;
+  // index of the first token of the next statement
+  int next_token;
+  // the errors of the lexer in the text, sorted by their place, and the first not given yet
+  Diagnostics lexer_diagnostics;
+  int next_diagnostic;
+} Statement_stream;
+
+Statement_stream * open_statement_stream(const char * file_path) {
+  FILE * file_ptr = fopen(file_path, "r");
+  if (file_ptr == NULL) {
+    errorf("File Error: Can not open the input code file: %s\n", file_path);
+  }
+  Statement_stream * stream = smalloc(sizeof(*stream));
+  *stream = (Statement_stream) {
+    .file_ptr = file_ptr,
+    .is_file_ended = false,
+    .text = smalloc(STREAM_CHUNK_SIZE + 1),
+    .text_size = 0,
+    .text_capacity = STREAM_CHUNK_SIZE + 1,
+    .line_number = 1,
+    .column_number = 1,
+    .tokens = { .tokens_count = 0, .offsets = NULL, .lengths = NULL, .types = NULL, .numbers_count = 0, .number_tokens = NULL, .number_values = NULL,
+                .lines = { .lines_count = 0, .line_beginnings = NULL } },
+    .next_token = 0,
+    .lexer_diagnostics = { .diagnostics_count = 0, .diagnostics = NULL },
+    .next_diagnostic = 0
+  };
+  stream->text[0] = '\0';
+  return stream;
+}
+
+// frees the errors of the lexer that were not given, they are found again when the text is lexed again
+static void free_stream_lexer_diagnostics(Statement_stream * stream) {
+  for (int i = stream->next_diagnostic; i < stream->lexer_diagnostics.diagnostics_count; i++) {
+    sfree(stream->lexer_diagnostics.diagnostics[i].message);
+  }
+  sfree(stream->lexer_diagnostics.diagnostics);
+  stream->lexer_diagnostics = (Diagnostics) { .diagnostics_count = 0, .diagnostics = NULL };
+  stream->next_diagnostic = 0;
+}
+
+void close_statement_stream(Statement_stream * stream) {
+  fclose(stream->file_ptr);
+  free_stream_lexer_diagnostics(stream);
+  if (active_token_texts != NULL) {
+    remove_token_text(active_token_texts, stream->text);
+  }
+  free_token_list(stream->tokens);
+  sfree(stream->text);
+  sfree(stream);
+}
+
+// removes from the text the statements already given, and reads more of the file after the rest
+// at least as many bytes as there are left, so a statement larger than a chunk is lexed a few times only
+static void read_statement_stream(Statement_stream * stream) {
+  // the tokens given before point into the text that is replaced
+  if (active_token_texts != NULL) {
+    remove_token_text(active_token_texts, stream->text);
+  }
+  // the text left begins after the last token of the last statement given
+  size_t consumed_size = 0;
+  if (stream->next_token > 0) {
+    consumed_size = stream->tokens.offsets[stream->next_token -1] + stream->tokens.lengths[stream->next_token -1];
+  }
+  for (size_t i = 0; i < consumed_size; i++) {
+    stream->column_number++;
+    if (stream->text[i] == '\n') {
+      stream->line_number++;
+      stream->column_number = 1;
+    }
+  }
+  stream->text_size -= consumed_size;
+  memmove(stream->text, stream->text + consumed_size, stream->text_size);
+
+  const size_t read_size = stream->text_size > STREAM_CHUNK_SIZE ? stream->text_size : STREAM_CHUNK_SIZE;
+  if (stream->text_size + read_size + 1 > stream->text_capacity) {
+    stream->text_capacity = stream->text_size + read_size + 1;
+    stream->text = srealloc(stream->text, stream->text_capacity);
+  }
+  const size_t read_count = fread(stream->text + stream->text_size, 1, read_size, stream->file_ptr);
+  if (read_count < read_size) {
+    if (ferror(stream->file_ptr)) {
+      errorf("File Error: Can not read the input code file\n");
+    }
+    stream->is_file_ended = true;
+  }
+  stream->text_size += read_count;
+  stream->text[stream->text_size] = '\0';
+
+  // lex the text again, its errors are given with the statements
+  free_token_list(stream->tokens);
+  free_stream_lexer_diagnostics(stream);
+  Diagnostics * previous_sink = diagnostic_sink;
+  diagnostic_sink = &stream->lexer_diagnostics;
+  stream->tokens = lexer_from(stream->text, stream->line_number, stream->column_number);
+  diagnostic_sink = previous_sink;
+  stream->next_token = 0;
+  if (active_token_texts != NULL) {
+    add_token_list_text(active_token_texts, &stream->tokens);
+  }
+}
+
+// gives the errors of the lexer that are before the token of the index to the current diagnostic sink,
+// or all of them if the index is -1
+static void give_stream_lexer_diagnostics(Statement_stream * stream, const int last_token_idx) {
+  Diagnostic last_token_position = { .line_number = 0, .column_number = 0 };
+  if (last_token_idx != -1) {
+    const Token_place place = get_listed_token_place(&stream->tokens, last_token_idx);
+    last_token_position = (Diagnostic) { .line_number = place.line_number, .column_number = place.column_number };
+  }
+  for (; stream->next_diagnostic < stream->lexer_diagnostics.diagnostics_count; stream->next_diagnostic++) {
+    const Diagnostic diagnostic = stream->lexer_diagnostics.diagnostics[stream->next_diagnostic];
+    if (last_token_idx != -1 && !is_diagnostic_before(diagnostic, last_token_position)) {
+      break;
+    }
+    append_diagnostic(diagnostic_sink, diagnostic);
+  }
+}
+
+// sets the tokens of the next top level statement, and returns false when there are no more statements
+// the tokens are valid until the next call, and point into a text that is also valid until then
+bool next_stream_statement(Statement_stream * stream, Token_span * statement_tokens) {
+  while (true) {
+    const Token_list * tokens = &stream->tokens;
+    const int first = stream->next_token;
+    if (first < tokens->tokens_count) {
+      bool is_complete;
+      const int last = statement_end_index(get_list_span(tokens), first, &is_complete);
+      // a '}' can be followed by an else block, that must be read whole to know it is not cut
+      const bool is_next_token_read = last + 2 < tokens->tokens_count;
+      const bool is_given = stream->is_file_ended
+                         || (is_complete && (tokens->types[last] == Semi_colon || is_next_token_read));
+      if (is_given) {
+        *statement_tokens = (Token_span) { .list = tokens, .first = first, .end = last + 1 };
+        stream->next_token = last + 1;
+        give_stream_lexer_diagnostics(stream, last);
+        return true;
+      }
+    }
+    else if (stream->is_file_ended) {
+      // the errors after the last statement
+      give_stream_lexer_diagnostics(stream, -1);
+      return false;
+    }
+    read_statement_stream(stream);
+  }
+}
+
+#endif
@@ -3,30 +3,70 @@
 
 #include "errors.h"
 #include "mlib.h"
+#include <stdint.h>
 
 #define NULL_TOKEN (Token) { .beginning=NULL, .length=0, .type=End_of_file }
 
 
+typedef enum Token_type {
+  Identifier,
+  Number,
+  Operation,
+  Colon,
+  Semi_colon,
+  Curly_bracket,
+  Bracket,
+  Square_bracket,
+  Comma,
+  End_of_file
+} Token_type;
+
+// a token of the code, it is what the parser and the syntax tree use
+// it does not keep its place in the code, that is found from its text only for the errors, see get_token_place()
 typedef struct Token {
   char * beginning;
-  unsigned short length;
-  enum {
-    Identifier,
-    Number,
-    Operation,
-    Colon,
-    Semi_colon,
-    Curly_bracket,
-    Bracket,
-    Square_bracket,
-    Comma,
-    End_of_file
-  } type;
-  // extra info for better error messages
-  int line_number;
-  short column_number;
+  int length;
+  Token_type type;
+  // the value of a number token, the lexer reads it once
+  uint64_t value;
 } Token;
 
+// the place of a token in the code, the line is 0 if the token is not in the code
+typedef struct Token_place {
+  int line_number;
+  int column_number;
+} Token_place;
+
+// the beginnings of the lines of a text, the places in the text are found from them
+typedef struct Text_lines {
+  int lines_count;
+  int lines_capacity;
+  // offset of the beginning of every line of the text, the first one is 0
+  uint32_t * line_beginnings;
+  // the place of the beginning of the text
+  int first_line_number;
+  int first_column_number;
+} Text_lines;
+
+// the tokens of a text as the lexer gives them, in a compact form: only the offset, the length and the type
+// of every token are kept, in separate arrays, and the place of a token is found from the beginnings
+// of the lines of the text only when it is needed
+typedef struct Token_list {
+  char * text;
+  int text_size;
+  int tokens_count;
+  int tokens_capacity;
+  uint32_t * offsets;
+  uint32_t * lengths;
+  uint8_t * types;
+  // the values of the number tokens in their order, with the index of the token of every one
+  int numbers_count;
+  int numbers_capacity;
+  uint32_t * number_tokens;
+  uint64_t * number_values;
+  Text_lines lines;
+} Token_list;
+
 
 #ifdef DEBUG
 void D_print_token(const Token token) {
@@ -50,16 +90,126 @@ bool is_in_str(char symbol, const char * string) {
   return false;
 }
 
-// appends a token to the end of the array of tokens
-static Token * append_token(Token * tokens, int tokens_count, const Token token) {
-  tokens_count += 1;
-  tokens = srealloc(tokens, sizeof(Token) * (tokens_count + 1));
-  tokens[tokens_count -1] = token;
-  return tokens;
+// appends a token to the end of the list, the arrays grow twice as much every time
+static void append_token(Token_list * tokens, const int offset, const int length, const Token_type type) {
+  if (tokens->tokens_count == tokens->tokens_capacity) {
+    tokens->tokens_capacity = 2 * tokens->tokens_capacity + 16;
+    tokens->offsets = srealloc(tokens->offsets, tokens->tokens_capacity * sizeof(*tokens->offsets));
+    tokens->lengths = srealloc(tokens->lengths, tokens->tokens_capacity * sizeof(*tokens->lengths));
+    tokens->types = srealloc(tokens->types, tokens->tokens_capacity * sizeof(*tokens->types));
+  }
+  tokens->offsets[tokens->tokens_count] = offset;
+  tokens->lengths[tokens->tokens_count] = length;
+  tokens->types[tokens->tokens_count] = type;
+  tokens->tokens_count++;
+}
+
+static void append_number_value(Token_list * tokens, const uint64_t value) {
+  if (tokens->numbers_count == tokens->numbers_capacity) {
+    tokens->numbers_capacity = 2 * tokens->numbers_capacity + 16;
+    tokens->number_tokens = srealloc(tokens->number_tokens, tokens->numbers_capacity * sizeof(*tokens->number_tokens));
+    tokens->number_values = srealloc(tokens->number_values, tokens->numbers_capacity * sizeof(*tokens->number_values));
+  }
+  tokens->number_tokens[tokens->numbers_count] = tokens->tokens_count -1;
+  tokens->number_values[tokens->numbers_count] = value;
+  tokens->numbers_count++;
+}
+
+// the arrays of the list do not grow after the lexer, so they only keep the space of their items,
+// the whole list is kept while the program is parsed
+static void shrink_token_list(Token_list * tokens) {
+  if (tokens->tokens_count > 0) {
+    tokens->tokens_capacity = tokens->tokens_count;
+    tokens->offsets = srealloc(tokens->offsets, tokens->tokens_capacity * sizeof(*tokens->offsets));
+    tokens->lengths = srealloc(tokens->lengths, tokens->tokens_capacity * sizeof(*tokens->lengths));
+    tokens->types = srealloc(tokens->types, tokens->tokens_capacity * sizeof(*tokens->types));
+  }
+  if (tokens->numbers_count > 0) {
+    tokens->numbers_capacity = tokens->numbers_count;
+    tokens->number_tokens = srealloc(tokens->number_tokens, tokens->numbers_capacity * sizeof(*tokens->number_tokens));
+    tokens->number_values = srealloc(tokens->number_values, tokens->numbers_capacity * sizeof(*tokens->number_values));
+  }
+  tokens->lines.lines_capacity = tokens->lines.lines_count;
+  tokens->lines.line_beginnings = srealloc(tokens->lines.line_beginnings, tokens->lines.lines_capacity * sizeof(*tokens->lines.line_beginnings));
+}
+
+// returns the value of a digit in any base up to 16, or 16 if it is not one
+static int get_digit_value(const char symbol) {
+  if (symbol >= '0' && symbol <= '9') {
+    return symbol - '0';
+  }
+  if (symbol >= 'a' && symbol <= 'f') {
+    return symbol - 'a' + 10;
+  }
+  if (symbol >= 'A' && symbol <= 'F') {
+    return symbol - 'A' + 10;
+  }
+  return 16;
+}
+
+// reads a number in decimal, or in hexadecimal after `0x` and binary after `0b`,
+// the errors are reported at the place of the token and the number is 0 then
+static uint64_t read_number(char * text, const int length, const int line_number, const int column_number) {
+  const Token number = { .beginning = text, .length = length, .type = Number };
+  uint64_t base = 10;
+  int i = 0;
+  if (length >= 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+    base = 16;
+    i = 2;
+  }
+  else if (length >= 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B')) {
+    base = 2;
+    i = 2;
+  }
+  if (i == length) {
+    report_error_at(line_number, column_number, "expected digits after the prefix of the number (%t)\n", number);
+    return 0;
+  }
+  uint64_t result = 0;
+  for (; i < length; i++) {
+    const uint64_t digit = get_digit_value(text[i]);
+    if (digit >= base) {
+      report_error_at(line_number, column_number, "invalid digit (%c) in the number (%t)\n", text[i], number);
+      return 0;
+    }
+    if (result > (UINT64_MAX - digit) / base) {
+      report_error_at(line_number, column_number, "the number (%t) does not fit in 64 bits\n", number);
+      return 0;
+    }
+    result = result * base + digit;
+  }
+  return result;
+}
+
+static void append_line_beginning(Text_lines * lines, const int offset) {
+  if (lines->lines_count == lines->lines_capacity) {
+    lines->lines_capacity = 2 * lines->lines_capacity + 16;
+    lines->line_beginnings = srealloc(lines->line_beginnings, lines->lines_capacity * sizeof(*lines->line_beginnings));
+  }
+  lines->line_beginnings[lines->lines_count] = offset;
+  lines->lines_count++;
 }
 
-// TODO: add linked list for O(1) time when appending tokens
-Token * lexer(char * string) {
+// the lines of a text that begins at the given line and column
+Text_lines get_text_lines(const char * text, const int text_size, const int first_line_number, const int first_column_number) {
+  Text_lines lines = {
+    .lines_count = 0,
+    .lines_capacity = 0,
+    .line_beginnings = NULL,
+    .first_line_number = first_line_number,
+    .first_column_number = first_column_number
+  };
+  append_line_beginning(&lines, 0);
+  for (int i = 0; i < text_size; i++) {
+    if (text[i] == '\n') {
+      append_line_beginning(&lines, i + 1);
+    }
+  }
+  return lines;
+}
+
+// the string begins at the given line and column, so a part of a file can be lexed on its own
+Token_list lexer_from(char * string, const int first_line_number, const int first_column_number) {
   typedef enum {
     searching_token,
     identifier,
@@ -73,13 +223,34 @@ Token * lexer(char * string) {
   const char * oper_sym = "+-*/%^><&";
   const char * separ_sym = " \r\t\n";
 
-  int token_beginning = 0;
-  int token_count = 0;
-  Token * token_array = malloc(token_count * sizeof(Token));
-  Token new_token = NULL_TOKEN;
+  Token_list tokens = {
+    .text = string,
+    .text_size = 0,
+    .tokens_count = 0,
+    .tokens_capacity = 0,
+    .offsets = NULL,
+    .lengths = NULL,
+    .types = NULL,
+    .numbers_count = 0,
+    .numbers_capacity = 0,
+    .number_tokens = NULL,
+    .number_values = NULL,
+    .lines = {
+      .lines_count = 0,
+      .lines_capacity = 0,
+      .line_beginnings = NULL,
+      .first_line_number = first_line_number,
+      .first_column_number = first_column_number
+    }
+  };
+  append_line_beginning(&tokens.lines, 0);
 
-  int line_number = 1;
-  int column_number = 1;
+  int token_beginning = 0;
+  // only for the errors of the lexer, the places of the tokens are found from the lines
+  int line_number = first_line_number;
+  int column_number = first_column_number;
+  // the column of the first symbol of the token, for the errors of the numbers
+  int token_column_number = first_column_number;
 
   int i;
   for (i = 0; string[i] != '\0'; i++) {
@@ -88,6 +259,7 @@ Token * lexer(char * string) {
     switch (mode) {
       case searching_token:
         token_beginning = i;
+        token_column_number = column_number;
         if (is_in_str(symbol, var_sym)) {
           mode = identifier;
           i--;
@@ -109,29 +281,16 @@ Token * lexer(char * string) {
         else if (symbol == '=') {
           // check for equality operator
           if (string[i + 1] == '=') {
-            new_token.beginning = string + token_beginning;
-            new_token.length = 2;
-            new_token.type = Operation;
-            new_token.line_number = line_number;
-            new_token.column_number = column_number;
-
-            token_array = append_token(token_array, token_count, new_token);
-            token_count++;
+            append_token(&tokens, token_beginning, 2, Operation);
 
             // add 1 because the token is 1 character longer
             i += 1;
+            column_number += 1;
             token_beginning = i;
             mode = searching_token;            
           } // otherwise it is an assignment
           else {
-            new_token.beginning = string + token_beginning;
-            new_token.length = 1;
-            new_token.type = Operation;
-            new_token.line_number = line_number;
-            new_token.column_number = column_number;
-
-            token_array = append_token(token_array, token_count, new_token);
-            token_count++;
+            append_token(&tokens, token_beginning, 1, Operation);
 
             token_beginning = i;
             mode = searching_token;
@@ -140,105 +299,44 @@ Token * lexer(char * string) {
 
         // deal here with sigle symbol tokens
         else if (symbol == ':') {
-          new_token.beginning = string + token_beginning;
-          new_token.length = 1;
-          new_token.type = Colon;
-          new_token.line_number = line_number;
-          new_token.column_number = column_number;
-
-          token_array = append_token(token_array, token_count, new_token);
-          token_count++;
-
-          token_beginning = i;
+          append_token(&tokens, token_beginning, 1, Colon);
           mode = searching_token;
         }
         else if (symbol == ';') {
-          new_token.beginning = string + token_beginning;
-          new_token.length = 1;
-          new_token.type = Semi_colon;
-          new_token.line_number = line_number;
-          new_token.column_number = column_number;
-
-          token_array = append_token(token_array, token_count, new_token);
-          token_count++;
-
-          token_beginning = i;
+          append_token(&tokens, token_beginning, 1, Semi_colon);
           mode = searching_token;
         }
         else if (symbol == '{' || symbol == '}') {
-          new_token.beginning = string + token_beginning;
-          new_token.length = 1;
-          new_token.type = Curly_bracket;
-          new_token.line_number = line_number;
-          new_token.column_number = column_number;
-
-          token_array = append_token(token_array, token_count, new_token);
-          token_count++;
-
-          token_beginning = i;
+          append_token(&tokens, token_beginning, 1, Curly_bracket);
           mode = searching_token;
         }
         else if (symbol == '(' || symbol == ')') {
-          new_token.beginning = string + token_beginning;
-          new_token.length = 1;
-          new_token.type = Bracket;
-          new_token.line_number = line_number;
-          new_token.column_number = column_number;
-
-          token_array = append_token(token_array, token_count, new_token);
-          token_count++;
-
-          token_beginning = i;
+          append_token(&tokens, token_beginning, 1, Bracket);
           mode = searching_token;
         }
         else if (symbol == '[' || symbol == ']') {
-          new_token.beginning = string + token_beginning;
-          new_token.length = 1;
-          new_token.type = Square_bracket;
-          new_token.line_number = line_number;
-          new_token.column_number = column_number;
-
-          token_array = append_token(token_array, token_count, new_token);
-          token_count++;
-
-          token_beginning = i;
+          append_token(&tokens, token_beginning, 1, Square_bracket);
           mode = searching_token;
         }
         else if (symbol == ',') {
-          new_token.beginning = string + token_beginning;
-          new_token.length = 1;
-          new_token.type = Comma;
-          new_token.line_number = line_number;
-          new_token.column_number = column_number;
-
-          token_array = append_token(token_array, token_count, new_token);
-          token_count++;
-
-          token_beginning = i;
+          append_token(&tokens, token_beginning, 1, Comma);
           mode = searching_token;
         }
         else if (symbol == '\n') {
           line_number += 1;
           column_number = 1;
+          append_line_beginning(&tokens.lines, i + 1);
         }
-        // throw error if the symbol is not allowed
+        // report the symbol if it is not allowed, and skip it to keep looking for errors
         else if (!is_in_str(symbol, separ_sym)) {
-          errorf("Line:%d, column:%d.  Error: unkown type of symbol (%c)\n", line_number, column_number, symbol);
+          report_error_at(line_number, column_number, "unkown type of symbol (%c)\n", symbol);
         }
         
         break;
       
       case identifier:
-        new_token.type = Identifier;
         if (!is_in_str(symbol, var_sym) && !is_in_str(symbol, numb_sym)) {
-          new_token.beginning = string + token_beginning;
-          new_token.length = (unsigned short) (i - token_beginning);
-          new_token.type = Identifier;
-          new_token.line_number = line_number;
-          new_token.column_number = column_number;
-
-          token_array = append_token(token_array, token_count, new_token);
-          token_count++;
+          append_token(&tokens, token_beginning, i - token_beginning, Identifier);
 
           token_beginning = i;
           mode = searching_token;
@@ -249,17 +347,11 @@ Token * lexer(char * string) {
         break;
       
       case number:
-        new_token.type = Number;
-        if (!is_in_str(symbol, numb_sym)) {
-          new_token.beginning = string + token_beginning;
-          new_token.length = (unsigned short) (i - token_beginning);
-          new_token.type = Number;
-          new_token.line_number = line_number;
-          new_token.column_number = column_number;
-
-          token_array = append_token(token_array, token_count, new_token);
-          token_count++;
-          
+        // the letters are read with the digits, for the prefixes and the hexadecimal digits
+        if (!is_in_str(symbol, numb_sym) && !is_in_str(symbol, var_sym)) {
+          append_token(&tokens, token_beginning, i - token_beginning, Number);
+          append_number_value(&tokens, read_number(&string[token_beginning], i - token_beginning, line_number, token_column_number));
+
           token_beginning = i;
           mode = searching_token;
           i--;
@@ -270,14 +362,7 @@ Token * lexer(char * string) {
       
       case operation:
         // the operation tokens (that have not been handled already) are 1 character large
-        new_token.beginning = string + token_beginning;
-        new_token.length = 1;
-        new_token.type = Operation;
-        new_token.line_number = line_number;
-        new_token.column_number = column_number;
-
-        token_array = append_token(token_array, token_count, new_token);
-        token_count++;
+        append_token(&tokens, token_beginning, 1, Operation);
 
         token_beginning = i;
         mode = searching_token;
@@ -288,18 +373,198 @@ Token * lexer(char * string) {
         implementation_error("unkown tokenizer State");
     }
   }
-  // if theres still a token left add it to the token array
+  // if theres still a token left add it to the token list
   if (mode != searching_token) {
-    new_token.beginning = string + token_beginning;
-    new_token.length = (unsigned short) (i - token_beginning);
+    append_token(&tokens, token_beginning, i - token_beginning, mode == identifier ? Identifier : (mode == number ? Number : Operation));
+    if (mode == number) {
+      append_number_value(&tokens, read_number(&string[token_beginning], i - token_beginning, line_number, token_column_number));
+    }
+  }
+  tokens.text_size = i;
+  shrink_token_list(&tokens);
+
+  return tokens;
+}
+
+Token_list lexer(char * string) {
+  return lexer_from(string, 1, 1);
+}
+
+// frees the tokens of the list, its lines are kept to find the places of the tokens taken out of it
+void free_listed_tokens(Token_list * tokens) {
+  sfree(tokens->offsets);
+  sfree(tokens->lengths);
+  sfree(tokens->types);
+  sfree(tokens->number_tokens);
+  sfree(tokens->number_values);
+  tokens->offsets = NULL;
+  tokens->lengths = NULL;
+  tokens->types = NULL;
+  tokens->number_tokens = NULL;
+  tokens->number_values = NULL;
+  tokens->tokens_count = 0;
+  tokens->numbers_count = 0;
+}
+
+void free_token_list(Token_list tokens) {
+  free_listed_tokens(&tokens);
+  sfree(tokens.lines.line_beginnings);
+}
+
+// returns the type of the token, or End_of_file after the last one
+static inline Token_type get_token_type(const Token_list * tokens, const int idx) {
+  return idx < tokens->tokens_count ? (Token_type) tokens->types[idx] : End_of_file;
+}
 
-    token_array = append_token(token_array, token_count, new_token);
-    token_count += 1;
+// binary search of the value of the number token
+static uint64_t get_number_value(const Token_list * tokens, const int idx) {
+  int first = 0;
+  int last = tokens->numbers_count -1;
+  while (first < last) {
+    const int middle = (first + last) / 2;
+    if ((int) tokens->number_tokens[middle] < idx) {
+      first = middle + 1;
+    }
+    else {
+      last = middle;
+    }
   }
-  // append null token to mark the end of the array
-  token_array = append_token(token_array, token_count, NULL_TOKEN);
+  return tokens->number_values[first];
+}
+
+// returns the token, or a NULL_TOKEN after the last one
+static inline Token get_token(const Token_list * tokens, const int idx) {
+  if (idx >= tokens->tokens_count) {
+    return NULL_TOKEN;
+  }
+  return (Token) {
+    .beginning = tokens->text + tokens->offsets[idx],
+    .length = tokens->lengths[idx],
+    .type = tokens->types[idx],
+    .value = tokens->types[idx] == Number ? get_number_value(tokens, idx) : 0
+  };
+}
+
 
-  return token_array;
+/* the places of the tokens */
+
+// binary search of the last line that begins before the offset
+static int find_text_line(const Text_lines * lines, const int offset) {
+  int first = 0;
+  int last = lines->lines_count -1;
+  while (first < last) {
+    const int middle = (first + last + 1) / 2;
+    if ((int) lines->line_beginnings[middle] <= offset) {
+      first = middle;
+    }
+    else {
+      last = middle -1;
+    }
+  }
+  return first;
+}
+
+// returns the place of the offset of the text, like the lexer counts it (the first column of a line is 2)
+Token_place get_text_place(const Text_lines * lines, const int offset) {
+  const int line_idx = find_text_line(lines, offset);
+  Token_place place = {
+    .line_number = lines->first_line_number + line_idx,
+    .column_number = offset - lines->line_beginnings[line_idx] + 2
+  };
+  if (line_idx == 0) {
+    place.column_number += lines->first_column_number - 1;
+  }
+  return place;
+}
+
+// the place of a token is the one of the symbol after it for the identifiers and the numbers,
+// that are found when it is read, and of its first symbol for the rest
+static int get_token_place_offset(const Token_type type, const int offset, const int length) {
+  return type == Identifier || type == Number ? offset + length : offset;
+}
+
+// returns the place of the token of the list
+Token_place get_listed_token_place(const Token_list * tokens, const int idx) {
+  return get_text_place(&tokens->lines, get_token_place_offset(tokens->types[idx], tokens->offsets[idx], tokens->lengths[idx]));
+}
+
+// a text that the tokens in use point into, the places of the tokens in [begin, end) are found from its lines
+typedef struct Token_text {
+  const char * begin;
+  const char * end;
+  // the beginning of the text the lines are counted from
+  const char * text;
+  Text_lines lines;
+} Token_text;
+
+// the texts of the tokens in use, sorted by their beginning
+typedef struct Token_texts {
+  int texts_count;
+  int texts_capacity;
+  Token_text * texts;
+} Token_texts;
+
+// the texts of the tokens of the compilation or the document of this thread, the errors find the places of the tokens in them
+thread_local Token_texts * active_token_texts = NULL;
+
+// binary search of the last text that begins at the address or before it, returns -1 if there is none
+static int find_token_text(const Token_texts * texts, const char * address) {
+  int first = 0;
+  int last = texts->texts_count -1;
+  while (first <= last) {
+    const int middle = (first + last) / 2;
+    if (texts->texts[middle].begin <= address) {
+      first = middle + 1;
+    }
+    else {
+      last = middle -1;
+    }
+  }
+  return first -1;
+}
+
+void add_token_text(Token_texts * texts, const Token_text text) {
+  if (texts->texts_count == texts->texts_capacity) {
+    texts->texts_capacity = 2 * texts->texts_capacity + 16;
+    texts->texts = srealloc(texts->texts, texts->texts_capacity * sizeof(*texts->texts));
+  }
+  const int idx = find_token_text(texts, text.begin) + 1;
+  memmove(&texts->texts[idx + 1], &texts->texts[idx], (texts->texts_count - idx) * sizeof(*texts->texts));
+  texts->texts[idx] = text;
+  texts->texts_count++;
+}
+
+// adds the whole text of the list
+void add_token_list_text(Token_texts * texts, const Token_list * tokens) {
+  add_token_text(texts, (Token_text) { .begin = tokens->text, .end = tokens->text + tokens->text_size, .text = tokens->text, .lines = tokens->lines });
+}
+
+// returns the text that begins at the address, or NULL
+Token_text * get_token_text(const Token_texts * texts, const char * begin) {
+  const int idx = find_token_text(texts, begin);
+  return idx >= 0 && texts->texts[idx].begin == begin ? &texts->texts[idx] : NULL;
+}
+
+void remove_token_text(Token_texts * texts, const char * begin) {
+  const int idx = find_token_text(texts, begin);
+  if (idx < 0 || texts->texts[idx].begin != begin) {
+    return;
+  }
+  texts->texts_count--;
+  memmove(&texts->texts[idx], &texts->texts[idx + 1], (texts->texts_count - idx) * sizeof(*texts->texts));
+}
+
+// returns the place of the token in the code, from the active texts
+Token_place get_token_place(const Token token) {
+  if (active_token_texts == NULL || token.beginning == NULL) {
+    return (Token_place) { .line_number = 0, .column_number = 0 };
+  }
+  const int idx = find_token_text(active_token_texts, token.beginning);
+  if (idx < 0 || token.beginning >= active_token_texts->texts[idx].end) {
+    return (Token_place) { .line_number = 0, .column_number = 0 };
+  }
+  const Token_text * text = &active_token_texts->texts[idx];
+  return get_text_place(&text->lines, get_token_place_offset(token.type, token.beginning - text->text, token.length));
 }
 
 
@@ -313,24 +578,11 @@ bool compare_token_to_string(const Token token, const char * string) {
   return i == token.length && string[i] == '\0';
 }
 
-// converts the string of the number token to an integer assuming it is in ascii and decimal
-int number_token_to_int(const Token number) {
-  if (number.type != Number) {
-    implementation_error("tried to convert token to integer but token is not type Number");
-  }
-  int result = 0;
-  for (int i = 0; i < number.length; i++) {
-    result *= 10;
-    result += number.beginning[i] - '0';
-  }
-  return result;
-}
-
 // returns if 2 tokens are equal
 bool compare_str_of_tokens(const Token token1, const Token token2) {
-  // if the tokens are number see if their integer values are the same
+  // if the tokens are number see if their values are the same
   if (token1.type == Number && token2.type == Number) {
-    return number_token_to_int(token1) == number_token_to_int(token2);
+    return token1.value == token2.value;
   }
   if (token1.length != token2.length) {
     return false;
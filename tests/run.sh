@@ -0,0 +1,287 @@
+#!/bin/sh
+# regression tests of the compiler
+# every test writes a program in $OUT, runs the compiler on it and checks what it printed or its exit code,
+# a compiler killed by a signal always fails the test
+#
+# environment variables:
+#   COMP     path of the compiler binary        (default: ./comp)
+#   OUT      directory for the test files        (default: tests/out)
+
+TESTS_DIR=$(dirname "$0")
+COMP=${COMP:-./comp}
+OUT=${OUT:-$TESTS_DIR/out}
+
+if [ ! -x "$COMP" ]; then
+  echo "Error: can not find the compiler at $COMP, build it first or set COMP"
+  exit 1
+fi
+mkdir -p "$OUT"
+
+FAILED=0
+PASSED=0
+
+pass() {
+  PASSED=$((PASSED + 1))
+}
+
+fail() {
+  echo "FAIL $1: $2"
+  FAILED=$((FAILED + 1))
+}
+
+# writes the program $2 of the test $1 and sets SRC to its path
+write_program() {
+  SRC="$OUT/$1.src"
+  printf '%s\n' "$2" > "$SRC"
+}
+
+# the test $1 compiles the program $2 to C and expects the error $3 in the output of the compiler
+expect_error() {
+  write_program "$1" "$2"
+  output=$("$COMP" "$SRC" "$OUT/$1.c" 2>&1)
+  status=$?
+  if [ $status -eq 0 ]; then
+    fail "$1" "the program compiled"
+  elif [ $status -gt 128 ]; then
+    fail "$1" "the compiler was killed by the signal $((status - 128))"
+  elif ! printf '%s\n' "$output" | grep -qF -- "$3"; then
+    fail "$1" "expected \"$3\" in: $output"
+  else
+    pass
+  fi
+}
+
+# the test $1 compiles the program $2 to the executable $3 and expects it to exit with the code $4
+expect_exit() {
+  write_program "$1" "$2"
+  if ! output=$("$COMP" "$SRC" "$3" 2>&1); then
+    fail "$1" "the program did not compile: $output"
+    return
+  fi
+  "$3"
+  status=$?
+  if [ $status -ne "$4" ]; then
+    fail "$1" "expected the exit code $4, the program exited with $status"
+  else
+    pass
+  fi
+}
+
+# lexer
+# the first column of a line is 2, like in all the errors of the compiler
+
+expect_error number_too_large "a: u64 = 18446744073709551616;" "Line:1, column:11.  Error: the number (18446744073709551616) does not fit in 64 bits"
+expect_error number_too_large_at_end "a: u64 = 1;
+a = 18446744073709551616" "Line:2, column:6.  Error: the number (18446744073709551616) does not fit in 64 bits"
+expect_error number_invalid_digit "x: u64 = 1;
+print 1x0;" "Line:2, column:8.  Error: invalid digit (x) in the number (1x0)"
+expect_error symbol_column "x: u64 = 1;
+print \$;" "Line:2, column:8.  Error: unkown type of symbol (\$)"
+
+# parser
+
+expect_error unclosed_square_bracket "t: u64 = 0;
+t = t + t[1;2];" "Line:2, column:11.  Error: expected a closing square bracket"
+expect_error unclosed_bracket "t: u64 = 0;
+t = t + (1;" "Line:2, column:10.  Error: expected a closing bracket"
+expect_error unclosed_bracket_index "t: u64 = 0;
+t = t + (t[1];" "Line:2, column:10.  Error: expected a closing bracket"
+# after an error in a top level statement the parsing continues with the next one
+expect_error error_after_scope_error "t: u64 = 0;
+if t { t = (1; }
+t = t + t[1;" "Line:3, column:11.  Error: expected a closing square bracket"
+
+# outputs
+# the extension of the output is the one of the file name, the directories can have dots
+
+mkdir -p "$OUT/out.d"
+expect_exit executable_in_dotted_directory "exit 7;" "$OUT/out.d/prog" 7
+expect_exit executable_in_current_directory "exit 8;" "$OUT/./prog1" 8
+
+# batch
+# the test $1 compiles a directory with the programs a and b in batch mode to the extension $2,
+# and expects the outputs $3 in a new output directory
+expect_batch_outputs() {
+  rm -rf "$OUT/$1"
+  mkdir -p "$OUT/$1/input"
+  printf 'exit 3;\n' > "$OUT/$1/input/a.src"
+  printf 'exit 4;\n' > "$OUT/$1/input/b.src"
+  if ! output=$("$COMP" --batch "$OUT/$1/input" "$OUT/$1/output" "$2" 2>&1); then
+    fail "$1" "the batch failed: $output"
+    return
+  fi
+  for output_file in $3; do
+    if [ ! -f "$OUT/$1/output/$output_file" ]; then
+      fail "$1" "the batch did not write $output_file"
+      return
+    fi
+  done
+  pass
+}
+
+expect_batch_outputs batch_extension_with_dot .c "a.c b.c"
+expect_batch_outputs batch_extension_without_dot asm "a.asm b.asm"
+expect_batch_outputs batch_executables "" "a b"
+
+# cache
+# the outputs are copies of the ones in the cache, changing them does not change the cache
+
+write_program cache_copies "exit 5;"
+rm -rf "$OUT/cache"
+"$COMP" "$SRC" "$OUT/cache_reference.c" > /dev/null
+"$COMP" --cache "$OUT/cache" "$SRC" "$OUT/cache_first.c" > /dev/null
+"$COMP" --cache "$OUT/cache" "$SRC" "$OUT/cache_hit.c" > /dev/null
+echo "// changed after the compilation" >> "$OUT/cache_hit.c"
+"$COMP" --cache "$OUT/cache" "$SRC" "$OUT/cache_second_hit.c" > /dev/null
+if cmp -s "$OUT/cache_reference.c" "$OUT/cache_first.c" && cmp -s "$OUT/cache_reference.c" "$OUT/cache_second_hit.c"; then
+  pass
+else
+  fail cache_copies "changing an output loaded from the cache changed the cache"
+fi
+"$COMP" --cache "$OUT/cache" "$SRC" "$OUT/cache_executable" > /dev/null
+expect_exit cache_executable "exit 5;" "$OUT/cache_executable" 5
+
+# executables
+
+expect_exit pointer_dereference "sum: u64 = 5;
+p: ptr u64 = &sum;
+exit *p;" "$OUT/pointer_dereference" 5
+expect_exit pointer_dereference_in_loop "x: u64 = 0;
+sum: u64 = 5;
+p: ptr u64 = &sum;
+while x < 3 { x = x + 1; sum = *p + 1; }
+exit sum;" "$OUT/pointer_dereference_in_loop" 8
+expect_exit nested_array_access "m: [3][3]u64 = [[1,2,3],[4,5,76],[7,8,33]];
+exit m[1][2];" "$OUT/nested_array_access" 76
+expect_exit nested_array_loop "m: [3][3]u64 = [[1,2,3],[4,5,76],[7,8,33]];
+s: u64 = 0;
+i: u64 = 0;
+while i < 3 { j: u64 = 0; while j < 3 { s = s + m[i][j]; j = j + 1; } i = i + 1; }
+exit s - 31;" "$OUT/nested_array_loop" 108
+expect_exit nested_packed_arrays "m: [2][3]u8 = [[1,2,3],[4,5,6]];
+n: [2][2][3]u16 = [[[1,2,3],[4,5,6]],[[7,8,9],[10,11,12]]];
+exit m[1][0] * 10 + m[0][2] + n[1][0][2] * 3 + n[0][1][1];" "$OUT/nested_packed_arrays" 75
+
+# server
+
+# the test $1 opens the document $2 in the server, applies the edit $3 ([offset]:[removed length]:[inserted text])
+# and expects the same errors a document opened with the edited text has
+expect_same_edit_errors() {
+  if [ -z "$SERVER_SOCKET" ]; then
+    return
+  fi
+  result=$(python3 - "$SERVER_SOCKET" "$2" "$3" <<'PYTHON'
+import socket, sys
+
+def request(connection, kind, argument, payload):
+    connection.sendall(b"%s %s %d\n" % (kind, argument, len(payload)) + payload)
+    header = b""
+    while not header.endswith(b"\n"):
+        header += connection.recv(1)
+    status, diagnostics_size, output_size = header.split()
+    size = int(diagnostics_size) + int(output_size)
+    response = b""
+    while len(response) < size:
+        response += connection.recv(size - len(response))
+    return status + b" " + response[:int(diagnostics_size)]
+
+def connect():
+    connection = socket.socket(socket.AF_UNIX)
+    connection.connect(sys.argv[1])
+    return connection
+
+text = sys.argv[2].encode()
+offset, removed, inserted = sys.argv[3].split(":", 2)
+offset, removed, inserted = int(offset), int(removed), inserted.encode()
+edited_text = text[:offset] + inserted + text[offset + removed:]
+
+document = connect()
+request(document, b"open", b"-", text)
+edited = request(document, b"edit", b"%d:%d" % (offset, removed), inserted)
+document.close()
+opened = request(connect(), b"open", b"-", edited_text)
+if edited != opened:
+    print("edited: %s opened: %s" % (edited.decode(), opened.decode()))
+PYTHON
+)
+  if [ $? -ne 0 ]; then
+    fail "$1" "the server did not answer"
+  elif [ -n "$result" ]; then
+    fail "$1" "$result"
+  else
+    pass
+  fi
+}
+
+SERVER_SOCKET=
+if command -v python3 >/dev/null 2>&1; then
+  SERVER_SOCKET="$OUT/server.sock"
+  rm -f "$SERVER_SOCKET"
+  "$COMP" --server "$SERVER_SOCKET" > /dev/null &
+  # wait for the socket of the server
+  i=0
+  while [ ! -S "$SERVER_SOCKET" ] && [ $i -lt 50 ]; do
+    sleep 0.1
+    i=$((i + 1))
+  done
+else
+  echo "python3 is not available, the tests of the server are skipped"
+fi
+
+expect_same_edit_errors edit_after_number_error "x: u64 = 1;
+print 1x0;
+exit 6;@
+" "31:0:"
+expect_same_edit_errors edit_before_number_error "x: u64 = 1;
+print 1x0;
+exit 6;
+" "0:1:y"
+expect_same_edit_errors edit_after_symbol_error "x: u64 = 1; \$ x = 2;
+exit 6;
+" "17:1:3"
+
+# the test $1 sends a request with the header $2 and no payload, and expects an error answer,
+# then the server must still compile a program
+expect_refused_request() {
+  if [ -z "$SERVER_SOCKET" ]; then
+    return
+  fi
+  result=$(python3 - "$SERVER_SOCKET" "$2" <<'PYTHON'
+import socket, sys
+
+def connect():
+    connection = socket.socket(socket.AF_UNIX)
+    connection.settimeout(10)
+    connection.connect(sys.argv[1])
+    return connection
+
+refused = connect()
+refused.sendall(sys.argv[2].encode() + b"\n")
+answer = refused.recv(128)
+refused.close()
+if not answer.startswith(b"error "):
+    print("the request was not refused: %s" % answer.decode())
+compiled = connect()
+compiled.sendall(b"source .c 8\nexit 3;\n")
+if not compiled.recv(128).startswith(b"ok "):
+    print("the server does not compile after the request")
+PYTHON
+)
+  if [ $? -ne 0 ]; then
+    fail "$1" "the server did not answer"
+  elif [ -n "$result" ]; then
+    fail "$1" "$result"
+  else
+    pass
+  fi
+}
+
+expect_refused_request payload_size_overflow "source .c 18446744073709551615"
+expect_refused_request payload_too_large "source .c 1000000000000"
+
+if [ -n "$SERVER_SOCKET" ]; then
+  "$COMP" --client "$SERVER_SOCKET" --stop > /dev/null
+fi
+
+echo "$PASSED passed, $FAILED failed"
+[ $FAILED -eq 0 ]